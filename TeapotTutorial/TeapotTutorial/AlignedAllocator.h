@@ -0,0 +1,72 @@
+#pragma once
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <cstdlib>
+#endif
+#include <new>
+#include <cstddef>
+
+// A std::vector allocator whose storage starts on an alignment byte boundary, e.g. a cache line, so streams
+// read with vector loads front to back never have a load straddle two lines.
+template<typename T, size_t alignment>
+class AlignedAllocator
+{
+public:
+	using value_type = T;
+
+	template<typename U>
+	struct rebind
+	{
+		using other = AlignedAllocator<U, alignment>;
+	};
+
+	AlignedAllocator() = default;
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U, alignment>&)
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+#ifdef _WIN32
+		void* data{ _aligned_malloc(count * sizeof(T), alignment) };
+#else
+		// posix_memalign wants a multiple of sizeof(void*), which every alignment asked for here is.
+		void* data{ nullptr };
+		if (posix_memalign(&data, alignment, count * sizeof(T)) != 0)
+		{
+			data = nullptr;
+		}
+#endif
+		if (data == nullptr)
+		{
+			throw(std::bad_alloc{});
+		}
+
+		return static_cast<T*>(data);
+	}
+
+	void deallocate(T* data, size_t)
+	{
+#ifdef _WIN32
+		_aligned_free(data);
+#else
+		free(data);
+#endif
+	}
+};
+
+template<typename T, typename U, size_t alignment>
+bool operator==(const AlignedAllocator<T, alignment>&, const AlignedAllocator<U, alignment>&)
+{
+	return true;
+}
+
+template<typename T, typename U, size_t alignment>
+bool operator!=(const AlignedAllocator<T, alignment>&, const AlignedAllocator<U, alignment>&)
+{
+	return false;
+}
\ No newline at end of file
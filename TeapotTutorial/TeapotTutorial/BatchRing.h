@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands batches from one producer thread to one consumer thread without locks, in order and none skipped,
+// unlike TripleBuffer. The slots are created once and filled in place, so batches made of vectors stop
+// allocating once their capacity has grown. When every slot is taken the producer gets no slot and decides
+// itself what to do with the batch it did not make.
+template<typename T, uint32_t capacity>
+class BatchRing
+{
+public:
+	// Producer: the slot to fill before endWrite(), or nullptr while the consumer still holds them all. It keeps
+	// its contents from capacity batches ago.
+	T* beginWrite()
+	{
+		uint64_t position{ writePosition.load(std::memory_order_relaxed) };
+		if (position - readPosition.load(std::memory_order_acquire) == capacity)
+		{
+			return nullptr;
+		}
+
+		return &slots[position % capacity];
+	}
+
+	void endWrite()
+	{
+		writePosition.store(writePosition.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// Consumer: the oldest batch not yet popped, or nullptr when there is none.
+	const T* front() const
+	{
+		uint64_t position{ readPosition.load(std::memory_order_relaxed) };
+		if (position == writePosition.load(std::memory_order_acquire))
+		{
+			return nullptr;
+		}
+
+		return &slots[position % capacity];
+	}
+
+	// Hands the front slot back to the producer.
+	void pop()
+	{
+		readPosition.store(readPosition.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+private:
+	T slots[capacity];
+	std::atomic<uint64_t> writePosition{ 0 };
+	std::atomic<uint64_t> readPosition{ 0 };
+};
\ No newline at end of file
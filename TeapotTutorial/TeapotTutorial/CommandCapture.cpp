@@ -0,0 +1,578 @@
+#include "CommandCapture.h"
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+	const char captureMagic[4]{ 'T', 'P', 'C', 'S' };
+	const uint32_t captureVersion{ 4 };
+
+	// Which argument slots of RecordedCommand each command type uses, in RenderCommandType order.
+	struct CommandLayout
+	{
+		uint8_t numU;
+		uint8_t numQ;
+		uint8_t numF;
+		bool barriers;
+		bool constants;
+		bool data;
+	};
+
+	const CommandLayout commandLayouts[]
+	{
+		{ 1, 0, 0, false, false, false }, // Reset
+		{ 0, 0, 0, false, false, false }, // Close
+		{ 1, 0, 0, false, false, false }, // SetPipelineState
+		{ 1, 0, 0, false, false, false }, // SetGraphicsRootSignature
+		{ 0, 0, 6, false, false, false }, // SetViewport
+		{ 4, 0, 0, false, false, false }, // SetScissorRect
+		{ 0, 0, 0, true, false, false }, // ResourceBarrier
+		{ 4, 0, 0, false, false, false }, // SetRenderTarget
+		{ 2, 0, 4, false, false, false }, // ClearRenderTarget
+		{ 2, 0, 1, false, false, false }, // ClearDepth
+		{ 1, 0, 0, false, false, false }, // SetPrimitiveTopology
+		{ 3, 1, 0, false, false, false }, // SetVertexBuffer
+		{ 2, 1, 0, false, false, false }, // SetIndexBuffer
+		{ 2, 0, 0, false, true, false }, // SetGraphicsRoot32BitConstants
+		{ 1, 1, 0, false, false, false }, // SetGraphicsRootConstantBufferView
+		{ 1, 0, 0, false, false, false }, // SetDescriptorHeap
+		{ 3, 0, 0, false, false, false }, // SetGraphicsRootDescriptorTable
+		{ 5, 0, 0, false, false, false }, // DrawIndexedInstanced
+		{ 3, 1, 0, false, false, false }, // ExecuteIndirect
+		{ 2, 3, 0, false, false, false }, // CopyBufferRegion
+		{ 1, 0, 0, false, true, false }, // ExecuteCommandLists
+		{ 2, 1, 0, false, false, false }, // Signal
+		{ 1, 1, 0, false, false, false }, // WaitForFence
+		{ 1, 1, 0, false, false, true }, // UpdateBuffer
+		{ 0, 0, 0, false, true, false }, // CopyDescriptors
+		{ 0, 0, 0, false, false, false } // Present
+	};
+
+	static_assert(sizeof(commandLayouts) / sizeof(commandLayouts[0]) == static_cast<size_t>(RenderCommandType::Count), "Every command type needs a layout.");
+
+	class BinaryWriter
+	{
+	public:
+		void putVarint(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				bytes.push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+
+			bytes.push_back(static_cast<uint8_t>(value));
+		}
+
+		void putFloat(float value)
+		{
+			putRaw(&value, sizeof(value));
+		}
+
+		void putRaw(const void* data, size_t size)
+		{
+			const uint8_t* p{ static_cast<const uint8_t*>(data) };
+			bytes.insert(bytes.end(), p, p + size);
+		}
+
+		void putBytes(const vector<uint8_t>& data)
+		{
+			putVarint(data.size());
+			putRaw(data.data(), data.size());
+		}
+
+		void putString(const string& s)
+		{
+			putVarint(s.size());
+			putRaw(s.data(), s.size());
+		}
+
+		vector<uint8_t> bytes;
+	};
+
+	class BinaryReader
+	{
+	public:
+		explicit BinaryReader(const vector<uint8_t>& bytes) : bytes{ bytes }
+		{
+		}
+
+		uint64_t getVarint()
+		{
+			uint64_t value{ 0 };
+			for (int shift{ 0 }; shift < 64; shift += 7)
+			{
+				uint8_t b{ getByte() };
+				value |= static_cast<uint64_t>(b & 0x7f) << shift;
+				if ((b & 0x80) == 0)
+				{
+					return value;
+				}
+			}
+
+			throw(runtime_error{ "Corrupt command capture." });
+		}
+
+		uint32_t getVarint32()
+		{
+			return static_cast<uint32_t>(getVarint());
+		}
+
+		float getFloat()
+		{
+			float value;
+			getRaw(&value, sizeof(value));
+			return value;
+		}
+
+		void getRaw(void* data, size_t size)
+		{
+			if (size > bytes.size() - position)
+			{
+				throw(runtime_error{ "Truncated command capture." });
+			}
+
+			if (size == 0)
+			{
+				return;
+			}
+
+			memcpy(data, bytes.data() + position, size);
+			position += size;
+		}
+
+		vector<uint8_t> getBytes()
+		{
+			vector<uint8_t> data(static_cast<size_t>(getVarint()));
+			getRaw(data.data(), data.size());
+			return data;
+		}
+
+		string getString()
+		{
+			vector<uint8_t> data{ getBytes() };
+			return string(data.begin(), data.end());
+		}
+
+	private:
+		uint8_t getByte()
+		{
+			uint8_t b;
+			getRaw(&b, 1);
+			return b;
+		}
+
+	private:
+		const vector<uint8_t>& bytes;
+		size_t position{ 0 };
+	};
+
+	void putDescriptor(BinaryWriter& writer, const DescriptorHandle& handle)
+	{
+		writer.putVarint(handle.heap.id);
+		writer.putVarint(handle.index);
+	}
+
+	DescriptorHandle getDescriptor(BinaryReader& reader)
+	{
+		DescriptorHandle handle;
+		handle.heap = DescriptorHeapHandle{ reader.getVarint32() };
+		handle.index = reader.getVarint32();
+		return handle;
+	}
+}
+
+size_t CommandCapture::getFrameCount() const
+{
+	size_t frames{ 0 };
+	for (const RecordedCommand& command : commands)
+	{
+		if (command.type == RenderCommandType::Present)
+		{
+			++frames;
+		}
+	}
+
+	return frames;
+}
+
+vector<uint8_t> teapot_tutorial::serializeCommandCapture(const CommandCapture& capture)
+{
+	BinaryWriter writer;
+	writer.putRaw(captureMagic, sizeof(captureMagic));
+	writer.putVarint(captureVersion);
+
+	writer.putVarint(capture.firstBackBufferIndex);
+	writer.putVarint(capture.backBuffers.size());
+	for (size_t i{ 0 }; i < capture.backBuffers.size(); i++)
+	{
+		writer.putVarint(capture.backBuffers[i].id);
+		putDescriptor(writer, capture.backBufferRtvs[i]);
+	}
+	putDescriptor(writer, capture.depthStencilView);
+
+	writer.putVarint(capture.buffers.size());
+	for (const CommandCapture::Buffer& buffer : capture.buffers)
+	{
+		writer.putVarint(buffer.handle.id);
+		writer.putVarint(buffer.desc.size);
+		writer.putVarint(static_cast<uint32_t>(buffer.desc.heapType));
+		writer.putVarint(static_cast<uint32_t>(buffer.desc.initialState));
+		writer.putString(buffer.desc.name);
+		writer.putVarint(buffer.gpuAddress);
+		writer.putBytes(buffer.initialData);
+	}
+
+	writer.putVarint(capture.descriptorHeaps.size());
+	for (const CommandCapture::DescriptorHeap& heap : capture.descriptorHeaps)
+	{
+		writer.putVarint(heap.handle.id);
+		writer.putVarint(static_cast<uint32_t>(heap.desc.type));
+		writer.putVarint(heap.desc.numDescriptors);
+		writer.putVarint(heap.desc.shaderVisible ? 1 : 0);
+	}
+
+	writer.putVarint(capture.shaderResourceViews.size());
+	for (const CommandCapture::ShaderResourceView& srv : capture.shaderResourceViews)
+	{
+		writer.putVarint(srv.buffer.id);
+		writer.putVarint(srv.desc.firstElement);
+		writer.putVarint(srv.desc.numElements);
+		writer.putVarint(srv.desc.structureByteStride);
+		putDescriptor(writer, srv.destDescriptor);
+	}
+
+	writer.putVarint(capture.rootSignatures.size());
+	for (const CommandCapture::RootSignature& rootSignature : capture.rootSignatures)
+	{
+		writer.putVarint(rootSignature.handle.id);
+		writer.putVarint(rootSignature.desc.flags);
+		writer.putVarint(rootSignature.desc.parameters.size());
+		for (const RootParameterDesc& param : rootSignature.desc.parameters)
+		{
+			writer.putVarint(static_cast<uint32_t>(param.type));
+			writer.putVarint(static_cast<uint32_t>(param.visibility));
+			writer.putVarint(param.shaderRegister);
+			writer.putVarint(param.registerSpace);
+			writer.putVarint(param.count);
+		}
+	}
+
+	writer.putVarint(capture.pipelineStates.size());
+	for (const CommandCapture::PipelineState& pipelineState : capture.pipelineStates)
+	{
+		const PipelineStateDesc& desc{ pipelineState.desc };
+		writer.putVarint(pipelineState.handle.id);
+		writer.putVarint(desc.rootSignature.id);
+		writer.putVarint(desc.inputLayout.size());
+		for (const InputElementDesc& element : desc.inputLayout)
+		{
+			writer.putString(element.semanticName);
+			writer.putVarint(element.semanticIndex);
+			writer.putVarint(static_cast<uint32_t>(element.format));
+			writer.putVarint(element.inputSlot);
+			writer.putVarint(element.alignedByteOffset);
+		}
+		writer.putBytes(desc.vertexShader);
+		writer.putBytes(desc.hullShader);
+		writer.putBytes(desc.domainShader);
+		writer.putBytes(desc.pixelShader);
+		writer.putVarint(static_cast<uint32_t>(desc.fillMode));
+		writer.putVarint(static_cast<uint32_t>(desc.cullMode));
+		writer.putVarint(desc.depthEnable ? 1 : 0);
+		writer.putVarint(static_cast<uint32_t>(desc.topologyType));
+		writer.putVarint(static_cast<uint32_t>(desc.renderTargetFormat));
+		writer.putVarint(static_cast<uint32_t>(desc.depthStencilFormat));
+	}
+
+	writer.putVarint(capture.commandSignatures.size());
+	for (const CommandCapture::CommandSignature& commandSignature : capture.commandSignatures)
+	{
+		const CommandSignatureDesc& desc{ commandSignature.desc };
+		writer.putVarint(commandSignature.handle.id);
+		writer.putVarint(desc.byteStride);
+		writer.putVarint(desc.rootSignature.id);
+		writer.putVarint(desc.arguments.size());
+		for (const IndirectArgumentDesc& argument : desc.arguments)
+		{
+			writer.putVarint(static_cast<uint32_t>(argument.type));
+			writer.putVarint(argument.rootParameterIndex);
+			writer.putVarint(argument.destOffsetIn32BitValues);
+			writer.putVarint(argument.num32BitValues);
+		}
+	}
+
+	writer.putVarint(capture.fences.size());
+	for (const CommandCapture::Fence& fence : capture.fences)
+	{
+		writer.putVarint(fence.handle.id);
+		writer.putVarint(fence.initialValue);
+	}
+
+	writer.putVarint(capture.commandListQueues.size());
+	for (QueueType queue : capture.commandListQueues)
+	{
+		writer.putVarint(static_cast<uint32_t>(queue));
+	}
+
+	writer.putVarint(capture.commands.size());
+	for (const RecordedCommand& command : capture.commands)
+	{
+		const CommandLayout& layout{ commandLayouts[static_cast<size_t>(command.type)] };
+		writer.putRaw(&command.type, 1);
+		writer.putVarint(command.commandList);
+
+		for (uint8_t i{ 0 }; i < layout.numU; i++)
+		{
+			writer.putVarint(command.u[i]);
+		}
+
+		for (uint8_t i{ 0 }; i < layout.numQ; i++)
+		{
+			writer.putVarint(command.q[i]);
+		}
+
+		for (uint8_t i{ 0 }; i < layout.numF; i++)
+		{
+			writer.putFloat(command.f[i]);
+		}
+
+		if (layout.barriers)
+		{
+			writer.putVarint(command.barriers.size());
+			for (const ResourceBarrier& barrier : command.barriers)
+			{
+				writer.putVarint(barrier.resource.id);
+				writer.putVarint(barrier.subresource);
+				writer.putVarint(static_cast<uint32_t>(barrier.stateBefore));
+				writer.putVarint(static_cast<uint32_t>(barrier.stateAfter));
+				writer.putVarint(static_cast<uint32_t>(barrier.flags));
+			}
+		}
+
+		if (layout.constants)
+		{
+			writer.putVarint(command.constants.size());
+			writer.putRaw(command.constants.data(), command.constants.size() * sizeof(uint32_t));
+		}
+
+		if (layout.data)
+		{
+			writer.putBytes(command.data);
+		}
+	}
+
+	return move(writer.bytes);
+}
+
+CommandCapture teapot_tutorial::deserializeCommandCapture(const vector<uint8_t>& bytes)
+{
+	BinaryReader reader{ bytes };
+
+	char magic[4];
+	reader.getRaw(magic, sizeof(magic));
+	if (memcmp(magic, captureMagic, sizeof(magic)) != 0 || reader.getVarint32() != captureVersion)
+	{
+		throw(runtime_error{ "Not a command capture." });
+	}
+
+	CommandCapture capture;
+	capture.firstBackBufferIndex = reader.getVarint32();
+	capture.backBuffers.resize(static_cast<size_t>(reader.getVarint()));
+	capture.backBufferRtvs.resize(capture.backBuffers.size());
+	for (size_t i{ 0 }; i < capture.backBuffers.size(); i++)
+	{
+		capture.backBuffers[i] = ResourceHandle{ reader.getVarint32() };
+		capture.backBufferRtvs[i] = getDescriptor(reader);
+	}
+	capture.depthStencilView = getDescriptor(reader);
+
+	capture.buffers.resize(static_cast<size_t>(reader.getVarint()));
+	for (CommandCapture::Buffer& buffer : capture.buffers)
+	{
+		buffer.handle = ResourceHandle{ reader.getVarint32() };
+		buffer.desc.size = reader.getVarint();
+		buffer.desc.heapType = static_cast<HeapType>(reader.getVarint32());
+		buffer.desc.initialState = static_cast<ResourceState>(reader.getVarint32());
+		buffer.desc.name = reader.getString();
+		buffer.gpuAddress = reader.getVarint();
+		buffer.initialData = reader.getBytes();
+	}
+
+	capture.descriptorHeaps.resize(static_cast<size_t>(reader.getVarint()));
+	for (CommandCapture::DescriptorHeap& heap : capture.descriptorHeaps)
+	{
+		heap.handle = DescriptorHeapHandle{ reader.getVarint32() };
+		heap.desc.type = static_cast<DescriptorHeapType>(reader.getVarint32());
+		heap.desc.numDescriptors = reader.getVarint32();
+		heap.desc.shaderVisible = reader.getVarint() != 0;
+	}
+
+	capture.shaderResourceViews.resize(static_cast<size_t>(reader.getVarint()));
+	for (CommandCapture::ShaderResourceView& srv : capture.shaderResourceViews)
+	{
+		srv.buffer = ResourceHandle{ reader.getVarint32() };
+		srv.desc.firstElement = reader.getVarint32();
+		srv.desc.numElements = reader.getVarint32();
+		srv.desc.structureByteStride = reader.getVarint32();
+		srv.destDescriptor = getDescriptor(reader);
+	}
+
+	capture.rootSignatures.resize(static_cast<size_t>(reader.getVarint()));
+	for (CommandCapture::RootSignature& rootSignature : capture.rootSignatures)
+	{
+		rootSignature.handle = RootSignatureHandle{ reader.getVarint32() };
+		rootSignature.desc.flags = reader.getVarint32();
+		rootSignature.desc.parameters.resize(static_cast<size_t>(reader.getVarint()));
+		for (RootParameterDesc& param : rootSignature.desc.parameters)
+		{
+			param.type = static_cast<RootParameterType>(reader.getVarint32());
+			param.visibility = static_cast<ShaderVisibility>(reader.getVarint32());
+			param.shaderRegister = reader.getVarint32();
+			param.registerSpace = reader.getVarint32();
+			param.count = reader.getVarint32();
+		}
+	}
+
+	capture.pipelineStates.resize(static_cast<size_t>(reader.getVarint()));
+	for (CommandCapture::PipelineState& pipelineState : capture.pipelineStates)
+	{
+		PipelineStateDesc& desc{ pipelineState.desc };
+		pipelineState.handle = PipelineStateHandle{ reader.getVarint32() };
+		desc.rootSignature = RootSignatureHandle{ reader.getVarint32() };
+		desc.inputLayout.resize(static_cast<size_t>(reader.getVarint()));
+		for (InputElementDesc& element : desc.inputLayout)
+		{
+			element.semanticName = reader.getString();
+			element.semanticIndex = reader.getVarint32();
+			element.format = static_cast<Format>(reader.getVarint32());
+			element.inputSlot = reader.getVarint32();
+			element.alignedByteOffset = reader.getVarint32();
+		}
+		desc.vertexShader = reader.getBytes();
+		desc.hullShader = reader.getBytes();
+		desc.domainShader = reader.getBytes();
+		desc.pixelShader = reader.getBytes();
+		desc.fillMode = static_cast<FillMode>(reader.getVarint32());
+		desc.cullMode = static_cast<CullMode>(reader.getVarint32());
+		desc.depthEnable = reader.getVarint() != 0;
+		desc.topologyType = static_cast<PrimitiveTopologyType>(reader.getVarint32());
+		desc.renderTargetFormat = static_cast<Format>(reader.getVarint32());
+		desc.depthStencilFormat = static_cast<Format>(reader.getVarint32());
+	}
+
+	capture.commandSignatures.resize(static_cast<size_t>(reader.getVarint()));
+	for (CommandCapture::CommandSignature& commandSignature : capture.commandSignatures)
+	{
+		CommandSignatureDesc& desc{ commandSignature.desc };
+		commandSignature.handle = CommandSignatureHandle{ reader.getVarint32() };
+		desc.byteStride = reader.getVarint32();
+		desc.rootSignature = RootSignatureHandle{ reader.getVarint32() };
+		desc.arguments.resize(static_cast<size_t>(reader.getVarint()));
+		for (IndirectArgumentDesc& argument : desc.arguments)
+		{
+			argument.type = static_cast<IndirectArgumentType>(reader.getVarint32());
+			argument.rootParameterIndex = reader.getVarint32();
+			argument.destOffsetIn32BitValues = reader.getVarint32();
+			argument.num32BitValues = reader.getVarint32();
+		}
+	}
+
+	capture.fences.resize(static_cast<size_t>(reader.getVarint()));
+	for (CommandCapture::Fence& fence : capture.fences)
+	{
+		fence.handle = FenceHandle{ reader.getVarint32() };
+		fence.initialValue = reader.getVarint();
+	}
+
+	capture.commandListQueues.resize(static_cast<size_t>(reader.getVarint()));
+	for (QueueType& queue : capture.commandListQueues)
+	{
+		queue = static_cast<QueueType>(reader.getVarint32());
+	}
+
+	capture.commands.resize(static_cast<size_t>(reader.getVarint()));
+	for (RecordedCommand& command : capture.commands)
+	{
+		memset(command.u, 0, sizeof(command.u));
+		memset(command.q, 0, sizeof(command.q));
+		memset(command.f, 0, sizeof(command.f));
+
+		reader.getRaw(&command.type, 1);
+		if (command.type >= RenderCommandType::Count)
+		{
+			throw(runtime_error{ "Corrupt command capture." });
+		}
+
+		const CommandLayout& layout{ commandLayouts[static_cast<size_t>(command.type)] };
+		command.commandList = reader.getVarint32();
+
+		for (uint8_t i{ 0 }; i < layout.numU; i++)
+		{
+			command.u[i] = reader.getVarint32();
+		}
+
+		for (uint8_t i{ 0 }; i < layout.numQ; i++)
+		{
+			command.q[i] = reader.getVarint();
+		}
+
+		for (uint8_t i{ 0 }; i < layout.numF; i++)
+		{
+			command.f[i] = reader.getFloat();
+		}
+
+		if (layout.barriers)
+		{
+			command.barriers.resize(static_cast<size_t>(reader.getVarint()));
+			for (ResourceBarrier& barrier : command.barriers)
+			{
+				barrier.resource = ResourceHandle{ reader.getVarint32() };
+				barrier.subresource = reader.getVarint32();
+				barrier.stateBefore = static_cast<ResourceState>(reader.getVarint32());
+				barrier.stateAfter = static_cast<ResourceState>(reader.getVarint32());
+				barrier.flags = static_cast<BarrierFlags>(reader.getVarint32());
+			}
+		}
+
+		if (layout.constants)
+		{
+			command.constants.resize(static_cast<size_t>(reader.getVarint()));
+			reader.getRaw(command.constants.data(), command.constants.size() * sizeof(uint32_t));
+		}
+
+		if (layout.data)
+		{
+			command.data = reader.getBytes();
+		}
+	}
+
+	return capture;
+}
+
+void teapot_tutorial::saveCommandCapture(const CommandCapture& capture, const string& fileName)
+{
+	vector<uint8_t> bytes{ serializeCommandCapture(capture) };
+
+	ofstream file{ fileName, ios::binary };
+	if (!file || !file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size()))
+	{
+		throw(runtime_error{ "Error writing command capture." });
+	}
+}
+
+CommandCapture teapot_tutorial::loadCommandCapture(const string& fileName)
+{
+	ifstream file{ fileName, ios::binary };
+	if (!file)
+	{
+		throw(runtime_error{ "Error reading command capture." });
+	}
+
+	vector<uint8_t> bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+	return deserializeCommandCapture(bytes);
+}
\ No newline at end of file
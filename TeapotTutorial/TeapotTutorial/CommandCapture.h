@@ -0,0 +1,105 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "RenderTypes.h"
+
+// One call recorded by RecordingRenderDevice. Arguments are stored by kind in the order of the call's
+// parameters: handles and 32 bit values in u, 64 bit values in q and floats in f. Root constants and the ids of
+// executed command lists go to constants, buffer contents written through a mapping to data; device level
+// calls use command list 0. Descriptor copies store destination heap and index, source heap and index and count
+// of each range in constants.
+struct RecordedCommand
+{
+	RenderCommandType type;
+	uint32_t commandList;
+	uint32_t u[6];
+	uint64_t q[3];
+	float f[6];
+	std::vector<ResourceBarrier> barriers;
+	std::vector<uint32_t> constants;
+	std::vector<uint8_t> data;
+};
+
+// Everything needed to submit recorded frames again without the application: the objects the renderer
+// created (with their handles and GPU addresses on the capturing device), the swap chain it rendered to and
+// the command stream. Handles and GPU addresses inside commands refer to the capturing device.
+struct CommandCapture
+{
+	struct Buffer
+	{
+		ResourceHandle handle;
+		BufferDesc desc;
+		uint64_t gpuAddress;
+		// Empty or up to desc.size bytes; the rest of the buffer starts zeroed.
+		std::vector<uint8_t> initialData;
+	};
+
+	struct DescriptorHeap
+	{
+		DescriptorHeapHandle handle;
+		DescriptorHeapDesc desc;
+	};
+
+	struct ShaderResourceView
+	{
+		ResourceHandle buffer;
+		ShaderResourceViewDesc desc;
+		DescriptorHandle destDescriptor;
+	};
+
+	struct RootSignature
+	{
+		RootSignatureHandle handle;
+		RootSignatureDesc desc;
+	};
+
+	struct PipelineState
+	{
+		PipelineStateHandle handle;
+		PipelineStateDesc desc;
+	};
+
+	struct CommandSignature
+	{
+		CommandSignatureHandle handle;
+		CommandSignatureDesc desc;
+	};
+
+	struct Fence
+	{
+		FenceHandle handle;
+		uint64_t initialValue;
+	};
+
+	uint32_t firstBackBufferIndex;
+	std::vector<ResourceHandle> backBuffers;
+	std::vector<DescriptorHandle> backBufferRtvs;
+	DescriptorHandle depthStencilView;
+
+	std::vector<Buffer> buffers;
+	std::vector<DescriptorHeap> descriptorHeaps;
+	std::vector<ShaderResourceView> shaderResourceViews;
+	std::vector<RootSignature> rootSignatures;
+	std::vector<PipelineState> pipelineStates;
+	std::vector<CommandSignature> commandSignatures;
+	std::vector<Fence> fences;
+	// Queue of each command list, indexed by command list id - 1.
+	std::vector<QueueType> commandListQueues;
+
+	std::vector<RecordedCommand> commands;
+
+	size_t getFrameCount() const;
+};
+
+namespace teapot_tutorial
+{
+	// Compact binary form of a capture ("TPCS" files). Commands only store the arguments their type uses and
+	// handles are written as variable length integers, so a frame of the teapot takes a few hundred bytes.
+	std::vector<uint8_t> serializeCommandCapture(const CommandCapture& capture);
+	CommandCapture deserializeCommandCapture(const std::vector<uint8_t>& bytes);
+
+	void saveCommandCapture(const CommandCapture& capture, const std::string& fileName);
+	CommandCapture loadCommandCapture(const std::string& fileName);
+}
\ No newline at end of file
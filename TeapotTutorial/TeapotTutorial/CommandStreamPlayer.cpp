@@ -0,0 +1,432 @@
+#include "CommandStreamPlayer.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+CommandStreamPlayer::CommandStreamPlayer(const CommandCapture& capture, RenderDevice& device) : capture{ capture }, device{ device }, bufferCount{ device.getBufferCount() }
+{
+	if (capture.backBuffers.size() != bufferCount)
+	{
+		throw(runtime_error{ "Command capture was recorded with a different number of back buffers." });
+	}
+
+	createObjects();
+	resolveCommands();
+}
+
+CommandStreamPlayer::~CommandStreamPlayer()
+{
+	device.waitIdle();
+}
+
+void CommandStreamPlayer::replay()
+{
+	// The capture addresses back buffers by index; when a pass does not cover a multiple of the buffer count
+	// the swap chain is somewhere else at the start of the next pass.
+	uint32_t shift{ (device.getCurrentBackBufferIndex() + bufferCount - capture.firstBackBufferIndex) % bufferCount };
+	if (shift != backBufferShift)
+	{
+		resolveCommands();
+	}
+
+	for (const RecordedCommand& command : commands)
+	{
+		execute(command);
+	}
+
+	++pass;
+}
+
+size_t CommandStreamPlayer::getFrameCount() const
+{
+	return capture.getFrameCount();
+}
+
+size_t CommandStreamPlayer::getCommandCount() const
+{
+	return commands.size();
+}
+
+void CommandStreamPlayer::createObjects()
+{
+	vector<uint8_t> paddedData;
+	for (const CommandCapture::Buffer& buffer : capture.buffers)
+	{
+		const void* initialData{ buffer.initialData.empty() ? nullptr : buffer.initialData.data() };
+		if (initialData != nullptr && buffer.initialData.size() < buffer.desc.size)
+		{
+			paddedData.assign(buffer.initialData.begin(), buffer.initialData.end());
+			paddedData.resize(static_cast<size_t>(buffer.desc.size));
+			initialData = paddedData.data();
+		}
+
+		ResourceHandle handle{ device.createBuffer(buffer.desc, initialData) };
+
+		if (resources.size() < buffer.handle.id + 1)
+		{
+			resources.resize(buffer.handle.id + 1);
+		}
+		resources[buffer.handle.id] = handle;
+
+		addressRanges.push_back({ buffer.gpuAddress, buffer.gpuAddress + buffer.desc.size, handle });
+	}
+
+	sort(addressRanges.begin(), addressRanges.end(), [](const AddressRange& a, const AddressRange& b) { return a.begin < b.begin; });
+
+	for (const CommandCapture::DescriptorHeap& heap : capture.descriptorHeaps)
+	{
+		if (descriptorHeaps.size() < heap.handle.id + 1)
+		{
+			descriptorHeaps.resize(heap.handle.id + 1);
+		}
+		descriptorHeaps[heap.handle.id] = device.createDescriptorHeap(heap.desc);
+	}
+
+	for (const CommandCapture::ShaderResourceView& srv : capture.shaderResourceViews)
+	{
+		device.createShaderResourceView(resolveResource(srv.buffer.id), srv.desc, resolveDescriptor(srv.destDescriptor.heap.id, srv.destDescriptor.index));
+	}
+
+	for (const CommandCapture::RootSignature& rootSignature : capture.rootSignatures)
+	{
+		if (rootSignatures.size() < rootSignature.handle.id + 1)
+		{
+			rootSignatures.resize(rootSignature.handle.id + 1);
+		}
+		rootSignatures[rootSignature.handle.id] = device.createRootSignature(rootSignature.desc);
+	}
+
+	for (const CommandCapture::PipelineState& pipelineState : capture.pipelineStates)
+	{
+		PipelineStateDesc desc{ pipelineState.desc };
+		desc.rootSignature = rootSignatures.at(desc.rootSignature.id);
+
+		if (pipelineStates.size() < pipelineState.handle.id + 1)
+		{
+			pipelineStates.resize(pipelineState.handle.id + 1);
+		}
+		pipelineStates[pipelineState.handle.id] = device.createPipelineState(desc);
+	}
+
+	for (const CommandCapture::CommandSignature& commandSignature : capture.commandSignatures)
+	{
+		CommandSignatureDesc desc{ commandSignature.desc };
+		if (desc.rootSignature.isValid())
+		{
+			desc.rootSignature = rootSignatures.at(desc.rootSignature.id);
+		}
+
+		if (commandSignatures.size() < commandSignature.handle.id + 1)
+		{
+			commandSignatures.resize(commandSignature.handle.id + 1);
+		}
+		commandSignatures[commandSignature.handle.id] = device.createCommandSignature(desc);
+	}
+
+	// Values signaled before the capture started are unknown, so every fence is rebased to start right
+	// after the capture's first signal and waits for earlier values are dropped.
+	for (const CommandCapture::Fence& fence : capture.fences)
+	{
+		if (fences.size() < fence.handle.id + 1)
+		{
+			fences.resize(fence.handle.id + 1);
+			fenceRanges.resize(fence.handle.id + 1, { UINT64_MAX, 0 });
+		}
+		fences[fence.handle.id] = device.createFence(0);
+	}
+
+	for (const RecordedCommand& command : capture.commands)
+	{
+		if (command.type == RenderCommandType::Signal)
+		{
+			FenceRange& range{ fenceRanges.at(command.u[0]) };
+			range.firstSignal = min(range.firstSignal, command.q[0]);
+			range.lastSignal = max(range.lastSignal, command.q[0]);
+		}
+	}
+
+	for (QueueType queue : capture.commandListQueues)
+	{
+		commandLists.push_back(device.createCommandList(queue));
+	}
+}
+
+void CommandStreamPlayer::resolveCommands()
+{
+	backBufferShift = (device.getCurrentBackBufferIndex() + bufferCount - capture.firstBackBufferIndex) % bufferCount;
+
+	commands.clear();
+	commands.reserve(capture.commands.size());
+
+	for (const RecordedCommand& captured : capture.commands)
+	{
+		RecordedCommand command{ captured };
+
+		switch (command.type)
+		{
+		case RenderCommandType::SetPipelineState:
+			command.u[0] = pipelineStates.at(command.u[0]).id;
+			break;
+		case RenderCommandType::SetGraphicsRootSignature:
+			command.u[0] = rootSignatures.at(command.u[0]).id;
+			break;
+		case RenderCommandType::ResourceBarrier:
+			for (ResourceBarrier& barrier : command.barriers)
+			{
+				barrier.resource = resolveResource(barrier.resource.id);
+			}
+			break;
+		case RenderCommandType::SetRenderTarget:
+		case RenderCommandType::ClearRenderTarget:
+		case RenderCommandType::ClearDepth:
+		{
+			DescriptorHandle first{ resolveDescriptor(command.u[0], command.u[1]) };
+			command.u[0] = first.heap.id;
+			command.u[1] = first.index;
+			if (command.type == RenderCommandType::SetRenderTarget && command.u[2] != 0)
+			{
+				DescriptorHandle second{ resolveDescriptor(command.u[2], command.u[3]) };
+				command.u[2] = second.heap.id;
+				command.u[3] = second.index;
+			}
+			break;
+		}
+		case RenderCommandType::SetVertexBuffer:
+		case RenderCommandType::SetIndexBuffer:
+		case RenderCommandType::SetGraphicsRootConstantBufferView:
+			command.q[0] = resolveAddress(command.q[0]);
+			break;
+		case RenderCommandType::SetDescriptorHeap:
+			command.u[0] = descriptorHeaps.at(command.u[0]).id;
+			break;
+		case RenderCommandType::SetGraphicsRootDescriptorTable:
+		{
+			DescriptorHandle table{ resolveDescriptor(command.u[1], command.u[2]) };
+			command.u[1] = table.heap.id;
+			command.u[2] = table.index;
+			break;
+		}
+		case RenderCommandType::ExecuteIndirect:
+			command.u[0] = commandSignatures.at(command.u[0]).id;
+			command.u[2] = resolveResource(command.u[2]).id;
+			break;
+		case RenderCommandType::CopyBufferRegion:
+			command.u[0] = resolveResource(command.u[0]).id;
+			command.u[1] = resolveResource(command.u[1]).id;
+			break;
+		case RenderCommandType::Signal:
+		case RenderCommandType::WaitForFence:
+			// q[1] keeps the rebased value without the per-pass offset, which execute() adds from the range of
+			// the captured fence in u[2].
+			command.q[1] = resolveFenceValue(command.u[0], command.q[0]);
+			command.u[2] = command.u[0];
+			command.u[0] = fences.at(command.u[0]).id;
+			if (command.type == RenderCommandType::WaitForFence && command.q[1] == 0)
+			{
+				continue;
+			}
+			break;
+		case RenderCommandType::UpdateBuffer:
+			command.u[0] = resolveResource(command.u[0]).id;
+			break;
+		case RenderCommandType::CopyDescriptors:
+			for (size_t i{ 0 }; i + 4 < command.constants.size(); i += 5)
+			{
+				DescriptorHandle dst{ resolveDescriptor(command.constants[i], command.constants[i + 1]) };
+				DescriptorHandle src{ resolveDescriptor(command.constants[i + 2], command.constants[i + 3]) };
+				command.constants[i] = dst.heap.id;
+				command.constants[i + 1] = dst.index;
+				command.constants[i + 2] = src.heap.id;
+				command.constants[i + 3] = src.index;
+			}
+			break;
+		default:
+			break;
+		}
+
+		commands.push_back(move(command));
+	}
+}
+
+void CommandStreamPlayer::execute(const RecordedCommand& command)
+{
+	RenderCommandList* commandList{ command.commandList != 0 ? commandLists[command.commandList - 1].get() : nullptr };
+
+	switch (command.type)
+	{
+	case RenderCommandType::Reset:
+		commandList->reset(command.u[0]);
+		break;
+	case RenderCommandType::Close:
+		commandList->close();
+		break;
+	case RenderCommandType::SetPipelineState:
+		commandList->setPipelineState(PipelineStateHandle{ command.u[0] });
+		break;
+	case RenderCommandType::SetGraphicsRootSignature:
+		commandList->setGraphicsRootSignature(RootSignatureHandle{ command.u[0] });
+		break;
+	case RenderCommandType::SetViewport:
+		commandList->setViewport({ command.f[0], command.f[1], command.f[2], command.f[3], command.f[4], command.f[5] });
+		break;
+	case RenderCommandType::SetScissorRect:
+		commandList->setScissorRect({ static_cast<int32_t>(command.u[0]), static_cast<int32_t>(command.u[1]), static_cast<int32_t>(command.u[2]), static_cast<int32_t>(command.u[3]) });
+		break;
+	case RenderCommandType::ResourceBarrier:
+		commandList->resourceBarrier(static_cast<uint32_t>(command.barriers.size()), command.barriers.data());
+		break;
+	case RenderCommandType::SetRenderTarget:
+	{
+		DescriptorHandle dsv{ DescriptorHeapHandle{ command.u[2] }, command.u[3] };
+		commandList->setRenderTarget({ DescriptorHeapHandle{ command.u[0] }, command.u[1] }, command.u[2] != 0 ? &dsv : nullptr);
+		break;
+	}
+	case RenderCommandType::ClearRenderTarget:
+	{
+		const float color[4]{ command.f[0], command.f[1], command.f[2], command.f[3] };
+		commandList->clearRenderTarget({ DescriptorHeapHandle{ command.u[0] }, command.u[1] }, color);
+		break;
+	}
+	case RenderCommandType::ClearDepth:
+		commandList->clearDepth({ DescriptorHeapHandle{ command.u[0] }, command.u[1] }, command.f[0]);
+		break;
+	case RenderCommandType::SetPrimitiveTopology:
+		commandList->setPrimitiveTopology(static_cast<PrimitiveTopology>(command.u[0]));
+		break;
+	case RenderCommandType::SetVertexBuffer:
+		commandList->setVertexBuffer(command.u[0], { command.q[0], command.u[1], command.u[2] });
+		break;
+	case RenderCommandType::SetIndexBuffer:
+		commandList->setIndexBuffer({ command.q[0], command.u[0], static_cast<Format>(command.u[1]) });
+		break;
+	case RenderCommandType::SetGraphicsRoot32BitConstants:
+		commandList->setGraphicsRoot32BitConstants(command.u[0], static_cast<uint32_t>(command.constants.size()), command.constants.data(), command.u[1]);
+		break;
+	case RenderCommandType::SetGraphicsRootConstantBufferView:
+		commandList->setGraphicsRootConstantBufferView(command.u[0], command.q[0]);
+		break;
+	case RenderCommandType::SetDescriptorHeap:
+		commandList->setDescriptorHeap(DescriptorHeapHandle{ command.u[0] });
+		break;
+	case RenderCommandType::SetGraphicsRootDescriptorTable:
+		commandList->setGraphicsRootDescriptorTable(command.u[0], { DescriptorHeapHandle{ command.u[1] }, command.u[2] });
+		break;
+	case RenderCommandType::DrawIndexedInstanced:
+		commandList->drawIndexedInstanced(command.u[0], command.u[1], command.u[2], static_cast<int32_t>(command.u[3]), command.u[4]);
+		break;
+	case RenderCommandType::ExecuteIndirect:
+		commandList->executeIndirect(CommandSignatureHandle{ command.u[0] }, command.u[1], ResourceHandle{ command.u[2] }, command.q[0]);
+		break;
+	case RenderCommandType::CopyBufferRegion:
+		commandList->copyBufferRegion(ResourceHandle{ command.u[0] }, command.q[0], ResourceHandle{ command.u[1] }, command.q[1], command.q[2]);
+		break;
+	case RenderCommandType::ExecuteCommandLists:
+		executeLists.clear();
+		for (uint32_t id : command.constants)
+		{
+			executeLists.push_back(commandLists.at(id - 1).get());
+		}
+		device.executeCommandLists(static_cast<QueueType>(command.u[0]), static_cast<uint32_t>(executeLists.size()), executeLists.data());
+		break;
+	case RenderCommandType::Signal:
+	case RenderCommandType::WaitForFence:
+	{
+		const FenceRange& range{ fenceRanges[command.u[2]] };
+		uint64_t value{ command.q[1] + pass * (range.lastSignal - range.firstSignal + 1) };
+		if (command.type == RenderCommandType::Signal)
+		{
+			device.signal(static_cast<QueueType>(command.u[1]), FenceHandle{ command.u[0] }, value);
+		}
+		else
+		{
+			device.waitForFence(FenceHandle{ command.u[0] }, value);
+		}
+		break;
+	}
+	case RenderCommandType::UpdateBuffer:
+	{
+		ResourceHandle buffer{ command.u[0] };
+		memcpy(static_cast<uint8_t*>(device.mapBuffer(buffer)) + command.q[0], command.data.data(), command.data.size());
+		device.unmapBuffer(buffer);
+		break;
+	}
+	case RenderCommandType::CopyDescriptors:
+		descriptorCopies.clear();
+		for (size_t i{ 0 }; i + 4 < command.constants.size(); i += 5)
+		{
+			descriptorCopies.push_back({ { DescriptorHeapHandle{ command.constants[i] }, command.constants[i + 1] }, { DescriptorHeapHandle{ command.constants[i + 2] }, command.constants[i + 3] }, command.constants[i + 4] });
+		}
+		device.copyDescriptors(static_cast<uint32_t>(descriptorCopies.size()), descriptorCopies.data());
+		break;
+	case RenderCommandType::Present:
+		device.present();
+		break;
+	default:
+		break;
+	}
+}
+
+ResourceHandle CommandStreamPlayer::resolveResource(uint32_t id) const
+{
+	for (uint32_t i{ 0 }; i < bufferCount; i++)
+	{
+		if (capture.backBuffers[i].id == id)
+		{
+			return device.getBackBuffer((i + backBufferShift) % bufferCount);
+		}
+	}
+
+	if (id >= resources.size() || !resources[id].isValid())
+	{
+		throw(runtime_error{ "Command capture references an unknown resource." });
+	}
+
+	return resources[id];
+}
+
+DescriptorHandle CommandStreamPlayer::resolveDescriptor(uint32_t heapId, uint32_t index) const
+{
+	for (uint32_t i{ 0 }; i < bufferCount; i++)
+	{
+		if (capture.backBufferRtvs[i].heap.id == heapId && capture.backBufferRtvs[i].index == index)
+		{
+			return device.getBackBufferRtv((i + backBufferShift) % bufferCount);
+		}
+	}
+
+	if (capture.depthStencilView.heap.id == heapId && capture.depthStencilView.index == index)
+	{
+		return device.getDepthStencilView();
+	}
+
+	if (heapId >= descriptorHeaps.size() || !descriptorHeaps[heapId].isValid())
+	{
+		throw(runtime_error{ "Command capture references an unknown descriptor heap." });
+	}
+
+	return{ descriptorHeaps[heapId], index };
+}
+
+uint64_t CommandStreamPlayer::resolveAddress(uint64_t address) const
+{
+	auto range = upper_bound(addressRanges.begin(), addressRanges.end(), address, [](uint64_t a, const AddressRange& r) { return a < r.begin; });
+	if (range == addressRanges.begin() || address >= (--range)->end)
+	{
+		throw(runtime_error{ "Command capture references an unknown GPU address." });
+	}
+
+	return device.getGpuVirtualAddress(range->buffer) + (address - range->begin);
+}
+
+uint64_t CommandStreamPlayer::resolveFenceValue(uint32_t fenceId, uint64_t value) const
+{
+	const FenceRange& range{ fenceRanges.at(fenceId) };
+	if (range.firstSignal == UINT64_MAX || value < range.firstSignal)
+	{
+		return 0;
+	}
+
+	return value - range.firstSignal + 1;
+}
\ No newline at end of file
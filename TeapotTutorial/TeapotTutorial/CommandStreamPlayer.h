@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "CommandCapture.h"
+
+// Replays a CommandCapture on any RenderDevice as fast as the device accepts it. The captured objects are
+// created once up front; handles, descriptors, GPU addresses, back buffers and fence values are translated
+// into the target's when the player is built, so replay() is a plain dispatch over the command stream and can
+// be used to profile command generation and submission in isolation.
+class CommandStreamPlayer
+{
+public:
+	CommandStreamPlayer(const CommandCapture& capture, RenderDevice& device);
+	~CommandStreamPlayer();
+
+	// Submits every captured frame once. May be called repeatedly; fence values keep increasing across passes.
+	void replay();
+
+	size_t getFrameCount() const;
+	size_t getCommandCount() const;
+
+private:
+	struct AddressRange
+	{
+		uint64_t begin;
+		uint64_t end;
+		ResourceHandle buffer;
+	};
+
+	struct FenceRange
+	{
+		uint64_t firstSignal;
+		uint64_t lastSignal;
+	};
+
+	void createObjects();
+	void resolveCommands();
+	void execute(const RecordedCommand& command);
+
+	ResourceHandle resolveResource(uint32_t id) const;
+	DescriptorHandle resolveDescriptor(uint32_t heapId, uint32_t index) const;
+	uint64_t resolveAddress(uint64_t address) const;
+	uint64_t resolveFenceValue(uint32_t fenceId, uint64_t value) const;
+
+private:
+	const CommandCapture& capture;
+	RenderDevice& device;
+	uint32_t bufferCount;
+
+	std::vector<ResourceHandle> resources;
+	std::vector<DescriptorHeapHandle> descriptorHeaps;
+	std::vector<RootSignatureHandle> rootSignatures;
+	std::vector<PipelineStateHandle> pipelineStates;
+	std::vector<CommandSignatureHandle> commandSignatures;
+	std::vector<FenceHandle> fences;
+	std::vector<FenceRange> fenceRanges;
+	std::vector<AddressRange> addressRanges;
+	std::vector<std::unique_ptr<RenderCommandList>> commandLists;
+
+	std::vector<RecordedCommand> commands;
+	uint32_t backBufferShift;
+	uint64_t pass{ 0 };
+	std::vector<RenderCommandList*> executeLists;
+	std::vector<DescriptorCopy> descriptorCopies;
+};
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "CpuRasterizer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	uint8_t toUnorm8(float value)
+	{
+		return static_cast<uint8_t>(max(0.0f, min(1.0f, value)) * 255.0f + 0.5f);
+	}
+}
+
+CpuRasterizer::CpuRasterizer(int width, int height) : width{ width }, height{ height }
+{
+	if (width <= 0 || height <= 0)
+	{
+		throw(runtime_error{ "Invalid rasterizer size." });
+	}
+
+	colorBuffer.resize(static_cast<size_t>(width) * height * 3);
+	depthBuffer.resize(static_cast<size_t>(width) * height);
+}
+
+void CpuRasterizer::clear(const XMFLOAT3& color, float depth)
+{
+	uint8_t rgb[3]{ toUnorm8(color.x), toUnorm8(color.y), toUnorm8(color.z) };
+	for (size_t i{ 0 }; i < depthBuffer.size(); i++)
+	{
+		colorBuffer[i * 3 + 0] = rgb[0];
+		colorBuffer[i * 3 + 1] = rgb[1];
+		colorBuffer[i * 3 + 2] = rgb[2];
+	}
+
+	fill(depthBuffer.begin(), depthBuffer.end(), depth);
+}
+
+void CpuRasterizer::drawMesh(const TessellatedMesh& mesh, FXMMATRIX mvp, const vector<XMFLOAT3>& patchColors)
+{
+	clipPositions.resize(mesh.positions.size());
+	for (size_t i{ 0 }; i < mesh.positions.size(); i++)
+	{
+		XMStoreFloat4(&clipPositions[i], XMVector3Transform(XMLoadFloat3(&mesh.positions[i]), mvp));
+	}
+
+	float halfWidth{ static_cast<float>(width) * 0.5f };
+	float halfHeight{ static_cast<float>(height) * 0.5f };
+
+	for (size_t t{ 0 }; t * 3 + 2 < mesh.indices.size(); t++)
+	{
+		ScreenVertex v[3];
+		bool clipped{ false };
+		for (int k{ 0 }; k < 3; k++)
+		{
+			const XMFLOAT4& c{ clipPositions[mesh.indices[t * 3 + k]] };
+			if (c.w <= FLT_EPSILON || c.z < 0.0f || c.z > c.w)
+			{
+				clipped = true;
+				break;
+			}
+
+			float invW{ 1.0f / c.w };
+			v[k].x = (c.x * invW + 1.0f) * halfWidth;
+			v[k].y = (1.0f - c.y * invW) * halfHeight;
+			v[k].z = c.z * invW;
+		}
+
+		if (clipped)
+		{
+			continue;
+		}
+
+		const XMFLOAT3& patchColor{ patchColors.at(mesh.trianglePatches[t]) };
+		uint8_t color[3]{ toUnorm8(patchColor.x), toUnorm8(patchColor.y), toUnorm8(patchColor.z) };
+		rasterizeTriangle(v[0], v[1], v[2], color);
+	}
+}
+
+void CpuRasterizer::rasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2, const uint8_t (&color)[3])
+{
+	float area{ (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x) };
+	if (fabs(area) <= FLT_EPSILON)
+	{
+		return;
+	}
+
+	float invArea{ 1.0f / area };
+
+	int x0{ max(0, static_cast<int>(floor(min(v0.x, min(v1.x, v2.x))))) };
+	int x1{ min(width - 1, static_cast<int>(ceil(max(v0.x, max(v1.x, v2.x))))) };
+	int y0{ max(0, static_cast<int>(floor(min(v0.y, min(v1.y, v2.y))))) };
+	int y1{ min(height - 1, static_cast<int>(ceil(max(v0.y, max(v1.y, v2.y))))) };
+
+	for (int y{ y0 }; y <= y1; y++)
+	{
+		float py{ static_cast<float>(y) + 0.5f };
+		for (int x{ x0 }; x <= x1; x++)
+		{
+			float px{ static_cast<float>(x) + 0.5f };
+
+			float w0{ ((v2.x - v1.x) * (py - v1.y) - (v2.y - v1.y) * (px - v1.x)) * invArea };
+			float w1{ ((v0.x - v2.x) * (py - v2.y) - (v0.y - v2.y) * (px - v2.x)) * invArea };
+			float w2{ 1.0f - w0 - w1 };
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+			{
+				continue;
+			}
+
+			size_t pixel{ static_cast<size_t>(y) * width + x };
+			float z{ w0 * v0.z + w1 * v1.z + w2 * v2.z };
+			if (!(z < depthBuffer[pixel]))
+			{
+				continue;
+			}
+
+			depthBuffer[pixel] = z;
+			colorBuffer[pixel * 3 + 0] = color[0];
+			colorBuffer[pixel * 3 + 1] = color[1];
+			colorBuffer[pixel * 3 + 2] = color[2];
+		}
+	}
+}
+
+int CpuRasterizer::getWidth() const
+{
+	return width;
+}
+
+int CpuRasterizer::getHeight() const
+{
+	return height;
+}
+
+const vector<uint8_t>& CpuRasterizer::getColorBuffer() const
+{
+	return colorBuffer;
+}
+
+const vector<float>& CpuRasterizer::getDepthBuffer() const
+{
+	return depthBuffer;
+}
\ No newline at end of file
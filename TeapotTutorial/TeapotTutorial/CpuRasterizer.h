@@ -0,0 +1,39 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include "PatchTessellator.h"
+
+// Reference rasterizer for tessellated patches: per-pixel interpolated depth with a LESS test and the flat
+// per-patch color the pixel shader outputs. Only used off-GPU, so it favours determinism over speed.
+class CpuRasterizer
+{
+public:
+	CpuRasterizer(int width, int height);
+
+	void clear(const DirectX::XMFLOAT3& color, float depth);
+	void drawMesh(const TessellatedMesh& mesh, DirectX::FXMMATRIX mvp, const std::vector<DirectX::XMFLOAT3>& patchColors);
+
+	int getWidth() const;
+	int getHeight() const;
+	const std::vector<uint8_t>& getColorBuffer() const;
+	const std::vector<float>& getDepthBuffer() const;
+
+private:
+	struct ScreenVertex
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	void rasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2, const uint8_t (&color)[3]);
+
+private:
+	int width;
+	int height;
+	std::vector<uint8_t> colorBuffer;
+	std::vector<float> depthBuffer;
+	std::vector<DirectX::XMFLOAT4> clipPositions;
+};
\ No newline at end of file
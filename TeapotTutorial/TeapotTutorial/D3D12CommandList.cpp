@@ -0,0 +1,179 @@
+#include "D3D12CommandList.h"
+#include <stdexcept>
+#include "Graphics.h"
+
+using namespace std;
+using namespace Microsoft::WRL;
+
+D3D12CommandList::D3D12CommandList(Graphics& graphics, QueueType queue) : graphics{ graphics }
+{
+	D3D12_COMMAND_LIST_TYPE type{ queue == QueueType::Copy ? D3D12_COMMAND_LIST_TYPE_COPY : D3D12_COMMAND_LIST_TYPE_DIRECT };
+
+	commandAllocators.resize(graphics.bufferCount);
+	for (ComPtr<ID3D12CommandAllocator>& commandAllocator : commandAllocators)
+	{
+		if (FAILED(graphics.device->CreateCommandAllocator(type, IID_PPV_ARGS(commandAllocator.ReleaseAndGetAddressOf()))))
+		{
+			throw(runtime_error{ "Error creating command allocator." });
+		}
+	}
+
+	if (FAILED(graphics.device->CreateCommandList(0, type, commandAllocators[0].Get(), nullptr, IID_PPV_ARGS(commandList.ReleaseAndGetAddressOf()))))
+	{
+		throw(runtime_error{ "Error creating command list." });
+	}
+
+	if (FAILED(commandList->Close()))
+	{
+		throw(runtime_error{ "Error closing command list." });
+	}
+}
+
+void D3D12CommandList::reset(uint32_t frameIndex)
+{
+	ComPtr<ID3D12CommandAllocator> commandAllocator{ commandAllocators.at(frameIndex) };
+
+	if (FAILED(commandAllocator->Reset()))
+	{
+		throw(runtime_error{ "Error resetting command allocator." });
+	}
+
+	if (FAILED(commandList->Reset(commandAllocator.Get(), nullptr)))
+	{
+		throw(runtime_error{ "Error resetting command list." });
+	}
+}
+
+void D3D12CommandList::close()
+{
+	if (FAILED(commandList->Close()))
+	{
+		throw(runtime_error{ "Failed closing command list." });
+	}
+}
+
+void D3D12CommandList::setPipelineState(PipelineStateHandle pipelineState)
+{
+	commandList->SetPipelineState(graphics.getPipelineState(pipelineState));
+}
+
+void D3D12CommandList::setGraphicsRootSignature(RootSignatureHandle rootSignature)
+{
+	commandList->SetGraphicsRootSignature(graphics.getRootSignature(rootSignature));
+}
+
+void D3D12CommandList::setViewport(const Viewport& viewport)
+{
+	D3D12_VIEWPORT d3dViewport{ viewport.topLeftX, viewport.topLeftY, viewport.width, viewport.height, viewport.minDepth, viewport.maxDepth };
+	commandList->RSSetViewports(1, &d3dViewport);
+}
+
+void D3D12CommandList::setScissorRect(const ScissorRect& scissorRect)
+{
+	D3D12_RECT d3dRect{ scissorRect.left, scissorRect.top, scissorRect.right, scissorRect.bottom };
+	commandList->RSSetScissorRects(1, &d3dRect);
+}
+
+void D3D12CommandList::resourceBarrier(uint32_t numBarriers, const ResourceBarrier* barriers)
+{
+	barrierDescs.resize(numBarriers);
+	for (uint32_t i{ 0 }; i < numBarriers; i++)
+	{
+		D3D12_RESOURCE_BARRIER& barrierDesc{ barrierDescs[i] };
+		ZeroMemory(&barrierDesc, sizeof(barrierDesc));
+		barrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+		barrierDesc.Transition.pResource = graphics.getResource(barriers[i].resource);
+		barrierDesc.Transition.Subresource = barriers[i].subresource;
+		barrierDesc.Transition.StateBefore = teapot_tutorial::toD3D12ResourceState(barriers[i].stateBefore);
+		barrierDesc.Transition.StateAfter = teapot_tutorial::toD3D12ResourceState(barriers[i].stateAfter);
+		barrierDesc.Flags =
+			barriers[i].flags == BarrierFlags::BeginOnly ? D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY :
+			barriers[i].flags == BarrierFlags::EndOnly ? D3D12_RESOURCE_BARRIER_FLAG_END_ONLY :
+			D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	}
+
+	commandList->ResourceBarrier(numBarriers, barrierDescs.data());
+}
+
+void D3D12CommandList::setRenderTarget(const DescriptorHandle& rtv, const DescriptorHandle* dsv)
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE descHandleRtv(graphics.getCpuDescriptor(rtv));
+
+	if (dsv != nullptr)
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE descHandleDepthStencil(graphics.getCpuDescriptor(*dsv));
+		commandList->OMSetRenderTargets(1, &descHandleRtv, FALSE, &descHandleDepthStencil);
+	}
+	else
+	{
+		commandList->OMSetRenderTargets(1, &descHandleRtv, FALSE, nullptr);
+	}
+}
+
+void D3D12CommandList::clearRenderTarget(const DescriptorHandle& rtv, const float (&color)[4])
+{
+	commandList->ClearRenderTargetView(graphics.getCpuDescriptor(rtv), color, 0, nullptr);
+}
+
+void D3D12CommandList::clearDepth(const DescriptorHandle& dsv, float depth)
+{
+	commandList->ClearDepthStencilView(graphics.getCpuDescriptor(dsv), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+}
+
+void D3D12CommandList::setPrimitiveTopology(PrimitiveTopology topology)
+{
+	commandList->IASetPrimitiveTopology(teapot_tutorial::toD3D12PrimitiveTopology(topology));
+}
+
+void D3D12CommandList::setVertexBuffer(uint32_t slot, const VertexBufferView& view)
+{
+	D3D12_VERTEX_BUFFER_VIEW d3dView{ view.bufferLocation, view.sizeInBytes, view.strideInBytes };
+	commandList->IASetVertexBuffers(slot, 1, &d3dView);
+}
+
+void D3D12CommandList::setIndexBuffer(const IndexBufferView& view)
+{
+	D3D12_INDEX_BUFFER_VIEW d3dView{ view.bufferLocation, view.sizeInBytes, teapot_tutorial::toD3D12Format(view.format) };
+	commandList->IASetIndexBuffer(&d3dView);
+}
+
+void D3D12CommandList::setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValues, const void* data, uint32_t destOffset)
+{
+	commandList->SetGraphicsRoot32BitConstants(rootParameterIndex, num32BitValues, data, destOffset);
+}
+
+void D3D12CommandList::setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation)
+{
+	commandList->SetGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+}
+
+void D3D12CommandList::setDescriptorHeap(DescriptorHeapHandle heap)
+{
+	ID3D12DescriptorHeap* ppHeaps[] = { graphics.getDescriptorHeap(heap) };
+	commandList->SetDescriptorHeaps(1, ppHeaps);
+}
+
+void D3D12CommandList::setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, const DescriptorHandle& baseDescriptor)
+{
+	commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, graphics.getGpuDescriptor(baseDescriptor));
+}
+
+void D3D12CommandList::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+{
+	commandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+}
+
+void D3D12CommandList::executeIndirect(CommandSignatureHandle commandSignature, uint32_t maxCommandCount, ResourceHandle argumentBuffer, uint64_t argumentBufferOffset)
+{
+	commandList->ExecuteIndirect(graphics.getCommandSignature(commandSignature), maxCommandCount, graphics.getResource(argumentBuffer), argumentBufferOffset, nullptr, 0);
+}
+
+void D3D12CommandList::copyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes)
+{
+	commandList->CopyBufferRegion(graphics.getResource(dst), dstOffset, graphics.getResource(src), srcOffset, numBytes);
+}
+
+ID3D12GraphicsCommandList* D3D12CommandList::getCommandList() const
+{
+	return commandList.Get();
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <vector>
+#include "RenderDevice.h"
+
+class Graphics;
+
+// RenderCommandList recording into a direct or copy ID3D12GraphicsCommandList. Handles are resolved through
+// the owning Graphics device at record time.
+class D3D12CommandList : public RenderCommandList
+{
+public:
+	D3D12CommandList(Graphics& graphics, QueueType queue);
+
+	void reset(uint32_t frameIndex) override;
+	void close() override;
+
+	void setPipelineState(PipelineStateHandle pipelineState) override;
+	void setGraphicsRootSignature(RootSignatureHandle rootSignature) override;
+	void setViewport(const Viewport& viewport) override;
+	void setScissorRect(const ScissorRect& scissorRect) override;
+	void resourceBarrier(uint32_t numBarriers, const ResourceBarrier* barriers) override;
+	void setRenderTarget(const DescriptorHandle& rtv, const DescriptorHandle* dsv) override;
+	void clearRenderTarget(const DescriptorHandle& rtv, const float (&color)[4]) override;
+	void clearDepth(const DescriptorHandle& dsv, float depth) override;
+	void setPrimitiveTopology(PrimitiveTopology topology) override;
+	void setVertexBuffer(uint32_t slot, const VertexBufferView& view) override;
+	void setIndexBuffer(const IndexBufferView& view) override;
+	void setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValues, const void* data, uint32_t destOffset) override;
+	void setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation) override;
+	void setDescriptorHeap(DescriptorHeapHandle heap) override;
+	void setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, const DescriptorHandle& baseDescriptor) override;
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+	void executeIndirect(CommandSignatureHandle commandSignature, uint32_t maxCommandCount, ResourceHandle argumentBuffer, uint64_t argumentBufferOffset) override;
+	void copyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes) override;
+
+	ID3D12GraphicsCommandList* getCommandList() const;
+
+private:
+	Graphics& graphics;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> commandAllocators;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
+	std::vector<D3D12_RESOURCE_BARRIER> barrierDescs;
+};
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "DescriptorAllocator.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+DescriptorAllocator::DescriptorAllocator(RenderDevice& device, uint32_t persistentCount, uint32_t transientCount) : device{ device }, persistentCount{ persistentCount }, persistentRegion{ persistentCount }, transientRing{ transientCount }
+{
+	heap = device.createDescriptorHeap({ DescriptorHeapType::CbvSrvUav, persistentCount + transientCount, true });
+	stagingHeap = device.createDescriptorHeap({ DescriptorHeapType::CbvSrvUav, persistentCount, false });
+	fence = device.createFence(0);
+	memset(&stats, 0, sizeof(stats));
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	if (fenceValue > 0)
+	{
+		device.waitForFence(fence, fenceValue);
+	}
+}
+
+DescriptorHeapHandle DescriptorAllocator::getHeap() const
+{
+	return heap;
+}
+
+DescriptorAllocator::Range DescriptorAllocator::allocatePersistent(uint32_t count)
+{
+	releaseCompleted();
+
+	uint64_t first{ persistentRegion.allocate(count, 1) };
+	if (first == TlsfAllocator::invalidOffset)
+	{
+		throw(runtime_error{ "Persistent descriptor region is full." });
+	}
+
+	++stats.persistentRanges;
+	stats.persistentDescriptors += count;
+	uint32_t index{ static_cast<uint32_t>(first) };
+	return{ { heap, index }, { stagingHeap, index }, count };
+}
+
+void DescriptorAllocator::freePersistent(const Range& range)
+{
+	// Frames already submitted may still read the descriptors; they go back to the free list once the end of
+	// the current frame has passed.
+	pendingFrees.push_back({ fenceValue + 1, range.gpu.index });
+	--stats.persistentRanges;
+	stats.persistentDescriptors -= range.count;
+}
+
+void DescriptorAllocator::createShaderResourceView(const Range& range, uint32_t index, ResourceHandle buffer, const ShaderResourceViewDesc& desc)
+{
+	if (index >= range.count)
+	{
+		throw(runtime_error{ "Descriptor index out of range." });
+	}
+
+	DescriptorHandle staging{ range.staging.heap, range.staging.index + index };
+	device.createShaderResourceView(buffer, desc, staging);
+	queueCopy({ range.gpu.heap, range.gpu.index + index }, staging, 1);
+}
+
+DescriptorHandle DescriptorAllocator::allocateTable(uint32_t count, const DescriptorHandle* sources)
+{
+	while (true)
+	{
+		transientRing.release(device.getCompletedValue(fence));
+
+		uint64_t offset{ transientRing.allocate(count, 1) };
+		if (offset != LinearRingAllocator::invalidOffset)
+		{
+			DescriptorHandle table{ heap, persistentCount + static_cast<uint32_t>(offset) };
+			for (uint32_t i{ 0 }; i < count; i++)
+			{
+				queueCopy({ heap, table.index + i }, sources[i], 1);
+			}
+
+			++stats.tables;
+			stats.transientDescriptors += count;
+			return table;
+		}
+
+		if (!transientRing.hasRetiredRanges())
+		{
+			throw(runtime_error{ "Descriptor ring is too small for one frame." });
+		}
+
+		++stats.stalls;
+		device.waitForFence(fence, transientRing.getOldestFenceValue());
+	}
+}
+
+void DescriptorAllocator::flush()
+{
+	if (pendingCopies.empty())
+	{
+		return;
+	}
+
+	device.copyDescriptors(static_cast<uint32_t>(pendingCopies.size()), pendingCopies.data());
+	stats.copyRanges += pendingCopies.size();
+	++stats.copyBatches;
+	pendingCopies.clear();
+}
+
+void DescriptorAllocator::endFrame(QueueType queue)
+{
+	device.signal(queue, fence, ++fenceValue);
+	transientRing.retire(fenceValue);
+}
+
+const DescriptorAllocator::Stats& DescriptorAllocator::getStats() const
+{
+	return stats;
+}
+
+void DescriptorAllocator::resetStats()
+{
+	// The persistent counts describe what is allocated, not what happened since the last reset.
+	uint32_t persistentDescriptors{ stats.persistentDescriptors };
+	uint32_t persistentRanges{ stats.persistentRanges };
+	memset(&stats, 0, sizeof(stats));
+	stats.persistentDescriptors = persistentDescriptors;
+	stats.persistentRanges = persistentRanges;
+}
+
+void DescriptorAllocator::queueCopy(const DescriptorHandle& dst, const DescriptorHandle& src, uint32_t count)
+{
+	stats.descriptorsCopied += count;
+
+	if (!pendingCopies.empty())
+	{
+		DescriptorCopy& last{ pendingCopies.back() };
+		if (last.dst.heap == dst.heap && last.dst.index + last.numDescriptors == dst.index && last.src.heap == src.heap && last.src.index + last.numDescriptors == src.index)
+		{
+			last.numDescriptors += count;
+			return;
+		}
+	}
+
+	pendingCopies.push_back({ dst, src, count });
+}
+
+void DescriptorAllocator::releaseCompleted()
+{
+	uint64_t completedValue{ device.getCompletedValue(fence) };
+	while (!pendingFrees.empty() && pendingFrees.front().fenceValue <= completedValue)
+	{
+		persistentRegion.free(pendingFrees.front().first);
+		pendingFrees.pop_front();
+	}
+}
\ No newline at end of file
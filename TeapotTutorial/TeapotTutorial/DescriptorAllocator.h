@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "TlsfAllocator.h"
+#include "LinearRingAllocator.h"
+
+// One shader visible CBV/SRV/UAV heap for everything a frame draws, so command lists never switch heaps. The
+// first persistentCount descriptors form a free list region for views that live as long as their objects; the
+// rest is a ring of per frame regions for tables assembled every frame, reused once the GPU has passed the
+// frame like UploadRing's blocks.
+//
+// Views are never written into the shader visible heap directly. Persistent views are created in a non shader
+// visible staging heap mirroring the persistent region, transient tables are assembled from staging
+// descriptors, and flush() copies everything pending with one copyDescriptors call. Only descriptor indices are
+// managed on the CPU, so with the null device the allocator runs without a GPU.
+class DescriptorAllocator
+{
+public:
+	struct Range
+	{
+		bool isValid() const { return count != 0; }
+
+		// Where the range is bound from and where its views are written.
+		DescriptorHandle gpu;
+		DescriptorHandle staging;
+		uint32_t count;
+	};
+
+	struct Stats
+	{
+		// Currently allocated; the other counters accumulate until resetStats().
+		uint32_t persistentDescriptors;
+		uint32_t persistentRanges;
+		uint64_t transientDescriptors;
+		uint64_t tables;
+		uint64_t descriptorsCopied;
+		uint64_t copyRanges;
+		uint64_t copyBatches;
+		uint64_t stalls;
+	};
+
+	DescriptorAllocator(RenderDevice& device, uint32_t persistentCount, uint32_t transientCount);
+	~DescriptorAllocator();
+
+	DescriptorAllocator(const DescriptorAllocator&) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+	DescriptorHeapHandle getHeap() const;
+
+	// Throws when the persistent region is full.
+	Range allocatePersistent(uint32_t count);
+	// The descriptors are reused after the GPU has finished the frames submitted so far.
+	void freePersistent(const Range& range);
+	// Writes the view to the staging heap and queues its copy into the shader visible heap.
+	void createShaderResourceView(const Range& range, uint32_t index, ResourceHandle buffer, const ShaderResourceViewDesc& desc);
+
+	// Copies count descriptors of non shader visible heaps (usually Range::staging of persistent ranges) into a
+	// contiguous table of the current frame and returns the table's start. Consecutive sources are copied as
+	// one range.
+	DescriptorHandle allocateTable(uint32_t count, const DescriptorHandle* sources);
+
+	// Issues the pending copies. Call before executing command lists that bind descriptors written since the
+	// last flush.
+	void flush();
+	// Call after the lists that use this frame's tables were executed on queue.
+	void endFrame(QueueType queue);
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct PendingFree
+	{
+		uint64_t fenceValue;
+		uint32_t first;
+	};
+
+	void queueCopy(const DescriptorHandle& dst, const DescriptorHandle& src, uint32_t count);
+	void releaseCompleted();
+
+private:
+	RenderDevice& device;
+	uint32_t persistentCount;
+	DescriptorHeapHandle heap;
+	DescriptorHeapHandle stagingHeap;
+	TlsfAllocator persistentRegion;
+	LinearRingAllocator transientRing;
+	FenceHandle fence;
+	uint64_t fenceValue{ 0 };
+	std::deque<PendingFree> pendingFrees;
+	std::vector<DescriptorCopy> pendingCopies;
+	Stats stats;
+};
\ No newline at end of file
@@ -4,7 +4,8 @@
 
 struct ConstantBufferPerObj
 {
-	row_major float4x4 wvpMat;
+	// Where this frame's matrices start in instanceMatrices.
+	uint firstInstanceMatrix;
 };
 ConstantBuffer<ConstantBufferPerObj> constPerObject : register(b0);
 
@@ -20,6 +21,30 @@ struct PatchColor
 };
 StructuredBuffer<PatchColor> patchColors : register(t1);
 
+// Every drawn instance's transform premultiplied by the model, view and projection matrices, in instance order,
+// written to the upload ring every frame.
+struct InstanceMatrix
+{
+	row_major float4x4 transform;
+};
+StructuredBuffer<InstanceMatrix> instanceMatrices : register(t2);
+
+struct InstanceColor
+{
+	float4 color;
+};
+StructuredBuffer<InstanceColor> instanceColors : register(t3);
+
+// Draws cover ranges of the instance order, sorted by level of detail.
+StructuredBuffer<uint> instanceOrder : register(t4);
+
+struct PatchOffset
+{
+	uint first;
+	uint firstInstance;
+};
+ConstantBuffer<PatchOffset> patchOffset : register(b1);
+
 struct PatchConstantData
 {
 	float edgeTessFactor[4] : SV_TessFactor;
@@ -29,6 +54,7 @@ struct PatchConstantData
 struct HullToDomain
 {
 	float3 pos : POSITION;
+	uint instance : INSTANCE;
 };
 
 struct DomainToPixel
@@ -67,12 +93,18 @@ DomainToPixel main(PatchConstantData input, float2 domain : SV_DomainLocation, c
 	// Evaluate the surface position for this vertex
 	float3 localPos = evaluateBezier(patch, basisU, basisV);
 
-	float4x4 transform = patchTransforms[patchID].transform;
+	uint globalPatchID = patchOffset.first + patchID;
+
+	// SV_InstanceID is only a vertex shader input; the hull shader passes it on with every control point.
+	uint orderIndex = patchOffset.firstInstance + patch[0].instance;
+	uint instanceID = instanceOrder[orderIndex];
+
+	float4x4 transform = patchTransforms[globalPatchID].transform;
 	float4 localPosTransformed = mul(float4(localPos, 1.0f), transform);
 
 	DomainToPixel output;
-	output.pos = mul(localPosTransformed, constPerObject.wvpMat);
-	output.color = patchColors[patchID].color;
+	output.pos = mul(localPosTransformed, instanceMatrices[constPerObject.firstInstanceMatrix + orderIndex].transform);
+	output.color = patchColors[globalPatchID].color * instanceColors[instanceID].color.rgb;
 
 	return output;
 }
\ No newline at end of file
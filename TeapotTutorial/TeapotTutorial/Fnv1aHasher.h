@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// 64 bit FNV-1a, for keys that must be the same in every run, such as cache file entries and content
+// addresses. Variable length values are preceded by their length, so moving bytes between neighboring values
+// changes the hash.
+class Fnv1aHasher
+{
+public:
+	void add(const void* data, size_t size)
+	{
+		const uint8_t* p{ static_cast<const uint8_t*>(data) };
+		for (size_t i{ 0 }; i < size; i++)
+		{
+			hash = (hash ^ p[i]) * 1099511628211ull;
+		}
+	}
+
+	void add(uint64_t value)
+	{
+		add(&value, sizeof(value));
+	}
+
+	void add(const std::string& value)
+	{
+		add(static_cast<uint64_t>(value.size()));
+		add(value.data(), value.size());
+	}
+
+	void add(const std::vector<uint8_t>& value)
+	{
+		add(static_cast<uint64_t>(value.size()));
+		add(value.data(), value.size());
+	}
+
+	uint64_t get() const
+	{
+		return hash;
+	}
+
+	static uint64_t hashBytes(const void* data, size_t size)
+	{
+		Fnv1aHasher hasher;
+		hasher.add(data, size);
+		return hasher.get();
+	}
+
+private:
+	uint64_t hash{ 14695981039346656037ull };
+};
\ No newline at end of file
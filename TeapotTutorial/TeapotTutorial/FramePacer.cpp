@@ -0,0 +1,111 @@
+#include "FramePacer.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+FramePacer::FramePacer(RenderDevice& device, uint32_t maxFramesInFlight) : device{ device }, backBufferFrames(device.getBufferCount(), 0)
+{
+	fence = device.createFence(0);
+	setMaxFramesInFlight(maxFramesInFlight);
+	resetStats();
+}
+
+FramePacer::~FramePacer()
+{
+	waitForFrame(frame - 1);
+}
+
+void FramePacer::setMaxFramesInFlight(uint32_t maxFramesInFlight)
+{
+	// More frames than back buffers cannot be queued: present blocks on the swap chain first.
+	if (maxFramesInFlight == 0 || maxFramesInFlight > backBufferFrames.size())
+	{
+		throw(runtime_error{ "Frames in flight must be between 1 and the back buffer count." });
+	}
+
+	this->maxFramesInFlight = maxFramesInFlight;
+}
+
+uint32_t FramePacer::getMaxFramesInFlight() const
+{
+	return maxFramesInFlight;
+}
+
+void FramePacer::setMode(Mode mode)
+{
+	this->mode = mode;
+}
+
+FramePacer::Mode FramePacer::getMode() const
+{
+	return mode;
+}
+
+void FramePacer::beginFrame()
+{
+	if (frameBegun)
+	{
+		return;
+	}
+
+	backBuffer = device.getCurrentBackBufferIndex();
+	uint64_t allowedFrame{ frame > maxFramesInFlight ? frame - maxFramesInFlight : 0 };
+	uint64_t backBufferFrame{ backBufferFrames[backBuffer] };
+	waitForFrame(allowedFrame > backBufferFrame ? allowedFrame : backBufferFrame);
+	frameBegun = true;
+}
+
+void FramePacer::endFrame(QueueType queue)
+{
+	if (!frameBegun)
+	{
+		throw(runtime_error{ "Frame ended without being begun." });
+	}
+
+	device.signal(queue, fence, frame);
+	backBufferFrames[backBuffer] = frame;
+	++frame;
+	++stats.frames;
+	frameBegun = false;
+
+	// The back buffer index has moved on with the present, so the next frame's buffer is known here.
+	if (mode == Mode::Throughput)
+	{
+		beginFrame();
+	}
+}
+
+uint64_t FramePacer::getFrame() const
+{
+	return frame;
+}
+
+uint64_t FramePacer::getCompletedFrame()
+{
+	return device.getCompletedValue(fence);
+}
+
+const FramePacer::Stats& FramePacer::getStats() const
+{
+	return stats;
+}
+
+void FramePacer::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void FramePacer::waitForFrame(uint64_t frame)
+{
+	if (frame == 0 || device.getCompletedValue(fence) >= frame)
+	{
+		return;
+	}
+
+	auto begin{ chrono::steady_clock::now() };
+	device.waitForFence(fence, frame);
+	++stats.waits;
+	stats.waitMilliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "RenderDevice.h"
+
+// Paces the CPU against the GPU with one timeline fence that is signaled with the frame number after every
+// frame's submission. At most maxFramesInFlight frames are queued; the limit is independent of the swap
+// chain's buffer count, except that a frame also waits for the last frame that rendered to the same back
+// buffer, whose command allocators it is about to reset.
+//
+// Where the CPU waits depends on the mode. Throughput waits right after present, so the next frame's work is
+// ready to start as soon as a slot frees up. LowLatency waits in beginFrame(), which the application calls
+// before it samples input, so the input a frame is rendered with is no older than the wait.
+class FramePacer
+{
+public:
+	enum class Mode
+	{
+		Throughput,
+		LowLatency
+	};
+
+	struct Stats
+	{
+		uint64_t frames;
+		uint64_t waits;
+		double waitMilliseconds;
+	};
+
+	FramePacer(RenderDevice& device, uint32_t maxFramesInFlight);
+	~FramePacer();
+
+	// Between 1 and the swap chain's buffer count.
+	void setMaxFramesInFlight(uint32_t maxFramesInFlight);
+	uint32_t getMaxFramesInFlight() const;
+	void setMode(Mode mode);
+	Mode getMode() const;
+
+	// Waits until the next frame may be recorded. Calling it again before endFrame() does nothing, so
+	// TeapotRenderer::render() calls it in case the application did not.
+	void beginFrame();
+	// Signals the frame after its lists were executed on queue and it was presented.
+	void endFrame(QueueType queue);
+
+	// Number of the frame being recorded; frames up to getCompletedFrame() have finished on the GPU.
+	uint64_t getFrame() const;
+	uint64_t getCompletedFrame();
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	void waitForFrame(uint64_t frame);
+
+private:
+	RenderDevice& device;
+	FenceHandle fence;
+	uint64_t frame{ 1 };
+	uint32_t maxFramesInFlight;
+	Mode mode{ Mode::Throughput };
+	bool frameBegun{ false };
+	uint32_t backBuffer{ 0 };
+	// Frame number last rendered to each back buffer.
+	std::vector<uint64_t> backBufferFrames;
+	Stats stats;
+};
\ No newline at end of file
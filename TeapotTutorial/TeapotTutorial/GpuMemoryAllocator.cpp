@@ -0,0 +1,190 @@
+#include "GpuMemoryAllocator.h"
+#include <stdexcept>
+
+using namespace std;
+
+GpuMemoryAllocator::GpuMemoryAllocator(RenderDevice& device, uint64_t heapSize) : device{ device }, heapSize{ heapSize }
+{
+	if (heapSize == 0 || heapSize % placedResourceAlignment != 0)
+	{
+		throw(runtime_error{ "GPU heap size has to be a multiple of the placed resource alignment." });
+	}
+}
+
+GpuMemoryAllocator::~GpuMemoryAllocator()
+{
+	for (Heap& heap : heaps)
+	{
+		if (heap.poolCpuAddress != nullptr)
+		{
+			device.unmapBuffer(heap.poolBuffer);
+		}
+	}
+}
+
+GpuMemoryAllocator::Allocation GpuMemoryAllocator::allocateBuffer(const BufferDesc& desc, uint64_t alignment)
+{
+	if (desc.size == 0 || alignment == 0)
+	{
+		throw(runtime_error{ "Invalid GPU buffer allocation." });
+	}
+
+	bool placed{ desc.size >= placedResourceAlignment };
+	Allocation allocation;
+	for (uint32_t i{ 0 }; i < heaps.size(); i++)
+	{
+		if (heaps[i].heapType == desc.heapType && heaps[i].placed == placed && allocateFrom(i, desc, alignment, allocation))
+		{
+			return allocation;
+		}
+	}
+
+	uint64_t size{ heapSize };
+	if (desc.size > heapSize)
+	{
+		size = (desc.size + placedResourceAlignment - 1) / placedResourceAlignment * placedResourceAlignment;
+	}
+
+	if (!allocateFrom(createHeap(desc.heapType, placed, size), desc, alignment, allocation))
+	{
+		throw(runtime_error{ "GPU buffer does not fit into a new heap." });
+	}
+
+	return allocation;
+}
+
+void GpuMemoryAllocator::free(const Allocation& allocation)
+{
+	Heap& heap{ heaps.at(allocation.heap) };
+	heap.allocator->free(allocation.heapOffset);
+	if (allocation.placed)
+	{
+		if (allocation.cpuAddress != nullptr)
+		{
+			device.unmapBuffer(allocation.buffer);
+		}
+
+		device.releaseResource(allocation.buffer);
+		--placedBuffers;
+	}
+	else
+	{
+		--bufferRanges;
+	}
+}
+
+GpuMemoryAllocator::Stats GpuMemoryAllocator::getStats() const
+{
+	Stats stats{ static_cast<uint32_t>(heaps.size()), 0, 0, placedBuffers, bufferRanges };
+	for (const Heap& heap : heaps)
+	{
+		TlsfAllocator::Stats heapStats{ heap.allocator->getStats() };
+		stats.reservedBytes += heapStats.size;
+		stats.allocatedBytes += heapStats.allocatedBytes;
+	}
+
+	return stats;
+}
+
+GpuMemoryAllocator::DefragmentationStats GpuMemoryAllocator::getDefragmentationStats() const
+{
+	DefragmentationStats stats{ 0, 0, 0, 0.0, 0, 0 };
+	for (const Heap& heap : heaps)
+	{
+		TlsfAllocator::Stats heapStats{ heap.allocator->getStats() };
+		stats.freeBytes += heapStats.freeBytes;
+		stats.freeBlocks += heapStats.freeBlocks;
+		if (heapStats.largestFreeBlock > stats.largestFreeBlock)
+		{
+			stats.largestFreeBlock = heapStats.largestFreeBlock;
+		}
+
+		if (heapStats.allocatedBytes > 0 && heapStats.allocatedBytes * 2 < heapStats.size)
+		{
+			++stats.sparseHeaps;
+			stats.movableBytes += heapStats.allocatedBytes;
+		}
+	}
+
+	if (stats.freeBytes > 0)
+	{
+		stats.fragmentation = 1.0 - static_cast<double>(stats.largestFreeBlock) / static_cast<double>(stats.freeBytes);
+	}
+
+	return stats;
+}
+
+uint32_t GpuMemoryAllocator::createHeap(HeapType heapType, bool placed, uint64_t size)
+{
+	Heap heap;
+	heap.handle = device.createHeap({ size, heapType });
+	heap.heapType = heapType;
+	heap.placed = placed;
+	heap.poolGpuAddress = 0;
+	heap.poolCpuAddress = nullptr;
+	heap.allocator.reset(new TlsfAllocator{ size });
+
+	if (!placed)
+	{
+		// Default pool buffers stay in Common so copy queue uploads and direct queue reads can promote them.
+		ResourceState state{ heapType == HeapType::Upload ? ResourceState::GenericRead : ResourceState::Common };
+		heap.poolBuffer = device.createPlacedBuffer(heap.handle, 0, { size, heapType, state, "buffer pool" });
+		heap.poolGpuAddress = device.getGpuVirtualAddress(heap.poolBuffer);
+		if (heapType == HeapType::Upload)
+		{
+			heap.poolCpuAddress = static_cast<uint8_t*>(device.mapBuffer(heap.poolBuffer));
+		}
+	}
+
+	heaps.push_back(move(heap));
+	return static_cast<uint32_t>(heaps.size() - 1);
+}
+
+bool GpuMemoryAllocator::allocateFrom(uint32_t heapIndex, const BufferDesc& desc, uint64_t alignment, Allocation& allocation)
+{
+	Heap& heap{ heaps[heapIndex] };
+	if (heap.placed)
+	{
+		// A placed buffer is used from offset 0, which meets any alignment. Rounding the size up keeps the next
+		// placed buffer of the heap on a 64 KB boundary.
+		uint64_t size{ (desc.size + placedResourceAlignment - 1) / placedResourceAlignment * placedResourceAlignment };
+		uint64_t heapOffset{ heap.allocator->allocate(size, placedResourceAlignment) };
+		if (heapOffset == TlsfAllocator::invalidOffset)
+		{
+			return false;
+		}
+
+		BufferDesc placedDesc{ desc };
+		if (desc.heapType == HeapType::Default)
+		{
+			placedDesc.initialState = ResourceState::Common;
+		}
+
+		allocation.buffer = device.createPlacedBuffer(heap.handle, heapOffset, placedDesc);
+		allocation.offset = 0;
+		allocation.gpuAddress = device.getGpuVirtualAddress(allocation.buffer);
+		allocation.cpuAddress = desc.heapType == HeapType::Upload ? static_cast<uint8_t*>(device.mapBuffer(allocation.buffer)) : nullptr;
+		allocation.heapOffset = heapOffset;
+		++placedBuffers;
+	}
+	else
+	{
+		uint64_t heapOffset{ heap.allocator->allocate(desc.size, alignment) };
+		if (heapOffset == TlsfAllocator::invalidOffset)
+		{
+			return false;
+		}
+
+		allocation.buffer = heap.poolBuffer;
+		allocation.offset = heapOffset;
+		allocation.gpuAddress = heap.poolGpuAddress + heapOffset;
+		allocation.cpuAddress = heap.poolCpuAddress != nullptr ? heap.poolCpuAddress + heapOffset : nullptr;
+		allocation.heapOffset = heapOffset;
+		++bufferRanges;
+	}
+
+	allocation.size = desc.size;
+	allocation.heap = heapIndex;
+	allocation.placed = heap.placed;
+	return true;
+}
\ No newline at end of file
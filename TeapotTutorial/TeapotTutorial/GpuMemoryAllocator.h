@@ -0,0 +1,93 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "TlsfAllocator.h"
+
+// Suballocates buffers from a few large heaps instead of creating one committed resource per buffer. Each heap is
+// managed by a TlsfAllocator. Buffers of at least placedResourceAlignment bytes become placed resources at 64 KB
+// aligned offsets; smaller ones share a single buffer placed over a whole heap and get a range of it, so they do
+// not each waste most of a 64 KB page. Buffers larger than the heap size get a heap of their own.
+//
+// Heaps are kept for the lifetime of the allocator. With the null device as the RenderDevice this runs without a
+// GPU, which is how the allocation patterns of a frame can be checked for overlaps and fragmentation.
+class GpuMemoryAllocator
+{
+public:
+	struct Allocation
+	{
+		bool isValid() const { return buffer.isValid(); }
+
+		// The buffer to bind, copy to or create views of, and where in it the allocation starts.
+		ResourceHandle buffer;
+		uint64_t offset;
+		uint64_t size;
+		uint64_t gpuAddress;
+		// Only set for upload heap allocations, which stay mapped.
+		uint8_t* cpuAddress;
+		uint32_t heap;
+		uint64_t heapOffset;
+		bool placed;
+	};
+
+	struct Stats
+	{
+		uint32_t heaps;
+		uint64_t reservedBytes;
+		uint64_t allocatedBytes;
+		uint32_t placedBuffers;
+		uint32_t bufferRanges;
+	};
+
+	struct DefragmentationStats
+	{
+		uint64_t freeBytes;
+		uint64_t largestFreeBlock;
+		uint32_t freeBlocks;
+		// 0 when the free space of every heap is a single block, see TlsfAllocator::getFragmentation().
+		double fragmentation;
+		// Heaps less than half full and the bytes allocated in them; moving those allocations elsewhere would
+		// let the heaps be released.
+		uint32_t sparseHeaps;
+		uint64_t movableBytes;
+	};
+
+	GpuMemoryAllocator(RenderDevice& device, uint64_t heapSize);
+	~GpuMemoryAllocator();
+
+	GpuMemoryAllocator(const GpuMemoryAllocator&) = delete;
+	GpuMemoryAllocator& operator=(const GpuMemoryAllocator&) = delete;
+
+	// Buffers in default heaps start in ResourceState::Common whatever desc.initialState says, because ranges of
+	// one buffer cannot have states of their own. Alignment may be any non zero value, e.g. a structure stride.
+	Allocation allocateBuffer(const BufferDesc& desc, uint64_t alignment);
+	// The GPU must be done with the allocation.
+	void free(const Allocation& allocation);
+
+	Stats getStats() const;
+	DefragmentationStats getDefragmentationStats() const;
+
+private:
+	struct Heap
+	{
+		HeapHandle handle;
+		HeapType heapType;
+		bool placed;
+		ResourceHandle poolBuffer;
+		uint64_t poolGpuAddress;
+		uint8_t* poolCpuAddress;
+		std::unique_ptr<TlsfAllocator> allocator;
+	};
+
+	uint32_t createHeap(HeapType heapType, bool placed, uint64_t size);
+	bool allocateFrom(uint32_t heap, const BufferDesc& desc, uint64_t alignment, Allocation& allocation);
+
+private:
+	RenderDevice& device;
+	uint64_t heapSize;
+	std::vector<Heap> heaps;
+	uint32_t placedBuffers{ 0 };
+	uint32_t bufferRanges{ 0 };
+};
\ No newline at end of file
@@ -1,10 +1,99 @@
 #include "Graphics.h"
 #include <stdexcept>
 #include "Window.h"
+#include "D3D12CommandList.h"
+#include "UploadManager.h"
 
 using namespace std;
 using namespace Microsoft::WRL;
 
+namespace
+{
+	DXGI_FORMAT toDxgiFormat(Format format)
+	{
+		switch (format)
+		{
+		case Format::R32Uint: return DXGI_FORMAT_R32_UINT;
+		case Format::R32G32B32Float: return DXGI_FORMAT_R32G32B32_FLOAT;
+		case Format::R8G8B8A8Unorm: return DXGI_FORMAT_R8G8B8A8_UNORM;
+		case Format::D32Float: return DXGI_FORMAT_D32_FLOAT;
+		default: return DXGI_FORMAT_UNKNOWN;
+		}
+	}
+
+	D3D12_SHADER_VISIBILITY toD3D12ShaderVisibility(ShaderVisibility visibility)
+	{
+		switch (visibility)
+		{
+		case ShaderVisibility::Vertex: return D3D12_SHADER_VISIBILITY_VERTEX;
+		case ShaderVisibility::Hull: return D3D12_SHADER_VISIBILITY_HULL;
+		case ShaderVisibility::Domain: return D3D12_SHADER_VISIBILITY_DOMAIN;
+		case ShaderVisibility::Geometry: return D3D12_SHADER_VISIBILITY_GEOMETRY;
+		case ShaderVisibility::Pixel: return D3D12_SHADER_VISIBILITY_PIXEL;
+		default: return D3D12_SHADER_VISIBILITY_ALL;
+		}
+	}
+
+	D3D12_DESCRIPTOR_HEAP_TYPE toD3D12DescriptorHeapType(DescriptorHeapType type)
+	{
+		switch (type)
+		{
+		case DescriptorHeapType::Rtv: return D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+		case DescriptorHeapType::Dsv: return D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+		default: return D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		}
+	}
+
+	D3D12_RESOURCE_DESC getBufferResourceDesc(uint64_t size)
+	{
+		D3D12_RESOURCE_DESC resourceDesc;
+		ZeroMemory(&resourceDesc, sizeof(resourceDesc));
+		resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+		resourceDesc.Alignment = 0;
+		resourceDesc.Width = size;
+		resourceDesc.Height = 1;
+		resourceDesc.DepthOrArraySize = 1;
+		resourceDesc.MipLevels = 1;
+		resourceDesc.Format = DXGI_FORMAT_UNKNOWN;
+		resourceDesc.SampleDesc.Count = 1;
+		resourceDesc.SampleDesc.Quality = 0;
+		resourceDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+		resourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
+		return resourceDesc;
+	}
+}
+
+D3D12_RESOURCE_STATES teapot_tutorial::toD3D12ResourceState(ResourceState state)
+{
+	switch (state)
+	{
+	case ResourceState::VertexAndConstantBuffer: return D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
+	case ResourceState::IndexBuffer: return D3D12_RESOURCE_STATE_INDEX_BUFFER;
+	case ResourceState::RenderTarget: return D3D12_RESOURCE_STATE_RENDER_TARGET;
+	case ResourceState::DepthWrite: return D3D12_RESOURCE_STATE_DEPTH_WRITE;
+	case ResourceState::NonPixelShaderResource: return D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+	case ResourceState::CopyDest: return D3D12_RESOURCE_STATE_COPY_DEST;
+	case ResourceState::CopySource: return D3D12_RESOURCE_STATE_COPY_SOURCE;
+	case ResourceState::GenericRead: return D3D12_RESOURCE_STATE_GENERIC_READ;
+	case ResourceState::Present: return D3D12_RESOURCE_STATE_PRESENT;
+	default: return D3D12_RESOURCE_STATE_COMMON;
+	}
+}
+
+D3D12_PRIMITIVE_TOPOLOGY teapot_tutorial::toD3D12PrimitiveTopology(PrimitiveTopology topology)
+{
+	switch (topology)
+	{
+	case PrimitiveTopology::PatchList16: return D3D_PRIMITIVE_TOPOLOGY_16_CONTROL_POINT_PATCHLIST;
+	default: return D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
+	}
+}
+
+DXGI_FORMAT teapot_tutorial::toD3D12Format(Format format)
+{
+	return toDxgiFormat(format);
+}
+
 Graphics::Graphics(UINT bufferCount, string name, LONG width, LONG height) : bufferCount{ bufferCount }, swapChainBuffers(bufferCount)
 {
 	createWindow(name, width, height);
@@ -17,18 +106,14 @@ Graphics::Graphics(UINT bufferCount, string name, LONG width, LONG height) : buf
 	createDescriptoprHeapRtv();
 	createDepthStencilBuffer();
 	createDescriptorHeapDepthStencil();
-	createCommandAllocators();
-	createCommandList();
-	createFences();
+	createIdleFence();
 	createFenceEventHandle();
 }
 
 Graphics::~Graphics()
 {
-	for (UINT i{ 0 }; i < bufferCount; i++)
-	{
-		waitFrameComplete(i);
-	}
+	uploadManager.reset();
+	waitIdle();
 }
 
 void Graphics::createWindow(string name, LONG width, LONG height)
@@ -107,6 +192,14 @@ void Graphics::createCommandQueue()
 	{
 		throw(runtime_error{ "Error creating command queue." });
 	}
+
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+
+	hr = device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(copyCommandQueue.ReleaseAndGetAddressOf()));
+	if (FAILED(hr))
+	{
+		throw(runtime_error{ "Error creating copy command queue." });
+	}
 }
 
 void Graphics::createSwapChain()
@@ -146,6 +239,8 @@ void Graphics::getSwapChainBuffers()
 		{
 			throw(runtime_error{ "Error getting buffer." });
 		}
+
+		swapChainBufferHandles.push_back(addResource(swapChainBuffers[i]));
 	}
 }
 
@@ -170,6 +265,8 @@ void Graphics::createDescriptoprHeapRtv()
 		d.ptr += i * rtvStep;
 		device->CreateRenderTargetView(swapChainBuffers[i].Get(), nullptr, d);
 	}
+
+	rtvHeapHandle = addDescriptorHeap(descHeapRtv);
 }
 
 void Graphics::createDepthStencilBuffer()
@@ -239,66 +336,570 @@ void Graphics::createDescriptorHeapDepthStencil()
 	depthStencilViewDesc.Flags = D3D12_DSV_FLAG_NONE;
 
 	device->CreateDepthStencilView(depthStencilBuffer.Get(), &depthStencilViewDesc, descHeapDepthStencil->GetCPUDescriptorHandleForHeapStart());
+
+	depthStencilHeapHandle = addDescriptorHeap(descHeapDepthStencil);
 }
 
-void Graphics::createCommandAllocators()
+void Graphics::createIdleFence()
 {
-	for (UINT i{ 0 }; i < bufferCount; i++)
+	if (FAILED(device->CreateFence(idleFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(idleFence.ReleaseAndGetAddressOf()))))
+	{
+		throw(runtime_error{ "Error creating fence." });
+	}
+}
+
+void Graphics::createFenceEventHandle()
+{
+	fenceEventHandle = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (fenceEventHandle == NULL)
+	{
+		throw(runtime_error{ "Error creating fence event." });
+	}
+}
+
+ResourceHandle Graphics::addResource(ComPtr<ID3D12Resource> resource)
+{
+	resources.push_back(resource);
+	return ResourceHandle{ static_cast<uint32_t>(resources.size()) };
+}
+
+DescriptorHeapHandle Graphics::addDescriptorHeap(ComPtr<ID3D12DescriptorHeap> heap)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc{ heap->GetDesc() };
+
+	DescriptorHeapEntry entry;
+	entry.heap = heap;
+	entry.type = heapDesc.Type;
+	entry.descriptorSize = device->GetDescriptorHandleIncrementSize(heapDesc.Type);
+	entry.cpuStart = heap->GetCPUDescriptorHandleForHeapStart();
+	entry.gpuStart.ptr = 0;
+	if (heapDesc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)
+	{
+		entry.gpuStart = heap->GetGPUDescriptorHandleForHeapStart();
+	}
+
+	descriptorHeaps.push_back(entry);
+	return DescriptorHeapHandle{ static_cast<uint32_t>(descriptorHeaps.size()) };
+}
+
+ID3D12Resource* Graphics::getResource(ResourceHandle handle) const
+{
+	return resources.at(handle.id - 1).Get();
+}
+
+ID3D12DescriptorHeap* Graphics::getDescriptorHeap(DescriptorHeapHandle handle) const
+{
+	return descriptorHeaps.at(handle.id - 1).heap.Get();
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE Graphics::getCpuDescriptor(const DescriptorHandle& handle) const
+{
+	const DescriptorHeapEntry& entry{ descriptorHeaps.at(handle.heap.id - 1) };
+	D3D12_CPU_DESCRIPTOR_HANDLE d{ entry.cpuStart };
+	d.ptr += static_cast<SIZE_T>(handle.index) * entry.descriptorSize;
+	return d;
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE Graphics::getGpuDescriptor(const DescriptorHandle& handle) const
+{
+	const DescriptorHeapEntry& entry{ descriptorHeaps.at(handle.heap.id - 1) };
+	D3D12_GPU_DESCRIPTOR_HANDLE d{ entry.gpuStart };
+	d.ptr += static_cast<UINT64>(handle.index) * entry.descriptorSize;
+	return d;
+}
+
+ID3D12RootSignature* Graphics::getRootSignature(RootSignatureHandle handle) const
+{
+	return rootSignatures.at(handle.id - 1).Get();
+}
+
+ID3D12PipelineState* Graphics::getPipelineState(PipelineStateHandle handle) const
+{
+	lock_guard<mutex> lock{ pipelineStateMutex };
+	return pipelineStates.at(handle.id - 1).Get();
+}
+
+ID3D12CommandSignature* Graphics::getCommandSignature(CommandSignatureHandle handle) const
+{
+	return commandSignatures.at(handle.id - 1).Get();
+}
+
+ID3D12Fence* Graphics::getFence(FenceHandle handle) const
+{
+	return fences.at(handle.id - 1).Get();
+}
+
+ID3D12CommandQueue* Graphics::getCommandQueue(QueueType queue) const
+{
+	return queue == QueueType::Copy ? copyCommandQueue.Get() : commandQueue.Get();
+}
+
+UploadManager& Graphics::getUploadManager()
+{
+	// Created on first use; its staging buffer and fence are ordinary objects of this device.
+	if (uploadManager == nullptr)
 	{
-		ComPtr<ID3D12CommandAllocator> commandAllocator;
-		if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(commandAllocator.ReleaseAndGetAddressOf()))))
+		uploadManager = make_unique<UploadManager>(*this, 4 * 1024 * 1024);
+	}
+
+	return *uploadManager;
+}
+
+ResourceHandle Graphics::createBuffer(const BufferDesc& desc, const void* initialData)
+{
+	wstring name(desc.name.begin(), desc.name.end());
+	bool upload{ desc.heapType == HeapType::Default && initialData != nullptr };
+
+	D3D12_HEAP_PROPERTIES heapProps;
+	ZeroMemory(&heapProps, sizeof(heapProps));
+	heapProps.Type = desc.heapType == HeapType::Upload ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
+	heapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	heapProps.CreationNodeMask = 1;
+	heapProps.VisibleNodeMask = 1;
+
+	D3D12_RESOURCE_DESC resourceDesc{ getBufferResourceDesc(desc.size) };
+
+	// Upload heap resources have to be created in GENERIC_READ and stay there. Buffers filled on the copy queue
+	// start in COMMON, the only state the copy queue can promote from.
+	D3D12_RESOURCE_STATES initialState{ teapot_tutorial::toD3D12ResourceState(desc.initialState) };
+	if (desc.heapType == HeapType::Upload)
+	{
+		initialState = D3D12_RESOURCE_STATE_GENERIC_READ;
+	}
+	else if (upload)
+	{
+		initialState = D3D12_RESOURCE_STATE_COMMON;
+	}
+
+	ComPtr<ID3D12Resource> buffer;
+	HRESULT hr{ device->CreateCommittedResource(
+		&heapProps,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		initialState,
+		nullptr,
+		IID_PPV_ARGS(buffer.ReleaseAndGetAddressOf())
+	) };
+
+	if (FAILED(hr))
+	{
+		throw(runtime_error{ "Error creating buffer." });
+	}
+
+	buffer->SetName(name.c_str());
+
+	if (upload)
+	{
+		ResourceHandle handle{ addResource(buffer) };
+		getUploadManager().upload(handle, 0, initialData, desc.size).wait();
+		return handle;
+	}
+
+	if (initialData != nullptr)
+	{
+		D3D12_RANGE readRange{ 0, 0 };
+		void* pData;
+		if (FAILED(buffer->Map(0, &readRange, &pData)))
 		{
-			throw(runtime_error{ "Error creating command allocator." });
+			throw(runtime_error{ "Failed map buffer." });
 		}
 
-		commandAllocators.push_back(commandAllocator);
+		memcpy(pData, initialData, static_cast<size_t>(desc.size));
+		buffer->Unmap(0, nullptr);
 	}
+
+	return addResource(buffer);
 }
 
-void Graphics::createCommandList()
+HeapHandle Graphics::createHeap(const HeapDesc& desc)
 {
-	if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators[0].Get(), nullptr, IID_PPV_ARGS(commandList.ReleaseAndGetAddressOf()))))
+	D3D12_HEAP_DESC heapDesc;
+	ZeroMemory(&heapDesc, sizeof(heapDesc));
+	heapDesc.SizeInBytes = desc.size;
+	heapDesc.Properties.Type = desc.heapType == HeapType::Upload ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
+	heapDesc.Properties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+	heapDesc.Properties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+	heapDesc.Properties.CreationNodeMask = 1;
+	heapDesc.Properties.VisibleNodeMask = 1;
+	heapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+	ComPtr<ID3D12Heap> heap;
+	if (FAILED(device->CreateHeap(&heapDesc, IID_PPV_ARGS(heap.ReleaseAndGetAddressOf()))))
 	{
-		throw(runtime_error{ "Error creating command list." });
+		throw(runtime_error{ "Error creating heap." });
 	}
 
-	if (FAILED(commandList->Close()))
+	heaps.push_back({ heap, desc.heapType });
+	return HeapHandle{ static_cast<uint32_t>(heaps.size()) };
+}
+
+ResourceHandle Graphics::createPlacedBuffer(HeapHandle heap, uint64_t heapOffset, const BufferDesc& desc)
+{
+	const HeapEntry& entry{ heaps.at(heap.id - 1) };
+	D3D12_RESOURCE_DESC resourceDesc{ getBufferResourceDesc(desc.size) };
+	D3D12_RESOURCE_STATES initialState{ entry.heapType == HeapType::Upload ? D3D12_RESOURCE_STATE_GENERIC_READ : teapot_tutorial::toD3D12ResourceState(desc.initialState) };
+
+	ComPtr<ID3D12Resource> buffer;
+	if (FAILED(device->CreatePlacedResource(entry.heap.Get(), heapOffset, &resourceDesc, initialState, nullptr, IID_PPV_ARGS(buffer.ReleaseAndGetAddressOf()))))
 	{
-		throw(runtime_error{ "Error closing command list." });
+		throw(runtime_error{ "Error creating placed buffer." });
 	}
+
+	wstring name(desc.name.begin(), desc.name.end());
+	buffer->SetName(name.c_str());
+
+	return addResource(buffer);
 }
 
-void Graphics::createFences()
+void Graphics::releaseResource(ResourceHandle resource)
 {
-	for (UINT i{ 0 }; i < bufferCount; i++)
+	resources.at(resource.id - 1).Reset();
+}
+
+void* Graphics::mapBuffer(ResourceHandle buffer)
+{
+	D3D12_RANGE readRange{ 0, 0 };
+	void* pData;
+	if (FAILED(getResource(buffer)->Map(0, &readRange, &pData)))
 	{
-		UINT64 initialValue{ 0 };
-		ComPtr<ID3D12Fence> fence;
-		if (FAILED(device->CreateFence(initialValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence.ReleaseAndGetAddressOf()))))
+		throw(runtime_error{ "Failed map buffer." });
+	}
+
+	return pData;
+}
+
+void Graphics::unmapBuffer(ResourceHandle buffer)
+{
+	getResource(buffer)->Unmap(0, nullptr);
+}
+
+uint64_t Graphics::getGpuVirtualAddress(ResourceHandle buffer)
+{
+	return getResource(buffer)->GetGPUVirtualAddress();
+}
+
+MemoryBudget Graphics::queryMemoryBudget()
+{
+	DXGI_QUERY_VIDEO_MEMORY_INFO info;
+	if (FAILED(adapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+	{
+		throw(runtime_error{ "Error querying video memory info." });
+	}
+
+	return{ info.Budget, info.CurrentUsage };
+}
+
+DescriptorHeapHandle Graphics::createDescriptorHeap(const DescriptorHeapDesc& desc)
+{
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc;
+	ZeroMemory(&heapDesc, sizeof(heapDesc));
+	heapDesc.NumDescriptors = desc.numDescriptors;
+	heapDesc.Flags = desc.shaderVisible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	heapDesc.Type = toD3D12DescriptorHeapType(desc.type);
+	heapDesc.NodeMask = 0;
+
+	ComPtr<ID3D12DescriptorHeap> heap;
+	if (FAILED(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(heap.ReleaseAndGetAddressOf()))))
+	{
+		throw(runtime_error{ "Error creating descriptor heap." });
+	}
+
+	return addDescriptorHeap(heap);
+}
+
+void Graphics::createShaderResourceView(ResourceHandle buffer, const ShaderResourceViewDesc& desc, const DescriptorHandle& destDescriptor)
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc;
+	ZeroMemory(&srvDesc, sizeof(srvDesc));
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN; // https://msdn.microsoft.com/en-us/library/windows/desktop/dn859358(v=vs.85).aspx#shader_resource_view
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Buffer.FirstElement = desc.firstElement;
+	srvDesc.Buffer.NumElements = desc.numElements;
+	srvDesc.Buffer.StructureByteStride = desc.structureByteStride;
+	srvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
+
+	device->CreateShaderResourceView(getResource(buffer), &srvDesc, getCpuDescriptor(destDescriptor));
+}
+
+void Graphics::copyDescriptors(uint32_t numCopies, const DescriptorCopy* copies)
+{
+	if (numCopies == 0)
+	{
+		return;
+	}
+
+	vector<D3D12_CPU_DESCRIPTOR_HANDLE> dstStarts(numCopies);
+	vector<D3D12_CPU_DESCRIPTOR_HANDLE> srcStarts(numCopies);
+	vector<UINT> sizes(numCopies);
+	for (uint32_t i{ 0 }; i < numCopies; i++)
+	{
+		dstStarts[i] = getCpuDescriptor(copies[i].dst);
+		srcStarts[i] = getCpuDescriptor(copies[i].src);
+		sizes[i] = copies[i].numDescriptors;
+	}
+
+	device->CopyDescriptors(numCopies, dstStarts.data(), sizes.data(), numCopies, srcStarts.data(), sizes.data(), descriptorHeaps.at(copies[0].dst.heap.id - 1).type);
+}
+
+RootSignatureHandle Graphics::createRootSignature(const RootSignatureDesc& desc)
+{
+	// Ranges are referenced by pointer from the parameters, so they must not move while parameters are built.
+	vector<D3D12_DESCRIPTOR_RANGE> ranges(desc.parameters.size());
+	vector<D3D12_ROOT_PARAMETER> rootParameters(desc.parameters.size());
+
+	for (size_t i{ 0 }; i < desc.parameters.size(); i++)
+	{
+		const RootParameterDesc& paramDesc{ desc.parameters[i] };
+		D3D12_ROOT_PARAMETER& param{ rootParameters[i] };
+		ZeroMemory(&param, sizeof(param));
+		param.ShaderVisibility = toD3D12ShaderVisibility(paramDesc.visibility);
+
+		switch (paramDesc.type)
 		{
-			throw(runtime_error{ "Error creating fence." });
+		case RootParameterType::Constants:
+			param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+			param.Constants = { paramDesc.shaderRegister, paramDesc.registerSpace, paramDesc.count };
+			break;
+		case RootParameterType::Cbv:
+			param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+			param.Descriptor = { paramDesc.shaderRegister, paramDesc.registerSpace };
+			break;
+		case RootParameterType::SrvTable:
+			ZeroMemory(&ranges[i], sizeof(ranges[i]));
+			ranges[i].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+			ranges[i].NumDescriptors = paramDesc.count;
+			ranges[i].BaseShaderRegister = paramDesc.shaderRegister;
+			ranges[i].RegisterSpace = paramDesc.registerSpace;
+			ranges[i].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+
+			param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+			param.DescriptorTable = { 1, &ranges[i] };
+			break;
 		}
+	}
 
-		fences.push_back(fence);
-		fenceValues.push_back(initialValue);
+	D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags{ D3D12_ROOT_SIGNATURE_FLAG_NONE };
+	if (desc.flags & RootSignatureFlagAllowInputLayout) rootSignatureFlags |= D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+	if (desc.flags & RootSignatureFlagDenyVertexShaderRootAccess) rootSignatureFlags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS;
+	if (desc.flags & RootSignatureFlagDenyHullShaderRootAccess) rootSignatureFlags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS;
+	if (desc.flags & RootSignatureFlagDenyDomainShaderRootAccess) rootSignatureFlags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS;
+	if (desc.flags & RootSignatureFlagDenyGeometryShaderRootAccess) rootSignatureFlags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS;
+	if (desc.flags & RootSignatureFlagDenyPixelShaderRootAccess) rootSignatureFlags |= D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
+
+	D3D12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	ZeroMemory(&rootSignatureDesc, sizeof(rootSignatureDesc));
+	rootSignatureDesc.NumParameters = static_cast<UINT>(rootParameters.size());
+	rootSignatureDesc.pParameters = rootParameters.data();
+	rootSignatureDesc.NumStaticSamplers = 0;
+	rootSignatureDesc.pStaticSamplers = nullptr;
+	rootSignatureDesc.Flags = rootSignatureFlags;
+
+	ComPtr<ID3DBlob> signature;
+	ComPtr<ID3DBlob> error;
+	if (FAILED(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, signature.ReleaseAndGetAddressOf(), error.ReleaseAndGetAddressOf())))
+	{
+		throw(runtime_error{ "Error serializing root signature" });
+	}
+
+	ComPtr<ID3D12RootSignature> rootSignature;
+	if (FAILED(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(rootSignature.ReleaseAndGetAddressOf()))))
+	{
+		throw(runtime_error{ "Error creating root signature" });
 	}
+
+	rootSignatures.push_back(rootSignature);
+	return RootSignatureHandle{ static_cast<uint32_t>(rootSignatures.size()) };
 }
 
-void Graphics::createFenceEventHandle()
+PipelineStateHandle Graphics::createPipelineState(const PipelineStateDesc& desc)
 {
-	fenceEventHandle = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-	if (fenceEventHandle == NULL)
+	vector<D3D12_INPUT_ELEMENT_DESC> inputElementDescs;
+	for (const InputElementDesc& element : desc.inputLayout)
 	{
-		throw(runtime_error{ "Error creating fence event." });
+		inputElementDescs.push_back({ element.semanticName.c_str(), element.semanticIndex, toDxgiFormat(element.format), element.inputSlot, element.alignedByteOffset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
 	}
+
+	D3D12_RASTERIZER_DESC rasterizerDesc;
+	ZeroMemory(&rasterizerDesc, sizeof(rasterizerDesc));
+	rasterizerDesc.FillMode = desc.fillMode == FillMode::Wireframe ? D3D12_FILL_MODE_WIREFRAME : D3D12_FILL_MODE_SOLID;
+	rasterizerDesc.CullMode = desc.cullMode == CullMode::Front ? D3D12_CULL_MODE_FRONT : desc.cullMode == CullMode::Back ? D3D12_CULL_MODE_BACK : D3D12_CULL_MODE_NONE;
+	rasterizerDesc.FrontCounterClockwise = FALSE;
+	rasterizerDesc.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
+	rasterizerDesc.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+	rasterizerDesc.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+	rasterizerDesc.DepthClipEnable = TRUE;
+	rasterizerDesc.MultisampleEnable = FALSE;
+	rasterizerDesc.AntialiasedLineEnable = FALSE;
+	rasterizerDesc.ForcedSampleCount = 0;
+	rasterizerDesc.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+
+	D3D12_BLEND_DESC blendDesc;
+	ZeroMemory(&blendDesc, sizeof(blendDesc));
+	blendDesc.AlphaToCoverageEnable = FALSE;
+	blendDesc.IndependentBlendEnable = FALSE;
+	blendDesc.RenderTarget[0] = {
+		FALSE,FALSE,
+		D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD,
+		D3D12_BLEND_ONE, D3D12_BLEND_ZERO, D3D12_BLEND_OP_ADD,
+		D3D12_LOGIC_OP_NOOP,
+		D3D12_COLOR_WRITE_ENABLE_ALL
+	};
+
+	D3D12_DEPTH_STENCIL_DESC depthStencilDesc;
+	ZeroMemory(&depthStencilDesc, sizeof(depthStencilDesc));
+	depthStencilDesc.DepthEnable = desc.depthEnable ? TRUE : FALSE;
+	depthStencilDesc.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+	depthStencilDesc.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+	depthStencilDesc.StencilEnable = FALSE;
+	depthStencilDesc.StencilReadMask = D3D12_DEFAULT_STENCIL_READ_MASK;
+	depthStencilDesc.StencilWriteMask = D3D12_DEFAULT_STENCIL_WRITE_MASK;
+	const D3D12_DEPTH_STENCILOP_DESC defaultStencilOp = { D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_STENCIL_OP_KEEP, D3D12_COMPARISON_FUNC_ALWAYS };
+	depthStencilDesc.FrontFace = defaultStencilOp;
+	depthStencilDesc.BackFace = defaultStencilOp;
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC pipelineStateDesc;
+	ZeroMemory(&pipelineStateDesc, sizeof(pipelineStateDesc));
+	pipelineStateDesc.InputLayout = { inputElementDescs.data(), static_cast<UINT>(inputElementDescs.size()) };
+	pipelineStateDesc.pRootSignature = getRootSignature(desc.rootSignature);
+	pipelineStateDesc.VS = { desc.vertexShader.data(), desc.vertexShader.size() };
+	pipelineStateDesc.HS = { desc.hullShader.data(), desc.hullShader.size() };
+	pipelineStateDesc.DS = { desc.domainShader.data(), desc.domainShader.size() };
+	pipelineStateDesc.PS = { desc.pixelShader.data(), desc.pixelShader.size() };
+	pipelineStateDesc.RasterizerState = rasterizerDesc;
+	pipelineStateDesc.BlendState = blendDesc;
+	pipelineStateDesc.DepthStencilState = depthStencilDesc;
+	pipelineStateDesc.SampleMask = UINT_MAX;
+	pipelineStateDesc.PrimitiveTopologyType = desc.topologyType == PrimitiveTopologyType::Patch ? D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH : D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	pipelineStateDesc.NumRenderTargets = 1;
+	pipelineStateDesc.RTVFormats[0] = toDxgiFormat(desc.renderTargetFormat);
+	pipelineStateDesc.DSVFormat = toDxgiFormat(desc.depthStencilFormat);
+	pipelineStateDesc.SampleDesc.Count = 1;
+	pipelineStateDesc.CachedPSO = { desc.cachedBlob.data(), desc.cachedBlob.size() };
+
+	// A blob from another driver version or adapter is rejected; the state is then compiled from the shaders.
+	ComPtr<ID3D12PipelineState> pipelineState;
+	HRESULT result{ device->CreateGraphicsPipelineState(&pipelineStateDesc, IID_PPV_ARGS(pipelineState.ReleaseAndGetAddressOf())) };
+	if (FAILED(result) && !desc.cachedBlob.empty())
+	{
+		pipelineStateDesc.CachedPSO = { nullptr, 0 };
+		result = device->CreateGraphicsPipelineState(&pipelineStateDesc, IID_PPV_ARGS(pipelineState.ReleaseAndGetAddressOf()));
+	}
+
+	if (FAILED(result))
+	{
+		throw(runtime_error{ "Error creating pipeline state." });
+	}
+
+	lock_guard<mutex> lock{ pipelineStateMutex };
+	pipelineStates.push_back(pipelineState);
+	return PipelineStateHandle{ static_cast<uint32_t>(pipelineStates.size()) };
 }
 
-void Graphics::waitFrameComplete(UINT frameIndex)
+ShaderBytecode Graphics::getPipelineStateBlob(PipelineStateHandle pipelineState)
 {
-	UINT64 fenceValue{ fenceValues[frameIndex] };
-	ComPtr<ID3D12Fence> fence{ fences[frameIndex] };
+	ComPtr<ID3DBlob> blob;
+	if (FAILED(getPipelineState(pipelineState)->GetCachedBlob(blob.ReleaseAndGetAddressOf())))
+	{
+		return ShaderBytecode{};
+	}
+
+	const uint8_t* data{ static_cast<const uint8_t*>(blob->GetBufferPointer()) };
+	return ShaderBytecode(data, data + blob->GetBufferSize());
+}
 
-	if (FAILED(fence->SetEventOnCompletion(fenceValue, fenceEventHandle)))
+CommandSignatureHandle Graphics::createCommandSignature(const CommandSignatureDesc& desc)
+{
+	vector<D3D12_INDIRECT_ARGUMENT_DESC> argumentDescs;
+	for (const IndirectArgumentDesc& argument : desc.arguments)
+	{
+		D3D12_INDIRECT_ARGUMENT_DESC argumentDesc;
+		ZeroMemory(&argumentDesc, sizeof(argumentDesc));
+		if (argument.type == IndirectArgumentType::Constant)
+		{
+			argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+			argumentDesc.Constant.RootParameterIndex = argument.rootParameterIndex;
+			argumentDesc.Constant.DestOffsetIn32BitValues = argument.destOffsetIn32BitValues;
+			argumentDesc.Constant.Num32BitValuesToSet = argument.num32BitValues;
+		}
+		else
+		{
+			argumentDesc.Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+		}
+
+		argumentDescs.push_back(argumentDesc);
+	}
+
+	D3D12_COMMAND_SIGNATURE_DESC commandSignatureDesc;
+	ZeroMemory(&commandSignatureDesc, sizeof(commandSignatureDesc));
+	commandSignatureDesc.ByteStride = desc.byteStride;
+	commandSignatureDesc.NumArgumentDescs = static_cast<UINT>(argumentDescs.size());
+	commandSignatureDesc.pArgumentDescs = argumentDescs.data();
+
+	// Signatures that only draw must not name a root signature.
+	ID3D12RootSignature* rootSignature{ desc.rootSignature.isValid() ? getRootSignature(desc.rootSignature) : nullptr };
+	ComPtr<ID3D12CommandSignature> commandSignature;
+	if (FAILED(device->CreateCommandSignature(&commandSignatureDesc, rootSignature, IID_PPV_ARGS(commandSignature.ReleaseAndGetAddressOf()))))
+	{
+		throw(runtime_error{ "Error creating command signature." });
+	}
+
+	commandSignatures.push_back(commandSignature);
+	return CommandSignatureHandle{ static_cast<uint32_t>(commandSignatures.size()) };
+}
+
+unique_ptr<RenderCommandList> Graphics::createCommandList(QueueType queue)
+{
+	return make_unique<D3D12CommandList>(*this, queue);
+}
+
+void Graphics::executeCommandLists(QueueType queue, uint32_t numCommandLists, RenderCommandList* const* commandLists)
+{
+	vector<ID3D12CommandList*> ppCommandLists;
+	for (uint32_t i{ 0 }; i < numCommandLists; i++)
+	{
+		ppCommandLists.push_back(static_cast<D3D12CommandList*>(commandLists[i])->getCommandList());
+	}
+
+	getCommandQueue(queue)->ExecuteCommandLists(static_cast<UINT>(ppCommandLists.size()), ppCommandLists.data());
+}
+
+FenceHandle Graphics::createFence(uint64_t initialValue)
+{
+	ComPtr<ID3D12Fence> fence;
+	if (FAILED(device->CreateFence(initialValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence.ReleaseAndGetAddressOf()))))
+	{
+		throw(runtime_error{ "Error creating fence." });
+	}
+
+	fences.push_back(fence);
+	return FenceHandle{ static_cast<uint32_t>(fences.size()) };
+}
+
+void Graphics::signal(QueueType queue, FenceHandle fence, uint64_t value)
+{
+	if (FAILED(getCommandQueue(queue)->Signal(getFence(fence), value)))
+	{
+		throw(runtime_error{ "Failed signal." });
+	}
+}
+
+uint64_t Graphics::getCompletedValue(FenceHandle fence)
+{
+	return getFence(fence)->GetCompletedValue();
+}
+
+void Graphics::waitForFence(FenceHandle fence, uint64_t value)
+{
+	ID3D12Fence* d3dFence{ getFence(fence) };
+	if (d3dFence->GetCompletedValue() >= value)
+	{
+		return;
+	}
+
+	if (FAILED(d3dFence->SetEventOnCompletion(value, fenceEventHandle)))
 	{
 		throw(runtime_error{ "Failed set event on completion." });
 	}
@@ -308,4 +909,61 @@ void Graphics::waitFrameComplete(UINT frameIndex)
 	{
 		throw(runtime_error{ "Failed WaitForSingleObject()." });
 	}
+}
+
+void Graphics::waitIdle()
+{
+	// Queues are drained one after the other; a fence signaled by both could complete the larger value first.
+	for (ID3D12CommandQueue* queue : { commandQueue.Get(), copyCommandQueue.Get() })
+	{
+		++idleFenceValue;
+		if (FAILED(queue->Signal(idleFence.Get(), idleFenceValue)))
+		{
+			throw(runtime_error{ "Failed signal." });
+		}
+
+		if (FAILED(idleFence->SetEventOnCompletion(idleFenceValue, fenceEventHandle)))
+		{
+			throw(runtime_error{ "Failed set event on completion." });
+		}
+
+		DWORD wait{ WaitForSingleObject(fenceEventHandle, 10000) };
+		if (wait != WAIT_OBJECT_0)
+		{
+			throw(runtime_error{ "Failed WaitForSingleObject()." });
+		}
+	}
+}
+
+void Graphics::present()
+{
+	if (FAILED(swapChain->Present(1, 0)))
+	{
+		throw(runtime_error{ "Failed present." });
+	}
+}
+
+uint32_t Graphics::getBufferCount()
+{
+	return bufferCount;
+}
+
+uint32_t Graphics::getCurrentBackBufferIndex()
+{
+	return swapChain->GetCurrentBackBufferIndex();
+}
+
+ResourceHandle Graphics::getBackBuffer(uint32_t index)
+{
+	return swapChainBufferHandles.at(index);
+}
+
+DescriptorHandle Graphics::getBackBufferRtv(uint32_t index)
+{
+	return{ rtvHeapHandle, index };
+}
+
+DescriptorHandle Graphics::getDepthStencilView()
+{
+	return{ depthStencilHeapHandle, 0 };
 }
\ No newline at end of file
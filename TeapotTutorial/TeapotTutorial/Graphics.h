@@ -7,13 +7,54 @@
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <mutex>
+#include "RenderDevice.h"
 
-class Graphics
+class UploadManager;
+
+// D3D12 backend of RenderDevice. Owns the window, device, direct and copy queues and the swap chain; every object
+// created through the RenderDevice interface lives in one of the tables below and is addressed by its handle.
+class Graphics : public RenderDevice
 {
 public:
 	Graphics(UINT bufferCount, std::string name, LONG width, LONG height);
 	~Graphics();
 
+	ResourceHandle createBuffer(const BufferDesc& desc, const void* initialData) override;
+	void* mapBuffer(ResourceHandle buffer) override;
+	void unmapBuffer(ResourceHandle buffer) override;
+	uint64_t getGpuVirtualAddress(ResourceHandle buffer) override;
+
+	HeapHandle createHeap(const HeapDesc& desc) override;
+	ResourceHandle createPlacedBuffer(HeapHandle heap, uint64_t heapOffset, const BufferDesc& desc) override;
+	void releaseResource(ResourceHandle resource) override;
+	MemoryBudget queryMemoryBudget() override;
+
+	DescriptorHeapHandle createDescriptorHeap(const DescriptorHeapDesc& desc) override;
+	void createShaderResourceView(ResourceHandle buffer, const ShaderResourceViewDesc& desc, const DescriptorHandle& destDescriptor) override;
+	void copyDescriptors(uint32_t numCopies, const DescriptorCopy* copies) override;
+
+	RootSignatureHandle createRootSignature(const RootSignatureDesc& desc) override;
+	PipelineStateHandle createPipelineState(const PipelineStateDesc& desc) override;
+	ShaderBytecode getPipelineStateBlob(PipelineStateHandle pipelineState) override;
+	CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+
+	std::unique_ptr<RenderCommandList> createCommandList(QueueType queue) override;
+	void executeCommandLists(QueueType queue, uint32_t numCommandLists, RenderCommandList* const* commandLists) override;
+
+	FenceHandle createFence(uint64_t initialValue) override;
+	void signal(QueueType queue, FenceHandle fence, uint64_t value) override;
+	uint64_t getCompletedValue(FenceHandle fence) override;
+	void waitForFence(FenceHandle fence, uint64_t value) override;
+	void waitIdle() override;
+
+	void present() override;
+	uint32_t getBufferCount() override;
+	uint32_t getCurrentBackBufferIndex() override;
+	ResourceHandle getBackBuffer(uint32_t index) override;
+	DescriptorHandle getBackBufferRtv(uint32_t index) override;
+	DescriptorHandle getDepthStencilView() override;
+
 private:
 	void createWindow(std::string name, LONG width, LONG height);
 	void createFactory();
@@ -25,13 +66,24 @@ private:
 	void createDescriptoprHeapRtv();
 	void createDepthStencilBuffer();
 	void createDescriptorHeapDepthStencil();
-	void createCommandAllocators();
-	void createCommandList();
-	void createFences();
+	void createIdleFence();
 	void createFenceEventHandle();
 
-protected:
-	void waitFrameComplete(UINT frameIndex);
+	ResourceHandle addResource(Microsoft::WRL::ComPtr<ID3D12Resource> resource);
+	DescriptorHeapHandle addDescriptorHeap(Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap);
+
+	ID3D12Resource* getResource(ResourceHandle handle) const;
+	ID3D12DescriptorHeap* getDescriptorHeap(DescriptorHeapHandle handle) const;
+	D3D12_CPU_DESCRIPTOR_HANDLE getCpuDescriptor(const DescriptorHandle& handle) const;
+	D3D12_GPU_DESCRIPTOR_HANDLE getGpuDescriptor(const DescriptorHandle& handle) const;
+	ID3D12RootSignature* getRootSignature(RootSignatureHandle handle) const;
+	ID3D12PipelineState* getPipelineState(PipelineStateHandle handle) const;
+	ID3D12CommandSignature* getCommandSignature(CommandSignatureHandle handle) const;
+	ID3D12Fence* getFence(FenceHandle handle) const;
+	ID3D12CommandQueue* getCommandQueue(QueueType queue) const;
+	UploadManager& getUploadManager();
+
+	friend class D3D12CommandList;
 
 protected:
 	std::shared_ptr<class Window> window;
@@ -40,16 +92,52 @@ protected:
 	Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter;
 	Microsoft::WRL::ComPtr<ID3D12Device> device;
 	Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyCommandQueue;
 	Microsoft::WRL::ComPtr<IDXGISwapChain3> swapChain;
 	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> swapChainBuffers;
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descHeapRtv;
 	Microsoft::WRL::ComPtr<ID3D12Resource> depthStencilBuffer;
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descHeapDepthStencil;
 
-protected:
-	std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> commandAllocators;
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
+private:
+	struct DescriptorHeapEntry
+	{
+		Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+		D3D12_DESCRIPTOR_HEAP_TYPE type;
+		UINT descriptorSize;
+		D3D12_CPU_DESCRIPTOR_HANDLE cpuStart;
+		D3D12_GPU_DESCRIPTOR_HANDLE gpuStart;
+	};
+
+	struct HeapEntry
+	{
+		Microsoft::WRL::ComPtr<ID3D12Heap> heap;
+		HeapType heapType;
+	};
+
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> resources;
+	std::vector<HeapEntry> heaps;
+	std::vector<DescriptorHeapEntry> descriptorHeaps;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12RootSignature>> rootSignatures;
+	// Pipeline states are created from compile jobs while lists are recorded, so their table is locked.
+	mutable std::mutex pipelineStateMutex;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12PipelineState>> pipelineStates;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12CommandSignature>> commandSignatures;
 	std::vector<Microsoft::WRL::ComPtr<ID3D12Fence>> fences;
-	std::vector<UINT64> fenceValues;
+	std::vector<ResourceHandle> swapChainBufferHandles;
+	DescriptorHeapHandle rtvHeapHandle;
+	DescriptorHeapHandle depthStencilHeapHandle;
+
+	Microsoft::WRL::ComPtr<ID3D12Fence> idleFence;
+	UINT64 idleFenceValue{ 0 };
 	HANDLE fenceEventHandle;
-};
\ No newline at end of file
+
+	std::unique_ptr<UploadManager> uploadManager;
+};
+
+namespace teapot_tutorial
+{
+	D3D12_RESOURCE_STATES toD3D12ResourceState(ResourceState state);
+	D3D12_PRIMITIVE_TOPOLOGY toD3D12PrimitiveTopology(PrimitiveTopology topology);
+	DXGI_FORMAT toD3D12Format(Format format);
+}
\ No newline at end of file
@@ -0,0 +1,587 @@
+#include "HiZBuffer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	// How the occluder being rasterized covers a level 0 texel.
+	const uint8_t texelTouched{ 1 };
+	const uint8_t texelCentreCovered{ 2 };
+	const uint8_t texelOnOutline{ 4 };
+	const uint8_t texelInsideTriangle{ 8 };
+
+	// A copy that containers can take by reference.
+	const uint32_t noNeighbor{ OccluderMesh::noNeighbor };
+
+	// Pairs the triangles sharing an edge between the same two welded vertices. An edge shared by more than two
+	// triangles, or, once oriented, by two crossing it the same way, stays on the boundary.
+	void linkEdges(OccluderMesh& occluder, const vector<uint32_t>& welded, bool oriented)
+	{
+		const vector<uint32_t>& indices{ occluder.mesh.indices };
+		vector<uint32_t>& neighbors{ occluder.edgeNeighbors };
+		neighbors.assign(indices.size(), noNeighbor);
+
+		// The first edge found between each pair of vertices, or noNeighbor once a third triangle shares it.
+		unordered_map<uint64_t, uint32_t> firstEdges;
+		for (uint32_t edge{ 0 }; edge < indices.size(); edge++)
+		{
+			uint32_t triangle{ edge / 3 };
+			uint32_t a{ welded[indices[edge]] };
+			uint32_t b{ welded[indices[triangle * 3 + (edge % 3 + 1) % 3]] };
+			uint64_t key{ (static_cast<uint64_t>(min(a, b)) << 32) | max(a, b) };
+
+			auto first = firstEdges.emplace(key, edge);
+			if (first.second)
+			{
+				continue;
+			}
+
+			uint32_t other{ first.first->second };
+			if (other == noNeighbor)
+			{
+				continue;
+			}
+
+			if (neighbors[other] != noNeighbor)
+			{
+				uint32_t partner{ neighbors[other] };
+				for (uint32_t k{ 0 }; k < 3; k++)
+				{
+					if (neighbors[partner * 3 + k] == other / 3)
+					{
+						neighbors[partner * 3 + k] = noNeighbor;
+					}
+				}
+
+				neighbors[other] = noNeighbor;
+				first.first->second = noNeighbor;
+				continue;
+			}
+
+			if (oriented && welded[indices[other]] == a)
+			{
+				continue;
+			}
+
+			neighbors[other] = triangle;
+			neighbors[edge] = other / 3;
+		}
+	}
+}
+
+void OccluderMesh::buildTopology(float weldDistance)
+{
+	// Vertices within weldDistance along every axis become one, found by sweeping them in order along x.
+	size_t numVertices{ mesh.positions.size() };
+	vector<uint32_t> order(numVertices);
+	for (size_t i{ 0 }; i < numVertices; i++)
+	{
+		order[i] = static_cast<uint32_t>(i);
+	}
+
+	sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return mesh.positions[a].x < mesh.positions[b].x; });
+
+	const uint32_t unwelded{ 0xFFFFFFFF };
+	vector<uint32_t> welded(numVertices, unwelded);
+	for (size_t i{ 0 }; i < numVertices; i++)
+	{
+		uint32_t a{ order[i] };
+		if (welded[a] != unwelded)
+		{
+			continue;
+		}
+
+		welded[a] = a;
+		const XMFLOAT3& p{ mesh.positions[a] };
+		for (size_t j{ i + 1 }; j < numVertices && mesh.positions[order[j]].x - p.x <= weldDistance; j++)
+		{
+			uint32_t b{ order[j] };
+			const XMFLOAT3& q{ mesh.positions[b] };
+			if (welded[b] == unwelded && fabs(q.y - p.y) <= weldDistance && fabs(q.z - p.z) <= weldDistance)
+			{
+				welded[b] = a;
+			}
+		}
+	}
+
+	// Collapsed triangles cover nothing, and without them the triangles around a pole share their edges.
+	size_t numTriangles{ triangleBounds.size() };
+	bool hasPatches{ mesh.trianglePatches.size() == numTriangles };
+	size_t kept{ 0 };
+	for (size_t t{ 0 }; t < numTriangles; t++)
+	{
+		uint32_t a{ welded[mesh.indices[t * 3]] };
+		uint32_t b{ welded[mesh.indices[t * 3 + 1]] };
+		uint32_t c{ welded[mesh.indices[t * 3 + 2]] };
+		if (a == b || b == c || c == a)
+		{
+			continue;
+		}
+
+		copy(mesh.indices.begin() + t * 3, mesh.indices.begin() + t * 3 + 3, mesh.indices.begin() + kept * 3);
+		triangleBounds[kept] = triangleBounds[t];
+		if (hasPatches)
+		{
+			mesh.trianglePatches[kept] = mesh.trianglePatches[t];
+		}
+
+		++kept;
+	}
+
+	mesh.indices.resize(kept * 3);
+	triangleBounds.resize(kept);
+	if (hasPatches)
+	{
+		mesh.trianglePatches.resize(kept);
+	}
+
+	// Each connected part is walked from a seed; a neighbour crossing a shared edge the same way as the triangle
+	// it is reached from gets flipped. A part whose volume comes out negative has its normals pointing in and is
+	// flipped as a whole.
+	linkEdges(*this, welded, false);
+	vector<uint8_t> visited(kept, 0);
+	vector<uint8_t> flipped(kept, 0);
+	vector<uint32_t> part;
+	for (size_t seed{ 0 }; seed < kept; seed++)
+	{
+		if (visited[seed])
+		{
+			continue;
+		}
+
+		part.assign(1, static_cast<uint32_t>(seed));
+		visited[seed] = 1;
+		for (size_t i{ 0 }; i < part.size(); i++)
+		{
+			uint32_t t{ part[i] };
+			for (uint32_t k{ 0 }; k < 3; k++)
+			{
+				uint32_t n{ edgeNeighbors[t * 3 + k] };
+				if (n == noNeighbor || visited[n])
+				{
+					continue;
+				}
+
+				// The neighbour crosses the edge the same way when its corner after a is b.
+				uint32_t a{ welded[mesh.indices[t * 3 + k]] };
+				uint32_t b{ welded[mesh.indices[t * 3 + (k + 1) % 3]] };
+				bool sameWay{ false };
+				for (uint32_t j{ 0 }; j < 3; j++)
+				{
+					sameWay = sameWay || (welded[mesh.indices[n * 3 + j]] == a && welded[mesh.indices[n * 3 + (j + 1) % 3]] == b);
+				}
+
+				flipped[n] = sameWay ? !flipped[t] : flipped[t];
+				visited[n] = 1;
+				part.push_back(n);
+			}
+		}
+
+		XMVECTOR centre{ XMVectorZero() };
+		for (uint32_t t : part)
+		{
+			for (uint32_t k{ 0 }; k < 3; k++)
+			{
+				centre = XMVectorAdd(centre, XMLoadFloat3(&mesh.positions[mesh.indices[t * 3 + k]]));
+			}
+		}
+
+		centre = XMVectorScale(centre, 1.0f / static_cast<float>(part.size() * 3));
+		float volume{ 0.0f };
+		for (uint32_t t : part)
+		{
+			XMVECTOR p0{ XMVectorSubtract(XMLoadFloat3(&mesh.positions[mesh.indices[t * 3]]), centre) };
+			XMVECTOR p1{ XMVectorSubtract(XMLoadFloat3(&mesh.positions[mesh.indices[t * 3 + 1]]), centre) };
+			XMVECTOR p2{ XMVectorSubtract(XMLoadFloat3(&mesh.positions[mesh.indices[t * 3 + 2]]), centre) };
+			float v{ XMVectorGetX(XMVector3Dot(p0, XMVector3Cross(p1, p2))) };
+			volume += flipped[t] ? -v : v;
+		}
+
+		for (uint32_t t : part)
+		{
+			if ((flipped[t] != 0) != (volume < 0.0f))
+			{
+				swap(mesh.indices[t * 3 + 1], mesh.indices[t * 3 + 2]);
+			}
+		}
+	}
+
+	linkEdges(*this, welded, true);
+}
+
+HiZBuffer::HiZBuffer(int width, int height)
+{
+	if (width <= 0 || height <= 0)
+	{
+		throw(runtime_error{ "Invalid hierarchical depth buffer size." });
+	}
+
+	while (true)
+	{
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.depth.resize(static_cast<size_t>(width) * height, 1.0f);
+		levels.push_back(move(level));
+
+		if (width == 1 && height == 1)
+		{
+			break;
+		}
+
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+
+	occluderDepth.resize(levels[0].depth.size(), 0.0f);
+	occluderCoverage.resize(levels[0].depth.size(), 0);
+}
+
+void HiZBuffer::clear()
+{
+	for (Level& level : levels)
+	{
+		fill(level.depth.begin(), level.depth.end(), 1.0f);
+	}
+}
+
+void HiZBuffer::rasterizeOccluder(const OccluderMesh& occluder, FXMMATRIX mvp)
+{
+	const TessellatedMesh& mesh{ occluder.mesh };
+	const Level& base{ levels[0] };
+	float halfWidth{ static_cast<float>(base.width) * 0.5f };
+	float halfHeight{ static_cast<float>(base.height) * 0.5f };
+
+	screenPositions.resize(mesh.positions.size());
+	projected.resize(mesh.positions.size());
+	for (size_t i{ 0 }; i < mesh.positions.size(); i++)
+	{
+		XMFLOAT4 c;
+		XMStoreFloat4(&c, XMVector3Transform(XMLoadFloat3(&mesh.positions[i]), mvp));
+
+		// Triangles crossing the near plane are dropped instead of clipped: an occluder may only ever cover
+		// less than the real geometry.
+		projected[i] = c.w > FLT_EPSILON && c.z >= 0.0f;
+		if (projected[i])
+		{
+			float invW{ 1.0f / c.w };
+			screenPositions[i] = { (c.x * invW + 1.0f) * halfWidth, (1.0f - c.y * invW) * halfHeight, c.z * invW };
+		}
+	}
+
+	// Only the triangles facing the eye are drawn: the back of the occluder lies behind its front, and leaving
+	// it out keeps the depth of the front. Through the left-handed projection outward normals show as a positive
+	// area on the y down screen, or a negative one when the transform mirrors.
+	float frontSign{ XMVectorGetX(XMMatrixDeterminant(mvp)) < 0.0f ? -1.0f : 1.0f };
+
+	size_t numTriangles{ occluder.triangleBounds.size() };
+	drawnTriangles.assign(numTriangles, 0);
+	TexelRect touched{ base.width, base.height, -1, -1 };
+	for (size_t t{ 0 }; t < numTriangles; t++)
+	{
+		const uint32_t* corners{ &mesh.indices[t * 3] };
+		if (!projected[corners[0]] || !projected[corners[1]] || !projected[corners[2]])
+		{
+			continue;
+		}
+
+		const ScreenVertex& v0{ screenPositions[corners[0]] };
+		const ScreenVertex& v1{ screenPositions[corners[1]] };
+		const ScreenVertex& v2{ screenPositions[corners[2]] };
+		float area{ (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x) };
+		if (area * frontSign <= FLT_EPSILON)
+		{
+			continue;
+		}
+
+		// The triangle is only a chord of the curved surface, which can bulge behind it anywhere between the
+		// vertices. The surface it stands for lies inside its bounds, so writing the farthest depth of those
+		// keeps the occluder at or behind the real surface.
+		float depth{ computeFarthestDepth(occluder.triangleBounds[t], mvp) };
+		if (depth >= 1.0f)
+		{
+			continue;
+		}
+
+		drawnTriangles[t] = 1;
+		rasterizeTriangle(v0, v1, v2, depth, touched);
+	}
+
+	// The drawn triangles are only bounded where an edge has no drawn triangle across it: at silhouettes, where
+	// the neighbour faces away, at the mesh boundary and around the triangles left out above. Elsewhere the
+	// triangles on both sides are drawn, so a texel straddling the edge is covered all the same.
+	bool hasNeighbors{ occluder.edgeNeighbors.size() == mesh.indices.size() };
+	for (size_t t{ 0 }; t < numTriangles; t++)
+	{
+		if (!drawnTriangles[t])
+		{
+			continue;
+		}
+
+		for (size_t k{ 0 }; k < 3; k++)
+		{
+			uint32_t neighbor{ hasNeighbors ? occluder.edgeNeighbors[t * 3 + k] : noNeighbor };
+			if (neighbor == noNeighbor || !drawnTriangles[neighbor])
+			{
+				markOutlineEdge(screenPositions[mesh.indices[t * 3 + k]], screenPositions[mesh.indices[t * 3 + (k + 1) % 3]]);
+			}
+		}
+	}
+
+	mergeOccluder(touched);
+}
+
+float HiZBuffer::computeFarthestDepth(const Aabb& bounds, FXMMATRIX mvp)
+{
+	// Depth is z / w with both affine in the position, so across the box it peaks at a corner.
+	float depth{ 0.0f };
+	for (int i{ 0 }; i < 8; i++)
+	{
+		XMVECTOR corner{ XMVectorSet(
+			(i & 1) ? bounds.maxCorner.x : bounds.minCorner.x,
+			(i & 2) ? bounds.maxCorner.y : bounds.minCorner.y,
+			(i & 4) ? bounds.maxCorner.z : bounds.minCorner.z,
+			1.0f) };
+
+		XMFLOAT4 c;
+		XMStoreFloat4(&c, XMVector4Transform(corner, mvp));
+		if (c.w <= FLT_EPSILON)
+		{
+			return 1.0f;
+		}
+
+		depth = max(depth, c.z / c.w);
+	}
+
+	return depth;
+}
+
+void HiZBuffer::rasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2, float depth, TexelRect& touched)
+{
+	float area{ (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x) };
+	if (fabs(area) <= FLT_EPSILON)
+	{
+		return;
+	}
+
+	const Level& base{ levels[0] };
+	int x0{ max(0, static_cast<int>(floor(min(v0.x, min(v1.x, v2.x))))) };
+	int x1{ min(base.width - 1, static_cast<int>(ceil(max(v0.x, max(v1.x, v2.x))))) };
+	int y0{ max(0, static_cast<int>(floor(min(v0.y, min(v1.y, v2.y))))) };
+	int y1{ min(base.height - 1, static_cast<int>(ceil(max(v0.y, max(v1.y, v2.y))))) };
+	if (x0 > x1 || y0 > y1)
+	{
+		return;
+	}
+
+	touched = { min(touched.x0, x0), min(touched.y0, y0), max(touched.x1, x1), max(touched.y1, y1) };
+
+	// The edge functions are linear, so the texel corner farthest out is half a texel along each axis from
+	// the centre: the triangle touches the texel when the centre is within that margin of every edge.
+	float sign{ area > 0.0f ? 1.0f : -1.0f };
+	float margin0{ 0.5f * (fabs(v2.x - v1.x) + fabs(v2.y - v1.y)) };
+	float margin1{ 0.5f * (fabs(v0.x - v2.x) + fabs(v0.y - v2.y)) };
+	float margin2{ 0.5f * (fabs(v1.x - v0.x) + fabs(v1.y - v0.y)) };
+
+	for (int y{ y0 }; y <= y1; y++)
+	{
+		float py{ static_cast<float>(y) + 0.5f };
+		for (int x{ x0 }; x <= x1; x++)
+		{
+			float px{ static_cast<float>(x) + 0.5f };
+
+			float e0{ ((v2.x - v1.x) * (py - v1.y) - (v2.y - v1.y) * (px - v1.x)) * sign };
+			float e1{ ((v0.x - v2.x) * (py - v2.y) - (v0.y - v2.y) * (px - v2.x)) * sign };
+			float e2{ ((v1.x - v0.x) * (py - v0.y) - (v1.y - v0.y) * (px - v0.x)) * sign };
+			if (e0 < -margin0 || e1 < -margin1 || e2 < -margin2)
+			{
+				continue;
+			}
+
+			// Whatever part of the texel the triangle covers, the front surface there is no farther than the
+			// triangle's depth.
+			size_t i{ static_cast<size_t>(y) * base.width + x };
+			occluderDepth[i] = max(occluderDepth[i], depth);
+			occluderCoverage[i] |= texelTouched;
+			if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f)
+			{
+				occluderCoverage[i] |= texelCentreCovered;
+			}
+
+			if (e0 >= margin0 && e1 >= margin1 && e2 >= margin2)
+			{
+				occluderCoverage[i] |= texelInsideTriangle;
+			}
+		}
+	}
+}
+
+void HiZBuffer::markOutlineEdge(const ScreenVertex& a, const ScreenVertex& b)
+{
+	const Level& base{ levels[0] };
+	int x0{ max(0, static_cast<int>(floor(min(a.x, b.x)))) };
+	int x1{ min(base.width - 1, static_cast<int>(ceil(max(a.x, b.x)))) };
+	int y0{ max(0, static_cast<int>(floor(min(a.y, b.y)))) };
+	int y1{ min(base.height - 1, static_cast<int>(ceil(max(a.y, b.y)))) };
+
+	// The segment passes through the texels within its bounding box whose centre is within half a texel along
+	// each axis of its line.
+	float dx{ b.x - a.x };
+	float dy{ b.y - a.y };
+	float margin{ 0.5f * (fabs(dx) + fabs(dy)) };
+	for (int y{ y0 }; y <= y1; y++)
+	{
+		float py{ static_cast<float>(y) + 0.5f };
+		for (int x{ x0 }; x <= x1; x++)
+		{
+			float px{ static_cast<float>(x) + 0.5f };
+			if (fabs(dx * (py - a.y) - dy * (px - a.x)) <= margin)
+			{
+				occluderCoverage[static_cast<size_t>(y) * base.width + x] |= texelOnOutline;
+			}
+		}
+	}
+}
+
+void HiZBuffer::mergeOccluder(const TexelRect& touched)
+{
+	// A texel whose centre is covered and which no outline passes through is covered entirely, and so is one
+	// lying wholly inside a single triangle, such as the body behind the silhouette of the spout.
+	Level& base{ levels[0] };
+	for (int y{ touched.y0 }; y <= touched.y1; y++)
+	{
+		for (int x{ touched.x0 }; x <= touched.x1; x++)
+		{
+			size_t i{ static_cast<size_t>(y) * base.width + x };
+			uint8_t coverage{ occluderCoverage[i] };
+			if ((coverage & texelInsideTriangle) || (coverage & (texelCentreCovered | texelOnOutline)) == texelCentreCovered)
+			{
+				base.depth[i] = min(base.depth[i], occluderDepth[i]);
+			}
+
+			occluderDepth[i] = 0.0f;
+			occluderCoverage[i] = 0;
+		}
+	}
+}
+
+void HiZBuffer::buildHierarchy()
+{
+	for (size_t l{ 1 }; l < levels.size(); l++)
+	{
+		const Level& src{ levels[l - 1] };
+		Level& dst{ levels[l] };
+
+		for (int y{ 0 }; y < dst.height; y++)
+		{
+			int sy0{ y * 2 };
+			int sy1{ min(sy0 + 1, src.height - 1) };
+			for (int x{ 0 }; x < dst.width; x++)
+			{
+				int sx0{ x * 2 };
+				int sx1{ min(sx0 + 1, src.width - 1) };
+
+				float d{ src.depth[static_cast<size_t>(sy0) * src.width + sx0] };
+				d = max(d, src.depth[static_cast<size_t>(sy0) * src.width + sx1]);
+				d = max(d, src.depth[static_cast<size_t>(sy1) * src.width + sx0]);
+				d = max(d, src.depth[static_cast<size_t>(sy1) * src.width + sx1]);
+				dst.depth[static_cast<size_t>(y) * dst.width + x] = d;
+			}
+		}
+	}
+}
+
+bool HiZBuffer::isBoxVisible(const Aabb& bounds, FXMMATRIX mvp) const
+{
+	const Level& base{ levels[0] };
+	float halfWidth{ static_cast<float>(base.width) * 0.5f };
+	float halfHeight{ static_cast<float>(base.height) * 0.5f };
+
+	float minX{ FLT_MAX };
+	float minY{ FLT_MAX };
+	float maxX{ -FLT_MAX };
+	float maxY{ -FLT_MAX };
+	float minZ{ FLT_MAX };
+
+	for (int i{ 0 }; i < 8; i++)
+	{
+		XMVECTOR corner{ XMVectorSet(
+			(i & 1) ? bounds.maxCorner.x : bounds.minCorner.x,
+			(i & 2) ? bounds.maxCorner.y : bounds.minCorner.y,
+			(i & 4) ? bounds.maxCorner.z : bounds.minCorner.z,
+			1.0f) };
+
+		XMFLOAT4 c;
+		XMStoreFloat4(&c, XMVector4Transform(corner, mvp));
+
+		if (c.w <= FLT_EPSILON || c.z < 0.0f)
+		{
+			return true;
+		}
+
+		float invW{ 1.0f / c.w };
+		float x{ (c.x * invW + 1.0f) * halfWidth };
+		float y{ (1.0f - c.y * invW) * halfHeight };
+
+		minX = min(minX, x);
+		maxX = max(maxX, x);
+		minY = min(minY, y);
+		maxY = max(maxY, y);
+		minZ = min(minZ, c.z * invW);
+	}
+
+	if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(base.width) || minY >= static_cast<float>(base.height) || minZ > 1.0f)
+	{
+		return false;
+	}
+
+	int x0{ max(0, static_cast<int>(floor(minX))) };
+	int x1{ min(base.width - 1, static_cast<int>(floor(maxX))) };
+	int y0{ max(0, static_cast<int>(floor(minY))) };
+	int y1{ min(base.height - 1, static_cast<int>(floor(maxY))) };
+
+	size_t l{ 0 };
+	while (l + 1 < levels.size() && ((x1 >> l) - (x0 >> l) > 1 || (y1 >> l) - (y0 >> l) > 1))
+	{
+		++l;
+	}
+
+	const Level& level{ levels[l] };
+	float maxDepth{ 0.0f };
+	for (int y{ y0 >> l }; y <= (y1 >> l); y++)
+	{
+		for (int x{ x0 >> l }; x <= (x1 >> l); x++)
+		{
+			maxDepth = max(maxDepth, level.depth[static_cast<size_t>(y) * level.width + x]);
+		}
+	}
+
+	return minZ <= maxDepth;
+}
+
+int HiZBuffer::getWidth() const
+{
+	return levels[0].width;
+}
+
+int HiZBuffer::getHeight() const
+{
+	return levels[0].height;
+}
+
+int HiZBuffer::getLevelCount() const
+{
+	return static_cast<int>(levels.size());
+}
+
+float HiZBuffer::getDepth(int level, int x, int y) const
+{
+	const Level& l{ levels.at(level) };
+	return l.depth[static_cast<size_t>(y) * l.width + x];
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include "PatchTessellator.h"
+
+// A coarse tessellation standing in for patches in the depth buffer, with for each triangle the bounds of the
+// part of the patch it approximates and the triangles across its edges, which tell the edges inside the
+// occluder from those on its outline.
+struct OccluderMesh
+{
+	static const uint32_t noNeighbor{ 0xFFFFFFFF };
+
+	TessellatedMesh mesh;
+	std::vector<Aabb> triangleBounds;
+	// For edge k of each triangle, from corner k to corner k + 1, the triangle on the other side, or noNeighbor.
+	std::vector<uint32_t> edgeNeighbors;
+
+	// Patches are tessellated separately, so their vertices along shared seams are matched by position, within
+	// weldDistance. Triangles the weld collapses, as at the poles of the lid and the bottom, are dropped, and
+	// every connected part is wound consistently, with its normals pointing out.
+	void buildTopology(float weldDistance);
+};
+
+// Low resolution CPU depth buffer with a max-depth mip chain. Occluders are rasterized into level 0, the
+// chain is built once per frame and bounding boxes are then tested against the coarsest level that covers
+// them with a 2x2 texel footprint. Depth follows the D3D convention used by the pipeline: 0 near, 1 far,
+// LESS comparison. Coverage is conservative: a texel only takes an occluder's depth when the occluder covers
+// all of it, so nothing showing through the uncovered part of a texel at a silhouette is culled.
+class HiZBuffer
+{
+public:
+	HiZBuffer(int width, int height);
+
+	void clear();
+	void rasterizeOccluder(const OccluderMesh& occluder, DirectX::FXMMATRIX mvp);
+	void buildHierarchy();
+	bool isBoxVisible(const Aabb& bounds, DirectX::FXMMATRIX mvp) const;
+
+	int getWidth() const;
+	int getHeight() const;
+	int getLevelCount() const;
+	float getDepth(int level, int x, int y) const;
+
+private:
+	struct Level
+	{
+		int width;
+		int height;
+		std::vector<float> depth;
+	};
+
+	struct ScreenVertex
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	struct TexelRect
+	{
+		int x0;
+		int y0;
+		int x1;
+		int y1;
+	};
+
+	void rasterizeTriangle(const ScreenVertex& v0, const ScreenVertex& v1, const ScreenVertex& v2, float depth, TexelRect& touched);
+	void markOutlineEdge(const ScreenVertex& a, const ScreenVertex& b);
+	void mergeOccluder(const TexelRect& touched);
+	// The farthest depth of the box, or 1 when part of it is behind the eye.
+	static float computeFarthestDepth(const Aabb& bounds, DirectX::FXMMATRIX mvp);
+
+private:
+	std::vector<Level> levels;
+	std::vector<ScreenVertex> screenPositions;
+	std::vector<uint8_t> projected;
+	std::vector<uint8_t> drawnTriangles;
+	// Per level 0 texel while one occluder is rasterized: the farthest depth of its triangles touching the texel
+	// and how the texel is covered.
+	std::vector<float> occluderDepth;
+	std::vector<uint8_t> occluderCoverage;
+};
\ No newline at end of file
@@ -10,6 +10,7 @@ ConstantBuffer<PatchTesselationFactors> tessFactors : register(b0);
 struct VertexToHull
 {
 	float3 pos : POSITION;
+	uint instance : INSTANCE;
 };
 
 struct PatchConstantData
@@ -21,6 +22,7 @@ struct PatchConstantData
 struct HullToDomain
 {
 	float3 pos : POSITION;
+	uint instance : INSTANCE;
 };
 
 PatchConstantData calculatePatchConstants()
@@ -46,6 +48,7 @@ HullToDomain main(InputPatch<VertexToHull, NUM_CONTROL_POINTS> input, uint i : S
 {
 	HullToDomain output;
 	output.pos = input[i].pos;
+	output.instance = input[i].instance;
 
 	return output;
 }
\ No newline at end of file
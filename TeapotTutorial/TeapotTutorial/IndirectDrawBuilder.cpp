@@ -0,0 +1,100 @@
+#include "IndirectDrawBuilder.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+IndirectDrawBuilder::IndirectDrawBuilder(uint32_t patchesPerChunk, uint32_t indicesPerPatch) : patchesPerChunk{ patchesPerChunk }, indicesPerPatch{ indicesPerPatch }
+{
+	if (patchesPerChunk == 0 || indicesPerPatch == 0)
+	{
+		throw(runtime_error{ "Invalid indirect draw layout." });
+	}
+
+	resetStats();
+}
+
+uint32_t IndirectDrawBuilder::build(const vector<uint32_t>& visiblePatches, const vector<uint8_t>& chunkResident, const vector<InstanceRange>& instanceRanges, PatchDrawCommand* commands)
+{
+	groups.clear();
+	uint32_t numCommands{ 0 };
+	size_t numVisible{ visiblePatches.size() };
+
+	for (size_t i{ 0 }; i < numVisible;)
+	{
+		uint32_t firstPatch{ visiblePatches[i] };
+		uint32_t chunk{ firstPatch / patchesPerChunk };
+		uint32_t chunkEnd{ (chunk + 1) * patchesPerChunk };
+		uint32_t numPatches{ 1 };
+		while (i + numPatches < numVisible && visiblePatches[i + numPatches] == firstPatch + numPatches && firstPatch + numPatches < chunkEnd)
+		{
+			++numPatches;
+		}
+
+		i += numPatches;
+
+		// Patches of chunks that are still being streamed in are left out until they arrive.
+		if (chunk >= chunkResident.size() || chunkResident[chunk] == 0)
+		{
+			stats.patchesDropped += numPatches;
+			continue;
+		}
+
+		if (groups.empty() || groups.back().chunk != chunk)
+		{
+			groups.push_back({ chunk, numCommands, 0 });
+		}
+
+		for (const InstanceRange& range : instanceRanges)
+		{
+			if (range.numInstances == 0)
+			{
+				continue;
+			}
+
+			// Built on the stack and copied whole, so mapped write-combined memory sees one sequential write.
+			PatchDrawCommand command;
+			command.tessFactors[0] = range.tessFactor;
+			command.tessFactors[1] = range.tessFactor;
+			command.firstPatch = firstPatch;
+			command.firstInstance = range.firstInstance;
+			command.draw.indexCountPerInstance = numPatches * indicesPerPatch;
+			command.draw.instanceCount = range.numInstances;
+			command.draw.startIndexLocation = (firstPatch - chunk * patchesPerChunk) * indicesPerPatch;
+			command.draw.baseVertexLocation = 0;
+			command.draw.startInstanceLocation = 0;
+			memcpy(commands + numCommands, &command, sizeof(command));
+
+			uint64_t cells{ static_cast<uint64_t>(range.tessFactor) * static_cast<uint64_t>(range.tessFactor) };
+			stats.triangles += static_cast<uint64_t>(numPatches) * range.numInstances * cells * 2;
+			++groups.back().numCommands;
+			++numCommands;
+		}
+	}
+
+	++stats.builds;
+	stats.patchesVisited += numVisible;
+	stats.commands += numCommands;
+	stats.groups += groups.size();
+	return numCommands;
+}
+
+const vector<IndirectDrawBuilder::Group>& IndirectDrawBuilder::getGroups() const
+{
+	return groups;
+}
+
+uint32_t IndirectDrawBuilder::getPatchesPerChunk() const
+{
+	return patchesPerChunk;
+}
+
+const IndirectDrawBuilder::Stats& IndirectDrawBuilder::getStats() const
+{
+	return stats;
+}
+
+void IndirectDrawBuilder::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
\ No newline at end of file
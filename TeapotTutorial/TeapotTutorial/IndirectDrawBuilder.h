@@ -0,0 +1,75 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "RenderTypes.h"
+
+// One draw of consecutive patches as it goes into an indirect argument buffer: the hull shader's tessellation
+// factors and the domain shader's first patch index and first instance order entry as root constants, then
+// the draw. The layout is the one TeapotRenderer's command signature describes, and the direct path records
+// the same commands one call at a time.
+struct PatchDrawCommand
+{
+	int32_t tessFactors[2];
+	uint32_t firstPatch;
+	uint32_t firstInstance;
+	DrawIndexedArguments draw;
+};
+
+static_assert(sizeof(PatchDrawCommand) == 36, "Patch draw commands are packed for the command signature.");
+
+// Instances drawn with one tessellation factor: a range of the instance order the domain shader looks
+// instances up in.
+struct InstanceRange
+{
+	int tessFactor;
+	uint32_t firstInstance;
+	uint32_t numInstances;
+};
+
+// Turns the visible patch list into packed draw commands on the CPU, with no device calls, so the stage can be
+// timed and tested on its own. Consecutive visible patches of the same index chunk become one command (the
+// compaction); patches of chunks that are not resident are dropped. Each run of patches is drawn once per
+// instance range. Commands come out in patch order, so each chunk's commands are contiguous and form a group
+// that shares one index buffer binding.
+class IndirectDrawBuilder
+{
+public:
+	struct Group
+	{
+		uint32_t chunk;
+		uint32_t firstCommand;
+		uint32_t numCommands;
+	};
+
+	struct Stats
+	{
+		uint64_t builds;
+		uint64_t patchesVisited;
+		uint64_t patchesDropped;
+		uint64_t commands;
+		uint64_t groups;
+		// Of the quad patches drawn, at two triangles per tessellated cell.
+		uint64_t triangles;
+	};
+
+	IndirectDrawBuilder(uint32_t patchesPerChunk, uint32_t indicesPerPatch);
+
+	// Writes at most visiblePatches.size() * instanceRanges.size() commands to commands, which may be mapped
+	// upload memory: it is only written, front to back. visiblePatches must be sorted; chunkResident holds a
+	// flag per chunk. Empty instance ranges are skipped. Returns the number of commands.
+	uint32_t build(const std::vector<uint32_t>& visiblePatches, const std::vector<uint8_t>& chunkResident, const std::vector<InstanceRange>& instanceRanges, PatchDrawCommand* commands);
+
+	// The groups of the last build, in chunk order.
+	const std::vector<Group>& getGroups() const;
+	uint32_t getPatchesPerChunk() const;
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	uint32_t patchesPerChunk;
+	uint32_t indicesPerPatch;
+	std::vector<Group> groups;
+	Stats stats;
+};
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "InputEventQueue.h"
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+
+InputEventQueue::InputEventQueue(uint32_t capacity) : writePosition{ 0 }, pushed{ 0 }, dropped{ 0 }
+{
+	if (capacity < 2)
+	{
+		throw(runtime_error{ "Input event queue needs room for at least two events." });
+	}
+
+	uint64_t size{ 1 };
+	while (size < capacity)
+	{
+		size *= 2;
+	}
+
+	// A cell is free for the writer at position p when its sequence is p and holds an event for the reader at
+	// position p when it is p + 1.
+	cells.reset(new Cell[static_cast<size_t>(size)]);
+	for (uint64_t i{ 0 }; i < size; i++)
+	{
+		cells[static_cast<size_t>(i)].sequence.store(i, memory_order_relaxed);
+	}
+
+	mask = size - 1;
+}
+
+bool InputEventQueue::push(InputEventType type, uint32_t key, bool repeat, int32_t x, int32_t y)
+{
+	uint64_t position{ writePosition.load(memory_order_relaxed) };
+	Cell* cell;
+	while (true)
+	{
+		cell = &cells[static_cast<size_t>(position & mask)];
+		int64_t difference{ static_cast<int64_t>(cell->sequence.load(memory_order_acquire) - position) };
+		if (difference == 0)
+		{
+			if (writePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			dropped.fetch_add(1, memory_order_relaxed);
+			return false;
+		}
+		else
+		{
+			position = writePosition.load(memory_order_relaxed);
+		}
+	}
+
+	cell->event = { type, key, repeat, x, y, getTimestamp() };
+	cell->sequence.store(position + 1, memory_order_release);
+	pushed.fetch_add(1, memory_order_relaxed);
+	return true;
+}
+
+uint32_t InputEventQueue::subscribe(Subscriber subscriber)
+{
+	subscribers.emplace_back(nextSubscription, move(subscriber));
+	return nextSubscription++;
+}
+
+void InputEventQueue::unsubscribe(uint32_t subscription)
+{
+	for (auto i = subscribers.begin(); i != subscribers.end(); ++i)
+	{
+		if (i->first == subscription)
+		{
+			subscribers.erase(i);
+			return;
+		}
+	}
+
+	throw(runtime_error{ "Unsubscribing an unknown input subscription." });
+}
+
+uint32_t InputEventQueue::dispatch()
+{
+	uint32_t count{ 0 };
+	InputEvent event;
+	while (pop(event))
+	{
+		for (const auto& subscriber : subscribers)
+		{
+			subscriber.second(event);
+		}
+
+		++count;
+	}
+
+	dispatched += count;
+	return count;
+}
+
+InputEventQueue::Stats InputEventQueue::getStats() const
+{
+	Stats stats;
+	stats.pushed = pushed.load(memory_order_relaxed);
+	stats.dropped = dropped.load(memory_order_relaxed);
+	stats.dispatched = dispatched;
+	return stats;
+}
+
+uint64_t InputEventQueue::getTimestamp()
+{
+	return static_cast<uint64_t>(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool InputEventQueue::pop(InputEvent& event)
+{
+	Cell& cell{ cells[static_cast<size_t>(readPosition & mask)] };
+	if (cell.sequence.load(memory_order_acquire) != readPosition + 1)
+	{
+		return false;
+	}
+
+	event = cell.event;
+	cell.sequence.store(readPosition + mask + 1, memory_order_release);
+	++readPosition;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <utility>
+#include <cstdint>
+
+enum class InputEventType : uint32_t
+{
+	KeyDown,
+	KeyUp,
+	MouseMove,
+	Resize
+};
+
+struct InputEvent
+{
+	InputEventType type;
+	// Virtual key code for key events.
+	uint32_t key;
+	// For key downs, whether the key was already down: an auto-repeat while it is held.
+	bool repeat;
+	// Client area position for mouse moves, client area size for resizes.
+	int32_t x;
+	int32_t y;
+	// Microseconds on the steady clock, taken when the event was pushed.
+	uint64_t timestamp;
+};
+
+// Bounded lock-free queue of input events from any number of producer threads to one consumer. Producers claim
+// a cell with one compare and swap on the write position and publish it through the cell's sequence number,
+// so a producer is never blocked by another one or by the consumer; when the queue is full the event is
+// dropped and counted. The consumer drains the queue once per update with dispatch(), which hands every event
+// in order to all subscribers, so input is handled in a batch on the thread that owns the state it changes.
+class InputEventQueue
+{
+public:
+	typedef std::function<void(const InputEvent& event)> Subscriber;
+
+	struct Stats
+	{
+		uint64_t pushed;
+		uint64_t dropped;
+		uint64_t dispatched;
+	};
+
+	// capacity is rounded up to a power of two.
+	explicit InputEventQueue(uint32_t capacity);
+
+	// Any thread. Fills in the timestamp; returns false when the queue is full.
+	bool push(InputEventType type, uint32_t key, bool repeat, int32_t x, int32_t y);
+
+	// Consumer thread only.
+	uint32_t subscribe(Subscriber subscriber);
+	void unsubscribe(uint32_t subscription);
+	// Returns the number of events dispatched.
+	uint32_t dispatch();
+
+	Stats getStats() const;
+
+	static uint64_t getTimestamp();
+
+private:
+	struct Cell
+	{
+		std::atomic<uint64_t> sequence;
+		InputEvent event;
+	};
+
+	bool pop(InputEvent& event);
+
+private:
+	std::unique_ptr<Cell[]> cells;
+	uint64_t mask;
+	std::atomic<uint64_t> writePosition;
+	uint64_t readPosition{ 0 };
+
+	std::vector<std::pair<uint32_t, Subscriber>> subscribers;
+	uint32_t nextSubscription{ 1 };
+
+	std::atomic<uint64_t> pushed;
+	std::atomic<uint64_t> dropped;
+	uint64_t dispatched{ 0 };
+};
\ No newline at end of file
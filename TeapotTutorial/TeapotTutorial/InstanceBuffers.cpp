@@ -0,0 +1,140 @@
+#include "InstanceBuffers.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	// Big enough that a copy job moves about a megabyte of colors.
+	const uint32_t colorsPerCopyJob{ 65536 };
+	// And of instance order.
+	const uint32_t orderEntriesPerCopyJob{ 262144 };
+}
+
+InstanceBuffers::InstanceBuffers(RenderDevice& device, DescriptorAllocator& descriptors, JobSystem& jobs, uint32_t slotCount, ResourceHandle matrices, uint32_t numMatrices) : device{ device }, descriptors{ descriptors }, jobs{ jobs }, matrices{ matrices }, numMatrices{ numMatrices }, slots(slotCount)
+{
+	if (slotCount == 0)
+	{
+		throw(runtime_error{ "Instance buffers need at least one slot." });
+	}
+
+	resetStats();
+}
+
+InstanceBuffers::~InstanceBuffers()
+{
+	releaseSlots();
+}
+
+void InstanceBuffers::reserve(uint32_t capacity)
+{
+	if (capacity <= this->capacity)
+	{
+		return;
+	}
+
+	// The old buffers may still be read by frames in flight.
+	if (this->capacity > 0)
+	{
+		device.waitIdle();
+		releaseSlots();
+	}
+
+	// Grows by half again, so instance counts creeping upwards do not replace the buffers every frame.
+	uint32_t newCapacity{ this->capacity + this->capacity / 2 };
+	this->capacity = newCapacity > capacity ? newCapacity : capacity;
+
+	for (Slot& slot : slots)
+	{
+		slot.colors = device.createBuffer({ static_cast<uint64_t>(this->capacity) * sizeof(XMFLOAT4), HeapType::Upload, ResourceState::GenericRead, "instance colors" }, nullptr);
+		slot.order = device.createBuffer({ static_cast<uint64_t>(this->capacity) * sizeof(uint32_t), HeapType::Upload, ResourceState::GenericRead, "instance order" }, nullptr);
+		slot.colorsData = static_cast<XMFLOAT4*>(device.mapBuffer(slot.colors));
+		slot.orderData = static_cast<uint32_t*>(device.mapBuffer(slot.order));
+
+		slot.views = descriptors.allocatePersistent(3);
+		descriptors.createShaderResourceView(slot.views, 0, matrices, { 0, numMatrices, static_cast<uint32_t>(sizeof(XMFLOAT4X4)) });
+		descriptors.createShaderResourceView(slot.views, 1, slot.colors, { 0, this->capacity, static_cast<uint32_t>(sizeof(XMFLOAT4)) });
+		descriptors.createShaderResourceView(slot.views, 2, slot.order, { 0, this->capacity, static_cast<uint32_t>(sizeof(uint32_t)) });
+	}
+}
+
+void InstanceBuffers::updateColors(uint32_t slot, uint32_t count, const XMFLOAT4* colors)
+{
+	if (slot >= slots.size() || count > capacity)
+	{
+		throw(runtime_error{ "Instance update out of range." });
+	}
+
+	auto begin{ chrono::steady_clock::now() };
+
+	// The buffers are write combined on most GPUs: each job writes its range front to back and never reads it.
+	const Slot& s{ slots[slot] };
+	jobs.parallelFor(count, colorsPerCopyJob, [&](uint32_t first, uint32_t end)
+	{
+		memcpy(s.colorsData + first, colors + first, (end - first) * sizeof(XMFLOAT4));
+	});
+
+	++stats.updates;
+	stats.instancesWritten += count;
+	stats.bytesWritten += static_cast<uint64_t>(count) * sizeof(XMFLOAT4);
+	stats.updateMilliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+void InstanceBuffers::updateOrder(uint32_t slot, uint32_t count, const uint32_t* order)
+{
+	if (slot >= slots.size() || count > capacity)
+	{
+		throw(runtime_error{ "Instance update out of range." });
+	}
+
+	auto begin{ chrono::steady_clock::now() };
+
+	const Slot& s{ slots[slot] };
+	jobs.parallelFor(count, orderEntriesPerCopyJob, [&](uint32_t first, uint32_t end)
+	{
+		memcpy(s.orderData + first, order + first, (end - first) * sizeof(uint32_t));
+	});
+
+	stats.bytesWritten += static_cast<uint64_t>(count) * sizeof(uint32_t);
+	stats.updateMilliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+DescriptorHandle InstanceBuffers::getTable(uint32_t slot) const
+{
+	return slots.at(slot).views.gpu;
+}
+
+uint32_t InstanceBuffers::getCapacity() const
+{
+	return capacity;
+}
+
+const InstanceBuffers::Stats& InstanceBuffers::getStats() const
+{
+	return stats;
+}
+
+void InstanceBuffers::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void InstanceBuffers::releaseSlots()
+{
+	if (capacity == 0)
+	{
+		return;
+	}
+
+	for (Slot& slot : slots)
+	{
+		device.unmapBuffer(slot.colors);
+		device.unmapBuffer(slot.order);
+		device.releaseResource(slot.colors);
+		device.releaseResource(slot.order);
+		descriptors.freePersistent(slot.views);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "DescriptorAllocator.h"
+#include "JobSystem.h"
+
+// Per instance colors for instanced draws, read by the domain shader through structured buffer views, along
+// with the instance order the draws look instances up through: draws cover ranges of the order, so instances
+// sorted by level of detail draw without moving their data. There is one set of persistently mapped upload
+// heap buffers per frame slot, indexed by back buffer: FramePacer has the frame that renders to a back buffer
+// wait for the last one that did, so a slot is never written while the GPU reads it. The instance matrices
+// are written elsewhere every frame; the tables start with a view of the buffer they go to. Each slot's views
+// sit in a persistent descriptor range that is bound as is, so writing new instance data is the only per
+// frame cost, and it is timed.
+class InstanceBuffers
+{
+public:
+	struct Stats
+	{
+		uint64_t updates;
+		uint64_t instancesWritten;
+		uint64_t bytesWritten;
+		double updateMilliseconds;
+	};
+
+	// matrices holds numMatrices instance matrices, e.g. an upload ring the frame's matrices are written to.
+	InstanceBuffers(RenderDevice& device, DescriptorAllocator& descriptors, JobSystem& jobs, uint32_t slotCount, ResourceHandle matrices, uint32_t numMatrices);
+	~InstanceBuffers();
+
+	InstanceBuffers(const InstanceBuffers&) = delete;
+	InstanceBuffers& operator=(const InstanceBuffers&) = delete;
+
+	// Grows every slot to hold at least capacity instances. Replacing the buffers waits for the GPU and leaves
+	// the slots empty.
+	void reserve(uint32_t capacity);
+	// Writes the first count instances' colors to the slot, splitting large copies across the job system.
+	void updateColors(uint32_t slot, uint32_t count, const DirectX::XMFLOAT4* colors);
+	// Writes the instance order alone, which changes every frame the levels of detail are selected.
+	void updateOrder(uint32_t slot, uint32_t count, const uint32_t* order);
+
+	// The matrices, colors and order views of the slot, for a three descriptor table.
+	DescriptorHandle getTable(uint32_t slot) const;
+	uint32_t getCapacity() const;
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct Slot
+	{
+		ResourceHandle colors;
+		ResourceHandle order;
+		DirectX::XMFLOAT4* colorsData;
+		uint32_t* orderData;
+		DescriptorAllocator::Range views;
+	};
+
+	void releaseSlots();
+
+private:
+	RenderDevice& device;
+	DescriptorAllocator& descriptors;
+	JobSystem& jobs;
+	ResourceHandle matrices;
+	uint32_t numMatrices;
+	uint32_t capacity{ 0 };
+	std::vector<Slot> slots;
+	Stats stats;
+};
\ No newline at end of file
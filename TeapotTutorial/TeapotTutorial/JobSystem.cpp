@@ -0,0 +1,346 @@
+#include "JobSystem.h"
+#include <stdexcept>
+#ifdef _WIN32
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace
+{
+	// Set on the pool's own threads, so jobs they spawn go to their deque.
+	thread_local const JobSystem* currentJobSystem{ nullptr };
+	thread_local uint32_t currentWorker{ 0 };
+}
+
+JobSystem::Counter::Counter() : value{ 0 }
+{
+}
+
+bool JobSystem::Counter::isDone() const
+{
+	return value.load(memory_order_acquire) == 0;
+}
+
+JobSystem::JobSystem(uint32_t numWorkers, bool pinWorkers) : queuedTasks{ 0 }, jobsRun{ 0 }, jobsStolen{ 0 }, parallelFors{ 0 }
+{
+	if (numWorkers == 0)
+	{
+		uint32_t hardwareThreads{ thread::hardware_concurrency() };
+		numWorkers = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+	}
+
+	for (uint32_t i{ 0 }; i <= numWorkers; i++)
+	{
+		queues.push_back(make_unique<Queue>());
+	}
+
+	for (uint32_t i{ 0 }; i < numWorkers; i++)
+	{
+		threads.emplace_back(&JobSystem::runWorker, this, i);
+		if (pinWorkers)
+		{
+			pinThread(threads.back(), i + 1);
+		}
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		lock_guard<mutex> lock{ sleepMutex };
+		stopping = true;
+	}
+
+	jobsAvailable.notify_all();
+	for (thread& t : threads)
+	{
+		t.join();
+	}
+}
+
+void JobSystem::run(Job job, Counter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->value.fetch_add(1, memory_order_relaxed);
+	}
+
+	push({ move(job), counter });
+}
+
+void JobSystem::runAfter(Counter& dependency, Job job, Counter* counter)
+{
+	if (counter != nullptr)
+	{
+		counter->value.fetch_add(1, memory_order_relaxed);
+	}
+
+	// The dependency's lock orders this against the job that takes it to zero, which queues whatever was
+	// added before.
+	{
+		lock_guard<mutex> lock{ dependency.mutex };
+		if (!dependency.isDone())
+		{
+			dependency.continuations.push_back({ move(job), counter });
+			return;
+		}
+	}
+
+	push({ move(job), counter });
+}
+
+void JobSystem::wait(Counter& counter)
+{
+	uint32_t queue{ getQueueIndex() };
+	while (!counter.isDone())
+	{
+		if (!tryRunTask(queue))
+		{
+			this_thread::yield();
+		}
+	}
+
+	// The job that finished the counter may still hold its lock; the caller is free to destroy it only after.
+	exception_ptr error;
+	{
+		lock_guard<mutex> lock{ counter.mutex };
+		error = counter.error;
+		counter.error = nullptr;
+	}
+
+	if (error)
+	{
+		rethrow_exception(error);
+	}
+}
+
+void JobSystem::parallelFor(uint32_t count, uint32_t grainSize, const RangeJob& body)
+{
+	if (grainSize == 0)
+	{
+		throw(runtime_error{ "Parallel for needs a non zero grain size." });
+	}
+
+	// A single range is not worth a trip through the queues.
+	if (count <= grainSize)
+	{
+		if (count > 0)
+		{
+			body(0, count);
+		}
+
+		return;
+	}
+
+	parallelFors.fetch_add(1, memory_order_relaxed);
+
+	// The calling thread keeps the first range and helps with the rest while it waits.
+	Counter counter;
+	for (uint32_t begin{ grainSize }; begin < count; begin += grainSize)
+	{
+		uint32_t end{ count - begin > grainSize ? begin + grainSize : count };
+		run([&body, begin, end] { body(begin, end); }, &counter);
+	}
+
+	// The queued ranges refer to body and counter, so they are waited for even when the first range throws.
+	exception_ptr error;
+	try
+	{
+		body(0, grainSize);
+	}
+	catch (...)
+	{
+		error = current_exception();
+	}
+
+	wait(counter);
+	if (error)
+	{
+		rethrow_exception(error);
+	}
+}
+
+uint32_t JobSystem::getWorkerCount() const
+{
+	return static_cast<uint32_t>(threads.size());
+}
+
+JobSystem::Stats JobSystem::getStats() const
+{
+	Stats stats;
+	stats.jobsRun = jobsRun.load();
+	stats.jobsStolen = jobsStolen.load();
+	stats.parallelFors = parallelFors.load();
+	return stats;
+}
+
+void JobSystem::resetStats()
+{
+	jobsRun = 0;
+	jobsStolen = 0;
+	parallelFors = 0;
+}
+
+void JobSystem::push(Task task)
+{
+	// Counted under the sleep lock, so a worker about to sleep either sees the count or gets the notification.
+	// The count goes up before the task is visible, so it never drops below the number of queued tasks.
+	{
+		lock_guard<mutex> lock{ sleepMutex };
+		queuedTasks.fetch_add(1, memory_order_relaxed);
+	}
+
+	Queue& queue{ *queues[getQueueIndex()] };
+	{
+		lock_guard<mutex> lock{ queue.mutex };
+		queue.tasks.push_back(move(task));
+	}
+
+	jobsAvailable.notify_one();
+}
+
+bool JobSystem::tryRunTask(uint32_t queue)
+{
+	Task task;
+	if (!popOwn(queue, task) && !steal(queue, task))
+	{
+		return false;
+	}
+
+	execute(task);
+	return true;
+}
+
+bool JobSystem::popOwn(uint32_t queue, Task& task)
+{
+	Queue& own{ *queues[queue] };
+	lock_guard<mutex> lock{ own.mutex };
+	if (own.tasks.empty())
+	{
+		return false;
+	}
+
+	task = move(own.tasks.back());
+	own.tasks.pop_back();
+	queuedTasks.fetch_sub(1, memory_order_relaxed);
+	return true;
+}
+
+bool JobSystem::steal(uint32_t queue, Task& task)
+{
+	// Victims are tried starting after the thief, so not every thief goes for the same deque first.
+	uint32_t numQueues{ static_cast<uint32_t>(queues.size()) };
+	for (uint32_t i{ 1 }; i < numQueues; i++)
+	{
+		Queue& victim{ *queues[(queue + i) % numQueues] };
+		lock_guard<mutex> lock{ victim.mutex };
+		if (!victim.tasks.empty())
+		{
+			task = move(victim.tasks.front());
+			victim.tasks.pop_front();
+			queuedTasks.fetch_sub(1, memory_order_relaxed);
+			jobsStolen.fetch_add(1, memory_order_relaxed);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void JobSystem::execute(Task& task)
+{
+	// An exception is handed to whoever waits for the job; without a counter there is nobody to tell.
+	try
+	{
+		task.job();
+	}
+	catch (...)
+	{
+		if (task.counter == nullptr)
+		{
+			throw;
+		}
+
+		lock_guard<mutex> lock{ task.counter->mutex };
+		if (!task.counter->error)
+		{
+			task.counter->error = current_exception();
+		}
+	}
+
+	jobsRun.fetch_add(1, memory_order_relaxed);
+	finish(task.counter);
+}
+
+void JobSystem::finish(Counter* counter)
+{
+	if (counter == nullptr)
+	{
+		return;
+	}
+
+	vector<Counter::Continuation> continuations;
+	{
+		lock_guard<mutex> lock{ counter->mutex };
+		if (counter->value.fetch_sub(1, memory_order_acq_rel) == 1)
+		{
+			continuations.swap(counter->continuations);
+		}
+	}
+
+	for (Counter::Continuation& continuation : continuations)
+	{
+		push({ move(continuation.job), continuation.counter });
+	}
+}
+
+void JobSystem::runWorker(uint32_t worker)
+{
+	currentJobSystem = this;
+	currentWorker = worker;
+
+	while (true)
+	{
+		if (tryRunTask(worker))
+		{
+			continue;
+		}
+
+		unique_lock<mutex> lock{ sleepMutex };
+		jobsAvailable.wait(lock, [this] { return stopping || queuedTasks.load(memory_order_relaxed) > 0; });
+		if (stopping)
+		{
+			return;
+		}
+	}
+}
+
+uint32_t JobSystem::getQueueIndex() const
+{
+	return currentJobSystem == this ? currentWorker : static_cast<uint32_t>(queues.size() - 1);
+}
+
+void JobSystem::pinThread(thread& workerThread, uint32_t core)
+{
+	uint32_t numCores{ thread::hardware_concurrency() };
+	if (numCores < 2)
+	{
+		return;
+	}
+
+	core %= numCores;
+#ifdef _WIN32
+	SetThreadAffinityMask(workerThread.native_handle(), static_cast<DWORD_PTR>(1) << core);
+#elif defined(__linux__)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(core, &cpus);
+	pthread_setaffinity_np(workerThread.native_handle(), sizeof(cpus), &cpus);
+#else
+	(void)workerThread;
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <cstdint>
+
+// Thread pool for the CPU work of a frame. Every worker has its own deque: jobs a worker spawns go to the back
+// of its deque and it takes its own work from the back (most recent first, while the data is in cache), while
+// idle workers steal from the front of the others'. Jobs spawned by threads outside the pool go to a shared
+// deque that is stolen from the same way. Workers are pinned to one core each, leaving the first core to the
+// thread that creates the pool and submits to the GPU.
+//
+// Completion is tracked with counters: run() increments the counter it is given and the job decrements it when
+// done. wait() executes queued jobs until the counter drops to zero, so a thread never blocks on work it could
+// do itself, and runAfter() holds a job back until another counter has dropped to zero.
+class JobSystem
+{
+public:
+	typedef std::function<void()> Job;
+	typedef std::function<void(uint32_t begin, uint32_t end)> RangeJob;
+
+	class Counter
+	{
+	public:
+		Counter();
+		Counter(const Counter&) = delete;
+		Counter& operator=(const Counter&) = delete;
+
+		bool isDone() const;
+
+	private:
+		struct Continuation
+		{
+			Job job;
+			Counter* counter;
+		};
+
+		std::atomic<uint32_t> value;
+		std::mutex mutex;
+		std::exception_ptr error;
+		std::vector<Continuation> continuations;
+
+		friend class JobSystem;
+	};
+
+	struct Stats
+	{
+		uint64_t jobsRun;
+		uint64_t jobsStolen;
+		uint64_t parallelFors;
+	};
+
+	// 0 workers sizes the pool to the hardware threads, less the one calling into it. A pool for background work
+	// leaves its workers unpinned, so they fit in around the frame's workers instead of sharing their cores.
+	explicit JobSystem(uint32_t numWorkers = 0, bool pinWorkers = true);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// counter may be nullptr for jobs nobody waits for.
+	void run(Job job, Counter* counter);
+	// Queues job once dependency is done; counter counts it from now on, so waiting for it covers both.
+	void runAfter(Counter& dependency, Job job, Counter* counter);
+	// Rethrows the first exception thrown by a job counted by counter.
+	void wait(Counter& counter);
+
+	// Calls body with consecutive ranges of at most grainSize items covering [0, count) and returns once all
+	// are done. Ranges run in any order and on any thread, including the calling one.
+	void parallelFor(uint32_t count, uint32_t grainSize, const RangeJob& body);
+
+	uint32_t getWorkerCount() const;
+	// The stats are updated from every thread, so they are read and reset between frames only.
+	Stats getStats() const;
+	void resetStats();
+
+private:
+	struct Task
+	{
+		Job job;
+		Counter* counter;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	void push(Task task);
+	bool tryRunTask(uint32_t queue);
+	bool popOwn(uint32_t queue, Task& task);
+	bool steal(uint32_t queue, Task& task);
+	void execute(Task& task);
+	void finish(Counter* counter);
+	void runWorker(uint32_t worker);
+	uint32_t getQueueIndex() const;
+	static void pinThread(std::thread& workerThread, uint32_t core);
+
+private:
+	// One queue per worker and a last one shared by all other threads.
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> threads;
+
+	std::mutex sleepMutex;
+	std::condition_variable jobsAvailable;
+	std::atomic<uint32_t> queuedTasks;
+	bool stopping{ false };
+
+	std::atomic<uint64_t> jobsRun;
+	std::atomic<uint64_t> jobsStolen;
+	std::atomic<uint64_t> parallelFors;
+};
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "LinearRingAllocator.h"
+#include <stdexcept>
+
+using namespace std;
+
+LinearRingAllocator::LinearRingAllocator(uint64_t size) : size{ size }
+{
+	if (size == 0)
+	{
+		throw(runtime_error{ "Ring allocator needs a non zero size." });
+	}
+}
+
+uint64_t LinearRingAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0)
+	{
+		throw(runtime_error{ "Invalid ring allocation." });
+	}
+
+	if (used == 0)
+	{
+		head = 0;
+		tail = 0;
+	}
+	else if (head == tail)
+	{
+		return invalidOffset;
+	}
+
+	uint64_t offset{ (head + alignment - 1) & ~(alignment - 1) };
+	uint64_t consumed;
+
+	if (head >= tail)
+	{
+		// Free space is [head, size) followed by [0, tail). A range never straddles the end; the rest of the
+		// ring is skipped instead and comes back when the range in front of it is released.
+		if (offset + size <= this->size)
+		{
+			consumed = offset + size - head;
+		}
+		else if (size <= tail)
+		{
+			offset = 0;
+			consumed = this->size - head + size;
+		}
+		else
+		{
+			return invalidOffset;
+		}
+	}
+	else
+	{
+		if (offset + size > tail)
+		{
+			return invalidOffset;
+		}
+
+		consumed = offset + size - head;
+	}
+
+	head = offset + size;
+	used += consumed;
+	pendingBytes += consumed;
+	return offset;
+}
+
+void LinearRingAllocator::retire(uint64_t fenceValue)
+{
+	if (pendingBytes == 0)
+	{
+		return;
+	}
+
+	retirements.push_back({ fenceValue, head, pendingBytes });
+	pendingBytes = 0;
+}
+
+void LinearRingAllocator::release(uint64_t completedFenceValue)
+{
+	while (!retirements.empty() && retirements.front().fenceValue <= completedFenceValue)
+	{
+		tail = retirements.front().end;
+		used -= retirements.front().bytes;
+		retirements.pop_front();
+	}
+}
+
+uint64_t LinearRingAllocator::getSize() const
+{
+	return size;
+}
+
+uint64_t LinearRingAllocator::getUsed() const
+{
+	return used;
+}
+
+bool LinearRingAllocator::hasRetiredRanges() const
+{
+	return !retirements.empty();
+}
+
+uint64_t LinearRingAllocator::getOldestFenceValue() const
+{
+	return retirements.empty() ? 0 : retirements.front().fenceValue;
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <deque>
+#include <cstdint>
+
+// Hands out aligned ranges of a fixed size ring in allocation order. Ranges are never freed one by one:
+// retire() tags everything allocated since the previous retire with a fence value, and release() frees all
+// tagged ranges whose value has completed. Only offsets are managed, so the ring can back any mapped buffer.
+class LinearRingAllocator
+{
+public:
+	static const uint64_t invalidOffset{ UINT64_MAX };
+
+	explicit LinearRingAllocator(uint64_t size);
+
+	// Returns invalidOffset when the ring has no contiguous room left until older ranges are released.
+	uint64_t allocate(uint64_t size, uint64_t alignment);
+	void retire(uint64_t fenceValue);
+	void release(uint64_t completedFenceValue);
+
+	uint64_t getSize() const;
+	uint64_t getUsed() const;
+	bool hasRetiredRanges() const;
+	// Fence value of the oldest range still in flight; waiting for it is the cheapest way to make room.
+	uint64_t getOldestFenceValue() const;
+
+private:
+	struct Retirement
+	{
+		uint64_t fenceValue;
+		uint64_t end;
+		uint64_t bytes;
+	};
+
+	uint64_t size;
+	uint64_t head{ 0 };
+	uint64_t tail{ 0 };
+	uint64_t used{ 0 };
+	uint64_t pendingBytes{ 0 };
+	std::deque<Retirement> retirements;
+};
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "LodSelector.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	// A multiple of four, so only the last grain has a partial vector.
+	const uint32_t instancesPerGrain{ 4096 };
+	// View depth below which instances count as touching the camera.
+	const float minViewDepth{ 1e-3f };
+
+	// The bucket of four sizes: how many bucket boundaries each size is below.
+	XMVECTOR XM_CALLCONV computeBuckets(FXMVECTOR sizes, const XMVECTOR* boundaries, uint32_t numBoundaries)
+	{
+		XMVECTOR one{ XMVectorSplatOne() };
+		XMVECTOR bucket{ XMVectorZero() };
+		for (uint32_t k{ 0 }; k < numBoundaries; k++)
+		{
+			bucket = XMVectorAdd(bucket, XMVectorSelect(XMVectorZero(), one, XMVectorLess(sizes, boundaries[k])));
+		}
+
+		return bucket;
+	}
+}
+
+LodSelector::LodSelector(JobSystem& jobs, uint32_t numBuckets, float fullDetailPixels, float hysteresis) : jobs{ jobs }, numBuckets{ numBuckets }, fullDetailPixels{ fullDetailPixels }, hysteresis{ hysteresis }
+{
+	if (numBuckets == 0 || numBuckets > maxBuckets || fullDetailPixels <= 0.0f || hysteresis < 0.0f || hysteresis >= 1.0f)
+	{
+		throw(runtime_error{ "Invalid level of detail settings." });
+	}
+
+	resetStats();
+}
+
+void LodSelector::setInstances(const XMFLOAT4* spheres, uint32_t count)
+{
+	// The same instances moved keep their buckets, so the hysteresis holds across updates.
+	if (count != numInstances)
+	{
+		numInstances = count;
+		size_t paddedCount{ (static_cast<size_t>(count) + 3) & ~static_cast<size_t>(3) };
+		centersX.assign(paddedCount, 0.0f);
+		centersY.assign(paddedCount, 0.0f);
+		centersZ.assign(paddedCount, 0.0f);
+		radii.assign(paddedCount, 0.0f);
+		lods.assign(paddedCount, 0);
+	}
+
+	for (uint32_t i{ 0 }; i < numInstances; i++)
+	{
+		setInstance(i, spheres[i]);
+	}
+}
+
+void LodSelector::setInstance(uint32_t index, const XMFLOAT4& sphere)
+{
+	centersX[index] = sphere.x;
+	centersY[index] = sphere.y;
+	centersZ[index] = sphere.z;
+	radii[index] = sphere.w;
+}
+
+void LodSelector::select(FXMMATRIX modelViewProj, float pixelsPerUnit, int maxTessFactor)
+{
+	selectInstances(modelViewProj, pixelsPerUnit, maxTessFactor, nullptr, numInstances);
+}
+
+void LodSelector::select(FXMMATRIX modelViewProj, float pixelsPerUnit, int maxTessFactor, const vector<uint32_t>& instances)
+{
+	selectInstances(modelViewProj, pixelsPerUnit, maxTessFactor, instances.data(), static_cast<uint32_t>(instances.size()));
+}
+
+// Without an instance list the streams are read four at a time as they are; with one they are gathered.
+void LodSelector::selectInstances(FXMMATRIX modelViewProj, float pixelsPerUnit, int maxTessFactor, const uint32_t* instances, uint32_t count)
+{
+	auto begin{ chrono::steady_clock::now() };
+
+	uint32_t numGrains{ (count + instancesPerGrain - 1) / instancesPerGrain };
+	grainCounts.assign(static_cast<size_t>(numGrains) * numBuckets, 0);
+	grainChanges.assign(numGrains, 0);
+
+	// Row vectors: the clip w of a point is its dot product with the last column.
+	XMVECTOR m03{ XMVectorSplatW(modelViewProj.r[0]) };
+	XMVECTOR m13{ XMVectorSplatW(modelViewProj.r[1]) };
+	XMVECTOR m23{ XMVectorSplatW(modelViewProj.r[2]) };
+	XMVECTOR m33{ XMVectorSplatW(modelViewProj.r[3]) };
+	XMVECTOR diameterScale{ XMVectorReplicate(2.0f * pixelsPerUnit) };
+	XMVECTOR minDepth{ XMVectorReplicate(minViewDepth) };
+	XMVECTOR grow{ XMVectorReplicate(1.0f + hysteresis) };
+	XMVECTOR shrink{ XMVectorReplicate(1.0f - hysteresis) };
+
+	XMVECTOR boundaries[maxBuckets];
+	for (uint32_t k{ 0 }; k + 1 < numBuckets; k++)
+	{
+		boundaries[k] = XMVectorReplicate(fullDetailPixels / static_cast<float>(1u << k));
+	}
+
+	jobs.parallelFor(numGrains, 1, [&](uint32_t firstGrain, uint32_t endGrain)
+	{
+		for (uint32_t grain{ firstGrain }; grain < endGrain; grain++)
+		{
+			uint32_t* counts{ grainCounts.data() + static_cast<size_t>(grain) * numBuckets };
+			uint32_t first{ grain * instancesPerGrain };
+			uint32_t end{ first + instancesPerGrain < count ? first + instancesPerGrain : count };
+			uint32_t changes{ 0 };
+
+			for (uint32_t i{ first }; i < end; i += 4)
+			{
+				// Past the end of a list the last instance is repeated; those lanes are not stored.
+				uint32_t ids[4];
+				XMVECTOR x, y, z, r;
+				if (instances != nullptr)
+				{
+					for (uint32_t lane{ 0 }; lane < 4; lane++)
+					{
+						ids[lane] = instances[i + lane < end ? i + lane : end - 1];
+					}
+
+					x = XMVectorSet(centersX[ids[0]], centersX[ids[1]], centersX[ids[2]], centersX[ids[3]]);
+					y = XMVectorSet(centersY[ids[0]], centersY[ids[1]], centersY[ids[2]], centersY[ids[3]]);
+					z = XMVectorSet(centersZ[ids[0]], centersZ[ids[1]], centersZ[ids[2]], centersZ[ids[3]]);
+					r = XMVectorSet(radii[ids[0]], radii[ids[1]], radii[ids[2]], radii[ids[3]]);
+				}
+				else
+				{
+					for (uint32_t lane{ 0 }; lane < 4; lane++)
+					{
+						ids[lane] = i + lane;
+					}
+
+					x = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centersX[i]));
+					y = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centersY[i]));
+					z = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&centersZ[i]));
+					r = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&radii[i]));
+				}
+
+				// Spheres entirely behind the camera get size 0 and the coarsest bucket.
+				XMVECTOR w{ XMVectorMultiplyAdd(x, m03, XMVectorMultiplyAdd(y, m13, XMVectorMultiplyAdd(z, m23, m33))) };
+				XMVECTOR size{ XMVectorDivide(XMVectorMultiply(r, diameterScale), XMVectorMax(w, minDepth)) };
+				size = XMVectorSelect(XMVectorZero(), size, XMVectorGreater(XMVectorAdd(w, r), XMVectorZero()));
+
+				// Coarser only once the size is below a boundary even when grown by the hysteresis, finer only once
+				// it is above one even when shrunk.
+				XMVECTOR coarser{ computeBuckets(XMVectorMultiply(size, grow), boundaries, numBuckets - 1) };
+				XMVECTOR finer{ computeBuckets(XMVectorMultiply(size, shrink), boundaries, numBuckets - 1) };
+				XMVECTOR previous{ XMVectorSet(lods[ids[0]], lods[ids[1]], lods[ids[2]], lods[ids[3]]) };
+				XMVECTOR lod{ XMVectorSelect(previous, coarser, XMVectorGreater(coarser, previous)) };
+				lod = XMVectorSelect(lod, finer, XMVectorLess(finer, previous));
+
+				XMFLOAT4 result;
+				XMStoreFloat4(&result, lod);
+				const float lanes[]{ result.x, result.y, result.z, result.w };
+				uint32_t numLanes{ end - i < 4 ? end - i : 4 };
+				for (uint32_t lane{ 0 }; lane < numLanes; lane++)
+				{
+					uint8_t bucket{ static_cast<uint8_t>(lanes[lane]) };
+					changes += bucket != lods[ids[lane]] ? 1 : 0;
+					lods[ids[lane]] = bucket;
+					++counts[bucket];
+				}
+			}
+
+			grainChanges[grain] = changes;
+		}
+	});
+
+	// Each grain scatters its instances from its own cursor per bucket: bucket by bucket, grain by grain.
+	uint32_t bucketStarts[maxBuckets];
+	uint32_t position{ 0 };
+	for (uint32_t bucket{ 0 }; bucket < numBuckets; bucket++)
+	{
+		bucketStarts[bucket] = position;
+		for (uint32_t grain{ 0 }; grain < numGrains; grain++)
+		{
+			uint32_t& cursor{ grainCounts[static_cast<size_t>(grain) * numBuckets + bucket] };
+			uint32_t grainCount{ cursor };
+			cursor = position;
+			position += grainCount;
+		}
+	}
+
+	instanceOrder.resize(count);
+	jobs.parallelFor(numGrains, 1, [&](uint32_t firstGrain, uint32_t endGrain)
+	{
+		for (uint32_t grain{ firstGrain }; grain < endGrain; grain++)
+		{
+			uint32_t* cursors{ grainCounts.data() + static_cast<size_t>(grain) * numBuckets };
+			uint32_t first{ grain * instancesPerGrain };
+			uint32_t end{ first + instancesPerGrain < count ? first + instancesPerGrain : count };
+			for (uint32_t i{ first }; i < end; i++)
+			{
+				uint32_t id{ instances != nullptr ? instances[i] : i };
+				instanceOrder[cursors[lods[id]]++] = id;
+			}
+		}
+	});
+
+	buckets.clear();
+	for (uint32_t bucket{ 0 }; bucket < numBuckets; bucket++)
+	{
+		uint32_t bucketEnd{ bucket + 1 < numBuckets ? bucketStarts[bucket + 1] : count };
+		uint32_t bucketCount{ bucketEnd - bucketStarts[bucket] };
+		stats.instancesPerBucket[bucket] += bucketCount;
+		if (bucketCount == 0)
+		{
+			continue;
+		}
+
+		int tessFactor{ maxTessFactor >> bucket };
+		tessFactor = tessFactor > 1 ? tessFactor : 1;
+		if (!buckets.empty() && buckets.back().tessFactor == tessFactor)
+		{
+			buckets.back().numInstances += bucketCount;
+		}
+		else
+		{
+			buckets.push_back({ tessFactor, bucketStarts[bucket], bucketCount });
+		}
+	}
+
+	for (uint32_t changes : grainChanges)
+	{
+		stats.bucketChanges += changes;
+	}
+
+	++stats.selections;
+	stats.selectMilliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+const vector<uint32_t>& LodSelector::getInstanceOrder() const
+{
+	return instanceOrder;
+}
+
+const vector<InstanceRange>& LodSelector::getBuckets() const
+{
+	return buckets;
+}
+
+uint32_t LodSelector::getInstanceCount() const
+{
+	return numInstances;
+}
+
+const LodSelector::Stats& LodSelector::getStats() const
+{
+	return stats;
+}
+
+void LodSelector::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include "JobSystem.h"
+#include "IndirectDrawBuilder.h"
+
+// Discrete levels of detail for instanced draws. Every frame each instance is put into a tessellation factor
+// bucket by the size its bounding sphere projects to on screen: bucket 0 draws the full factor and each next
+// bucket halves the factor and the size it starts at. An instance only leaves its bucket once its size is
+// past the boundary by the hysteresis fraction, so instances near a boundary do not switch back and forth
+// while the camera moves slightly. The instances are then sorted by bucket with a counting sort, so each
+// bucket is one contiguous range of an instance order and can be drawn with one call and its own factor.
+//
+// The sizes and buckets are computed four instances at a time with DirectXMath vectors over structure of
+// arrays bounds, on the job system in fixed size grains; the sort scatters each grain on its own as well.
+class LodSelector
+{
+public:
+	static const uint32_t maxBuckets{ 6 };
+
+	struct Stats
+	{
+		uint64_t selections;
+		// Summed over the selections; divided by selections they give a frame's average.
+		uint64_t instancesPerBucket[maxBuckets];
+		uint64_t bucketChanges;
+		double selectMilliseconds;
+	};
+
+	// fullDetailPixels is the projected bounding sphere diameter from which instances get the full factor.
+	LodSelector(JobSystem& jobs, uint32_t numBuckets, float fullDetailPixels, float hysteresis);
+
+	// The instances' bounding spheres as center and radius. A new instance count starts every instance in
+	// bucket 0; with the same count the instances keep their buckets.
+	void setInstances(const DirectX::XMFLOAT4* spheres, uint32_t count);
+	void setInstance(uint32_t index, const DirectX::XMFLOAT4& sphere);
+	// pixelsPerUnit is the on screen size of one unit at a view depth of 1, half the viewport height over the
+	// tangent of half the vertical field of view.
+	void select(DirectX::FXMMATRIX modelViewProj, float pixelsPerUnit, int maxTessFactor);
+	// Selects and sorts only the listed instances, e.g. the visible ones; the others keep their buckets.
+	void select(DirectX::FXMMATRIX modelViewProj, float pixelsPerUnit, int maxTessFactor, const std::vector<uint32_t>& instances);
+
+	// Instance indices of the last selection, bucket by bucket from the finest.
+	const std::vector<uint32_t>& getInstanceOrder() const;
+	// The non-empty buckets of the last selection as ranges of the instance order; neighbouring buckets that
+	// ended up with the same factor, as happens with low maximum factors, are merged.
+	const std::vector<InstanceRange>& getBuckets() const;
+	uint32_t getInstanceCount() const;
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	void selectInstances(DirectX::FXMMATRIX modelViewProj, float pixelsPerUnit, int maxTessFactor, const uint32_t* instances, uint32_t count);
+
+private:
+	JobSystem& jobs;
+	uint32_t numBuckets;
+	float fullDetailPixels;
+	float hysteresis;
+
+	// Padded to a multiple of four; the padding has radius 0.
+	uint32_t numInstances{ 0 };
+	std::vector<float> centersX;
+	std::vector<float> centersY;
+	std::vector<float> centersZ;
+	std::vector<float> radii;
+	std::vector<uint8_t> lods;
+
+	// Instances per bucket of every grain, grain by grain.
+	std::vector<uint32_t> grainCounts;
+	std::vector<uint32_t> grainChanges;
+	std::vector<uint32_t> instanceOrder;
+	std::vector<InstanceRange> buckets;
+	Stats stats;
+};
\ No newline at end of file
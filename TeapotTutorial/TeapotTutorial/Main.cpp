@@ -1,26 +1,177 @@
+#ifdef _WIN32
 #include "TeapotTutorial.h"
 #include <wrl/client.h>
+#endif
+#include "RegressionHarness.h"
+#include "RendererBenchmark.h"
+#include "SelfTest.h"
+#include <iostream>
+#include <iterator>
 #include <memory>
+#include <sstream>
 #include <stdexcept>
 
+#ifdef _WIN32
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "D3DCompiler.lib")
+#endif
 
 using namespace std;
+#ifdef _WIN32
 using namespace Microsoft::WRL;
+#endif
 
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
+// The window's size and swap chain length, which the benchmark and the replay render at as well.
+const uint32_t windowWidth{ 800 };
+const uint32_t windowHeight{ 600 };
+const uint32_t windowBufferCount{ 3 };
+
+// The modes below run unattended, so a failure is written to stderr rather than shown in a message box; on
+// Windows it goes to the debugger as well, since the process only has a console when its output is redirected.
+void reportError(const exception& err)
+{
+	cerr << err.what() << endl;
+#ifdef _WIN32
+	OutputDebugStringA(err.what());
+	OutputDebugStringA("\n");
+#endif
+}
+
+// TeapotTutorial.exe --regress <golden directory> [--update]
+// Runs the CPU regression harness without creating a window or a device. The exit code is 0 when every
+// camera key matched its goldens and a per-key report is written to <golden directory>/report.csv. The
+// goldens of the default camera path are in Goldens, next to the sources.
+int runRegression(const string& goldenDirectory, bool updateGoldens)
+{
+	// Independent of the window, so the goldens stay valid and small.
+	const int width{ 320 };
+	const int height{ 240 };
+
+	try
+	{
+		RegressionHarness harness{ goldenDirectory, width, height };
+		harness.setUpdateGoldens(updateGoldens);
+
+		vector<RegressionHarness::FrameResult> results{ harness.run(RegressionHarness::getDefaultCameraPath()) };
+		harness.writeReport(results, goldenDirectory + "/report.csv");
+
+		return RegressionHarness::allPassed(results) ? 0 : 1;
+	}
+	catch (runtime_error& err)
+	{
+		reportError(err);
+		return 2;
+	}
+}
+
+// TeapotTutorial.exe --selftest <directory>
+// Runs the behavior checks of the allocators and stores without a window or a device. The exit code is 0 when
+// every check passed and a per-check report is written to <directory>/selftest.csv; the checks' scratch files
+// come and go there as well.
+int runSelfTest(const string& directory)
+{
+	try
+	{
+		string outputDirectory{ directory.empty() ? "." : directory };
+		SelfTest selfTest{ outputDirectory };
+		vector<SelfTest::CheckResult> results{ selfTest.run() };
+		selfTest.writeReport(results, outputDirectory + "/selftest.csv");
+
+		return SelfTest::allPassed(results) ? 0 : 1;
+	}
+	catch (runtime_error& err)
+	{
+		reportError(err);
+		return 2;
+	}
+}
+
+// TeapotTutorial.exe --bench <report file>
+// Renders the camera sweep of RendererBenchmark on the null device and writes the CPU cost per frame.
+int runBenchmark(const string& reportFile, uint32_t width, uint32_t height, uint32_t bufferCount)
+{
+	try
+	{
+		RendererBenchmark benchmark{ width, height, bufferCount };
+		benchmark.writeReport(benchmark.run(), reportFile.empty() ? "benchmark.csv" : reportFile);
+		return 0;
+	}
+	catch (runtime_error& err)
+	{
+		reportError(err);
+		return 2;
+	}
+}
+
+// TeapotTutorial.exe --replay <capture file> <report file>
+// Replays a capture saved with key 6 on the null device and writes the submission cost per frame.
+int runReplay(const string& captureFile, const string& reportFile, uint32_t width, uint32_t height, uint32_t bufferCount)
+{
+	try
+	{
+		RendererBenchmark benchmark{ width, height, bufferCount };
+		vector<RendererBenchmark::Result> results{ benchmark.runReplay(captureFile, teapot_tutorial::loadCommandCapture(captureFile)) };
+		benchmark.writeReport(results, reportFile.empty() ? "replay.csv" : reportFile);
+		return 0;
+	}
+	catch (runtime_error& err)
+	{
+		reportError(err);
+		return 2;
+	}
+}
+
+// Runs the mode named by the first argument, if it is one of the above, and sets the exit code it returned.
+// Missing arguments read as empty.
+bool runConsoleMode(const vector<string>& args, int& exitCode)
 {
-	const LONG width{ 800 };
-	const LONG height{ 600 };
-	const UINT bufferCount{ 3 };
+	auto arg = [&args](size_t i) { return i < args.size() ? args[i] : string{}; };
+
+	string mode{ arg(0) };
+	if (mode == "--regress")
+	{
+		exitCode = runRegression(arg(1), arg(2) == "--update");
+		return true;
+	}
+
+	if (mode == "--selftest")
+	{
+		exitCode = runSelfTest(arg(1));
+		return true;
+	}
+
+	if (mode == "--bench")
+	{
+		exitCode = runBenchmark(arg(1), windowWidth, windowHeight, windowBufferCount);
+		return true;
+	}
+
+	if (mode == "--replay")
+	{
+		exitCode = runReplay(arg(1), arg(2), windowWidth, windowHeight, windowBufferCount);
+		return true;
+	}
+
+	return false;
+}
+
+#ifdef _WIN32
+
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR cmdLine, int)
+{
+	istringstream args{ cmdLine };
+	int exitCode;
+	if (runConsoleMode({ istream_iterator<string>{ args }, istream_iterator<string>{} }, exitCode))
+	{
+		return exitCode;
+	}
 
 	shared_ptr<TeapotTutorial> teapot;
 
 	try
 	{
-		teapot = make_shared<TeapotTutorial>(bufferCount, "Hello Teapot!", width, height);
+		teapot = make_shared<TeapotTutorial>(windowBufferCount, "Hello Teapot!", static_cast<LONG>(windowWidth), static_cast<LONG>(windowHeight));
 	}
 	catch (runtime_error& err)
 	{
@@ -38,7 +189,7 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 		{
 			try
 			{
-				teapot->render();
+				teapot->update();
 			}
 			catch (runtime_error& err)
 			{
@@ -53,4 +204,23 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	}
 
 	return 0;
-}
\ No newline at end of file
+}
+
+#else
+
+// The console build, e.g. the CMake one, has no window: only the modes above run, as TeapotTutorial --regress,
+// --selftest, --bench or --replay with the same arguments.
+int main(int argc, char* argv[])
+{
+	int exitCode;
+	if (runConsoleMode({ argv + 1, argv + argc }, exitCode))
+	{
+		return exitCode;
+	}
+
+	cerr << "Usage: " << argv[0] << " --regress <golden directory> [--update] | --selftest <directory> | "
+		"--bench <report file> | --replay <capture file> <report file>" << endl;
+	return 2;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const string& fileName)
+{
+	file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		throw(runtime_error{ "Error opening " + fileName + "." });
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		throw(runtime_error{ "Error reading the size of " + fileName + "." });
+	}
+
+	size = static_cast<size_t>(fileSize.QuadPart);
+	// Empty files cannot be mapped; they are read as no bytes.
+	if (size == 0)
+	{
+		return;
+	}
+
+	mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping != nullptr)
+	{
+		data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	}
+
+	if (data == nullptr)
+	{
+		if (mapping != nullptr)
+		{
+			CloseHandle(mapping);
+		}
+
+		CloseHandle(file);
+		throw(runtime_error{ "Error mapping " + fileName + "." });
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+	{
+		UnmapViewOfFile(data);
+		CloseHandle(mapping);
+	}
+
+	CloseHandle(file);
+}
+
+bool MappedFile::getStamp(const string& fileName, Stamp& stamp)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(fileName.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		return false;
+	}
+
+	stamp.writeTime = (static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+	stamp.size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+	return true;
+}
+
+#else
+
+MappedFile::MappedFile(const string& fileName)
+{
+	file = open(fileName.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		throw(runtime_error{ "Error opening " + fileName + "." });
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0)
+	{
+		close(file);
+		throw(runtime_error{ "Error reading the size of " + fileName + "." });
+	}
+
+	size = static_cast<size_t>(status.st_size);
+	// Empty files cannot be mapped; they are read as no bytes.
+	if (size == 0)
+	{
+		return;
+	}
+
+	void* view{ mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0) };
+	if (view == MAP_FAILED)
+	{
+		close(file);
+		throw(runtime_error{ "Error mapping " + fileName + "." });
+	}
+
+	data = static_cast<const uint8_t*>(view);
+}
+
+MappedFile::~MappedFile()
+{
+	if (data != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(data), size);
+	}
+
+	close(file);
+}
+
+bool MappedFile::getStamp(const string& fileName, Stamp& stamp)
+{
+	struct stat status;
+	if (stat(fileName.c_str(), &status) != 0)
+	{
+		return false;
+	}
+
+	stamp.writeTime = static_cast<uint64_t>(status.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(status.st_mtim.tv_nsec);
+	stamp.size = static_cast<uint64_t>(status.st_size);
+	return true;
+}
+
+#endif
+
+const uint8_t* MappedFile::getData() const
+{
+	return data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return size;
+}
\ No newline at end of file
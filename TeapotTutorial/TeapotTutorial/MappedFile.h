@@ -0,0 +1,51 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+// Read-only view of a whole file through the OS file mapping (CreateFileMapping on Windows, mmap elsewhere),
+// so the contents are paged in straight from the file cache instead of being copied through stream buffers.
+class MappedFile
+{
+public:
+	// When the write time or size of a file differs from the last look, the file has changed.
+	struct Stamp
+	{
+		uint64_t writeTime;
+		uint64_t size;
+
+		bool operator==(const Stamp& other) const
+		{
+			return writeTime == other.writeTime && size == other.size;
+		}
+
+		bool operator!=(const Stamp& other) const
+		{
+			return !(*this == other);
+		}
+	};
+
+	// Throws runtime_error if the file cannot be opened or mapped.
+	explicit MappedFile(const std::string& fileName);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const uint8_t* getData() const;
+	size_t getSize() const;
+
+	// Returns false if the file does not exist or cannot be queried.
+	static bool getStamp(const std::string& fileName, Stamp& stamp);
+
+private:
+	const uint8_t* data{ nullptr };
+	size_t size{ 0 };
+#ifdef _WIN32
+	void* file;
+	void* mapping{ nullptr };
+#else
+	int file;
+#endif
+};
\ No newline at end of file
@@ -0,0 +1,895 @@
+#include "NullRenderDevice.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+// Records nothing; checks each call against the state the D3D12 debug layer would complain about and counts
+// it. The counts stay with the list until it is executed, so lists can be recorded on several threads.
+class NullCommandList : public RenderCommandList
+{
+public:
+	NullCommandList(NullRenderDevice& device, QueueType queue) : device{ device }, queue{ queue }
+	{
+		memset(&stats, 0, sizeof(stats));
+	}
+
+	void reset(uint32_t frameIndex) override
+	{
+		if (open)
+		{
+			throw(runtime_error{ "Null device: resetting a command list that is still open." });
+		}
+
+		if (frameIndex >= device.bufferCount)
+		{
+			throw(runtime_error{ "Null device: invalid command allocator index." });
+		}
+
+		open = true;
+		pipelineState = PipelineStateHandle{};
+		rootSignature = RootSignatureHandle{};
+		descriptorHeap = DescriptorHeapHandle{};
+		indexBufferSet = false;
+		vertexBufferSet = false;
+		countCommand(RenderCommandType::Reset);
+	}
+
+	void close() override
+	{
+		validateOpen();
+		open = false;
+		countCommand(RenderCommandType::Close);
+	}
+
+	void setPipelineState(PipelineStateHandle pipelineState) override
+	{
+		validateGraphics();
+		device.validatePipelineState(pipelineState);
+		this->pipelineState = pipelineState;
+		countCommand(RenderCommandType::SetPipelineState);
+	}
+
+	void setGraphicsRootSignature(RootSignatureHandle rootSignature) override
+	{
+		validateGraphics();
+		device.getRootSignature(rootSignature);
+		this->rootSignature = rootSignature;
+		countCommand(RenderCommandType::SetGraphicsRootSignature);
+	}
+
+	void setViewport(const Viewport& viewport) override
+	{
+		validateGraphics();
+		if (viewport.width <= 0.0f || viewport.height <= 0.0f || viewport.minDepth > viewport.maxDepth)
+		{
+			throw(runtime_error{ "Null device: invalid viewport." });
+		}
+
+		countCommand(RenderCommandType::SetViewport);
+	}
+
+	void setScissorRect(const ScissorRect& scissorRect) override
+	{
+		validateGraphics();
+		if (scissorRect.right < scissorRect.left || scissorRect.bottom < scissorRect.top)
+		{
+			throw(runtime_error{ "Null device: invalid scissor rect." });
+		}
+
+		countCommand(RenderCommandType::SetScissorRect);
+	}
+
+	void resourceBarrier(uint32_t numBarriers, const ResourceBarrier* barriers) override
+	{
+		validateOpen();
+		for (uint32_t i{ 0 }; i < numBarriers; i++)
+		{
+			NullRenderDevice::Buffer& buffer{ device.getBuffer(barriers[i].resource) };
+
+			// A begin-only split barrier leaves the resource unusable until the matching end; the state only
+			// changes once the end half is recorded.
+			if (barriers[i].flags != BarrierFlags::EndOnly && buffer.state != barriers[i].stateBefore)
+			{
+				throw(runtime_error{ "Null device: barrier state before does not match the resource state." });
+			}
+
+			if (barriers[i].flags != BarrierFlags::BeginOnly)
+			{
+				buffer.state = barriers[i].stateAfter;
+			}
+		}
+
+		countCommand(RenderCommandType::ResourceBarrier);
+	}
+
+	void setRenderTarget(const DescriptorHandle& rtv, const DescriptorHandle* dsv) override
+	{
+		validateGraphics();
+		device.validateDescriptor(rtv, DescriptorHeapType::Rtv);
+		if (dsv != nullptr)
+		{
+			device.validateDescriptor(*dsv, DescriptorHeapType::Dsv);
+		}
+
+		countCommand(RenderCommandType::SetRenderTarget);
+	}
+
+	void clearRenderTarget(const DescriptorHandle& rtv, const float (&)[4]) override
+	{
+		validateGraphics();
+		device.validateDescriptor(rtv, DescriptorHeapType::Rtv);
+		if (device.getBuffer(device.backBuffers.at(rtv.index)).state != ResourceState::RenderTarget)
+		{
+			throw(runtime_error{ "Null device: clearing a render target that is not in the render target state." });
+		}
+
+		countCommand(RenderCommandType::ClearRenderTarget);
+	}
+
+	void clearDepth(const DescriptorHandle& dsv, float depth) override
+	{
+		validateGraphics();
+		device.validateDescriptor(dsv, DescriptorHeapType::Dsv);
+		if (depth < 0.0f || depth > 1.0f)
+		{
+			throw(runtime_error{ "Null device: depth clear value out of range." });
+		}
+
+		countCommand(RenderCommandType::ClearDepth);
+	}
+
+	void setPrimitiveTopology(PrimitiveTopology) override
+	{
+		validateGraphics();
+		countCommand(RenderCommandType::SetPrimitiveTopology);
+	}
+
+	void setVertexBuffer(uint32_t, const VertexBufferView& view) override
+	{
+		validateGraphics();
+		if (view.bufferLocation == 0 || view.strideInBytes == 0)
+		{
+			throw(runtime_error{ "Null device: invalid vertex buffer view." });
+		}
+
+		vertexBufferSet = true;
+		countCommand(RenderCommandType::SetVertexBuffer);
+	}
+
+	void setIndexBuffer(const IndexBufferView& view) override
+	{
+		validateGraphics();
+		if (view.bufferLocation == 0 || view.format != Format::R32Uint)
+		{
+			throw(runtime_error{ "Null device: invalid index buffer view." });
+		}
+
+		indexBufferSet = true;
+		countCommand(RenderCommandType::SetIndexBuffer);
+	}
+
+	void setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValues, const void* data, uint32_t destOffset) override
+	{
+		const RootParameterDesc& param{ validateRootParameter(rootParameterIndex, RootParameterType::Constants) };
+		if (data == nullptr || destOffset + num32BitValues > param.count)
+		{
+			throw(runtime_error{ "Null device: root constants out of range." });
+		}
+
+		countCommand(RenderCommandType::SetGraphicsRoot32BitConstants);
+	}
+
+	void setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation) override
+	{
+		validateRootParameter(rootParameterIndex, RootParameterType::Cbv);
+		if (bufferLocation == 0 || bufferLocation % 256 != 0)
+		{
+			throw(runtime_error{ "Null device: constant buffer views must be 256 byte aligned." });
+		}
+
+		countCommand(RenderCommandType::SetGraphicsRootConstantBufferView);
+	}
+
+	void setDescriptorHeap(DescriptorHeapHandle heap) override
+	{
+		validateGraphics();
+		if (!device.getDescriptorHeap(heap).shaderVisible)
+		{
+			throw(runtime_error{ "Null device: descriptor heap is not shader visible." });
+		}
+
+		descriptorHeap = heap;
+		countCommand(RenderCommandType::SetDescriptorHeap);
+	}
+
+	void setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, const DescriptorHandle& baseDescriptor) override
+	{
+		const RootParameterDesc& param{ validateRootParameter(rootParameterIndex, RootParameterType::SrvTable) };
+		if (baseDescriptor.heap != descriptorHeap)
+		{
+			throw(runtime_error{ "Null device: descriptor table is not in the bound descriptor heap." });
+		}
+
+		if (baseDescriptor.index + param.count > device.getDescriptorHeap(baseDescriptor.heap).numDescriptors)
+		{
+			throw(runtime_error{ "Null device: descriptor table out of range." });
+		}
+
+		countCommand(RenderCommandType::SetGraphicsRootDescriptorTable);
+	}
+
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t, int32_t, uint32_t) override
+	{
+		validateDraw();
+		stats.indicesDrawn += static_cast<uint64_t>(indexCountPerInstance) * instanceCount;
+		countCommand(RenderCommandType::DrawIndexedInstanced);
+	}
+
+	void executeIndirect(CommandSignatureHandle commandSignature, uint32_t maxCommandCount, ResourceHandle argumentBuffer, uint64_t argumentBufferOffset) override
+	{
+		validateDraw();
+		const CommandSignatureDesc& desc{ device.getCommandSignature(commandSignature) };
+		if (desc.rootSignature.isValid() && desc.rootSignature != rootSignature)
+		{
+			throw(runtime_error{ "Null device: command signature was created with a different root signature." });
+		}
+
+		const NullRenderDevice::Buffer& buffer{ device.getBuffer(argumentBuffer) };
+		if (buffer.state != ResourceState::GenericRead)
+		{
+			throw(runtime_error{ "Null device: indirect argument buffer is not in the generic read state." });
+		}
+
+		if (argumentBufferOffset % 4 != 0 || argumentBufferOffset + static_cast<uint64_t>(maxCommandCount) * desc.byteStride > buffer.desc.size)
+		{
+			throw(runtime_error{ "Null device: indirect arguments out of range." });
+		}
+
+		// The arguments are read when the command is recorded, which for the upload heaps they come from is
+		// after the CPU wrote them; the draw is the last argument of every command.
+		const uint8_t* command{ buffer.data.data() + argumentBufferOffset };
+		size_t drawOffset{ 0 };
+		for (const IndirectArgumentDesc& argument : desc.arguments)
+		{
+			if (argument.type == IndirectArgumentType::DrawIndexed)
+			{
+				break;
+			}
+
+			drawOffset += argument.num32BitValues * 4;
+		}
+
+		for (uint32_t i{ 0 }; i < maxCommandCount; i++)
+		{
+			DrawIndexedArguments draw;
+			memcpy(&draw, command + static_cast<size_t>(i) * desc.byteStride + drawOffset, sizeof(draw));
+			stats.indicesDrawn += static_cast<uint64_t>(draw.indexCountPerInstance) * draw.instanceCount;
+		}
+
+		stats.indirectDraws += maxCommandCount;
+		countCommand(RenderCommandType::ExecuteIndirect);
+	}
+
+	void copyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes) override
+	{
+		validateOpen();
+		NullRenderDevice::Buffer& dstBuffer{ device.getBuffer(dst) };
+		NullRenderDevice::Buffer& srcBuffer{ device.getBuffer(src) };
+		if (dstOffset + numBytes > dstBuffer.desc.size || srcOffset + numBytes > srcBuffer.desc.size)
+		{
+			throw(runtime_error{ "Null device: copy out of range." });
+		}
+
+		// Buffers in the common state are promoted to copy dest implicitly, which is how the copy queue writes.
+		if (dstBuffer.desc.heapType != HeapType::Upload && dstBuffer.state != ResourceState::CopyDest && dstBuffer.state != ResourceState::Common)
+		{
+			throw(runtime_error{ "Null device: copy destination is not in the copy dest or common state." });
+		}
+
+		memcpy(dstBuffer.data.data() + dstOffset, srcBuffer.data.data() + srcOffset, static_cast<size_t>(numBytes));
+		stats.bytesCopied += numBytes;
+		countCommand(RenderCommandType::CopyBufferRegion);
+	}
+
+	bool isOpen() const
+	{
+		return open;
+	}
+
+	QueueType getQueue() const
+	{
+		return queue;
+	}
+
+	void mergeStats(NullRenderDevice::Stats& deviceStats)
+	{
+		for (size_t i{ 0 }; i < static_cast<size_t>(RenderCommandType::Count); i++)
+		{
+			deviceStats.commandCounts[i] += stats.commandCounts[i];
+		}
+
+		deviceStats.indicesDrawn += stats.indicesDrawn;
+		deviceStats.bytesCopied += stats.bytesCopied;
+		deviceStats.indirectDraws += stats.indirectDraws;
+		memset(&stats, 0, sizeof(stats));
+	}
+
+private:
+	void countCommand(RenderCommandType type)
+	{
+		++stats.commandCounts[static_cast<size_t>(type)];
+	}
+
+	void validateOpen() const
+	{
+		if (!open)
+		{
+			throw(runtime_error{ "Null device: recording into a closed command list." });
+		}
+	}
+
+	void validateGraphics() const
+	{
+		validateOpen();
+		if (queue != QueueType::Direct)
+		{
+			throw(runtime_error{ "Null device: graphics command recorded into a copy command list." });
+		}
+	}
+
+	void validateDraw() const
+	{
+		validateGraphics();
+		if (!pipelineState.isValid() || !rootSignature.isValid())
+		{
+			throw(runtime_error{ "Null device: draw without a pipeline state and root signature." });
+		}
+
+		if (device.getPipelineStateRootSignature(pipelineState) != rootSignature)
+		{
+			throw(runtime_error{ "Null device: pipeline state was created with a different root signature." });
+		}
+
+		if (!indexBufferSet || !vertexBufferSet)
+		{
+			throw(runtime_error{ "Null device: draw without vertex and index buffers." });
+		}
+	}
+
+	const RootParameterDesc& validateRootParameter(uint32_t rootParameterIndex, RootParameterType type) const
+	{
+		validateGraphics();
+		if (!rootSignature.isValid())
+		{
+			throw(runtime_error{ "Null device: root parameter set before the root signature." });
+		}
+
+		const RootSignatureDesc& desc{ device.getRootSignature(rootSignature) };
+		if (rootParameterIndex >= desc.parameters.size() || desc.parameters[rootParameterIndex].type != type)
+		{
+			throw(runtime_error{ "Null device: root parameter does not match the root signature." });
+		}
+
+		return desc.parameters[rootParameterIndex];
+	}
+
+private:
+	NullRenderDevice& device;
+	QueueType queue;
+	bool open{ false };
+	PipelineStateHandle pipelineState;
+	RootSignatureHandle rootSignature;
+	DescriptorHeapHandle descriptorHeap;
+	bool indexBufferSet{ false };
+	bool vertexBufferSet{ false };
+	NullRenderDevice::Stats stats;
+};
+
+NullRenderDevice::NullRenderDevice(uint32_t bufferCount, uint32_t width, uint32_t height) : bufferCount{ bufferCount }, width{ width }, height{ height }, nextGpuAddress{ 0x10000 }
+{
+	if (bufferCount == 0 || width == 0 || height == 0)
+	{
+		throw(runtime_error{ "Null device: invalid swap chain description." });
+	}
+
+	resetStats();
+
+	for (uint32_t i{ 0 }; i < bufferCount; i++)
+	{
+		backBuffers.push_back(createBuffer({ static_cast<uint64_t>(width) * height * 4, HeapType::Default, ResourceState::Present, "back buffer" }, nullptr));
+	}
+
+	depthStencilBuffer = createBuffer({ static_cast<uint64_t>(width) * height * 4, HeapType::Default, ResourceState::DepthWrite, "depth stencil" }, nullptr);
+	rtvHeap = createDescriptorHeap({ DescriptorHeapType::Rtv, bufferCount, false });
+	dsvHeap = createDescriptorHeap({ DescriptorHeapType::Dsv, 1, false });
+}
+
+ResourceHandle NullRenderDevice::createBuffer(const BufferDesc& desc, const void* initialData)
+{
+	if (desc.size == 0)
+	{
+		throw(runtime_error{ "Null device: zero sized buffer." });
+	}
+
+	Buffer buffer;
+	buffer.desc = desc;
+	buffer.data.resize(static_cast<size_t>(desc.size));
+	buffer.gpuAddress = nextGpuAddress;
+	buffer.state = desc.initialState;
+	if (desc.heapType == HeapType::Upload)
+	{
+		buffer.state = ResourceState::GenericRead;
+	}
+	else if (initialData != nullptr)
+	{
+		buffer.state = ResourceState::Common;
+	}
+	buffer.mapped = false;
+	buffer.released = false;
+	buffer.heapOffset = 0;
+
+	if (initialData != nullptr)
+	{
+		memcpy(buffer.data.data(), initialData, buffer.data.size());
+	}
+
+	// Keep every buffer 64KB aligned like placed resources, which also keeps constant buffer views aligned.
+	nextGpuAddress += (desc.size + 0xffff) & ~static_cast<uint64_t>(0xffff);
+	if (desc.heapType == HeapType::Default)
+	{
+		memoryUsage += (desc.size + 0xffff) & ~static_cast<uint64_t>(0xffff);
+	}
+
+	buffers.push_back(move(buffer));
+	return ResourceHandle{ static_cast<uint32_t>(buffers.size()) };
+}
+
+HeapHandle NullRenderDevice::createHeap(const HeapDesc& desc)
+{
+	if (desc.size == 0)
+	{
+		throw(runtime_error{ "Null device: zero sized heap." });
+	}
+
+	heaps.push_back({ desc, nextGpuAddress });
+	nextGpuAddress += (desc.size + placedResourceAlignment - 1) & ~(placedResourceAlignment - 1);
+	if (desc.heapType == HeapType::Default)
+	{
+		memoryUsage += (desc.size + placedResourceAlignment - 1) & ~(placedResourceAlignment - 1);
+	}
+	return HeapHandle{ static_cast<uint32_t>(heaps.size()) };
+}
+
+ResourceHandle NullRenderDevice::createPlacedBuffer(HeapHandle heap, uint64_t heapOffset, const BufferDesc& desc)
+{
+	if (!heap.isValid() || heap.id > heaps.size())
+	{
+		throw(runtime_error{ "Null device: invalid heap handle." });
+	}
+
+	const Heap& h{ heaps[heap.id - 1] };
+	if (desc.size == 0 || heapOffset % placedResourceAlignment != 0 || heapOffset + desc.size > h.desc.size)
+	{
+		throw(runtime_error{ "Null device: placed buffer is misaligned or outside its heap." });
+	}
+
+	for (const Buffer& other : buffers)
+	{
+		if (!other.released && other.heap == heap && heapOffset < other.heapOffset + other.desc.size && other.heapOffset < heapOffset + desc.size)
+		{
+			throw(runtime_error{ "Null device: placed buffer overlaps a live buffer of the same heap." });
+		}
+	}
+
+	// Placed buffers get their own storage; nothing aliases, so the heap only provides addresses.
+	Buffer buffer;
+	buffer.desc = desc;
+	buffer.desc.heapType = h.desc.heapType;
+	buffer.data.resize(static_cast<size_t>(desc.size));
+	buffer.gpuAddress = h.gpuAddress + heapOffset;
+	buffer.state = h.desc.heapType == HeapType::Upload ? ResourceState::GenericRead : desc.initialState;
+	buffer.mapped = false;
+	buffer.released = false;
+	buffer.heap = heap;
+	buffer.heapOffset = heapOffset;
+
+	buffers.push_back(move(buffer));
+	return ResourceHandle{ static_cast<uint32_t>(buffers.size()) };
+}
+
+void NullRenderDevice::releaseResource(ResourceHandle resource)
+{
+	Buffer& buffer{ getBuffer(resource) };
+	buffer.released = true;
+	buffer.mapped = false;
+	vector<uint8_t>().swap(buffer.data);
+
+	// Placed buffers give their memory back to the heap, not to the device.
+	if (buffer.desc.heapType == HeapType::Default && !buffer.heap.isValid())
+	{
+		memoryUsage -= (buffer.desc.size + 0xffff) & ~static_cast<uint64_t>(0xffff);
+	}
+}
+
+MemoryBudget NullRenderDevice::queryMemoryBudget()
+{
+	return{ memoryBudget, memoryUsage };
+}
+
+void NullRenderDevice::setMemoryBudget(uint64_t budget)
+{
+	memoryBudget = budget;
+}
+
+void* NullRenderDevice::mapBuffer(ResourceHandle buffer)
+{
+	Buffer& b{ getBuffer(buffer) };
+	if (b.desc.heapType != HeapType::Upload)
+	{
+		throw(runtime_error{ "Null device: only upload heap buffers can be mapped." });
+	}
+
+	b.mapped = true;
+	return b.data.data();
+}
+
+void NullRenderDevice::unmapBuffer(ResourceHandle buffer)
+{
+	Buffer& b{ getBuffer(buffer) };
+	if (!b.mapped)
+	{
+		throw(runtime_error{ "Null device: unmapping a buffer that is not mapped." });
+	}
+
+	b.mapped = false;
+}
+
+uint64_t NullRenderDevice::getGpuVirtualAddress(ResourceHandle buffer)
+{
+	return getBuffer(buffer).gpuAddress;
+}
+
+DescriptorHeapHandle NullRenderDevice::createDescriptorHeap(const DescriptorHeapDesc& desc)
+{
+	if (desc.numDescriptors == 0 || (desc.shaderVisible && desc.type != DescriptorHeapType::CbvSrvUav))
+	{
+		throw(runtime_error{ "Null device: invalid descriptor heap description." });
+	}
+
+	descriptorHeaps.push_back(desc);
+	return DescriptorHeapHandle{ static_cast<uint32_t>(descriptorHeaps.size()) };
+}
+
+void NullRenderDevice::createShaderResourceView(ResourceHandle buffer, const ShaderResourceViewDesc& desc, const DescriptorHandle& destDescriptor)
+{
+	const Buffer& b{ getBuffer(buffer) };
+	validateDescriptor(destDescriptor, DescriptorHeapType::CbvSrvUav);
+
+	if (desc.structureByteStride == 0 || (static_cast<uint64_t>(desc.firstElement) + desc.numElements) * desc.structureByteStride > b.desc.size)
+	{
+		throw(runtime_error{ "Null device: shader resource view out of range." });
+	}
+}
+
+void NullRenderDevice::copyDescriptors(uint32_t numCopies, const DescriptorCopy* copies)
+{
+	for (uint32_t i{ 0 }; i < numCopies; i++)
+	{
+		const DescriptorCopy& copy{ copies[i] };
+		const DescriptorHeapDesc& dst{ getDescriptorHeap(copy.dst.heap) };
+		const DescriptorHeapDesc& src{ getDescriptorHeap(copy.src.heap) };
+		if (src.shaderVisible)
+		{
+			throw(runtime_error{ "Null device: copying descriptors from a shader visible heap." });
+		}
+
+		if (dst.type != src.type || dst.type != getDescriptorHeap(copies[0].dst.heap).type)
+		{
+			throw(runtime_error{ "Null device: copying descriptors between heap types." });
+		}
+
+		if (copy.numDescriptors == 0 || static_cast<uint64_t>(copy.dst.index) + copy.numDescriptors > dst.numDescriptors || static_cast<uint64_t>(copy.src.index) + copy.numDescriptors > src.numDescriptors)
+		{
+			throw(runtime_error{ "Null device: descriptor copy out of range." });
+		}
+	}
+
+	countCommand(RenderCommandType::CopyDescriptors);
+}
+
+RootSignatureHandle NullRenderDevice::createRootSignature(const RootSignatureDesc& desc)
+{
+	rootSignatures.push_back(desc);
+	return RootSignatureHandle{ static_cast<uint32_t>(rootSignatures.size()) };
+}
+
+PipelineStateHandle NullRenderDevice::createPipelineState(const PipelineStateDesc& desc)
+{
+	getRootSignature(desc.rootSignature);
+
+	if (desc.vertexShader.empty() || desc.pixelShader.empty())
+	{
+		throw(runtime_error{ "Null device: pipeline state without vertex or pixel shader." });
+	}
+
+	if ((desc.topologyType == PrimitiveTopologyType::Patch) != !desc.hullShader.empty() || desc.hullShader.empty() != desc.domainShader.empty())
+	{
+		throw(runtime_error{ "Null device: patch topology requires hull and domain shaders." });
+	}
+
+	// The null blob only stands for the desc's fixed function state; a blob that does not match is ignored, as
+	// drivers do with blobs of other versions.
+	ShaderBytecode blob{ makePipelineStateBlob(desc) };
+
+	lock_guard<mutex> lock{ pipelineStateMutex };
+	if (!desc.cachedBlob.empty() && desc.cachedBlob == blob)
+	{
+		++stats.pipelineStatesFromBlob;
+	}
+
+	pipelineStates.push_back(desc.rootSignature);
+	pipelineStateBlobs.push_back(move(blob));
+	return PipelineStateHandle{ static_cast<uint32_t>(pipelineStates.size()) };
+}
+
+ShaderBytecode NullRenderDevice::getPipelineStateBlob(PipelineStateHandle pipelineState)
+{
+	validatePipelineState(pipelineState);
+
+	lock_guard<mutex> lock{ pipelineStateMutex };
+	return pipelineStateBlobs[pipelineState.id - 1];
+}
+
+CommandSignatureHandle NullRenderDevice::createCommandSignature(const CommandSignatureDesc& desc)
+{
+	if (desc.arguments.empty() || desc.arguments.back().type != IndirectArgumentType::DrawIndexed)
+	{
+		throw(runtime_error{ "Null device: command signature does not end with a draw." });
+	}
+
+	uint32_t size{ 0 };
+	for (const IndirectArgumentDesc& argument : desc.arguments)
+	{
+		if (argument.type == IndirectArgumentType::DrawIndexed)
+		{
+			if (&argument != &desc.arguments.back())
+			{
+				throw(runtime_error{ "Null device: command signature with more than one draw." });
+			}
+
+			size += sizeof(DrawIndexedArguments);
+			continue;
+		}
+
+		// Constant arguments change the root signature's constants, so the signature must name it.
+		if (!desc.rootSignature.isValid())
+		{
+			throw(runtime_error{ "Null device: command signature sets root constants without a root signature." });
+		}
+
+		const RootSignatureDesc& rootSignature{ getRootSignature(desc.rootSignature) };
+		if (argument.rootParameterIndex >= rootSignature.parameters.size() || rootSignature.parameters[argument.rootParameterIndex].type != RootParameterType::Constants || argument.num32BitValues == 0 || argument.destOffsetIn32BitValues + argument.num32BitValues > rootSignature.parameters[argument.rootParameterIndex].count)
+		{
+			throw(runtime_error{ "Null device: command signature constants do not match the root signature." });
+		}
+
+		size += argument.num32BitValues * 4;
+	}
+
+	if (desc.byteStride < size || desc.byteStride % 4 != 0)
+	{
+		throw(runtime_error{ "Null device: command signature stride is smaller than its arguments." });
+	}
+
+	commandSignatures.push_back(desc);
+	return CommandSignatureHandle{ static_cast<uint32_t>(commandSignatures.size()) };
+}
+
+unique_ptr<RenderCommandList> NullRenderDevice::createCommandList(QueueType queue)
+{
+	return make_unique<NullCommandList>(*this, queue);
+}
+
+void NullRenderDevice::executeCommandLists(QueueType queue, uint32_t numCommandLists, RenderCommandList* const* commandLists)
+{
+	for (uint32_t i{ 0 }; i < numCommandLists; i++)
+	{
+		NullCommandList* commandList{ static_cast<NullCommandList*>(commandLists[i]) };
+		if (commandList->isOpen())
+		{
+			throw(runtime_error{ "Null device: executing a command list that is still open." });
+		}
+
+		if (commandList->getQueue() != queue)
+		{
+			throw(runtime_error{ "Null device: executing a command list on a queue of a different type." });
+		}
+
+		commandList->mergeStats(stats);
+	}
+
+	countCommand(RenderCommandType::ExecuteCommandLists);
+}
+
+FenceHandle NullRenderDevice::createFence(uint64_t initialValue)
+{
+	fences.push_back(initialValue);
+	return FenceHandle{ static_cast<uint32_t>(fences.size()) };
+}
+
+void NullRenderDevice::signal(QueueType, FenceHandle fence, uint64_t value)
+{
+	uint64_t& fenceValue{ getFence(fence) };
+	if (value < fenceValue)
+	{
+		throw(runtime_error{ "Null device: fence values must not decrease." });
+	}
+
+	fenceValue = value;
+	countCommand(RenderCommandType::Signal);
+}
+
+uint64_t NullRenderDevice::getCompletedValue(FenceHandle fence)
+{
+	return getFence(fence);
+}
+
+void NullRenderDevice::waitForFence(FenceHandle fence, uint64_t value)
+{
+	// Nothing runs asynchronously, so waiting for a value that was never signaled would wait forever.
+	if (getFence(fence) < value)
+	{
+		throw(runtime_error{ "Null device: waiting for a fence value that was never signaled." });
+	}
+}
+
+void NullRenderDevice::waitIdle()
+{
+}
+
+void NullRenderDevice::present()
+{
+	if (getBuffer(backBuffers[backBufferIndex]).state != ResourceState::Present)
+	{
+		throw(runtime_error{ "Null device: presenting a back buffer that is not in the present state." });
+	}
+
+	backBufferIndex = (backBufferIndex + 1) % bufferCount;
+	countCommand(RenderCommandType::Present);
+}
+
+uint32_t NullRenderDevice::getBufferCount()
+{
+	return bufferCount;
+}
+
+uint32_t NullRenderDevice::getCurrentBackBufferIndex()
+{
+	return backBufferIndex;
+}
+
+ResourceHandle NullRenderDevice::getBackBuffer(uint32_t index)
+{
+	return backBuffers.at(index);
+}
+
+DescriptorHandle NullRenderDevice::getBackBufferRtv(uint32_t index)
+{
+	return{ rtvHeap, index };
+}
+
+DescriptorHandle NullRenderDevice::getDepthStencilView()
+{
+	return{ dsvHeap, 0 };
+}
+
+uint32_t NullRenderDevice::getWidth() const
+{
+	return width;
+}
+
+uint32_t NullRenderDevice::getHeight() const
+{
+	return height;
+}
+
+const NullRenderDevice::Stats& NullRenderDevice::getStats() const
+{
+	return stats;
+}
+
+void NullRenderDevice::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+NullRenderDevice::Buffer& NullRenderDevice::getBuffer(ResourceHandle handle)
+{
+	if (!handle.isValid() || handle.id > buffers.size())
+	{
+		throw(runtime_error{ "Null device: invalid resource handle." });
+	}
+
+	if (buffers[handle.id - 1].released)
+	{
+		throw(runtime_error{ "Null device: using a released resource." });
+	}
+
+	return buffers[handle.id - 1];
+}
+
+const DescriptorHeapDesc& NullRenderDevice::getDescriptorHeap(DescriptorHeapHandle handle) const
+{
+	if (!handle.isValid() || handle.id > descriptorHeaps.size())
+	{
+		throw(runtime_error{ "Null device: invalid descriptor heap handle." });
+	}
+
+	return descriptorHeaps[handle.id - 1];
+}
+
+void NullRenderDevice::validateDescriptor(const DescriptorHandle& handle, DescriptorHeapType type) const
+{
+	const DescriptorHeapDesc& desc{ getDescriptorHeap(handle.heap) };
+	if (desc.type != type || handle.index >= desc.numDescriptors)
+	{
+		throw(runtime_error{ "Null device: invalid descriptor." });
+	}
+}
+
+const RootSignatureDesc& NullRenderDevice::getRootSignature(RootSignatureHandle handle) const
+{
+	if (!handle.isValid() || handle.id > rootSignatures.size())
+	{
+		throw(runtime_error{ "Null device: invalid root signature handle." });
+	}
+
+	return rootSignatures[handle.id - 1];
+}
+
+void NullRenderDevice::validatePipelineState(PipelineStateHandle handle) const
+{
+	getPipelineStateRootSignature(handle);
+}
+
+RootSignatureHandle NullRenderDevice::getPipelineStateRootSignature(PipelineStateHandle handle) const
+{
+	lock_guard<mutex> lock{ pipelineStateMutex };
+	if (!handle.isValid() || handle.id > pipelineStates.size())
+	{
+		throw(runtime_error{ "Null device: invalid pipeline state handle." });
+	}
+
+	return pipelineStates[handle.id - 1];
+}
+
+const CommandSignatureDesc& NullRenderDevice::getCommandSignature(CommandSignatureHandle handle) const
+{
+	if (!handle.isValid() || handle.id > commandSignatures.size())
+	{
+		throw(runtime_error{ "Null device: invalid command signature handle." });
+	}
+
+	return commandSignatures[handle.id - 1];
+}
+
+ShaderBytecode NullRenderDevice::makePipelineStateBlob(const PipelineStateDesc& desc)
+{
+	return ShaderBytecode{ 'N', 'P', 'S', 'O', static_cast<uint8_t>(desc.fillMode), static_cast<uint8_t>(desc.cullMode), static_cast<uint8_t>(desc.depthEnable ? 1 : 0), static_cast<uint8_t>(desc.topologyType) };
+}
+
+uint64_t& NullRenderDevice::getFence(FenceHandle handle)
+{
+	if (!handle.isValid() || handle.id > fences.size())
+	{
+		throw(runtime_error{ "Null device: invalid fence handle." });
+	}
+
+	return fences[handle.id - 1];
+}
+
+void NullRenderDevice::countCommand(RenderCommandType type)
+{
+	++stats.commandCounts[static_cast<size_t>(type)];
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include "RenderDevice.h"
+
+// RenderDevice without a GPU. Buffers live in CPU memory, fences complete as soon as they are signaled and
+// nothing is drawn, but every call is validated (handles, open/closed lists, root signature and pipeline
+// bound before use, barrier before-states, monotonic fence values, placed buffer bounds and overlaps, use of
+// released buffers, descriptor copy ranges and sources, command signature layouts and indirect argument buffers)
+// and counted. Violations throw
+// runtime_error, so the renderer can be exercised and benchmarked without a D3D12 device.
+class NullRenderDevice : public RenderDevice
+{
+public:
+	struct Stats
+	{
+		uint64_t commandCounts[static_cast<size_t>(RenderCommandType::Count)];
+		uint64_t indicesDrawn;
+		uint64_t bytesCopied;
+		// Pipeline states created with a matching cached blob.
+		uint64_t pipelineStatesFromBlob;
+		// Draws run by ExecuteIndirect commands, whose indices are counted in indicesDrawn as well.
+		uint64_t indirectDraws;
+	};
+
+	NullRenderDevice(uint32_t bufferCount, uint32_t width, uint32_t height);
+
+	ResourceHandle createBuffer(const BufferDesc& desc, const void* initialData) override;
+	void* mapBuffer(ResourceHandle buffer) override;
+	void unmapBuffer(ResourceHandle buffer) override;
+	uint64_t getGpuVirtualAddress(ResourceHandle buffer) override;
+
+	HeapHandle createHeap(const HeapDesc& desc) override;
+	ResourceHandle createPlacedBuffer(HeapHandle heap, uint64_t heapOffset, const BufferDesc& desc) override;
+	void releaseResource(ResourceHandle resource) override;
+	MemoryBudget queryMemoryBudget() override;
+
+	DescriptorHeapHandle createDescriptorHeap(const DescriptorHeapDesc& desc) override;
+	void createShaderResourceView(ResourceHandle buffer, const ShaderResourceViewDesc& desc, const DescriptorHandle& destDescriptor) override;
+	void copyDescriptors(uint32_t numCopies, const DescriptorCopy* copies) override;
+
+	RootSignatureHandle createRootSignature(const RootSignatureDesc& desc) override;
+	PipelineStateHandle createPipelineState(const PipelineStateDesc& desc) override;
+	ShaderBytecode getPipelineStateBlob(PipelineStateHandle pipelineState) override;
+	CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+
+	std::unique_ptr<RenderCommandList> createCommandList(QueueType queue) override;
+	void executeCommandLists(QueueType queue, uint32_t numCommandLists, RenderCommandList* const* commandLists) override;
+
+	FenceHandle createFence(uint64_t initialValue) override;
+	void signal(QueueType queue, FenceHandle fence, uint64_t value) override;
+	uint64_t getCompletedValue(FenceHandle fence) override;
+	void waitForFence(FenceHandle fence, uint64_t value) override;
+	void waitIdle() override;
+
+	void present() override;
+	uint32_t getBufferCount() override;
+	uint32_t getCurrentBackBufferIndex() override;
+	ResourceHandle getBackBuffer(uint32_t index) override;
+	DescriptorHandle getBackBufferRtv(uint32_t index) override;
+	DescriptorHandle getDepthStencilView() override;
+
+	// Stands in for the budget the OS would grant; usage counts default heaps and committed default buffers.
+	void setMemoryBudget(uint64_t budget);
+
+	uint32_t getWidth() const;
+	uint32_t getHeight() const;
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct Buffer
+	{
+		BufferDesc desc;
+		std::vector<uint8_t> data;
+		uint64_t gpuAddress;
+		ResourceState state;
+		bool mapped;
+		bool released;
+		HeapHandle heap;
+		uint64_t heapOffset;
+	};
+
+	struct Heap
+	{
+		HeapDesc desc;
+		uint64_t gpuAddress;
+	};
+
+	Buffer& getBuffer(ResourceHandle handle);
+	const DescriptorHeapDesc& getDescriptorHeap(DescriptorHeapHandle handle) const;
+	void validateDescriptor(const DescriptorHandle& handle, DescriptorHeapType type) const;
+	const RootSignatureDesc& getRootSignature(RootSignatureHandle handle) const;
+	void validatePipelineState(PipelineStateHandle handle) const;
+	RootSignatureHandle getPipelineStateRootSignature(PipelineStateHandle handle) const;
+	const CommandSignatureDesc& getCommandSignature(CommandSignatureHandle handle) const;
+	static ShaderBytecode makePipelineStateBlob(const PipelineStateDesc& desc);
+	uint64_t& getFence(FenceHandle handle);
+	void countCommand(RenderCommandType type);
+
+	friend class NullCommandList;
+
+private:
+	uint32_t bufferCount;
+	uint32_t width;
+	uint32_t height;
+	uint32_t backBufferIndex{ 0 };
+	uint64_t nextGpuAddress;
+	uint64_t memoryBudget{ 256 * 1024 * 1024 };
+	uint64_t memoryUsage{ 0 };
+
+	std::vector<Buffer> buffers;
+	std::vector<Heap> heaps;
+	std::vector<DescriptorHeapDesc> descriptorHeaps;
+	std::vector<RootSignatureDesc> rootSignatures;
+	// Pipeline states may be created while lists are recorded on other threads.
+	mutable std::mutex pipelineStateMutex;
+	std::vector<RootSignatureHandle> pipelineStates;
+	std::vector<ShaderBytecode> pipelineStateBlobs;
+	std::vector<CommandSignatureDesc> commandSignatures;
+	std::vector<uint64_t> fences;
+
+	std::vector<ResourceHandle> backBuffers;
+	ResourceHandle depthStencilBuffer;
+	DescriptorHeapHandle rtvHeap;
+	DescriptorHeapHandle dsvHeap;
+
+	Stats stats;
+};
\ No newline at end of file
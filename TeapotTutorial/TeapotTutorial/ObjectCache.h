@@ -0,0 +1,114 @@
+#pragma once
+
+#include <unordered_map>
+#include <utility>
+#include <stdexcept>
+#include <cstdint>
+
+struct ObjectCacheStats
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t objects;
+};
+
+// Device objects named by a stable hash of the desc they were created from (see Fnv1aHasher), so every unique
+// desc is created once no matter how many models and passes ask for it. Each lookup through find() or
+// getOrCreate() counts as a hit or a miss and as a use of the object; peek() looks without counting. Not
+// thread safe; the owner locks if it needs to.
+template<typename T>
+class ObjectCache
+{
+public:
+	ObjectCache()
+	{
+		resetStats();
+	}
+
+	// The object for key or nullptr.
+	T* find(uint64_t key)
+	{
+		auto entry = entries.find(key);
+		if (entry == entries.end())
+		{
+			++stats.misses;
+			return nullptr;
+		}
+
+		++stats.hits;
+		++entry->second.uses;
+		return &entry->second.object;
+	}
+
+	const T* peek(uint64_t key) const
+	{
+		auto entry = entries.find(key);
+		return entry == entries.end() ? nullptr : &entry->second.object;
+	}
+
+	// Adds an object after find() missed it; the miss counted its first use.
+	T& insert(uint64_t key, T object)
+	{
+		auto entry = entries.emplace(key, Entry{ std::move(object), 1 });
+		if (!entry.second)
+		{
+			throw(std::runtime_error{ "Object cache already holds an object with this key." });
+		}
+
+		++stats.objects;
+		return entry.first->second.object;
+	}
+
+	// create() is only called on a miss and returns the new object.
+	template<typename Create>
+	T& getOrCreate(uint64_t key, Create create)
+	{
+		T* object{ find(key) };
+		return object != nullptr ? *object : insert(key, create());
+	}
+
+	// How many lookups found or created the object; 0 for unknown keys.
+	uint64_t getUses(uint64_t key) const
+	{
+		auto entry = entries.find(key);
+		return entry == entries.end() ? 0 : entry->second.uses;
+	}
+
+	// Calls function(key, object, uses) for every object.
+	template<typename Function>
+	void forEach(Function function) const
+	{
+		for (const auto& entry : entries)
+		{
+			function(entry.first, entry.second.object, entry.second.uses);
+		}
+	}
+
+	size_t size() const
+	{
+		return entries.size();
+	}
+
+	const ObjectCacheStats& getStats() const
+	{
+		return stats;
+	}
+
+	// Keeps the objects; only the hit and miss counts restart.
+	void resetStats()
+	{
+		stats.hits = 0;
+		stats.misses = 0;
+		stats.objects = entries.size();
+	}
+
+private:
+	struct Entry
+	{
+		T object;
+		uint64_t uses;
+	};
+
+	std::unordered_map<uint64_t, Entry> entries;
+	ObjectCacheStats stats;
+};
\ No newline at end of file
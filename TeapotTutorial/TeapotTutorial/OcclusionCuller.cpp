@@ -0,0 +1,189 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+using namespace DirectX;
+
+OcclusionCuller::OcclusionCuller(int width, int height) : hiZBuffer{ width, height }, stats{}
+{
+}
+
+void OcclusionCuller::beginFrame()
+{
+	hiZBuffer.clear();
+	stats = {};
+}
+
+void OcclusionCuller::addOccluder(const OccluderMesh& occluder, FXMMATRIX mvp)
+{
+	hiZBuffer.rasterizeOccluder(occluder, mvp);
+	stats.occluderTriangles += occluder.mesh.indices.size() / 3;
+}
+
+void OcclusionCuller::endOccluders()
+{
+	hiZBuffer.buildHierarchy();
+}
+
+void OcclusionCuller::cull(const vector<Aabb>& bounds, FXMMATRIX mvp, vector<uint32_t>& visible)
+{
+	for (size_t i{ 0 }; i < bounds.size(); i++)
+	{
+		++stats.tested;
+
+		if (hiZBuffer.isBoxVisible(bounds[i], mvp))
+		{
+			visible.push_back(static_cast<uint32_t>(i));
+		}
+		else
+		{
+			++stats.culled;
+		}
+	}
+}
+
+void OcclusionCuller::cull(const vector<Aabb>& bounds, FXMMATRIX mvp, JobSystem& jobs, vector<uint32_t>& visible)
+{
+	// Enough boxes per job to pay for queueing it; the Hi-Z buffer is only read.
+	const uint32_t boxesPerJob{ 256 };
+
+	XMMATRIX boxMvp{ mvp };
+	boxVisible.resize(bounds.size());
+	jobs.parallelFor(static_cast<uint32_t>(bounds.size()), boxesPerJob, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i{ begin }; i < end; i++)
+		{
+			boxVisible[i] = hiZBuffer.isBoxVisible(bounds[i], boxMvp) ? 1 : 0;
+		}
+	});
+
+	for (size_t i{ 0 }; i < bounds.size(); i++)
+	{
+		if (boxVisible[i] != 0)
+		{
+			visible.push_back(static_cast<uint32_t>(i));
+		}
+		else
+		{
+			++stats.culled;
+		}
+	}
+
+	stats.tested += bounds.size();
+}
+
+void OcclusionCuller::cullSpheres(const XMFLOAT4* spheres, FXMMATRIX mvp, JobSystem& jobs, vector<uint32_t>& candidates)
+{
+	const uint32_t spheresPerJob{ 256 };
+
+	XMMATRIX sphereMvp{ mvp };
+	boxVisible.resize(candidates.size());
+	jobs.parallelFor(static_cast<uint32_t>(candidates.size()), spheresPerJob, [&](uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i{ begin }; i < end; i++)
+		{
+			const XMFLOAT4& sphere{ spheres[candidates[i]] };
+			Aabb bounds{ { sphere.x - sphere.w, sphere.y - sphere.w, sphere.z - sphere.w }, { sphere.x + sphere.w, sphere.y + sphere.w, sphere.z + sphere.w } };
+			boxVisible[i] = hiZBuffer.isBoxVisible(bounds, sphereMvp) ? 1 : 0;
+		}
+	});
+
+	size_t kept{ 0 };
+	for (size_t i{ 0 }; i < candidates.size(); i++)
+	{
+		if (boxVisible[i] != 0)
+		{
+			candidates[kept++] = candidates[i];
+		}
+	}
+
+	stats.tested += candidates.size();
+	stats.culled += candidates.size() - kept;
+	candidates.resize(kept);
+}
+
+const OcclusionCuller::Stats& OcclusionCuller::getStats() const
+{
+	return stats;
+}
+
+const HiZBuffer& OcclusionCuller::getHiZBuffer() const
+{
+	return hiZBuffer;
+}
+
+OccluderMesh OcclusionCuller::buildOccluderMesh(const vector<XMFLOAT3>& points, const vector<uint32_t>& patches, const vector<XMFLOAT4X4>& transforms, int tessFactor, float minAreaFraction)
+{
+	vector<Aabb> bounds{ buildPatchBounds(points, patches, transforms) };
+
+	float maxArea{ 0.0f };
+	for (const Aabb& b : bounds)
+	{
+		maxArea = max(maxArea, b.getSurfaceArea());
+	}
+
+	tessFactor = max(1, min(tessFactor, 64));
+	float step{ 1.0f / static_cast<float>(tessFactor) };
+
+	OccluderMesh occluder;
+	for (size_t i{ 0 }; i < bounds.size(); i++)
+	{
+		if (bounds[i].getSurfaceArea() < maxArea * minAreaFraction)
+		{
+			continue;
+		}
+
+		teapot_tutorial::PatchControlPoints controlPoints;
+		teapot_tutorial::gatherPatchControlPoints(points, patches, i, controlPoints);
+		teapot_tutorial::tessellatePatch(controlPoints, transforms[i], static_cast<uint32_t>(i), tessFactor, occluder.mesh);
+
+		// In the order tessellatePatch() emits the quads.
+		for (int v{ 0 }; v < tessFactor; v++)
+		{
+			for (int u{ 0 }; u < tessFactor; u++)
+			{
+				teapot_tutorial::PatchControlPoints subControlPoints;
+				teapot_tutorial::subdividePatch(controlPoints, u * step, (u + 1) * step, v * step, (v + 1) * step, subControlPoints);
+				Aabb quadBounds{ teapot_tutorial::computePatchBounds(subControlPoints, transforms[i]) };
+				occluder.triangleBounds.insert(occluder.triangleBounds.end(), { quadBounds, quadBounds });
+			}
+		}
+	}
+
+	// Seam vertices are matched to a small fraction of the model's size, far above the rounding of the patch
+	// evaluation and far below the spacing of the tessellation.
+	if (!bounds.empty())
+	{
+		Aabb modelBounds{ bounds[0] };
+		for (const Aabb& b : bounds)
+		{
+			modelBounds.merge(b);
+		}
+
+		XMVECTOR extent{ XMVectorSubtract(XMLoadFloat3(&modelBounds.maxCorner), XMLoadFloat3(&modelBounds.minCorner)) };
+		occluder.buildTopology(XMVectorGetX(XMVector3Length(extent)) * 1e-5f);
+	}
+
+	return occluder;
+}
+
+vector<Aabb> OcclusionCuller::buildPatchBounds(const vector<XMFLOAT3>& points, const vector<uint32_t>& patches, const vector<XMFLOAT4X4>& transforms)
+{
+	size_t numPatches{ patches.size() / teapot_tutorial::numPatchControlPoints };
+	if (transforms.size() < numPatches)
+	{
+		throw(runtime_error{ "Missing patch transforms." });
+	}
+
+	vector<Aabb> bounds;
+	bounds.reserve(numPatches);
+	for (size_t i{ 0 }; i < numPatches; i++)
+	{
+		teapot_tutorial::PatchControlPoints controlPoints;
+		teapot_tutorial::gatherPatchControlPoints(points, patches, i, controlPoints);
+		bounds.push_back(teapot_tutorial::computePatchBounds(controlPoints, transforms[i]));
+	}
+
+	return bounds;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include "HiZBuffer.h"
+#include "PatchTessellator.h"
+#include "JobSystem.h"
+
+class OcclusionCuller
+{
+public:
+	struct Stats
+	{
+		size_t tested;
+		size_t culled;
+		size_t occluderTriangles;
+	};
+
+	OcclusionCuller(int width, int height);
+
+	void beginFrame();
+	void addOccluder(const OccluderMesh& occluder, DirectX::FXMMATRIX mvp);
+	void endOccluders();
+	void cull(const std::vector<Aabb>& bounds, DirectX::FXMMATRIX mvp, std::vector<uint32_t>& visible);
+	// Tests ranges of boxes as jobs; visible comes out in the same order as from the serial version.
+	void cull(const std::vector<Aabb>& bounds, DirectX::FXMMATRIX mvp, JobSystem& jobs, std::vector<uint32_t>& visible);
+	// Drops the candidates whose bounding spheres (center, radius) are hidden, keeping the others in order;
+	// ranges of them are tested as jobs.
+	void cullSpheres(const DirectX::XMFLOAT4* spheres, DirectX::FXMMATRIX mvp, JobSystem& jobs, std::vector<uint32_t>& candidates);
+
+	const Stats& getStats() const;
+	const HiZBuffer& getHiZBuffer() const;
+
+	// Coarsely tessellates the patches whose bounds are at least minAreaFraction of the largest patch bounds.
+	// Small patches cost as much to rasterize as they hide, so they are left out of the occluder pass. Each quad's
+	// two triangles are bounded by the control points of the part of the patch under the quad.
+	static OccluderMesh buildOccluderMesh(const std::vector<DirectX::XMFLOAT3>& points, const std::vector<uint32_t>& patches, const std::vector<DirectX::XMFLOAT4X4>& transforms, int tessFactor, float minAreaFraction);
+	static std::vector<Aabb> buildPatchBounds(const std::vector<DirectX::XMFLOAT3>& points, const std::vector<uint32_t>& patches, const std::vector<DirectX::XMFLOAT4X4>& transforms);
+
+private:
+	HiZBuffer hiZBuffer;
+	Stats stats;
+	std::vector<uint8_t> boxVisible;
+};
\ No newline at end of file
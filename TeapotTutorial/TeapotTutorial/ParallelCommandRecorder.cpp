@@ -0,0 +1,108 @@
+#include "ParallelCommandRecorder.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+ParallelCommandRecorder::ParallelCommandRecorder(RenderDevice& device, JobSystem& jobs, uint32_t numLists) : jobs{ jobs }
+{
+	if (numLists == 0)
+	{
+		throw(runtime_error{ "Parallel command recording needs at least one list." });
+	}
+
+	lists.resize(numLists);
+	for (RecordingList& list : lists)
+	{
+		list.commandList = make_unique<StateCachingCommandList>(device.createCommandList(QueueType::Direct));
+		list.milliseconds = 0.0;
+	}
+
+	resetStats();
+}
+
+void ParallelCommandRecorder::record(uint32_t frameIndex, uint32_t numItems, const RecordFunction& recordFunction)
+{
+	auto begin{ chrono::steady_clock::now() };
+
+	jobs.parallelFor(static_cast<uint32_t>(lists.size()), 1, [&](uint32_t first, uint32_t last)
+	{
+		for (uint32_t list{ first }; list < last; list++)
+		{
+			recordRange(list, frameIndex, numItems, recordFunction);
+		}
+	});
+
+	++stats.frames;
+	stats.itemsRecorded += numItems;
+	stats.recordMilliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+	for (const RecordingList& list : lists)
+	{
+		stats.listMilliseconds += list.milliseconds;
+	}
+}
+
+void ParallelCommandRecorder::appendCommandLists(vector<RenderCommandList*>& commandLists) const
+{
+	for (const RecordingList& list : lists)
+	{
+		commandLists.push_back(list.commandList->getTarget());
+	}
+}
+
+uint32_t ParallelCommandRecorder::getListCount() const
+{
+	return static_cast<uint32_t>(lists.size());
+}
+
+void ParallelCommandRecorder::setStateFiltering(bool enabled)
+{
+	for (RecordingList& list : lists)
+	{
+		list.commandList->setEnabled(enabled);
+	}
+}
+
+void ParallelCommandRecorder::addCommandStats(StateCachingCommandList::Stats& commandStats) const
+{
+	for (const RecordingList& list : lists)
+	{
+		commandStats.add(list.commandList->getStats());
+	}
+}
+
+void ParallelCommandRecorder::resetCommandStats()
+{
+	for (RecordingList& list : lists)
+	{
+		list.commandList->resetStats();
+	}
+}
+
+const ParallelCommandRecorder::Stats& ParallelCommandRecorder::getStats() const
+{
+	return stats;
+}
+
+void ParallelCommandRecorder::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void ParallelCommandRecorder::recordRange(uint32_t list, uint32_t frameIndex, uint32_t numItems, const RecordFunction& recordFunction)
+{
+	auto begin{ chrono::steady_clock::now() };
+
+	uint32_t numLists{ static_cast<uint32_t>(lists.size()) };
+	uint32_t first{ static_cast<uint32_t>(static_cast<uint64_t>(numItems) * list / numLists) };
+	uint32_t last{ static_cast<uint32_t>(static_cast<uint64_t>(numItems) * (list + 1) / numLists) };
+
+	// Every list is recorded and closed even when its range is empty, so all of them can be executed.
+	StateCachingCommandList& commandList{ *lists[list].commandList };
+	commandList.reset(frameIndex);
+	recordFunction(commandList, first, last);
+	commandList.close();
+
+	lists[list].milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "StateCachingCommandList.h"
+#include "JobSystem.h"
+
+// Records the items of a frame (draw runs, instances, ...) into several direct command lists at once. Every
+// list owns its command allocators, one per frame in flight, so lists recorded at the same time never share an
+// allocator and a list's allocator for a frame is only reset once that frame has completed. record() splits the
+// items into contiguous ranges, one per list, and records each range as a job; the calling thread records the
+// first range itself. The lists are handed to a single executeCommandLists call after the lists recorded
+// before them, so the GPU sees the draws in item order.
+class ParallelCommandRecorder
+{
+public:
+	// Called on any thread of the job system with the range's open list and its range [begin, end) of the
+	// items. The list starts with no state set, as a fresh D3D12 list does.
+	typedef std::function<void(StateCachingCommandList& commandList, uint32_t begin, uint32_t end)> RecordFunction;
+
+	struct Stats
+	{
+		uint64_t frames;
+		uint64_t itemsRecorded;
+		// Wall time of record() and the time spent recording all lists; their ratio is the speedup.
+		double recordMilliseconds;
+		double listMilliseconds;
+	};
+
+	ParallelCommandRecorder(RenderDevice& device, JobSystem& jobs, uint32_t numLists);
+
+	// Resets every list for frameIndex, records the items and closes the lists. Returns once all are done; an
+	// exception thrown by recordFunction for any range is rethrown here.
+	void record(uint32_t frameIndex, uint32_t numItems, const RecordFunction& recordFunction);
+
+	// Appends the lists recorded by the last record() in item order.
+	void appendCommandLists(std::vector<RenderCommandList*>& commandLists) const;
+
+	uint32_t getListCount() const;
+	void setStateFiltering(bool enabled);
+	// State filtering counts of all lists.
+	void addCommandStats(StateCachingCommandList::Stats& commandStats) const;
+	void resetCommandStats();
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct RecordingList
+	{
+		std::unique_ptr<StateCachingCommandList> commandList;
+		double milliseconds;
+	};
+
+	void recordRange(uint32_t list, uint32_t frameIndex, uint32_t numItems, const RecordFunction& recordFunction);
+
+private:
+	JobSystem& jobs;
+	std::vector<RecordingList> lists;
+	Stats stats;
+};
\ No newline at end of file
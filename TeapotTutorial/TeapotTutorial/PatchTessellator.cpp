@@ -0,0 +1,184 @@
+#include "PatchTessellator.h"
+#include <algorithm>
+#include <cfloat>
+#include <stdexcept>
+
+using namespace std;
+using namespace DirectX;
+
+void TessellatedMesh::clear()
+{
+	positions.clear();
+	indices.clear();
+	trianglePatches.clear();
+}
+
+void Aabb::merge(const Aabb& other)
+{
+	minCorner = { std::min(minCorner.x, other.minCorner.x), std::min(minCorner.y, other.minCorner.y), std::min(minCorner.z, other.minCorner.z) };
+	maxCorner = { std::max(maxCorner.x, other.maxCorner.x), std::max(maxCorner.y, other.maxCorner.y), std::max(maxCorner.z, other.maxCorner.z) };
+}
+
+float Aabb::getSurfaceArea() const
+{
+	float dx{ maxCorner.x - minCorner.x };
+	float dy{ maxCorner.y - minCorner.y };
+	float dz{ maxCorner.z - minCorner.z };
+	return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+namespace
+{
+	XMFLOAT4 bernsteinBasis(float t)
+	{
+		float invT{ 1.0f - t };
+		return{ invT * invT * invT, 3.0f * t * invT * invT, 3.0f * t * t * invT, t * t * t };
+	}
+
+	XMVECTOR evaluateRow(const teapot_tutorial::PatchControlPoints& controlPoints, int row, const XMFLOAT4& basisU)
+	{
+		XMVECTOR value{ XMVectorScale(XMLoadFloat3(&controlPoints[row * 4 + 0]), basisU.x) };
+		value = XMVectorAdd(value, XMVectorScale(XMLoadFloat3(&controlPoints[row * 4 + 1]), basisU.y));
+		value = XMVectorAdd(value, XMVectorScale(XMLoadFloat3(&controlPoints[row * 4 + 2]), basisU.z));
+		value = XMVectorAdd(value, XMVectorScale(XMLoadFloat3(&controlPoints[row * 4 + 3]), basisU.w));
+		return value;
+	}
+
+	// The blossom of the cubic with control points p at (t0, t1, t2): de Casteljau with a different parameter
+	// at each step.
+	XMVECTOR blossomCubic(const XMVECTOR p[4], float t0, float t1, float t2)
+	{
+		XMVECTOR q[3];
+		for (int i{ 0 }; i < 3; i++)
+		{
+			q[i] = XMVectorLerp(p[i], p[i + 1], t0);
+		}
+
+		XMVECTOR r[2];
+		for (int i{ 0 }; i < 2; i++)
+		{
+			r[i] = XMVectorLerp(q[i], q[i + 1], t1);
+		}
+
+		return XMVectorLerp(r[0], r[1], t2);
+	}
+
+	void restrictCubic(const XMVECTOR p[4], float t0, float t1, XMVECTOR restricted[4])
+	{
+		restricted[0] = blossomCubic(p, t0, t0, t0);
+		restricted[1] = blossomCubic(p, t0, t0, t1);
+		restricted[2] = blossomCubic(p, t0, t1, t1);
+		restricted[3] = blossomCubic(p, t1, t1, t1);
+	}
+}
+
+void teapot_tutorial::gatherPatchControlPoints(const vector<XMFLOAT3>& points, const vector<uint32_t>& patches, size_t patchIndex, PatchControlPoints& controlPoints)
+{
+	size_t first{ patchIndex * numPatchControlPoints };
+	if (first + numPatchControlPoints > patches.size())
+	{
+		throw(runtime_error{ "Patch index out of range." });
+	}
+
+	for (int i{ 0 }; i < numPatchControlPoints; i++)
+	{
+		controlPoints[i] = points[patches[first + i]];
+	}
+}
+
+XMFLOAT3 teapot_tutorial::evaluatePatch(const PatchControlPoints& controlPoints, float u, float v)
+{
+	XMFLOAT4 basisU{ bernsteinBasis(u) };
+	XMFLOAT4 basisV{ bernsteinBasis(v) };
+
+	XMVECTOR value{ XMVectorScale(evaluateRow(controlPoints, 0, basisU), basisV.x) };
+	value = XMVectorAdd(value, XMVectorScale(evaluateRow(controlPoints, 1, basisU), basisV.y));
+	value = XMVectorAdd(value, XMVectorScale(evaluateRow(controlPoints, 2, basisU), basisV.z));
+	value = XMVectorAdd(value, XMVectorScale(evaluateRow(controlPoints, 3, basisU), basisV.w));
+
+	XMFLOAT3 result;
+	XMStoreFloat3(&result, value);
+	return result;
+}
+
+void teapot_tutorial::tessellatePatch(const PatchControlPoints& controlPoints, const XMFLOAT4X4& transform, uint32_t patchId, int tessFactor, TessellatedMesh& mesh)
+{
+	tessFactor = std::max(1, std::min(tessFactor, 64));
+
+	XMMATRIX transformDX{ XMLoadFloat4x4(&transform) };
+	uint32_t firstVertex{ static_cast<uint32_t>(mesh.positions.size()) };
+	uint32_t rowSize{ static_cast<uint32_t>(tessFactor + 1) };
+	float step{ 1.0f / static_cast<float>(tessFactor) };
+
+	for (int j{ 0 }; j <= tessFactor; j++)
+	{
+		for (int i{ 0 }; i <= tessFactor; i++)
+		{
+			XMFLOAT3 localPos{ evaluatePatch(controlPoints, i * step, j * step) };
+
+			XMFLOAT3 pos;
+			XMStoreFloat3(&pos, XMVector3TransformCoord(XMLoadFloat3(&localPos), transformDX));
+			mesh.positions.push_back(pos);
+		}
+	}
+
+	for (uint32_t j{ 0 }; j < static_cast<uint32_t>(tessFactor); j++)
+	{
+		for (uint32_t i{ 0 }; i < static_cast<uint32_t>(tessFactor); i++)
+		{
+			uint32_t i00{ firstVertex + j * rowSize + i };
+			uint32_t i10{ i00 + 1 };
+			uint32_t i01{ i00 + rowSize };
+			uint32_t i11{ i01 + 1 };
+
+			mesh.indices.insert(mesh.indices.end(), { i00, i10, i11, i00, i11, i01 });
+			mesh.trianglePatches.insert(mesh.trianglePatches.end(), { patchId, patchId });
+		}
+	}
+}
+
+void teapot_tutorial::subdividePatch(const PatchControlPoints& controlPoints, float u0, float u1, float v0, float v1, PatchControlPoints& subControlPoints)
+{
+	// Rows run along u, like evaluateRow().
+	XMVECTOR rows[4][4];
+	for (int row{ 0 }; row < 4; row++)
+	{
+		XMVECTOR p[4];
+		for (int i{ 0 }; i < 4; i++)
+		{
+			p[i] = XMLoadFloat3(&controlPoints[row * 4 + i]);
+		}
+
+		restrictCubic(p, u0, u1, rows[row]);
+	}
+
+	for (int column{ 0 }; column < 4; column++)
+	{
+		XMVECTOR p[4]{ rows[0][column], rows[1][column], rows[2][column], rows[3][column] };
+		XMVECTOR restricted[4];
+		restrictCubic(p, v0, v1, restricted);
+		for (int row{ 0 }; row < 4; row++)
+		{
+			XMStoreFloat3(&subControlPoints[row * 4 + column], restricted[row]);
+		}
+	}
+}
+
+Aabb teapot_tutorial::computePatchBounds(const PatchControlPoints& controlPoints, const XMFLOAT4X4& transform)
+{
+	XMMATRIX transformDX{ XMLoadFloat4x4(&transform) };
+
+	XMVECTOR minDX{ XMVectorReplicate(FLT_MAX) };
+	XMVECTOR maxDX{ XMVectorReplicate(-FLT_MAX) };
+	for (int i{ 0 }; i < numPatchControlPoints; i++)
+	{
+		XMVECTOR p{ XMVector3TransformCoord(XMLoadFloat3(&controlPoints[i]), transformDX) };
+		minDX = XMVectorMin(minDX, p);
+		maxDX = XMVectorMax(maxDX, p);
+	}
+
+	Aabb bounds;
+	XMStoreFloat3(&bounds.minCorner, minDX);
+	XMStoreFloat3(&bounds.maxCorner, maxDX);
+	return bounds;
+}
\ No newline at end of file
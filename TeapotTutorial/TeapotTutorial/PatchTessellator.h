@@ -0,0 +1,47 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+struct TessellatedMesh
+{
+	std::vector<DirectX::XMFLOAT3> positions;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> trianglePatches;
+
+	void clear();
+};
+
+struct Aabb
+{
+	DirectX::XMFLOAT3 minCorner;
+	DirectX::XMFLOAT3 maxCorner;
+
+	void merge(const Aabb& other);
+	float getSurfaceArea() const;
+};
+
+namespace teapot_tutorial
+{
+	const int numPatchControlPoints{ 16 };
+
+	using PatchControlPoints = DirectX::XMFLOAT3[numPatchControlPoints];
+
+	void gatherPatchControlPoints(const std::vector<DirectX::XMFLOAT3>& points, const std::vector<uint32_t>& patches, size_t patchIndex, PatchControlPoints& controlPoints);
+
+	// Same evaluation as evaluateBezier() in DomainShader.hlsl.
+	DirectX::XMFLOAT3 evaluatePatch(const PatchControlPoints& controlPoints, float u, float v);
+
+	// Tessellates the quad domain the way the hull shader asks for it (integer partitioning, equal edge
+	// and inside factors, clockwise triangles) and applies the patch transform like the domain shader does.
+	void tessellatePatch(const PatchControlPoints& controlPoints, const DirectX::XMFLOAT4X4& transform, uint32_t patchId, int tessFactor, TessellatedMesh& mesh);
+
+	// The control points of the part of the patch over [u0, u1] x [v0, v1], found by blossoming each row and
+	// then each column. The part lies inside their convex hull, which hugs it far closer than the whole hull.
+	void subdividePatch(const PatchControlPoints& controlPoints, float u0, float u1, float v0, float v1, PatchControlPoints& subControlPoints);
+
+	// Bezier patches lie inside the convex hull of their control points, so the box around the transformed
+	// control points bounds the tessellated surface for any tess factor.
+	Aabb computePatchBounds(const PatchControlPoints& controlPoints, const DirectX::XMFLOAT4X4& transform);
+}
\ No newline at end of file
@@ -0,0 +1,300 @@
+#include "PipelineStateManager.h"
+#include <fstream>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include "Fnv1aHasher.h"
+
+using namespace std;
+
+namespace
+{
+	const char cacheMagic[4]{ 'T', 'P', 'S', 'O' };
+	const uint32_t cacheVersion{ 1 };
+	// Few states are requested at once; more workers would only take cores from the frame.
+	const uint32_t compileWorkers{ 2 };
+
+	bool readValue(ifstream& file, void* value, size_t size)
+	{
+		return static_cast<bool>(file.read(static_cast<char*>(value), static_cast<streamsize>(size)));
+	}
+}
+
+PipelineStateManager::Entry::Entry() : pipelineState{ 0 }
+{
+}
+
+PipelineStateManager::PipelineStateManager(RenderDevice& device, const string& cacheFileName) : device{ device }, cacheFileName{ cacheFileName }, compileJobs{ compileWorkers, false }
+{
+	resetStats();
+	loadCache();
+}
+
+PipelineStateManager::~PipelineStateManager()
+{
+	pipelineStates.forEach([this](Key, const unique_ptr<Entry>& entry, uint64_t) { compileJobs.wait(entry->counter); });
+}
+
+RootSignatureHandle PipelineStateManager::createRootSignature(const RootSignatureDesc& desc)
+{
+	Key key{ computeKey(desc) };
+	return rootSignatures.getOrCreate(key, [this, key, &desc]()
+	{
+		RootSignatureHandle rootSignature{ device.createRootSignature(desc) };
+		rootSignatureKeys[rootSignature.id] = key;
+		return rootSignature;
+	});
+}
+
+PipelineStateManager::Key PipelineStateManager::request(const PipelineStateDesc& desc)
+{
+	Key key{ computeKey(desc) };
+	if (pipelineStates.find(key) != nullptr)
+	{
+		return key;
+	}
+
+	Entry* entry{ pipelineStates.insert(key, make_unique<Entry>()).get() };
+	compileJobs.run([this, entry, key, desc]() mutable { compile(*entry, key, move(desc)); }, &entry->counter);
+	return key;
+}
+
+PipelineStateHandle PipelineStateManager::getPipelineState(Key key, PipelineStateHandle fallback) const
+{
+	const Entry& entry{ getEntry(key) };
+	uint32_t pipelineState{ entry.pipelineState.load(memory_order_acquire) };
+	if (pipelineState != 0)
+	{
+		return PipelineStateHandle{ pipelineState };
+	}
+
+	// The job sets error before it finishes the counter.
+	if (entry.counter.isDone() && entry.error)
+	{
+		rethrow_exception(entry.error);
+	}
+
+	return fallback;
+}
+
+bool PipelineStateManager::isReady(Key key) const
+{
+	return getEntry(key).pipelineState.load(memory_order_acquire) != 0;
+}
+
+PipelineStateHandle PipelineStateManager::waitFor(Key key)
+{
+	Entry& entry{ const_cast<Entry&>(getEntry(key)) };
+	compileJobs.wait(entry.counter);
+	if (entry.error)
+	{
+		rethrow_exception(entry.error);
+	}
+
+	return PipelineStateHandle{ entry.pipelineState.load(memory_order_acquire) };
+}
+
+uint64_t PipelineStateManager::getUses(Key key) const
+{
+	return pipelineStates.getUses(key);
+}
+
+bool PipelineStateManager::saveCache()
+{
+	lock_guard<mutex> lock{ blobMutex };
+	if (cacheFileName.empty())
+	{
+		return true;
+	}
+
+	vector<const pair<const Key, ShaderBytecode>*> requestedBlobs;
+	for (const auto& blob : blobs)
+	{
+		if (pipelineStates.peek(blob.first) != nullptr)
+		{
+			requestedBlobs.push_back(&blob);
+		}
+	}
+
+	if (!blobsChanged && requestedBlobs.size() == blobs.size())
+	{
+		return true;
+	}
+
+	ofstream file{ cacheFileName, ios::binary | ios::trunc };
+	file.write(cacheMagic, sizeof(cacheMagic));
+	file.write(reinterpret_cast<const char*>(&cacheVersion), sizeof(cacheVersion));
+	uint64_t count{ requestedBlobs.size() };
+	file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+	for (const auto* blob : requestedBlobs)
+	{
+		uint64_t size{ blob->second.size() };
+		file.write(reinterpret_cast<const char*>(&blob->first), sizeof(blob->first));
+		file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+		file.write(reinterpret_cast<const char*>(blob->second.data()), static_cast<streamsize>(size));
+	}
+
+	if (!file)
+	{
+		return false;
+	}
+
+	blobsChanged = false;
+	return true;
+}
+
+PipelineStateManager::Key PipelineStateManager::computeKey(const PipelineStateDesc& desc) const
+{
+	auto rootSignatureKey = rootSignatureKeys.find(desc.rootSignature.id);
+	if (rootSignatureKey == rootSignatureKeys.end())
+	{
+		throw(runtime_error{ "Pipeline state uses a root signature the pipeline state manager did not create." });
+	}
+
+	// The cached blob is left out: it is derived from the rest and the same state may be given one or not.
+	Fnv1aHasher hasher;
+	hasher.add(rootSignatureKey->second);
+	hasher.add(desc.inputLayout.size());
+	for (const InputElementDesc& element : desc.inputLayout)
+	{
+		hasher.add(element.semanticName);
+		hasher.add(element.semanticIndex);
+		hasher.add(static_cast<uint64_t>(element.format));
+		hasher.add(element.inputSlot);
+		hasher.add(element.alignedByteOffset);
+	}
+
+	hasher.add(desc.vertexShader);
+	hasher.add(desc.hullShader);
+	hasher.add(desc.domainShader);
+	hasher.add(desc.pixelShader);
+	hasher.add(static_cast<uint64_t>(desc.fillMode));
+	hasher.add(static_cast<uint64_t>(desc.cullMode));
+	hasher.add(static_cast<uint64_t>(desc.depthEnable ? 1 : 0));
+	hasher.add(static_cast<uint64_t>(desc.topologyType));
+	hasher.add(static_cast<uint64_t>(desc.renderTargetFormat));
+	hasher.add(static_cast<uint64_t>(desc.depthStencilFormat));
+	return hasher.get();
+}
+
+PipelineStateManager::Key PipelineStateManager::computeKey(const RootSignatureDesc& desc)
+{
+	Fnv1aHasher hasher;
+	hasher.add(desc.flags);
+	hasher.add(desc.parameters.size());
+	for (const RootParameterDesc& param : desc.parameters)
+	{
+		hasher.add(static_cast<uint64_t>(param.type));
+		hasher.add(static_cast<uint64_t>(param.visibility));
+		hasher.add(param.shaderRegister);
+		hasher.add(param.registerSpace);
+		hasher.add(param.count);
+	}
+
+	return hasher.get();
+}
+
+PipelineStateManager::Stats PipelineStateManager::getStats() const
+{
+	lock_guard<mutex> lock{ blobMutex };
+	Stats currentStats(stats);
+	currentStats.rootSignatures = rootSignatures.getStats();
+	currentStats.pipelineStates = pipelineStates.getStats();
+	return currentStats;
+}
+
+void PipelineStateManager::resetStats()
+{
+	lock_guard<mutex> lock{ blobMutex };
+	memset(&stats, 0, sizeof(stats));
+	rootSignatures.resetStats();
+	pipelineStates.resetStats();
+}
+
+void PipelineStateManager::compile(Entry& entry, Key key, PipelineStateDesc desc)
+{
+	try
+	{
+		{
+			lock_guard<mutex> lock{ blobMutex };
+			auto blob = blobs.find(key);
+			if (blob != blobs.end())
+			{
+				desc.cachedBlob = blob->second;
+				++stats.compilesWithBlob;
+			}
+		}
+
+		auto begin{ chrono::steady_clock::now() };
+		PipelineStateHandle pipelineState{ device.createPipelineState(desc) };
+		ShaderBytecode blob{ device.getPipelineStateBlob(pipelineState) };
+		double milliseconds{ chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count() };
+
+		{
+			lock_guard<mutex> lock{ blobMutex };
+			++stats.compiles;
+			stats.compileMilliseconds += milliseconds;
+			if (!blob.empty() && blob != desc.cachedBlob)
+			{
+				blobs[key] = move(blob);
+				blobsChanged = true;
+			}
+		}
+
+		entry.pipelineState.store(pipelineState.id, memory_order_release);
+	}
+	catch (...)
+	{
+		entry.error = current_exception();
+	}
+}
+
+void PipelineStateManager::loadCache()
+{
+	if (cacheFileName.empty())
+	{
+		return;
+	}
+
+	// A missing, old or damaged file only means the states are compiled from scratch.
+	ifstream file{ cacheFileName, ios::binary };
+	char magic[4];
+	uint32_t version;
+	uint64_t count;
+	if (!readValue(file, magic, sizeof(magic)) || memcmp(magic, cacheMagic, sizeof(magic)) != 0 || !readValue(file, &version, sizeof(version)) || version != cacheVersion || !readValue(file, &count, sizeof(count)))
+	{
+		return;
+	}
+
+	unordered_map<Key, ShaderBytecode> loadedBlobs;
+	for (uint64_t i{ 0 }; i < count; i++)
+	{
+		Key key;
+		uint64_t size;
+		if (!readValue(file, &key, sizeof(key)) || !readValue(file, &size, sizeof(size)) || size > (64ull << 20))
+		{
+			return;
+		}
+
+		ShaderBytecode blob(static_cast<size_t>(size));
+		if (!readValue(file, blob.data(), blob.size()))
+		{
+			return;
+		}
+
+		loadedBlobs[key] = move(blob);
+	}
+
+	blobs = move(loadedBlobs);
+}
+
+const PipelineStateManager::Entry& PipelineStateManager::getEntry(Key key) const
+{
+	const unique_ptr<Entry>* entry{ pipelineStates.peek(key) };
+	if (entry == nullptr)
+	{
+		throw(runtime_error{ "Pipeline state key was never requested." });
+	}
+
+	return **entry;
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <unordered_map>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "JobSystem.h"
+#include "ObjectCache.h"
+
+// Compiles pipeline states on a pool of its own and keeps the driver's compiled blobs in a file across runs. A pipeline
+// state is named by a key, a 64 bit hash of everything in its desc: input layout, shader bytecode, fixed function
+// state, formats and the desc of its root signature, so a key stays the same from run to run and changes whenever a
+// shader does. Root signatures and pipeline states are kept in ObjectCaches by key, so models and passes asking for
+// identical descs share one object. request() queues the compile and returns at once; until the state is ready the
+// renderer draws with a fallback, so switching to a state that was never used costs a frame of the old look instead of
+// a hitch. The compiles stay out of the frame's job system: a thread waiting there runs whatever is queued, and a
+// compile taking tens of milliseconds would stall the frame that picked it up. On a warm run the compile is passed the
+// blob saved for its key and the driver skips most of the work.
+class PipelineStateManager
+{
+public:
+	typedef uint64_t Key;
+
+	struct Stats
+	{
+		// A hit is a request for a desc that was requested before.
+		ObjectCacheStats rootSignatures;
+		ObjectCacheStats pipelineStates;
+		uint64_t compiles;
+		// Compiles that were given a blob from the cache file.
+		uint64_t compilesWithBlob;
+		double compileMilliseconds;
+	};
+
+	// cacheFileName is read here and written by saveCache(); empty keeps no cache file.
+	PipelineStateManager(RenderDevice& device, const std::string& cacheFileName);
+	// Waits for the compiles still running.
+	~PipelineStateManager();
+
+	PipelineStateManager(const PipelineStateManager&) = delete;
+	PipelineStateManager& operator=(const PipelineStateManager&) = delete;
+
+	// Creates the root signature on the device unless one with the same desc was created before. Its desc becomes
+	// part of the keys of the pipeline states using it, so pipeline states requested here must use root
+	// signatures created here.
+	RootSignatureHandle createRootSignature(const RootSignatureDesc& desc);
+
+	// Queues the compile of desc unless a state with the same key was requested before. Render thread.
+	Key request(const PipelineStateDesc& desc);
+	// The state if its compile is done, fallback otherwise. Rethrows the exception of a failed compile.
+	PipelineStateHandle getPipelineState(Key key, PipelineStateHandle fallback) const;
+	bool isReady(Key key) const;
+	// Helps running compiles until this one is done.
+	PipelineStateHandle waitFor(Key key);
+	// Number of requests for the key.
+	uint64_t getUses(Key key) const;
+
+	// Writes the blobs of the states requested in this run to the cache file, if their set changed since the file
+	// was read. Blobs of states nobody asked for, such as those of shaders since edited, are dropped, so the file
+	// does not grow from run to run. Render thread. Returns false when the file cannot be written; the cache is
+	// only an optimization.
+	bool saveCache();
+
+	Key computeKey(const PipelineStateDesc& desc) const;
+	static Key computeKey(const RootSignatureDesc& desc);
+
+	// Compiles finish on other threads, so the stats are read and reset between frames.
+	Stats getStats() const;
+	void resetStats();
+
+private:
+	struct Entry
+	{
+		Entry();
+
+		std::atomic<uint32_t> pipelineState;
+		std::exception_ptr error;
+		JobSystem::Counter counter;
+	};
+
+	void compile(Entry& entry, Key key, PipelineStateDesc desc);
+	void loadCache();
+	const Entry& getEntry(Key key) const;
+
+private:
+	RenderDevice& device;
+	std::string cacheFileName;
+
+	ObjectCache<RootSignatureHandle> rootSignatures;
+	std::unordered_map<uint32_t, Key> rootSignatureKeys;
+	// Entries are only added on the render thread and never removed; compile jobs hold references to them.
+	ObjectCache<std::unique_ptr<Entry>> pipelineStates;
+
+	// Guards the blobs, which compile jobs add to, and the compile stats.
+	mutable std::mutex blobMutex;
+	std::unordered_map<Key, ShaderBytecode> blobs;
+	bool blobsChanged{ false };
+	Stats stats;
+
+	// Last, so its workers are joined before the entries and blobs they use go away.
+	JobSystem compileJobs;
+};
\ No newline at end of file
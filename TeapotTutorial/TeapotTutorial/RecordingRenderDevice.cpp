@@ -0,0 +1,628 @@
+#include "RecordingRenderDevice.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+using namespace std;
+
+class RecordingCommandList : public RenderCommandList
+{
+public:
+	RecordingCommandList(RecordingRenderDevice& device, unique_ptr<RenderCommandList> target, uint32_t id) : device{ device }, target{ move(target) }, id{ id }
+	{
+	}
+
+	void reset(uint32_t frameIndex) override
+	{
+		// Whatever was recorded since the last execution is thrown away by the reset, as it is on the GPU.
+		commands.clear();
+		record(RenderCommandType::Reset).u[0] = frameIndex;
+		target->reset(frameIndex);
+	}
+
+	void close() override
+	{
+		record(RenderCommandType::Close);
+		target->close();
+	}
+
+	void setPipelineState(PipelineStateHandle pipelineState) override
+	{
+		record(RenderCommandType::SetPipelineState).u[0] = pipelineState.id;
+		target->setPipelineState(pipelineState);
+	}
+
+	void setGraphicsRootSignature(RootSignatureHandle rootSignature) override
+	{
+		record(RenderCommandType::SetGraphicsRootSignature).u[0] = rootSignature.id;
+		target->setGraphicsRootSignature(rootSignature);
+	}
+
+	void setViewport(const Viewport& viewport) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::SetViewport) };
+		command.f[0] = viewport.topLeftX;
+		command.f[1] = viewport.topLeftY;
+		command.f[2] = viewport.width;
+		command.f[3] = viewport.height;
+		command.f[4] = viewport.minDepth;
+		command.f[5] = viewport.maxDepth;
+		target->setViewport(viewport);
+	}
+
+	void setScissorRect(const ScissorRect& scissorRect) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::SetScissorRect) };
+		command.u[0] = static_cast<uint32_t>(scissorRect.left);
+		command.u[1] = static_cast<uint32_t>(scissorRect.top);
+		command.u[2] = static_cast<uint32_t>(scissorRect.right);
+		command.u[3] = static_cast<uint32_t>(scissorRect.bottom);
+		target->setScissorRect(scissorRect);
+	}
+
+	void resourceBarrier(uint32_t numBarriers, const ResourceBarrier* barriers) override
+	{
+		record(RenderCommandType::ResourceBarrier).barriers.assign(barriers, barriers + numBarriers);
+		target->resourceBarrier(numBarriers, barriers);
+	}
+
+	void setRenderTarget(const DescriptorHandle& rtv, const DescriptorHandle* dsv) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::SetRenderTarget) };
+		command.u[0] = rtv.heap.id;
+		command.u[1] = rtv.index;
+		command.u[2] = dsv != nullptr ? dsv->heap.id : 0;
+		command.u[3] = dsv != nullptr ? dsv->index : 0;
+		target->setRenderTarget(rtv, dsv);
+	}
+
+	void clearRenderTarget(const DescriptorHandle& rtv, const float (&color)[4]) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::ClearRenderTarget) };
+		command.u[0] = rtv.heap.id;
+		command.u[1] = rtv.index;
+		memcpy(command.f, color, sizeof(color));
+		target->clearRenderTarget(rtv, color);
+	}
+
+	void clearDepth(const DescriptorHandle& dsv, float depth) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::ClearDepth) };
+		command.u[0] = dsv.heap.id;
+		command.u[1] = dsv.index;
+		command.f[0] = depth;
+		target->clearDepth(dsv, depth);
+	}
+
+	void setPrimitiveTopology(PrimitiveTopology topology) override
+	{
+		record(RenderCommandType::SetPrimitiveTopology).u[0] = static_cast<uint32_t>(topology);
+		target->setPrimitiveTopology(topology);
+	}
+
+	void setVertexBuffer(uint32_t slot, const VertexBufferView& view) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::SetVertexBuffer) };
+		command.u[0] = slot;
+		command.u[1] = view.sizeInBytes;
+		command.u[2] = view.strideInBytes;
+		command.q[0] = view.bufferLocation;
+		target->setVertexBuffer(slot, view);
+	}
+
+	void setIndexBuffer(const IndexBufferView& view) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::SetIndexBuffer) };
+		command.u[0] = view.sizeInBytes;
+		command.u[1] = static_cast<uint32_t>(view.format);
+		command.q[0] = view.bufferLocation;
+		target->setIndexBuffer(view);
+	}
+
+	void setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValues, const void* data, uint32_t destOffset) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::SetGraphicsRoot32BitConstants) };
+		command.u[0] = rootParameterIndex;
+		command.u[1] = destOffset;
+		command.constants.resize(num32BitValues);
+		memcpy(command.constants.data(), data, num32BitValues * sizeof(uint32_t));
+		target->setGraphicsRoot32BitConstants(rootParameterIndex, num32BitValues, data, destOffset);
+	}
+
+	void setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::SetGraphicsRootConstantBufferView) };
+		command.u[0] = rootParameterIndex;
+		command.q[0] = bufferLocation;
+		target->setGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+	}
+
+	void setDescriptorHeap(DescriptorHeapHandle heap) override
+	{
+		record(RenderCommandType::SetDescriptorHeap).u[0] = heap.id;
+		target->setDescriptorHeap(heap);
+	}
+
+	void setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, const DescriptorHandle& baseDescriptor) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::SetGraphicsRootDescriptorTable) };
+		command.u[0] = rootParameterIndex;
+		command.u[1] = baseDescriptor.heap.id;
+		command.u[2] = baseDescriptor.index;
+		target->setGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+	}
+
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::DrawIndexedInstanced) };
+		command.u[0] = indexCountPerInstance;
+		command.u[1] = instanceCount;
+		command.u[2] = startIndexLocation;
+		command.u[3] = static_cast<uint32_t>(baseVertexLocation);
+		command.u[4] = startInstanceLocation;
+		target->drawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+	}
+
+	void executeIndirect(CommandSignatureHandle commandSignature, uint32_t maxCommandCount, ResourceHandle argumentBuffer, uint64_t argumentBufferOffset) override
+	{
+		// The arguments are buffer contents, captured like any other write to the buffer.
+		RecordedCommand& command{ record(RenderCommandType::ExecuteIndirect) };
+		command.u[0] = commandSignature.id;
+		command.u[1] = maxCommandCount;
+		command.u[2] = argumentBuffer.id;
+		command.q[0] = argumentBufferOffset;
+		target->executeIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset);
+	}
+
+	void copyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes) override
+	{
+		RecordedCommand& command{ record(RenderCommandType::CopyBufferRegion) };
+		command.u[0] = dst.id;
+		command.u[1] = src.id;
+		command.q[0] = dstOffset;
+		command.q[1] = srcOffset;
+		command.q[2] = numBytes;
+		device.captureCopy(dst, dstOffset, src, srcOffset, numBytes);
+		target->copyBufferRegion(dst, dstOffset, src, srcOffset, numBytes);
+	}
+
+	RenderCommandList* getTarget() const
+	{
+		return target.get();
+	}
+
+	uint32_t getId() const
+	{
+		return id;
+	}
+
+	void appendCommands(vector<RecordedCommand>& stream)
+	{
+		stream.insert(stream.end(), make_move_iterator(commands.begin()), make_move_iterator(commands.end()));
+		commands.clear();
+	}
+
+private:
+	// Commands are kept with the list until it is executed instead of going to the device's stream directly,
+	// so lists can be recorded on several threads at once.
+	RecordedCommand& record(RenderCommandType type)
+	{
+		RecordedCommand* command{ &discardedCommand };
+		if (device.recordingCommands)
+		{
+			commands.emplace_back();
+			command = &commands.back();
+		}
+
+		RecordingRenderDevice::initCommand(*command, type, id);
+		return *command;
+	}
+
+private:
+	RecordingRenderDevice& device;
+	unique_ptr<RenderCommandList> target;
+	uint32_t id;
+	vector<RecordedCommand> commands;
+	RecordedCommand discardedCommand;
+};
+
+RecordingRenderDevice::RecordingRenderDevice(RenderDevice& target) : target{ target }
+{
+	capture.firstBackBufferIndex = target.getCurrentBackBufferIndex();
+	for (uint32_t i{ 0 }; i < target.getBufferCount(); i++)
+	{
+		capture.backBuffers.push_back(target.getBackBuffer(i));
+		capture.backBufferRtvs.push_back(target.getBackBufferRtv(i));
+	}
+
+	capture.depthStencilView = target.getDepthStencilView();
+}
+
+ResourceHandle RecordingRenderDevice::createBuffer(const BufferDesc& desc, const void* initialData)
+{
+	CommandCapture::Buffer buffer;
+	buffer.handle = target.createBuffer(desc, initialData);
+	buffer.desc = desc;
+	buffer.gpuAddress = target.getGpuVirtualAddress(buffer.handle);
+	if (initialData != nullptr)
+	{
+		const uint8_t* bytes{ static_cast<const uint8_t*>(initialData) };
+		buffer.initialData.assign(bytes, bytes + desc.size);
+	}
+
+	bufferIndices[buffer.handle.id] = capture.buffers.size();
+	capture.buffers.push_back(move(buffer));
+	return capture.buffers.back().handle;
+}
+
+HeapHandle RecordingRenderDevice::createHeap(const HeapDesc& desc)
+{
+	return target.createHeap(desc);
+}
+
+ResourceHandle RecordingRenderDevice::createPlacedBuffer(HeapHandle heap, uint64_t heapOffset, const BufferDesc& desc)
+{
+	// Placement does not show up in the command stream, so placed buffers are captured like committed ones and
+	// a replay creates them committed.
+	CommandCapture::Buffer buffer;
+	buffer.handle = target.createPlacedBuffer(heap, heapOffset, desc);
+	buffer.desc = desc;
+	buffer.gpuAddress = target.getGpuVirtualAddress(buffer.handle);
+
+	bufferIndices[buffer.handle.id] = capture.buffers.size();
+	capture.buffers.push_back(move(buffer));
+	return capture.buffers.back().handle;
+}
+
+void RecordingRenderDevice::releaseResource(ResourceHandle resource)
+{
+	// The captured buffer stays, so a replay keeps it alive for the whole stream.
+	mappedBuffers.erase(resource.id);
+	target.releaseResource(resource);
+}
+
+void* RecordingRenderDevice::mapBuffer(ResourceHandle buffer)
+{
+	void* data{ target.mapBuffer(buffer) };
+	mappedBuffers[buffer.id] = static_cast<uint8_t*>(data);
+	return data;
+}
+
+void RecordingRenderDevice::unmapBuffer(ResourceHandle buffer)
+{
+	auto mapped = mappedBuffers.find(buffer.id);
+	if (mapped != mappedBuffers.end())
+	{
+		captureMappedWrites(buffer.id, mapped->second);
+		mappedBuffers.erase(mapped);
+	}
+
+	target.unmapBuffer(buffer);
+}
+
+uint64_t RecordingRenderDevice::getGpuVirtualAddress(ResourceHandle buffer)
+{
+	return target.getGpuVirtualAddress(buffer);
+}
+
+MemoryBudget RecordingRenderDevice::queryMemoryBudget()
+{
+	return target.queryMemoryBudget();
+}
+
+DescriptorHeapHandle RecordingRenderDevice::createDescriptorHeap(const DescriptorHeapDesc& desc)
+{
+	DescriptorHeapHandle handle{ target.createDescriptorHeap(desc) };
+	capture.descriptorHeaps.push_back({ handle, desc });
+	return handle;
+}
+
+void RecordingRenderDevice::createShaderResourceView(ResourceHandle buffer, const ShaderResourceViewDesc& desc, const DescriptorHandle& destDescriptor)
+{
+	target.createShaderResourceView(buffer, desc, destDescriptor);
+	descriptorViews[getDescriptorKey(destDescriptor)] = capture.shaderResourceViews.size();
+	capture.shaderResourceViews.push_back({ buffer, desc, destDescriptor });
+}
+
+void RecordingRenderDevice::copyDescriptors(uint32_t numCopies, const DescriptorCopy* copies)
+{
+	target.copyDescriptors(numCopies, copies);
+
+	if (recordingCommands)
+	{
+		RecordedCommand& command{ record(RenderCommandType::CopyDescriptors, 0) };
+		for (uint32_t i{ 0 }; i < numCopies; i++)
+		{
+			const DescriptorCopy& copy{ copies[i] };
+			command.constants.insert(command.constants.end(), { copy.dst.heap.id, copy.dst.index, copy.src.heap.id, copy.src.index, copy.numDescriptors });
+		}
+
+		return;
+	}
+
+	// Outside of the recorded frames only the resulting views matter: each copied descriptor becomes another
+	// view created at its destination, like the folded buffer copies.
+	for (uint32_t i{ 0 }; i < numCopies; i++)
+	{
+		for (uint32_t j{ 0 }; j < copies[i].numDescriptors; j++)
+		{
+			auto view = descriptorViews.find(getDescriptorKey({ copies[i].src.heap, copies[i].src.index + j }));
+			if (view != descriptorViews.end())
+			{
+				CommandCapture::ShaderResourceView srv{ capture.shaderResourceViews[view->second] };
+				srv.destDescriptor = { copies[i].dst.heap, copies[i].dst.index + j };
+				descriptorViews[getDescriptorKey(srv.destDescriptor)] = capture.shaderResourceViews.size();
+				capture.shaderResourceViews.push_back(srv);
+			}
+		}
+	}
+}
+
+RootSignatureHandle RecordingRenderDevice::createRootSignature(const RootSignatureDesc& desc)
+{
+	RootSignatureHandle handle{ target.createRootSignature(desc) };
+	capture.rootSignatures.push_back({ handle, desc });
+	return handle;
+}
+
+PipelineStateHandle RecordingRenderDevice::createPipelineState(const PipelineStateDesc& desc)
+{
+	PipelineStateHandle handle{ target.createPipelineState(desc) };
+
+	// The blob only holds for the driver that made it, so captures replay from the shaders.
+	lock_guard<mutex> lock{ pipelineStateMutex };
+	capture.pipelineStates.push_back({ handle, desc });
+	capture.pipelineStates.back().desc.cachedBlob.clear();
+	return handle;
+}
+
+ShaderBytecode RecordingRenderDevice::getPipelineStateBlob(PipelineStateHandle pipelineState)
+{
+	return target.getPipelineStateBlob(pipelineState);
+}
+
+CommandSignatureHandle RecordingRenderDevice::createCommandSignature(const CommandSignatureDesc& desc)
+{
+	CommandSignatureHandle handle{ target.createCommandSignature(desc) };
+	capture.commandSignatures.push_back({ handle, desc });
+	return handle;
+}
+
+unique_ptr<RenderCommandList> RecordingRenderDevice::createCommandList(QueueType queue)
+{
+	capture.commandListQueues.push_back(queue);
+	return make_unique<RecordingCommandList>(*this, target.createCommandList(queue), static_cast<uint32_t>(capture.commandListQueues.size()));
+}
+
+void RecordingRenderDevice::executeCommandLists(QueueType queue, uint32_t numCommandLists, RenderCommandList* const* commandLists)
+{
+	// Buffers that stay mapped are written without any call to observe, so whatever changed in them is captured
+	// before the lists that may read it are submitted.
+	for (const auto& mapped : mappedBuffers)
+	{
+		captureMappedWrites(mapped.first, mapped.second);
+	}
+
+	// The lists' own commands go into the stream in submission order, ahead of the execution that uses them.
+	for (uint32_t i{ 0 }; i < numCommandLists; i++)
+	{
+		static_cast<RecordingCommandList*>(commandLists[i])->appendCommands(capture.commands);
+	}
+
+	RecordedCommand& command{ record(RenderCommandType::ExecuteCommandLists, 0) };
+	command.u[0] = static_cast<uint32_t>(queue);
+
+	targetCommandLists.clear();
+	for (uint32_t i{ 0 }; i < numCommandLists; i++)
+	{
+		RecordingCommandList* commandList{ static_cast<RecordingCommandList*>(commandLists[i]) };
+		command.constants.push_back(commandList->getId());
+		targetCommandLists.push_back(commandList->getTarget());
+	}
+
+	target.executeCommandLists(queue, numCommandLists, targetCommandLists.data());
+}
+
+FenceHandle RecordingRenderDevice::createFence(uint64_t initialValue)
+{
+	FenceHandle handle{ target.createFence(initialValue) };
+	capture.fences.push_back({ handle, initialValue });
+	return handle;
+}
+
+void RecordingRenderDevice::signal(QueueType queue, FenceHandle fence, uint64_t value)
+{
+	RecordedCommand& command{ record(RenderCommandType::Signal, 0) };
+	command.u[0] = fence.id;
+	command.u[1] = static_cast<uint32_t>(queue);
+	command.q[0] = value;
+	target.signal(queue, fence, value);
+}
+
+uint64_t RecordingRenderDevice::getCompletedValue(FenceHandle fence)
+{
+	return target.getCompletedValue(fence);
+}
+
+void RecordingRenderDevice::waitForFence(FenceHandle fence, uint64_t value)
+{
+	RecordedCommand& command{ record(RenderCommandType::WaitForFence, 0) };
+	command.u[0] = fence.id;
+	command.q[0] = value;
+	target.waitForFence(fence, value);
+}
+
+void RecordingRenderDevice::waitIdle()
+{
+	target.waitIdle();
+}
+
+void RecordingRenderDevice::present()
+{
+	record(RenderCommandType::Present, 0);
+	target.present();
+}
+
+uint32_t RecordingRenderDevice::getBufferCount()
+{
+	return target.getBufferCount();
+}
+
+uint32_t RecordingRenderDevice::getCurrentBackBufferIndex()
+{
+	return target.getCurrentBackBufferIndex();
+}
+
+ResourceHandle RecordingRenderDevice::getBackBuffer(uint32_t index)
+{
+	return target.getBackBuffer(index);
+}
+
+DescriptorHandle RecordingRenderDevice::getBackBufferRtv(uint32_t index)
+{
+	return target.getBackBufferRtv(index);
+}
+
+DescriptorHandle RecordingRenderDevice::getDepthStencilView()
+{
+	return target.getDepthStencilView();
+}
+
+const vector<RecordedCommand>& RecordingRenderDevice::getCommands() const
+{
+	return capture.commands;
+}
+
+const CommandCapture& RecordingRenderDevice::getCapture() const
+{
+	return capture;
+}
+
+void RecordingRenderDevice::clear()
+{
+	capture.commands.clear();
+	capture.firstBackBufferIndex = target.getCurrentBackBufferIndex();
+	replayedContents.clear();
+}
+
+void RecordingRenderDevice::setRecordingCommands(bool recordingCommands)
+{
+	this->recordingCommands = recordingCommands;
+}
+
+uint64_t RecordingRenderDevice::getDescriptorKey(const DescriptorHandle& descriptor)
+{
+	return static_cast<uint64_t>(descriptor.heap.id) << 32 | descriptor.index;
+}
+
+RecordedCommand& RecordingRenderDevice::record(RenderCommandType type, uint32_t commandList)
+{
+	// While not recording, calls still fill in a scratch command so the callers need no special case.
+	RecordedCommand* command{ &discardedCommand };
+	if (recordingCommands)
+	{
+		capture.commands.emplace_back();
+		command = &capture.commands.back();
+	}
+
+	initCommand(*command, type, commandList);
+	return *command;
+}
+
+void RecordingRenderDevice::initCommand(RecordedCommand& command, RenderCommandType type, uint32_t commandList)
+{
+	memset(command.u, 0, sizeof(command.u));
+	memset(command.q, 0, sizeof(command.q));
+	memset(command.f, 0, sizeof(command.f));
+	command.type = type;
+	command.commandList = commandList;
+	command.barriers.clear();
+	command.constants.clear();
+	command.data.clear();
+}
+
+void RecordingRenderDevice::captureMappedWrites(uint32_t bufferId, const uint8_t* data)
+{
+	auto index = bufferIndices.find(bufferId);
+	if (!recordingCommands || index == bufferIndices.end())
+	{
+		return;
+	}
+
+	// Only the range that differs from what a replay will have in the buffer at this point is recorded, so a
+	// persistently mapped ring costs the bytes written since the last submission rather than its whole size.
+	const CommandCapture::Buffer& buffer{ capture.buffers[index->second] };
+	auto contents = replayedContents.find(bufferId);
+	if (contents == replayedContents.end())
+	{
+		contents = replayedContents.emplace(bufferId, buffer.initialData).first;
+		contents->second.resize(static_cast<size_t>(buffer.desc.size));
+	}
+
+	// Whole blocks are compared with memcmp first; only the blocks at either end of the change are scanned
+	// byte by byte.
+	const size_t blockSize{ 4096 };
+	vector<uint8_t>& known{ contents->second };
+	size_t size{ known.size() };
+
+	size_t first{ 0 };
+	while (first < size && memcmp(data + first, known.data() + first, min(blockSize, size - first)) == 0)
+	{
+		first += blockSize;
+	}
+
+	if (first >= size)
+	{
+		return;
+	}
+
+	while (data[first] == known[first])
+	{
+		++first;
+	}
+
+	size_t last{ size };
+	while (last - first > blockSize && memcmp(data + last - blockSize, known.data() + last - blockSize, blockSize) == 0)
+	{
+		last -= blockSize;
+	}
+
+	while (data[last - 1] == known[last - 1])
+	{
+		--last;
+	}
+
+	RecordedCommand& command{ record(RenderCommandType::UpdateBuffer, 0) };
+	command.u[0] = bufferId;
+	command.q[0] = first;
+	command.data.assign(data + first, data + last);
+	memcpy(known.data() + first, data + first, last - first);
+}
+
+void RecordingRenderDevice::captureCopy(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes)
+{
+	// Copies into default heap buffers are folded into their initial data as well, so a capture started after
+	// the uploads (or cleared since) still replays with the uploaded contents. The source is read at record
+	// time, which is when an uploader has just written it.
+	auto dstIndex = bufferIndices.find(dst.id);
+	auto mappedSource = mappedBuffers.find(src.id);
+	if (dstIndex == bufferIndices.end() || mappedSource == mappedBuffers.end())
+	{
+		return;
+	}
+
+	CommandCapture::Buffer& buffer{ capture.buffers[dstIndex->second] };
+	if (buffer.desc.heapType != HeapType::Default)
+	{
+		return;
+	}
+
+	// Initial data only extends to the last byte written, so a large pool buffer with a few ranges in use does
+	// not make the capture large.
+	if (buffer.initialData.size() < dstOffset + numBytes)
+	{
+		buffer.initialData.resize(static_cast<size_t>(dstOffset + numBytes));
+	}
+
+	memcpy(buffer.initialData.data() + dstOffset, mappedSource->second + srcOffset, static_cast<size_t>(numBytes));
+}
\ No newline at end of file
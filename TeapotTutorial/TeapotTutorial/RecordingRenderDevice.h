@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+#include <mutex>
+#include "RenderDevice.h"
+#include "CommandCapture.h"
+
+// Forwards every call to another RenderDevice and captures it: created objects are kept with their descriptions and
+// initial data, command list calls, executions, fence operations, buffer writes and presents are appended to a flat
+// stream. Writes through a mapping are captured when the buffer is unmapped or, for buffers that stay mapped, before
+// each submission. The result can be inspected or saved and replayed with CommandStreamPlayer. Command lists are
+// numbered in creation order starting at 1. Each list holds its commands until it is executed, so several lists can be
+// recorded on different threads; copies into captured buffers are only supported on the thread that creates objects.
+class RecordingRenderDevice : public RenderDevice
+{
+public:
+	explicit RecordingRenderDevice(RenderDevice& target);
+
+	ResourceHandle createBuffer(const BufferDesc& desc, const void* initialData) override;
+	void* mapBuffer(ResourceHandle buffer) override;
+	void unmapBuffer(ResourceHandle buffer) override;
+	uint64_t getGpuVirtualAddress(ResourceHandle buffer) override;
+
+	HeapHandle createHeap(const HeapDesc& desc) override;
+	ResourceHandle createPlacedBuffer(HeapHandle heap, uint64_t heapOffset, const BufferDesc& desc) override;
+	void releaseResource(ResourceHandle resource) override;
+	MemoryBudget queryMemoryBudget() override;
+
+	DescriptorHeapHandle createDescriptorHeap(const DescriptorHeapDesc& desc) override;
+	void createShaderResourceView(ResourceHandle buffer, const ShaderResourceViewDesc& desc, const DescriptorHandle& destDescriptor) override;
+	void copyDescriptors(uint32_t numCopies, const DescriptorCopy* copies) override;
+
+	RootSignatureHandle createRootSignature(const RootSignatureDesc& desc) override;
+	PipelineStateHandle createPipelineState(const PipelineStateDesc& desc) override;
+	ShaderBytecode getPipelineStateBlob(PipelineStateHandle pipelineState) override;
+	CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) override;
+
+	std::unique_ptr<RenderCommandList> createCommandList(QueueType queue) override;
+	void executeCommandLists(QueueType queue, uint32_t numCommandLists, RenderCommandList* const* commandLists) override;
+
+	FenceHandle createFence(uint64_t initialValue) override;
+	void signal(QueueType queue, FenceHandle fence, uint64_t value) override;
+	uint64_t getCompletedValue(FenceHandle fence) override;
+	void waitForFence(FenceHandle fence, uint64_t value) override;
+	void waitIdle() override;
+
+	void present() override;
+	uint32_t getBufferCount() override;
+	uint32_t getCurrentBackBufferIndex() override;
+	ResourceHandle getBackBuffer(uint32_t index) override;
+	DescriptorHandle getBackBufferRtv(uint32_t index) override;
+	DescriptorHandle getDepthStencilView() override;
+
+	const std::vector<RecordedCommand>& getCommands() const;
+	const CommandCapture& getCapture() const;
+
+	// Drops the recorded commands but keeps the created objects, so the next frames can be captured alone.
+	void clear();
+	void setRecordingCommands(bool recordingCommands);
+
+private:
+	static uint64_t getDescriptorKey(const DescriptorHandle& descriptor);
+	RecordedCommand& record(RenderCommandType type, uint32_t commandList);
+	static void initCommand(RecordedCommand& command, RenderCommandType type, uint32_t commandList);
+	void captureMappedWrites(uint32_t bufferId, const uint8_t* data);
+	void captureCopy(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes);
+
+	friend class RecordingCommandList;
+
+private:
+	RenderDevice& target;
+	CommandCapture capture;
+	// Guards the captured pipeline states, which compile jobs add to; the capture is read once they are done.
+	std::mutex pipelineStateMutex;
+	bool recordingCommands{ true };
+	RecordedCommand discardedCommand;
+	std::unordered_map<uint32_t, size_t> bufferIndices;
+	std::unordered_map<uint32_t, uint8_t*> mappedBuffers;
+	std::unordered_map<uint32_t, std::vector<uint8_t>> replayedContents;
+	// Index of the last captured view written to each descriptor, for folding descriptor copies.
+	std::unordered_map<uint64_t, size_t> descriptorViews;
+	std::vector<RenderCommandList*> targetCommandLists;
+};
\ No newline at end of file
@@ -0,0 +1,361 @@
+#include "RegressionHarness.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include "TeapotData.h"
+#include "SceneMath.h"
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t meshFileMagic{ 0x534d5054 }; // "TPMS"
+
+	const int occluderTessFactor{ 4 };
+	const float occluderMinAreaFraction{ 0.25f };
+
+	// TeapotData::patchesColors comes from rand(), which differs between C runtimes, so goldens use a fixed
+	// palette instead.
+	vector<XMFLOAT3> makePatchPalette(size_t numPatches)
+	{
+		vector<XMFLOAT3> palette;
+		for (size_t i{ 0 }; i < numPatches; i++)
+		{
+			palette.push_back({
+				static_cast<float>((i * 97 + 40) % 256) / 255.0f,
+				static_cast<float>((i * 57 + 80) % 256) / 255.0f,
+				static_cast<float>((i * 23 + 160) % 256) / 255.0f });
+		}
+
+		return palette;
+	}
+
+	void tessellatePatches(const vector<uint32_t>& patchIndices, int tessFactor, TessellatedMesh& mesh)
+	{
+		mesh.clear();
+		for (uint32_t i : patchIndices)
+		{
+			teapot_tutorial::PatchControlPoints controlPoints;
+			teapot_tutorial::gatherPatchControlPoints(TeapotData::points, TeapotData::patches, i, controlPoints);
+			teapot_tutorial::tessellatePatch(controlPoints, TeapotData::patchesTransforms[i], i, tessFactor, mesh);
+		}
+	}
+
+	template<typename F>
+	double measureMs(F f)
+	{
+		auto begin{ chrono::steady_clock::now() };
+		f();
+		auto end{ chrono::steady_clock::now() };
+		return chrono::duration<double, milli>(end - begin).count();
+	}
+
+	void writePpm(const string& fileName, int width, int height, const vector<uint8_t>& rgb)
+	{
+		ofstream file{ fileName, ios::binary };
+		if (!file)
+		{
+			throw(runtime_error{ "Error writing golden image." });
+		}
+
+		file << "P6\n" << width << " " << height << "\n255\n";
+		file.write(reinterpret_cast<const char*>(rgb.data()), rgb.size());
+	}
+
+	bool readPpm(const string& fileName, int& width, int& height, vector<uint8_t>& rgb)
+	{
+		ifstream file{ fileName, ios::binary };
+		if (!file)
+		{
+			return false;
+		}
+
+		string magic;
+		int maxValue;
+		file >> magic >> width >> height >> maxValue;
+		file.get();
+		if (magic != "P6" || maxValue != 255 || width <= 0 || height <= 0)
+		{
+			return false;
+		}
+
+		rgb.resize(static_cast<size_t>(width) * height * 3);
+		file.read(reinterpret_cast<char*>(rgb.data()), rgb.size());
+		return static_cast<bool>(file);
+	}
+
+	void writeMesh(const string& fileName, const TessellatedMesh& mesh)
+	{
+		ofstream file{ fileName, ios::binary };
+		if (!file)
+		{
+			throw(runtime_error{ "Error writing golden mesh." });
+		}
+
+		uint32_t numPositions{ static_cast<uint32_t>(mesh.positions.size()) };
+		uint32_t numIndices{ static_cast<uint32_t>(mesh.indices.size()) };
+		file.write(reinterpret_cast<const char*>(&meshFileMagic), sizeof(meshFileMagic));
+		file.write(reinterpret_cast<const char*>(&numPositions), sizeof(numPositions));
+		file.write(reinterpret_cast<const char*>(mesh.positions.data()), numPositions * sizeof(XMFLOAT3));
+		file.write(reinterpret_cast<const char*>(&numIndices), sizeof(numIndices));
+		file.write(reinterpret_cast<const char*>(mesh.indices.data()), numIndices * sizeof(uint32_t));
+	}
+
+	bool readMesh(const string& fileName, TessellatedMesh& mesh)
+	{
+		ifstream file{ fileName, ios::binary };
+		if (!file)
+		{
+			return false;
+		}
+
+		uint32_t magic{ 0 };
+		uint32_t numPositions{ 0 };
+		file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+		file.read(reinterpret_cast<char*>(&numPositions), sizeof(numPositions));
+		if (!file || magic != meshFileMagic)
+		{
+			return false;
+		}
+
+		mesh.positions.resize(numPositions);
+		file.read(reinterpret_cast<char*>(mesh.positions.data()), numPositions * sizeof(XMFLOAT3));
+
+		uint32_t numIndices{ 0 };
+		file.read(reinterpret_cast<char*>(&numIndices), sizeof(numIndices));
+		mesh.indices.resize(numIndices);
+		file.read(reinterpret_cast<char*>(mesh.indices.data()), numIndices * sizeof(uint32_t));
+		return static_cast<bool>(file);
+	}
+}
+
+RegressionHarness::RegressionHarness(string goldenDirectory, int width, int height) :
+	goldenDirectory{ goldenDirectory }, width{ width }, height{ height },
+	tolerances{ 8, 0.002, 1e-4f },
+	occlusionCuller{ width / 4, height / 4 }, rasterizer{ width, height }
+{
+	patchBounds = OcclusionCuller::buildPatchBounds(TeapotData::points, TeapotData::patches, TeapotData::patchesTransforms);
+	occluderMesh = OcclusionCuller::buildOccluderMesh(TeapotData::points, TeapotData::patches, TeapotData::patchesTransforms, occluderTessFactor, occluderMinAreaFraction);
+	patchColors = makePatchPalette(patchBounds.size());
+}
+
+void RegressionHarness::setTolerances(const Tolerances& tolerances)
+{
+	this->tolerances = tolerances;
+}
+
+void RegressionHarness::setUpdateGoldens(bool updateGoldens)
+{
+	this->updateGoldens = updateGoldens;
+}
+
+void RegressionHarness::setTimingRepeats(int timingRepeats)
+{
+	this->timingRepeats = max(1, timingRepeats);
+}
+
+vector<RegressionHarness::CameraKey> RegressionHarness::getDefaultCameraPath()
+{
+	vector<CameraKey> path;
+
+	const int numYawKeys{ 8 };
+	for (int i{ 0 }; i < numYawKeys; i++)
+	{
+		path.push_back({ "yaw" + to_string(i), static_cast<float>(i) / numYawKeys, 0.5f, 8 });
+	}
+
+	const int numPitchKeys{ 4 };
+	for (int i{ 0 }; i < numPitchKeys; i++)
+	{
+		path.push_back({ "pitch" + to_string(i), 0.5f, static_cast<float>(i) / numPitchKeys, 8 });
+	}
+
+	for (int tessFactor : { 1, 4, 16, 64 })
+	{
+		path.push_back({ "tess" + to_string(tessFactor), 0.6f, 0.4f, tessFactor });
+	}
+
+	return path;
+}
+
+bool RegressionHarness::allPassed(const vector<FrameResult>& results)
+{
+	return all_of(results.begin(), results.end(), [](const FrameResult& r) { return r.imageMatched && r.meshMatched; });
+}
+
+vector<RegressionHarness::FrameResult> RegressionHarness::run(const vector<CameraKey>& cameraPath)
+{
+	vector<FrameResult> results;
+	for (const CameraKey& key : cameraPath)
+	{
+		results.push_back(runKey(key));
+	}
+
+	return results;
+}
+
+RegressionHarness::FrameResult RegressionHarness::runKey(const CameraKey& key)
+{
+	float w{ static_cast<float>(width) };
+	float h{ static_cast<float>(height) };
+	XMMATRIX mvp{ teapot_tutorial::computeModelMatrix(key.mouseX * w, key.mouseY * h, w, h) * teapot_tutorial::computeViewProjMatrix(w, h) };
+
+	FrameResult result{};
+	result.name = key.name;
+
+	// The fastest of several runs is far less noisy than a single sample or the mean.
+	result.timings = renderKey(key, mvp, true);
+	for (int i{ 1 }; i < timingRepeats; i++)
+	{
+		StageTimings t{ renderKey(key, mvp, true) };
+		result.timings.cullingMs = min(result.timings.cullingMs, t.cullingMs);
+		result.timings.tessellationMs = min(result.timings.tessellationMs, t.tessellationMs);
+		result.timings.rasterizationMs = min(result.timings.rasterizationMs, t.rasterizationMs);
+	}
+
+	result.visiblePatches = visiblePatches.size();
+
+	vector<uint32_t> allPatches(patchBounds.size());
+	for (size_t i{ 0 }; i < allPatches.size(); i++)
+	{
+		allPatches[i] = static_cast<uint32_t>(i);
+	}
+
+	TessellatedMesh fullMesh;
+	tessellatePatches(allPatches, key.tessFactor, fullMesh);
+	string meshName{ "patches_tess" + to_string(key.tessFactor) + ".mesh" };
+
+	if (updateGoldens)
+	{
+		renderKey(key, mvp, false);
+		writePpm(getGoldenPath(key.name + ".ppm"), width, height, rasterizer.getColorBuffer());
+		writeMesh(getGoldenPath(meshName), fullMesh);
+		result.imageMatched = true;
+		result.meshMatched = true;
+	}
+	else
+	{
+		result.imageMatched = compareImage(getGoldenPath(key.name + ".ppm"), result);
+		result.meshMatched = compareMesh(getGoldenPath(meshName), fullMesh, result);
+	}
+
+	return result;
+}
+
+RegressionHarness::StageTimings RegressionHarness::renderKey(const CameraKey& key, FXMMATRIX mvp, bool cullingEnabled)
+{
+	StageTimings timings{};
+
+	timings.cullingMs = measureMs([&]()
+	{
+		visiblePatches.clear();
+		if (cullingEnabled)
+		{
+			occlusionCuller.beginFrame();
+			occlusionCuller.addOccluder(occluderMesh, mvp);
+			occlusionCuller.endOccluders();
+			occlusionCuller.cull(patchBounds, mvp, visiblePatches);
+		}
+		else
+		{
+			for (size_t i{ 0 }; i < patchBounds.size(); i++)
+			{
+				visiblePatches.push_back(static_cast<uint32_t>(i));
+			}
+		}
+	});
+
+	timings.tessellationMs = measureMs([&]()
+	{
+		tessellatePatches(visiblePatches, key.tessFactor, visibleMesh);
+	});
+
+	timings.rasterizationMs = measureMs([&]()
+	{
+		rasterizer.clear({ 0.1f, 0.1f, 0.1f }, 1.0f);
+		rasterizer.drawMesh(visibleMesh, mvp, patchColors);
+	});
+
+	return timings;
+}
+
+bool RegressionHarness::compareImage(const string& fileName, FrameResult& result) const
+{
+	int goldenWidth{ 0 };
+	int goldenHeight{ 0 };
+	vector<uint8_t> golden;
+	if (!readPpm(fileName, goldenWidth, goldenHeight, golden) || goldenWidth != width || goldenHeight != height)
+	{
+		result.mismatchedPixels = static_cast<size_t>(width) * height;
+		return false;
+	}
+
+	const vector<uint8_t>& image{ rasterizer.getColorBuffer() };
+	size_t mismatched{ 0 };
+	for (size_t p{ 0 }; p < image.size(); p += 3)
+	{
+		for (size_t c{ 0 }; c < 3; c++)
+		{
+			if (abs(static_cast<int>(image[p + c]) - static_cast<int>(golden[p + c])) > tolerances.maxChannelDelta)
+			{
+				++mismatched;
+				break;
+			}
+		}
+	}
+
+	result.mismatchedPixels = mismatched;
+	return static_cast<double>(mismatched) <= tolerances.maxMismatchedPixelFraction * width * height;
+}
+
+bool RegressionHarness::compareMesh(const string& fileName, const TessellatedMesh& mesh, FrameResult& result) const
+{
+	TessellatedMesh golden;
+	if (!readMesh(fileName, golden) || golden.positions.size() != mesh.positions.size() || golden.indices != mesh.indices)
+	{
+		result.maxVertexError = INFINITY;
+		return false;
+	}
+
+	float maxError{ 0.0f };
+	for (size_t i{ 0 }; i < mesh.positions.size(); i++)
+	{
+		maxError = max(maxError, fabs(mesh.positions[i].x - golden.positions[i].x));
+		maxError = max(maxError, fabs(mesh.positions[i].y - golden.positions[i].y));
+		maxError = max(maxError, fabs(mesh.positions[i].z - golden.positions[i].z));
+	}
+
+	result.maxVertexError = maxError;
+	return maxError <= tolerances.maxVertexDelta;
+}
+
+void RegressionHarness::writeReport(const vector<FrameResult>& results, const string& fileName) const
+{
+	ofstream file{ fileName };
+	if (!file)
+	{
+		throw(runtime_error{ "Error writing regression report." });
+	}
+
+	file << "name,image,mesh,mismatched_pixels,max_vertex_error,visible_patches,culling_ms,tessellation_ms,rasterization_ms\n";
+	for (const FrameResult& r : results)
+	{
+		file << r.name << ","
+			<< (r.imageMatched ? "pass" : "FAIL") << ","
+			<< (r.meshMatched ? "pass" : "FAIL") << ","
+			<< r.mismatchedPixels << ","
+			<< r.maxVertexError << ","
+			<< r.visiblePatches << ","
+			<< r.timings.cullingMs << ","
+			<< r.timings.tessellationMs << ","
+			<< r.timings.rasterizationMs << "\n";
+	}
+}
+
+string RegressionHarness::getGoldenPath(const string& fileName) const
+{
+	return goldenDirectory + "/" + fileName;
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "PatchTessellator.h"
+#include "OcclusionCuller.h"
+#include "CpuRasterizer.h"
+
+// Renders fixed camera paths through the CPU pipeline (tessellation, occlusion culling, rasterization) with
+// the same view and projection as TeapotRenderer::render and compares the results with golden files:
+//   <name>.ppm               color image, rendered with culling disabled when goldens are updated
+//   patches_tess<N>.mesh     all patches tessellated at tess factor N, shared by the keys using it
+// Timed renders always cull, while golden images are rendered without culling, so over-eager culling shows
+// up as an image mismatch. Stage timings depend on the machine, so they are only reported, never compared.
+class RegressionHarness
+{
+public:
+	struct Tolerances
+	{
+		int maxChannelDelta;
+		double maxMismatchedPixelFraction;
+		float maxVertexDelta;
+	};
+
+	struct CameraKey
+	{
+		std::string name;
+		float mouseX;
+		float mouseY;
+		int tessFactor;
+	};
+
+	struct StageTimings
+	{
+		double cullingMs;
+		double tessellationMs;
+		double rasterizationMs;
+	};
+
+	struct FrameResult
+	{
+		std::string name;
+		bool imageMatched;
+		bool meshMatched;
+		size_t mismatchedPixels;
+		float maxVertexError;
+		size_t visiblePatches;
+		StageTimings timings;
+	};
+
+	RegressionHarness(std::string goldenDirectory, int width, int height);
+
+	void setTolerances(const Tolerances& tolerances);
+	void setUpdateGoldens(bool updateGoldens);
+	void setTimingRepeats(int timingRepeats);
+
+	std::vector<FrameResult> run(const std::vector<CameraKey>& cameraPath);
+	void writeReport(const std::vector<FrameResult>& results, const std::string& fileName) const;
+
+	static std::vector<CameraKey> getDefaultCameraPath();
+	static bool allPassed(const std::vector<FrameResult>& results);
+
+private:
+	FrameResult runKey(const CameraKey& key);
+	StageTimings renderKey(const CameraKey& key, DirectX::FXMMATRIX mvp, bool cullingEnabled);
+	bool compareImage(const std::string& fileName, FrameResult& result) const;
+	bool compareMesh(const std::string& fileName, const TessellatedMesh& mesh, FrameResult& result) const;
+	std::string getGoldenPath(const std::string& fileName) const;
+
+private:
+	std::string goldenDirectory;
+	int width;
+	int height;
+	Tolerances tolerances;
+	bool updateGoldens{ false };
+	int timingRepeats{ 5 };
+
+	std::vector<Aabb> patchBounds;
+	OccluderMesh occluderMesh;
+	std::vector<DirectX::XMFLOAT3> patchColors;
+	OcclusionCuller occlusionCuller;
+	CpuRasterizer rasterizer;
+	TessellatedMesh visibleMesh;
+	std::vector<uint32_t> visiblePatches;
+};
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include "RenderTypes.h"
+
+class RenderCommandList
+{
+public:
+	virtual ~RenderCommandList() = default;
+
+	// Each list keeps one allocator per back buffer; frameIndex selects the one that is reset. Lists created for
+	// the copy queue only accept copies and barriers.
+	virtual void reset(uint32_t frameIndex) = 0;
+	virtual void close() = 0;
+
+	virtual void setPipelineState(PipelineStateHandle pipelineState) = 0;
+	virtual void setGraphicsRootSignature(RootSignatureHandle rootSignature) = 0;
+	virtual void setViewport(const Viewport& viewport) = 0;
+	virtual void setScissorRect(const ScissorRect& scissorRect) = 0;
+	virtual void resourceBarrier(uint32_t numBarriers, const ResourceBarrier* barriers) = 0;
+	virtual void setRenderTarget(const DescriptorHandle& rtv, const DescriptorHandle* dsv) = 0;
+	virtual void clearRenderTarget(const DescriptorHandle& rtv, const float (&color)[4]) = 0;
+	virtual void clearDepth(const DescriptorHandle& dsv, float depth) = 0;
+	virtual void setPrimitiveTopology(PrimitiveTopology topology) = 0;
+	virtual void setVertexBuffer(uint32_t slot, const VertexBufferView& view) = 0;
+	virtual void setIndexBuffer(const IndexBufferView& view) = 0;
+	virtual void setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValues, const void* data, uint32_t destOffset) = 0;
+	virtual void setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation) = 0;
+	virtual void setDescriptorHeap(DescriptorHeapHandle heap) = 0;
+	virtual void setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, const DescriptorHandle& baseDescriptor) = 0;
+	virtual void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) = 0;
+	// Runs maxCommandCount commands laid out as commandSignature describes from argumentBuffer, which must be in
+	// the generic read state, as upload heap buffers always are. Root arguments the commands set are undefined
+	// afterwards.
+	virtual void executeIndirect(CommandSignatureHandle commandSignature, uint32_t maxCommandCount, ResourceHandle argumentBuffer, uint64_t argumentBufferOffset) = 0;
+	virtual void copyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes) = 0;
+};
+
+// Thin device abstraction over everything the renderer needs from the GPU: resources, descriptors, pipeline
+// objects, command lists, fences and the swap chain. Graphics implements it on top of D3D12;
+// NullRenderDevice and RecordingRenderDevice run without a GPU.
+class RenderDevice
+{
+public:
+	virtual ~RenderDevice() = default;
+
+	// Default heap buffers with initial data are uploaded through the copy queue before this returns and are left
+	// in the common state, from which buffers are promoted implicitly on first use. UploadManager does the same
+	// without blocking.
+	virtual ResourceHandle createBuffer(const BufferDesc& desc, const void* initialData) = 0;
+	virtual void* mapBuffer(ResourceHandle buffer) = 0;
+	virtual void unmapBuffer(ResourceHandle buffer) = 0;
+	virtual uint64_t getGpuVirtualAddress(ResourceHandle buffer) = 0;
+
+	// Heaps only hold buffers. Placed buffers start empty, in desc.initialState (GenericRead for upload heaps),
+	// and must not overlap other live buffers of the same heap.
+	virtual HeapHandle createHeap(const HeapDesc& desc) = 0;
+	virtual ResourceHandle createPlacedBuffer(HeapHandle heap, uint64_t heapOffset, const BufferDesc& desc) = 0;
+	// The caller makes sure the GPU no longer uses the buffer. Handles are not reused.
+	virtual void releaseResource(ResourceHandle resource) = 0;
+	// Video memory the OS currently grants the process and how much of it the process uses. The budget changes
+	// with other applications' demands, so it is queried when deciding what to keep resident.
+	virtual MemoryBudget queryMemoryBudget() = 0;
+
+	virtual DescriptorHeapHandle createDescriptorHeap(const DescriptorHeapDesc& desc) = 0;
+	virtual void createShaderResourceView(ResourceHandle buffer, const ShaderResourceViewDesc& desc, const DescriptorHandle& destDescriptor) = 0;
+	// Copies all ranges in one call. Sources must be in non shader visible heaps and every range of a call must
+	// be of the same descriptor heap type.
+	virtual void copyDescriptors(uint32_t numCopies, const DescriptorCopy* copies) = 0;
+
+	virtual RootSignatureHandle createRootSignature(const RootSignatureDesc& desc) = 0;
+	// Pipeline states may be created on any thread, also while other threads record and submit lists; compiles
+	// take milliseconds, so they are best kept off the render thread.
+	virtual PipelineStateHandle createPipelineState(const PipelineStateDesc& desc) = 0;
+	// The driver's compiled form of the pipeline state, to pass as PipelineStateDesc::cachedBlob in later runs.
+	// Empty if the device has none. Any thread.
+	virtual ShaderBytecode getPipelineStateBlob(PipelineStateHandle pipelineState) = 0;
+	virtual CommandSignatureHandle createCommandSignature(const CommandSignatureDesc& desc) = 0;
+
+	virtual std::unique_ptr<RenderCommandList> createCommandList(QueueType queue) = 0;
+	virtual void executeCommandLists(QueueType queue, uint32_t numCommandLists, RenderCommandList* const* commandLists) = 0;
+
+	virtual FenceHandle createFence(uint64_t initialValue) = 0;
+	virtual void signal(QueueType queue, FenceHandle fence, uint64_t value) = 0;
+	virtual uint64_t getCompletedValue(FenceHandle fence) = 0;
+	virtual void waitForFence(FenceHandle fence, uint64_t value) = 0;
+	virtual void waitIdle() = 0;
+
+	virtual void present() = 0;
+	virtual uint32_t getBufferCount() = 0;
+	virtual uint32_t getCurrentBackBufferIndex() = 0;
+	virtual ResourceHandle getBackBuffer(uint32_t index) = 0;
+	virtual DescriptorHandle getBackBufferRtv(uint32_t index) = 0;
+	virtual DescriptorHandle getDepthStencilView() = 0;
+};
\ No newline at end of file
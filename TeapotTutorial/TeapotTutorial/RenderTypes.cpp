@@ -0,0 +1,35 @@
+#include "RenderTypes.h"
+
+const char* getRenderCommandName(RenderCommandType type)
+{
+	switch (type)
+	{
+	case RenderCommandType::Reset: return "Reset";
+	case RenderCommandType::Close: return "Close";
+	case RenderCommandType::SetPipelineState: return "SetPipelineState";
+	case RenderCommandType::SetGraphicsRootSignature: return "SetGraphicsRootSignature";
+	case RenderCommandType::SetViewport: return "SetViewport";
+	case RenderCommandType::SetScissorRect: return "SetScissorRect";
+	case RenderCommandType::ResourceBarrier: return "ResourceBarrier";
+	case RenderCommandType::SetRenderTarget: return "SetRenderTarget";
+	case RenderCommandType::ClearRenderTarget: return "ClearRenderTarget";
+	case RenderCommandType::ClearDepth: return "ClearDepth";
+	case RenderCommandType::SetPrimitiveTopology: return "SetPrimitiveTopology";
+	case RenderCommandType::SetVertexBuffer: return "SetVertexBuffer";
+	case RenderCommandType::SetIndexBuffer: return "SetIndexBuffer";
+	case RenderCommandType::SetGraphicsRoot32BitConstants: return "SetGraphicsRoot32BitConstants";
+	case RenderCommandType::SetGraphicsRootConstantBufferView: return "SetGraphicsRootConstantBufferView";
+	case RenderCommandType::SetDescriptorHeap: return "SetDescriptorHeap";
+	case RenderCommandType::SetGraphicsRootDescriptorTable: return "SetGraphicsRootDescriptorTable";
+	case RenderCommandType::DrawIndexedInstanced: return "DrawIndexedInstanced";
+	case RenderCommandType::ExecuteIndirect: return "ExecuteIndirect";
+	case RenderCommandType::CopyBufferRegion: return "CopyBufferRegion";
+	case RenderCommandType::ExecuteCommandLists: return "ExecuteCommandLists";
+	case RenderCommandType::Signal: return "Signal";
+	case RenderCommandType::WaitForFence: return "WaitForFence";
+	case RenderCommandType::UpdateBuffer: return "UpdateBuffer";
+	case RenderCommandType::CopyDescriptors: return "CopyDescriptors";
+	case RenderCommandType::Present: return "Present";
+	default: return "Unknown";
+	}
+}
\ No newline at end of file
@@ -0,0 +1,336 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+// Backend independent types used by RenderDevice and RenderCommandList. They mirror the subset of D3D12 the
+// tutorial uses, so the D3D12 backend can translate them one to one.
+
+template<typename Tag>
+struct RenderHandle
+{
+	RenderHandle() : id{ 0 } {}
+	explicit RenderHandle(uint32_t id) : id{ id } {}
+
+	bool isValid() const { return id != 0; }
+	bool operator==(const RenderHandle& other) const { return id == other.id; }
+	bool operator!=(const RenderHandle& other) const { return id != other.id; }
+
+	uint32_t id;
+};
+
+using ResourceHandle = RenderHandle<struct ResourceTag>;
+using DescriptorHeapHandle = RenderHandle<struct DescriptorHeapTag>;
+using RootSignatureHandle = RenderHandle<struct RootSignatureTag>;
+using PipelineStateHandle = RenderHandle<struct PipelineStateTag>;
+using FenceHandle = RenderHandle<struct FenceTag>;
+using HeapHandle = RenderHandle<struct HeapTag>;
+using CommandSignatureHandle = RenderHandle<struct CommandSignatureTag>;
+
+struct DescriptorHandle
+{
+	DescriptorHeapHandle heap;
+	uint32_t index;
+};
+
+enum class HeapType : uint32_t
+{
+	Default,
+	Upload
+};
+
+enum class ResourceState : uint32_t
+{
+	Common,
+	VertexAndConstantBuffer,
+	IndexBuffer,
+	RenderTarget,
+	DepthWrite,
+	NonPixelShaderResource,
+	CopyDest,
+	CopySource,
+	GenericRead,
+	Present
+};
+
+enum class QueueType : uint32_t
+{
+	Direct,
+	Copy
+};
+
+enum class DescriptorHeapType : uint32_t
+{
+	CbvSrvUav,
+	Rtv,
+	Dsv
+};
+
+enum class Format : uint32_t
+{
+	Unknown,
+	R32Uint,
+	R32G32B32Float,
+	R8G8B8A8Unorm,
+	D32Float
+};
+
+enum class PrimitiveTopology : uint32_t
+{
+	TriangleList,
+	PatchList16
+};
+
+enum class PrimitiveTopologyType : uint32_t
+{
+	Triangle,
+	Patch
+};
+
+enum class FillMode : uint32_t
+{
+	Wireframe,
+	Solid
+};
+
+enum class CullMode : uint32_t
+{
+	None,
+	Front,
+	Back
+};
+
+enum class ShaderVisibility : uint32_t
+{
+	All,
+	Vertex,
+	Hull,
+	Domain,
+	Geometry,
+	Pixel
+};
+
+enum class RootParameterType : uint32_t
+{
+	Constants,
+	Cbv,
+	SrvTable
+};
+
+enum class IndirectArgumentType : uint32_t
+{
+	DrawIndexed,
+	Constant
+};
+
+enum class BarrierFlags : uint32_t
+{
+	None,
+	BeginOnly,
+	EndOnly
+};
+
+enum RootSignatureFlags : uint32_t
+{
+	RootSignatureFlagNone = 0,
+	RootSignatureFlagAllowInputLayout = 1 << 0,
+	RootSignatureFlagDenyVertexShaderRootAccess = 1 << 1,
+	RootSignatureFlagDenyHullShaderRootAccess = 1 << 2,
+	RootSignatureFlagDenyDomainShaderRootAccess = 1 << 3,
+	RootSignatureFlagDenyGeometryShaderRootAccess = 1 << 4,
+	RootSignatureFlagDenyPixelShaderRootAccess = 1 << 5
+};
+
+const uint32_t allSubresources{ 0xffffffff };
+
+// Offsets of placed buffers inside a heap have to be multiples of this.
+const uint64_t placedResourceAlignment{ 64 * 1024 };
+
+struct BufferDesc
+{
+	uint64_t size;
+	HeapType heapType;
+	ResourceState initialState;
+	std::string name;
+};
+
+struct HeapDesc
+{
+	uint64_t size;
+	HeapType heapType;
+};
+
+struct MemoryBudget
+{
+	uint64_t budget;
+	uint64_t currentUsage;
+};
+
+struct DescriptorHeapDesc
+{
+	DescriptorHeapType type;
+	uint32_t numDescriptors;
+	bool shaderVisible;
+};
+
+struct DescriptorCopy
+{
+	DescriptorHandle dst;
+	DescriptorHandle src;
+	uint32_t numDescriptors;
+};
+
+struct ShaderResourceViewDesc
+{
+	uint32_t firstElement;
+	uint32_t numElements;
+	uint32_t structureByteStride;
+};
+
+struct RootParameterDesc
+{
+	RootParameterType type;
+	ShaderVisibility visibility;
+	uint32_t shaderRegister;
+	uint32_t registerSpace;
+	uint32_t count; // 32 bit values for Constants, descriptors for SrvTable
+};
+
+struct RootSignatureDesc
+{
+	std::vector<RootParameterDesc> parameters;
+	uint32_t flags;
+};
+
+using ShaderBytecode = std::vector<uint8_t>;
+
+struct InputElementDesc
+{
+	std::string semanticName;
+	uint32_t semanticIndex;
+	Format format;
+	uint32_t inputSlot;
+	uint32_t alignedByteOffset;
+};
+
+struct PipelineStateDesc
+{
+	RootSignatureHandle rootSignature;
+	std::vector<InputElementDesc> inputLayout;
+	ShaderBytecode vertexShader;
+	ShaderBytecode hullShader;
+	ShaderBytecode domainShader;
+	ShaderBytecode pixelShader;
+	FillMode fillMode;
+	CullMode cullMode;
+	bool depthEnable;
+	PrimitiveTopologyType topologyType;
+	Format renderTargetFormat;
+	Format depthStencilFormat;
+	// Optional blob from RenderDevice::getPipelineStateBlob for the same desc, so the driver can skip the
+	// compile. A blob from another driver or adapter is ignored and the state is compiled from the shaders.
+	ShaderBytecode cachedBlob;
+};
+
+struct IndirectArgumentDesc
+{
+	IndirectArgumentType type;
+	// Constant arguments only.
+	uint32_t rootParameterIndex;
+	uint32_t destOffsetIn32BitValues;
+	uint32_t num32BitValues;
+};
+
+// Layout of one command in an indirect argument buffer: the arguments in order, each packed after the previous
+// one, and the draw last. rootSignature is required when there are constant arguments.
+struct CommandSignatureDesc
+{
+	uint32_t byteStride;
+	std::vector<IndirectArgumentDesc> arguments;
+	RootSignatureHandle rootSignature;
+};
+
+// Laid out as D3D12_DRAW_INDEXED_ARGUMENTS, so argument buffers written on the CPU go to the GPU as they are.
+struct DrawIndexedArguments
+{
+	uint32_t indexCountPerInstance;
+	uint32_t instanceCount;
+	uint32_t startIndexLocation;
+	int32_t baseVertexLocation;
+	uint32_t startInstanceLocation;
+};
+
+struct Viewport
+{
+	float topLeftX;
+	float topLeftY;
+	float width;
+	float height;
+	float minDepth;
+	float maxDepth;
+};
+
+struct ScissorRect
+{
+	int32_t left;
+	int32_t top;
+	int32_t right;
+	int32_t bottom;
+};
+
+struct VertexBufferView
+{
+	uint64_t bufferLocation;
+	uint32_t sizeInBytes;
+	uint32_t strideInBytes;
+};
+
+struct IndexBufferView
+{
+	uint64_t bufferLocation;
+	uint32_t sizeInBytes;
+	Format format;
+};
+
+struct ResourceBarrier
+{
+	ResourceHandle resource;
+	uint32_t subresource;
+	ResourceState stateBefore;
+	ResourceState stateAfter;
+	BarrierFlags flags;
+};
+
+enum class RenderCommandType : uint8_t
+{
+	Reset,
+	Close,
+	SetPipelineState,
+	SetGraphicsRootSignature,
+	SetViewport,
+	SetScissorRect,
+	ResourceBarrier,
+	SetRenderTarget,
+	ClearRenderTarget,
+	ClearDepth,
+	SetPrimitiveTopology,
+	SetVertexBuffer,
+	SetIndexBuffer,
+	SetGraphicsRoot32BitConstants,
+	SetGraphicsRootConstantBufferView,
+	SetDescriptorHeap,
+	SetGraphicsRootDescriptorTable,
+	DrawIndexedInstanced,
+	ExecuteIndirect,
+	CopyBufferRegion,
+	ExecuteCommandLists,
+	Signal,
+	WaitForFence,
+	UpdateBuffer,
+	CopyDescriptors,
+	Present,
+	Count
+};
+
+const char* getRenderCommandName(RenderCommandType type);
\ No newline at end of file
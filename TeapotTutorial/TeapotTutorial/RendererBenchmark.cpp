@@ -0,0 +1,429 @@
+#include "RendererBenchmark.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <stdexcept>
+#include "NullRenderDevice.h"
+#include "RecordingRenderDevice.h"
+#include "CommandStreamPlayer.h"
+#include "IndirectDrawBuilder.h"
+#include "SceneMath.h"
+#include "SceneStore.h"
+#include "TransformKernel.h"
+
+using namespace std;
+
+RendererBenchmark::RendererBenchmark(uint32_t width, uint32_t height, uint32_t bufferCount) : width{ width }, height{ height }, bufferCount{ bufferCount }
+{
+}
+
+void RendererBenchmark::setFrameCount(uint32_t frameCount)
+{
+	this->frameCount = frameCount;
+}
+
+vector<RendererBenchmark::Result> RendererBenchmark::run()
+{
+	vector<Result> results;
+	results.push_back(runNullDevice("null", true, true, false, 0, false));
+	results.push_back(runNullDevice("null_no_culling", false, true, false, 0, false));
+	results.push_back(runNullDevice("null_no_state_filter", true, false, false, 0, false));
+	results.push_back(runNullDevice("null_parallel_4", true, true, false, 4, false));
+	results.push_back(runNullDevice("null_indirect", true, true, false, 0, true));
+	results.push_back(runNullDevice("recording_null", true, true, true, 0, false));
+	results.push_back(runDrawBuilder("draw_builder_1m", 1024 * 1024));
+	results.push_back(runInstanced("null_instanced_100k", 100000, false, false, 0));
+	results.push_back(runInstanced("null_instanced_100k_indirect", 100000, true, false, 0));
+	results.push_back(runInstanced("null_instanced_100k_lod", 100000, false, true, 0));
+	results.push_back(runInstanced("null_instanced_100k_lod_indirect", 100000, true, true, 0));
+	results.push_back(runInstanced("null_instanced_100k_moving_4k", 100000, false, true, 4096));
+	results.push_back(runTransformKernel("transform_kernel_100k", 100000, false, false));
+	results.push_back(runTransformKernel("transform_kernel_100k_gathered", 100000, true, false));
+	results.push_back(runTransformKernel("transform_kernel_100k_one_by_one", 100000, false, true));
+
+	// Goes through the binary format so the numbers include nothing the file would lose. Capturing whole
+	// swap chain cycles keeps the back buffers in place between replay passes.
+	CommandCapture capture{ teapot_tutorial::deserializeCommandCapture(teapot_tutorial::serializeCommandCapture(captureFrames(bufferCount * 20))) };
+	results.push_back(runReplay("replay_null", capture));
+	return results;
+}
+
+RendererBenchmark::Result RendererBenchmark::runReplay(const string& name, const CommandCapture& capture)
+{
+	NullRenderDevice device{ bufferCount, width, height };
+	CommandStreamPlayer player{ capture, device };
+
+	if (player.getFrameCount() == 0)
+	{
+		throw(runtime_error{ "Command capture contains no frames." });
+	}
+
+	player.replay();
+	device.resetStats();
+
+	uint32_t frames{ 0 };
+	auto begin{ chrono::steady_clock::now() };
+	while (frames < frameCount)
+	{
+		player.replay();
+		frames += static_cast<uint32_t>(player.getFrameCount());
+	}
+	auto end{ chrono::steady_clock::now() };
+
+	const NullRenderDevice::Stats& stats{ device.getStats() };
+	uint64_t commands{ 0 };
+	for (uint64_t count : stats.commandCounts)
+	{
+		commands += count;
+	}
+
+	Result result;
+	result.name = name;
+	result.frames = frames;
+	result.msPerFrame = chrono::duration<double, milli>(end - begin).count() / frames;
+	result.commandsPerFrame = static_cast<double>(commands) / frames;
+	result.drawsPerFrame = static_cast<double>(stats.commandCounts[static_cast<size_t>(RenderCommandType::DrawIndexedInstanced)] + stats.indirectDraws) / frames;
+	result.elidedPerFrame = 0.0;
+	result.barriersPerFrame = static_cast<double>(stats.commandCounts[static_cast<size_t>(RenderCommandType::ResourceBarrier)]) / frames;
+	result.instanceUpdateMsPerFrame = 0.0;
+	result.trianglesPerFrame = 0.0;
+	result.visibleInstancesPerFrame = 0.0;
+	result.occludedInstancesPerFrame = 0.0;
+	result.matricesPerSecond = 0.0;
+	return result;
+}
+
+void RendererBenchmark::writeReport(const vector<Result>& results, const string& fileName) const
+{
+	ofstream file{ fileName };
+	if (!file)
+	{
+		throw(runtime_error{ "Error writing benchmark report." });
+	}
+
+	file << "name,frames,ms_per_frame,commands_per_frame,draws_per_frame,elided_per_frame,barriers_per_frame,instance_update_ms_per_frame,triangles_per_frame,visible_instances_per_frame,occluded_instances_per_frame,matrices_per_second,instances_per_bucket\n";
+	for (const Result& r : results)
+	{
+		file << r.name << ","
+			<< r.frames << ","
+			<< r.msPerFrame << ","
+			<< r.commandsPerFrame << ","
+			<< r.drawsPerFrame << ","
+			<< r.elidedPerFrame << ","
+			<< r.barriersPerFrame << ","
+			<< r.instanceUpdateMsPerFrame << ","
+			<< r.trianglesPerFrame << ","
+			<< r.visibleInstancesPerFrame << ","
+			<< r.occludedInstancesPerFrame << ","
+			<< r.matricesPerSecond << ",";
+
+		// One column, the buckets separated by slashes.
+		for (size_t i{ 0 }; i < r.instancesPerBucket.size(); i++)
+		{
+			file << (i > 0 ? "/" : "") << r.instancesPerBucket[i];
+		}
+		file << "\n";
+	}
+}
+
+TeapotRenderer::ShaderSet RendererBenchmark::getPlaceholderShaderSet()
+{
+	TeapotRenderer::ShaderSet shaderSet;
+	shaderSet.vertexShader = { 0 };
+	shaderSet.hullShader = { 0 };
+	shaderSet.domainShader = { 0 };
+	shaderSet.pixelShader = { 0 };
+	return shaderSet;
+}
+
+RendererBenchmark::Result RendererBenchmark::runNullDevice(const string& name, bool occlusionCulling, bool stateFiltering, bool recording, uint32_t recordingLists, bool indirectDraws)
+{
+	NullRenderDevice nullDevice{ bufferCount, width, height };
+	RecordingRenderDevice recordingDevice{ nullDevice };
+	RenderDevice& device{ recording ? static_cast<RenderDevice&>(recordingDevice) : static_cast<RenderDevice&>(nullDevice) };
+
+	TeapotRenderer renderer{ device, getPlaceholderShaderSet(), width, height, "" };
+	renderer.setWireframe(false);
+	renderer.setStateFiltering(stateFiltering);
+	renderer.setRecordingLists(recordingLists);
+	renderer.setIndirectDraws(indirectDraws);
+	if (!occlusionCulling)
+	{
+		renderer.toggleOcclusionCulling();
+	}
+
+	// One untimed pass warms up caches and grows every per-frame vector to its final size.
+	renderFrames(renderer, frameCount);
+	nullDevice.resetStats();
+	recordingDevice.clear();
+	renderer.resetCommandStats();
+	renderer.resetInstanceStats();
+	uint64_t trianglesBefore{ renderer.getDrawBuilderStats().triangles };
+
+	auto begin{ chrono::steady_clock::now() };
+	renderFrames(renderer, frameCount);
+	auto end{ chrono::steady_clock::now() };
+
+	const NullRenderDevice::Stats& stats{ nullDevice.getStats() };
+	uint64_t commands{ 0 };
+	for (uint64_t count : stats.commandCounts)
+	{
+		commands += count;
+	}
+
+	Result result;
+	result.name = name;
+	result.frames = frameCount;
+	result.msPerFrame = chrono::duration<double, milli>(end - begin).count() / frameCount;
+	result.commandsPerFrame = static_cast<double>(commands) / frameCount;
+	result.drawsPerFrame = static_cast<double>(stats.commandCounts[static_cast<size_t>(RenderCommandType::DrawIndexedInstanced)] + stats.indirectDraws) / frameCount;
+	result.elidedPerFrame = static_cast<double>(renderer.getCommandStats().getElidedTotal()) / frameCount;
+	result.barriersPerFrame = static_cast<double>(stats.commandCounts[static_cast<size_t>(RenderCommandType::ResourceBarrier)]) / frameCount;
+	result.instanceUpdateMsPerFrame = renderer.getInstanceStats().updateMilliseconds / frameCount;
+	result.trianglesPerFrame = static_cast<double>(renderer.getDrawBuilderStats().triangles - trianglesBefore) / frameCount;
+	result.visibleInstancesPerFrame = 0.0;
+	result.occludedInstancesPerFrame = 0.0;
+	result.matricesPerSecond = 0.0;
+	return result;
+}
+
+RendererBenchmark::Result RendererBenchmark::runDrawBuilder(const string& name, uint32_t numPatches)
+{
+	const uint32_t patchesPerChunk{ 16 };
+	IndirectDrawBuilder builder{ patchesPerChunk, 16 };
+
+	// Runs of 1 to 7 visible patches separated by gaps, with every eighth chunk not resident.
+	vector<uint32_t> visiblePatches;
+	for (uint32_t patch{ 0 }, run{ 0 }; patch < numPatches; run++)
+	{
+		uint32_t length{ 1 + run % 7 };
+		for (uint32_t i{ 0 }; i < length && patch + i < numPatches; i++)
+		{
+			visiblePatches.push_back(patch + i);
+		}
+
+		patch += length + 1 + run % 3;
+	}
+
+	vector<uint8_t> chunkResident((numPatches + patchesPerChunk - 1) / patchesPerChunk);
+	for (size_t i{ 0 }; i < chunkResident.size(); i++)
+	{
+		chunkResident[i] = i % 8 != 7 ? 1 : 0;
+	}
+
+	vector<PatchDrawCommand> commands(visiblePatches.size());
+	uint32_t frames{ frameCount / 20 > 0 ? frameCount / 20 : 1 };
+	const vector<InstanceRange> instanceRanges{ { 8, 0, 1 } };
+	builder.build(visiblePatches, chunkResident, instanceRanges, commands.data());
+	builder.resetStats();
+
+	auto begin{ chrono::steady_clock::now() };
+	for (uint32_t i{ 0 }; i < frames; i++)
+	{
+		builder.build(visiblePatches, chunkResident, instanceRanges, commands.data());
+	}
+	auto end{ chrono::steady_clock::now() };
+
+	Result result;
+	result.name = name;
+	result.frames = frames;
+	result.msPerFrame = chrono::duration<double, milli>(end - begin).count() / frames;
+	result.commandsPerFrame = 0.0;
+	result.drawsPerFrame = static_cast<double>(builder.getStats().commands) / frames;
+	result.elidedPerFrame = 0.0;
+	result.barriersPerFrame = 0.0;
+	result.instanceUpdateMsPerFrame = 0.0;
+	result.trianglesPerFrame = static_cast<double>(builder.getStats().triangles) / frames;
+	result.visibleInstancesPerFrame = 0.0;
+	result.occludedInstancesPerFrame = 0.0;
+	result.matricesPerSecond = 0.0;
+	return result;
+}
+
+RendererBenchmark::Result RendererBenchmark::runInstanced(const string& name, uint32_t numInstances, bool indirectDraws, bool levelsOfDetail, uint32_t movedPerFrame)
+{
+	NullRenderDevice device{ bufferCount, width, height };
+	TeapotRenderer renderer{ device, getPlaceholderShaderSet(), width, height, "" };
+	renderer.setWireframe(false);
+	renderer.setIndirectDraws(indirectDraws);
+	renderer.setLevelsOfDetail(levelsOfDetail);
+
+	vector<teapot_tutorial::Transform> transforms;
+	vector<DirectX::XMFLOAT4> colors;
+	teapot_tutorial::makeInstanceGrid(numInstances, transforms, colors);
+	renderer.setInstances(transforms, colors);
+	vector<uint32_t> movedInstances;
+	vector<teapot_tutorial::Transform> movedTransforms;
+
+	// Every frame writes the whole instance set, so fewer frames give stable numbers.
+	uint32_t frames{ frameCount / 10 > 0 ? frameCount / 10 : 1 };
+	float w{ static_cast<float>(width) };
+	float h{ static_cast<float>(height) };
+	renderFrames(renderer, frames);
+	device.resetStats();
+	renderer.resetCommandStats();
+	renderer.resetInstanceStats();
+	renderer.resetLodStats();
+	renderer.resetInstanceGridStats();
+	renderer.resetInstanceOcclusionStats();
+	uint64_t trianglesBefore{ renderer.getDrawBuilderStats().triangles };
+
+	auto begin{ chrono::steady_clock::now() };
+	for (uint32_t i{ 0 }; i < frames; i++)
+	{
+		float t{ static_cast<float>(i) / frames };
+		if (movedPerFrame == 0)
+		{
+			renderer.setInstances(transforms, colors);
+		}
+		else
+		{
+			// A batch of instances shifted up by a cell size a tenth, so some of them change cells.
+			movedInstances.clear();
+			movedTransforms.clear();
+			for (uint32_t j{ 0 }; j < movedPerFrame; j++)
+			{
+				uint32_t index{ (i * movedPerFrame + j) % numInstances };
+				movedInstances.push_back(index);
+				movedTransforms.push_back(transforms[index]);
+				movedTransforms.back().position.y += 0.1f * (i % 2 == 0 ? 1.0f : -1.0f);
+			}
+
+			renderer.moveInstances(movedInstances, movedTransforms);
+		}
+
+		renderer.render(t * w, (0.25f + 0.5f * t) * h, w, h);
+	}
+	auto end{ chrono::steady_clock::now() };
+
+	const NullRenderDevice::Stats& stats{ device.getStats() };
+	uint64_t commands{ 0 };
+	for (uint64_t count : stats.commandCounts)
+	{
+		commands += count;
+	}
+
+	Result result;
+	result.name = name;
+	result.frames = frames;
+	result.msPerFrame = chrono::duration<double, milli>(end - begin).count() / frames;
+	result.commandsPerFrame = static_cast<double>(commands) / frames;
+	result.drawsPerFrame = static_cast<double>(stats.commandCounts[static_cast<size_t>(RenderCommandType::DrawIndexedInstanced)] + stats.indirectDraws) / frames;
+	result.elidedPerFrame = static_cast<double>(renderer.getCommandStats().getElidedTotal()) / frames;
+	result.barriersPerFrame = static_cast<double>(stats.commandCounts[static_cast<size_t>(RenderCommandType::ResourceBarrier)]) / frames;
+	result.instanceUpdateMsPerFrame = renderer.getInstanceStats().updateMilliseconds / frames;
+	result.trianglesPerFrame = static_cast<double>(renderer.getDrawBuilderStats().triangles - trianglesBefore) / frames;
+	result.visibleInstancesPerFrame = static_cast<double>(renderer.getInstanceGridStats().spheresVisible) / frames;
+	result.occludedInstancesPerFrame = static_cast<double>(renderer.getInstanceOcclusionStats().culled) / frames;
+	result.matricesPerSecond = 0.0;
+
+	const LodSelector::Stats& lodStats{ renderer.getLodStats() };
+	for (uint32_t i{ 0 }; levelsOfDetail && i < LodSelector::maxBuckets; i++)
+	{
+		result.instancesPerBucket.push_back(static_cast<double>(lodStats.instancesPerBucket[i]) / frames);
+	}
+	return result;
+}
+
+RendererBenchmark::Result RendererBenchmark::runTransformKernel(const string& name, uint32_t numMatrices, bool gathered, bool oneByOne)
+{
+	// The instance grid, each teapot turned its own way.
+	vector<teapot_tutorial::Transform> transforms;
+	vector<DirectX::XMFLOAT4> colors;
+	teapot_tutorial::makeInstanceGrid(numMatrices, transforms, colors);
+	SceneStore store;
+	store.reserve(numMatrices);
+	for (uint32_t i{ 0 }; i < numMatrices; i++)
+	{
+		DirectX::XMStoreFloat4(&transforms[i].rotation, DirectX::XMQuaternionRotationRollPitchYaw(0.1f * i, 0.2f * i, 0.3f * i));
+		store.create(transforms[i], colors[i], 0);
+	}
+
+	// A fixed shuffle, so every run gathers in the same order.
+	vector<uint32_t> indices;
+	if (gathered)
+	{
+		indices.resize(numMatrices);
+		uint32_t state{ 1 };
+		for (uint32_t i{ 0 }; i < numMatrices; i++)
+		{
+			indices[i] = i;
+		}
+
+		for (uint32_t i{ numMatrices }; i > 1; i--)
+		{
+			state = state * 1664525u + 1013904223u;
+			swap(indices[i - 1], indices[state % i]);
+		}
+	}
+
+	teapot_tutorial::TransformStreams streams{ store.getTransformStreams() };
+	const uint32_t* order{ gathered ? indices.data() : nullptr };
+	DirectX::XMMATRIX viewProj{ teapot_tutorial::computeViewProjMatrix(static_cast<float>(width), static_cast<float>(height)) };
+	SceneStore::Stream<DirectX::XMFLOAT4X4> matrices(numMatrices);
+	uint32_t frames{ frameCount / 20 > 0 ? frameCount / 20 : 1 };
+
+	auto begin{ chrono::steady_clock::now() };
+	for (uint32_t i{ 0 }; i < frames; i++)
+	{
+		if (oneByOne)
+		{
+			teapot_tutorial::computeTransformMatricesOneByOne(streams, order, 0, numMatrices, viewProj, matrices.data());
+		}
+		else
+		{
+			teapot_tutorial::computeTransformMatrices(streams, order, 0, numMatrices, viewProj, matrices.data());
+		}
+	}
+	auto end{ chrono::steady_clock::now() };
+
+	double milliseconds{ chrono::duration<double, milli>(end - begin).count() };
+	Result result;
+	result.name = name;
+	result.frames = frames;
+	result.msPerFrame = milliseconds / frames;
+	result.commandsPerFrame = 0.0;
+	result.drawsPerFrame = 0.0;
+	result.elidedPerFrame = 0.0;
+	result.barriersPerFrame = 0.0;
+	result.instanceUpdateMsPerFrame = 0.0;
+	result.trianglesPerFrame = 0.0;
+	result.visibleInstancesPerFrame = 0.0;
+	result.occludedInstancesPerFrame = 0.0;
+	result.matricesPerSecond = static_cast<double>(numMatrices) * frames / (milliseconds / 1000.0);
+	return result;
+}
+
+void RendererBenchmark::renderFrames(TeapotRenderer& renderer, uint32_t numFrames)
+{
+	float w{ static_cast<float>(width) };
+	float h{ static_cast<float>(height) };
+
+	for (uint32_t i{ 0 }; i < numFrames; i++)
+	{
+		float t{ static_cast<float>(i) / numFrames };
+		renderer.render(t * w, (0.25f + 0.5f * t) * h, w, h);
+	}
+}
+
+CommandCapture RendererBenchmark::captureFrames(uint32_t numFrames)
+{
+	NullRenderDevice nullDevice{ bufferCount, width, height };
+	RecordingRenderDevice recordingDevice{ nullDevice };
+
+	TeapotRenderer renderer{ recordingDevice, getPlaceholderShaderSet(), width, height, "" };
+	renderer.setWireframe(false);
+
+	float w{ static_cast<float>(width) };
+	float h{ static_cast<float>(height) };
+	renderer.render(0.0f, 0.0f, w, h);
+	recordingDevice.clear();
+
+	for (uint32_t i{ 0 }; i < numFrames; i++)
+	{
+		float t{ static_cast<float>(i) / numFrames };
+		renderer.render(t * w, (0.25f + 0.5f * t) * h, w, h);
+	}
+
+	return recordingDevice.getCapture();
+}
\ No newline at end of file
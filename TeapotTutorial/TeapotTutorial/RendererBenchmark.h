@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include "TeapotRenderer.h"
+#include "CommandCapture.h"
+
+// Measures the CPU cost of TeapotRenderer frames (culling, command recording and submission) on devices that
+// need no GPU, so backends and renderer changes can be compared on any machine. The camera sweeps the same
+// path for every case.
+class RendererBenchmark
+{
+public:
+	struct Result
+	{
+		std::string name;
+		uint32_t frames;
+		double msPerFrame;
+		double commandsPerFrame;
+		double drawsPerFrame;
+		double elidedPerFrame;
+		double barriersPerFrame;
+		// Copying instance colors and order for the GPU, part of msPerFrame; building the instance matrices is
+		// timed by the transform kernel cases.
+		double instanceUpdateMsPerFrame;
+		// Tessellated triangles of the draws built; 0 for replays, which build none.
+		double trianglesPerFrame;
+		// Instances the spatial grid found in the frustum; 0 where instances are not culled.
+		double visibleInstancesPerFrame;
+		// Of those, the instances the largest ones on screen hid.
+		double occludedInstancesPerFrame;
+		// Instances per level of detail bucket, finest first; empty without levels of detail.
+		std::vector<double> instancesPerBucket;
+		// Instance matrices built per second on one thread; 0 outside the transform kernel cases.
+		double matricesPerSecond;
+	};
+
+	RendererBenchmark(uint32_t width, uint32_t height, uint32_t bufferCount);
+
+	void setFrameCount(uint32_t frameCount);
+
+	std::vector<Result> run();
+
+	// Replays the capture on a null device until at least the frame count has been submitted. Only command
+	// submission is measured; the objects are created before timing starts.
+	Result runReplay(const std::string& name, const CommandCapture& capture);
+
+	void writeReport(const std::vector<Result>& results, const std::string& fileName) const;
+
+	// The null device only checks that shader stages are present, it never looks at the bytecode.
+	static TeapotRenderer::ShaderSet getPlaceholderShaderSet();
+
+private:
+	Result runNullDevice(const std::string& name, bool occlusionCulling, bool stateFiltering, bool recording, uint32_t recordingLists, bool indirectDraws);
+	// Times IndirectDrawBuilder alone on a scene of numPatches patches with every other run of them visible;
+	// a frame is one build and its draws are the commands built.
+	Result runDrawBuilder(const std::string& name, uint32_t numPatches);
+	// Draws numInstances teapots and hands the renderer their instance data again every frame, like an
+	// application moving all of them would, or with movedPerFrame moves only that many, in batches.
+	Result runInstanced(const std::string& name, uint32_t numInstances, bool indirectDraws, bool levelsOfDetail, uint32_t movedPerFrame);
+	// Times computeTransformMatrices() alone building numMatrices view projected matrices of a scene store's
+	// objects, as the renderer does for the drawn instances; a frame is one call. gathered reads the objects
+	// through a shuffled index list like a visible list; oneByOne times the reference instead.
+	Result runTransformKernel(const std::string& name, uint32_t numMatrices, bool gathered, bool oneByOne);
+	void renderFrames(TeapotRenderer& renderer, uint32_t numFrames);
+	CommandCapture captureFrames(uint32_t numFrames);
+
+private:
+	uint32_t width;
+	uint32_t height;
+	uint32_t bufferCount;
+	uint32_t frameCount{ 2000 };
+};
\ No newline at end of file
@@ -0,0 +1,195 @@
+#include "ResidencyManager.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+ResidencyManager::ResidencyManager(RenderDevice& device, GpuMemoryAllocator& allocator, UploadManager& uploadManager, uint64_t maxBytes, uint64_t streamBytesPerFrame) : device{ device }, allocator{ allocator }, uploadManager{ uploadManager }, maxBytes{ maxBytes }, streamBytesPerFrame{ streamBytesPerFrame }
+{
+	fence = device.createFence(0);
+	memset(&stats, 0, sizeof(stats));
+}
+
+ResidencyManager::~ResidencyManager()
+{
+	device.waitForFence(fence, frame - 1);
+	uploadManager.waitIdle();
+
+	for (const PendingFree& pending : pendingFrees)
+	{
+		allocator.free(pending.allocation);
+	}
+
+	for (const Chunk& chunk : chunks)
+	{
+		if (chunk.resident)
+		{
+			allocator.free(chunk.allocation);
+		}
+	}
+}
+
+uint32_t ResidencyManager::addChunk(const void* data, uint64_t size, uint64_t alignment, const string& name)
+{
+	Chunk chunk;
+	chunk.data = data;
+	chunk.size = size;
+	chunk.alignment = alignment;
+	chunk.name = name;
+	chunk.resident = false;
+	chunk.lastUsedFrame = 0;
+	chunk.priority = 0.0f;
+	chunk.lruPosition = lru.end();
+
+	chunks.push_back(move(chunk));
+	return static_cast<uint32_t>(chunks.size() - 1);
+}
+
+const GpuMemoryAllocator::Allocation* ResidencyManager::request(uint32_t chunkIndex, float priority)
+{
+	Chunk& chunk{ chunks.at(chunkIndex) };
+	bool firstRequest{ chunk.lastUsedFrame != frame };
+	chunk.lastUsedFrame = frame;
+
+	if (!chunk.resident)
+	{
+		// Several requests in a frame count once and keep the highest priority.
+		if (firstRequest)
+		{
+			++stats.misses;
+			chunk.priority = priority;
+			missing.push_back(chunkIndex);
+		}
+		else
+		{
+			chunk.priority = max(chunk.priority, priority);
+		}
+
+		return nullptr;
+	}
+
+	if (firstRequest)
+	{
+		++stats.hits;
+		lru.splice(lru.begin(), lru, chunk.lruPosition);
+	}
+
+	return chunk.uploaded.isReady() ? &chunk.allocation : nullptr;
+}
+
+void ResidencyManager::update()
+{
+	releaseCompleted();
+
+	sort(missing.begin(), missing.end(), [this](uint32_t a, uint32_t b) { return chunks[a].priority > chunks[b].priority; });
+
+	uint64_t budget{ getBudget() };
+	stats.budget = budget;
+	uint64_t streamed{ 0 };
+	bool uploaded{ false };
+	for (uint32_t chunkIndex : missing)
+	{
+		Chunk& chunk{ chunks[chunkIndex] };
+		if ((streamed > 0 && streamed + chunk.size > streamBytesPerFrame) || !makeRoom(chunk.size, budget))
+		{
+			++stats.deferred;
+			continue;
+		}
+
+		chunk.allocation = allocator.allocateBuffer({ chunk.size, HeapType::Default, ResourceState::Common, chunk.name }, chunk.alignment);
+		chunk.uploaded = uploadManager.upload(chunk.allocation.buffer, chunk.allocation.offset, chunk.data, chunk.size);
+		chunk.resident = true;
+		lru.push_front(chunkIndex);
+		chunk.lruPosition = lru.begin();
+
+		usedBytes += chunk.size;
+		++stats.residentChunks;
+		stats.residentBytes += chunk.size;
+		streamed += chunk.size;
+		stats.bytesStreamed += chunk.size;
+		uploaded = true;
+	}
+
+	missing.clear();
+	if (uploaded)
+	{
+		uploadManager.flush();
+	}
+}
+
+void ResidencyManager::endFrame(QueueType queue)
+{
+	device.signal(queue, fence, frame++);
+}
+
+uint64_t ResidencyManager::getBudget()
+{
+	// Everything the process does not use yet is available, in addition to what the chunks already hold.
+	MemoryBudget memory{ device.queryMemoryBudget() };
+	uint64_t available{ memory.budget > memory.currentUsage ? memory.budget - memory.currentUsage : 0 };
+	return min(maxBytes, usedBytes + available);
+}
+
+const ResidencyManager::Stats& ResidencyManager::getStats() const
+{
+	return stats;
+}
+
+void ResidencyManager::resetStats()
+{
+	// Resident chunks and bytes describe the current state, not what happened since the last reset.
+	uint32_t residentChunks{ static_cast<uint32_t>(lru.size()) };
+	uint64_t residentBytes{ 0 };
+	for (uint32_t chunkIndex : lru)
+	{
+		residentBytes += chunks[chunkIndex].size;
+	}
+
+	uint64_t budget{ stats.budget };
+	memset(&stats, 0, sizeof(stats));
+	stats.residentChunks = residentChunks;
+	stats.residentBytes = residentBytes;
+	stats.budget = budget;
+}
+
+bool ResidencyManager::makeRoom(uint64_t size, uint64_t budget)
+{
+	while (usedBytes + size > budget)
+	{
+		if (lru.empty() || chunks[lru.back()].lastUsedFrame == frame)
+		{
+			return false;
+		}
+
+		evict(lru.back());
+	}
+
+	return true;
+}
+
+void ResidencyManager::evict(uint32_t chunkIndex)
+{
+	Chunk& chunk{ chunks[chunkIndex] };
+	pendingFrees.push_back({ chunk.lastUsedFrame, chunk.uploaded, chunk.allocation });
+	lru.erase(chunk.lruPosition);
+	chunk.lruPosition = lru.end();
+	chunk.resident = false;
+	chunk.uploaded = UploadFuture{};
+
+	--stats.residentChunks;
+	stats.residentBytes -= chunk.size;
+	++stats.evictions;
+	stats.bytesEvicted += chunk.size;
+}
+
+void ResidencyManager::releaseCompleted()
+{
+	uint64_t completedFrame{ device.getCompletedValue(fence) };
+	while (!pendingFrees.empty() && pendingFrees.front().frame <= completedFrame && pendingFrees.front().uploaded.isReady())
+	{
+		allocator.free(pendingFrees.front().allocation);
+		usedBytes -= pendingFrees.front().allocation.size;
+		pendingFrees.pop_front();
+	}
+}
\ No newline at end of file
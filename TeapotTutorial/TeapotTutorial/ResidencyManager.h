@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "GpuMemoryAllocator.h"
+#include "UploadManager.h"
+
+// Keeps the data chunks a frame needs resident in default heap memory within a budget. Chunks are registered
+// with their CPU data and start out non-resident. Each frame the renderer requests the chunks it wants to draw
+// with a priority (visibility and distance); update() streams missing ones through the UploadManager, highest
+// priority first, and evicts the least recently requested chunks when the budget is exceeded. Chunks requested
+// in the current frame are never evicted, and evicted memory is freed only after the GPU has finished the last
+// frame that used it.
+//
+// The budget is the smaller of a fixed cap and what the device reports as available (queryMemoryBudget()), so
+// the null device's setMemoryBudget() can squeeze it to exercise eviction without a GPU.
+class ResidencyManager
+{
+public:
+	static const uint32_t invalidChunk{ UINT32_MAX };
+
+	struct Stats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t evictions;
+		uint64_t bytesStreamed;
+		uint64_t bytesEvicted;
+		// Misses that could not be streamed for lack of budget or of streaming bandwidth this frame.
+		uint64_t deferred;
+		// Current values; the counters above accumulate until resetStats().
+		uint32_t residentChunks;
+		uint64_t residentBytes;
+		uint64_t budget;
+	};
+
+	// At most streamBytesPerFrame are uploaded per update(), but always at least one chunk.
+	ResidencyManager(RenderDevice& device, GpuMemoryAllocator& allocator, UploadManager& uploadManager, uint64_t maxBytes, uint64_t streamBytesPerFrame);
+	~ResidencyManager();
+
+	ResidencyManager(const ResidencyManager&) = delete;
+	ResidencyManager& operator=(const ResidencyManager&) = delete;
+
+	// data has to stay valid while the manager exists; it is read whenever the chunk is streamed in again.
+	uint32_t addChunk(const void* data, uint64_t size, uint64_t alignment, const std::string& name);
+
+	// Marks the chunk as used by the current frame. Returns its memory once it is resident and uploaded, nullptr
+	// while it is missing or still in flight. The pointer stays valid until the next endFrame().
+	const GpuMemoryAllocator::Allocation* request(uint32_t chunk, float priority);
+	void update();
+	// Call after the lists that read this frame's chunks were executed on queue.
+	void endFrame(QueueType queue);
+
+	uint64_t getBudget();
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct Chunk
+	{
+		const void* data;
+		uint64_t size;
+		uint64_t alignment;
+		std::string name;
+		bool resident;
+		GpuMemoryAllocator::Allocation allocation;
+		UploadFuture uploaded;
+		uint64_t lastUsedFrame;
+		float priority;
+		std::list<uint32_t>::iterator lruPosition;
+	};
+
+	struct PendingFree
+	{
+		uint64_t frame;
+		UploadFuture uploaded;
+		GpuMemoryAllocator::Allocation allocation;
+	};
+
+	bool makeRoom(uint64_t size, uint64_t budget);
+	void evict(uint32_t chunk);
+	void releaseCompleted();
+
+private:
+	RenderDevice& device;
+	GpuMemoryAllocator& allocator;
+	UploadManager& uploadManager;
+	uint64_t maxBytes;
+	uint64_t streamBytesPerFrame;
+	std::vector<Chunk> chunks;
+	// Resident chunks, most recently requested first.
+	std::list<uint32_t> lru;
+	std::vector<uint32_t> missing;
+	std::deque<PendingFree> pendingFrees;
+	// Memory of resident chunks and of evicted ones the GPU may still read.
+	uint64_t usedBytes{ 0 };
+	FenceHandle fence;
+	uint64_t frame{ 1 };
+	Stats stats;
+};
\ No newline at end of file
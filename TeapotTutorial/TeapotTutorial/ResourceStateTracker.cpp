@@ -0,0 +1,300 @@
+#include "ResourceStateTracker.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+void ResourceStateRegistry::registerResource(ResourceHandle resource, ResourceState state, uint32_t subresourceCount)
+{
+	if (!resource.isValid() || subresourceCount == 0)
+	{
+		throw(runtime_error{ "Invalid resource for state tracking." });
+	}
+
+	entries[resource.id] = { subresourceCount, state, {} };
+}
+
+void ResourceStateRegistry::unregisterResource(ResourceHandle resource)
+{
+	entries.erase(resource.id);
+}
+
+bool ResourceStateRegistry::isRegistered(ResourceHandle resource) const
+{
+	return entries.find(resource.id) != entries.end();
+}
+
+uint32_t ResourceStateRegistry::getSubresourceCount(ResourceHandle resource) const
+{
+	return getEntry(resource).subresourceCount;
+}
+
+ResourceState ResourceStateRegistry::getState(ResourceHandle resource, uint32_t subresource) const
+{
+	const Entry& entry{ getEntry(resource) };
+	return entry.subresourceStates.empty() ? entry.state : entry.subresourceStates.at(subresource);
+}
+
+void ResourceStateRegistry::setState(ResourceHandle resource, uint32_t subresource, ResourceState state)
+{
+	auto found = entries.find(resource.id);
+	if (found == entries.end())
+	{
+		throw(runtime_error{ "Resource state is not tracked." });
+	}
+
+	Entry& entry{ found->second };
+	if (entry.subresourceStates.empty())
+	{
+		if (entry.state == state)
+		{
+			return;
+		}
+
+		if (entry.subresourceCount == 1)
+		{
+			entry.state = state;
+			return;
+		}
+
+		entry.subresourceStates.assign(entry.subresourceCount, entry.state);
+	}
+
+	entry.subresourceStates.at(subresource) = state;
+
+	// Back to a single state once every subresource agrees again.
+	for (ResourceState s : entry.subresourceStates)
+	{
+		if (s != state)
+		{
+			return;
+		}
+	}
+
+	entry.state = state;
+	entry.subresourceStates.clear();
+}
+
+const ResourceStateRegistry::Entry& ResourceStateRegistry::getEntry(ResourceHandle resource) const
+{
+	auto entry = entries.find(resource.id);
+	if (entry == entries.end())
+	{
+		throw(runtime_error{ "Resource state is not tracked." });
+	}
+
+	return entry->second;
+}
+
+ResourceStateTracker::ResourceStateTracker(ResourceStateRegistry& registry) : registry{ registry }
+{
+	resetStats();
+}
+
+void ResourceStateTracker::reset()
+{
+	localStates.clear();
+	queuedBarriers.clear();
+}
+
+void ResourceStateTracker::transition(ResourceHandle resource, ResourceState state, uint32_t subresource)
+{
+	LocalState& local{ getLocalState(resource) };
+	if (subresource != allSubresources)
+	{
+		transitionSubresource(resource, local, subresource, state);
+		return;
+	}
+
+	// One barrier for the whole resource when its subresources agree, one per subresource otherwise.
+	bool uniform{ true };
+	for (size_t i{ 0 }; i < local.states.size(); i++)
+	{
+		uniform = uniform && !local.splitPending[i] && local.states[i] == local.states[0];
+	}
+
+	if (uniform && local.states.size() > 1)
+	{
+		++stats.transitions;
+		if (local.states[0] == state)
+		{
+			++stats.redundantTransitions;
+			return;
+		}
+
+		queueBarrier({ resource, allSubresources, local.states[0], state, BarrierFlags::None });
+		local.states.assign(local.states.size(), state);
+		return;
+	}
+
+	for (uint32_t i{ 0 }; i < local.states.size(); i++)
+	{
+		transitionSubresource(resource, local, i, state);
+	}
+}
+
+void ResourceStateTracker::beginTransition(RenderCommandList& commandList, ResourceHandle resource, ResourceState state, uint32_t subresource)
+{
+	LocalState& local{ getLocalState(resource) };
+	uint32_t first{ subresource == allSubresources ? 0 : subresource };
+	uint32_t end{ subresource == allSubresources ? static_cast<uint32_t>(local.states.size()) : subresource + 1 };
+
+	vector<ResourceBarrier> barriers;
+	for (uint32_t i{ first }; i < end; i++)
+	{
+		// Settle an earlier split first; a transition to the current state needs no barrier at all.
+		if (local.splitPending[i])
+		{
+			transitionSubresource(resource, local, i, local.splitStates[i]);
+		}
+
+		if (local.states[i] != state)
+		{
+			barriers.push_back({ resource, getBarrierSubresource(local, i), local.states[i], state, BarrierFlags::BeginOnly });
+			local.splitStates[i] = state;
+			local.splitPending[i] = true;
+		}
+	}
+
+	// Whatever is queued, including the end halves of settled splits, has to happen before the begin half.
+	flushBarriers(commandList);
+	if (!barriers.empty())
+	{
+		commandList.resourceBarrier(static_cast<uint32_t>(barriers.size()), barriers.data());
+		stats.barriersIssued += barriers.size();
+		stats.splitBarriers += barriers.size();
+		++stats.barrierCalls;
+	}
+}
+
+void ResourceStateTracker::flushBarriers(RenderCommandList& commandList)
+{
+	if (queuedBarriers.empty())
+	{
+		return;
+	}
+
+	commandList.resourceBarrier(static_cast<uint32_t>(queuedBarriers.size()), queuedBarriers.data());
+	stats.barriersIssued += queuedBarriers.size();
+	++stats.barrierCalls;
+	queuedBarriers.clear();
+}
+
+void ResourceStateTracker::commit()
+{
+	if (!queuedBarriers.empty())
+	{
+		throw(runtime_error{ "Committing resource states with barriers that were never recorded." });
+	}
+
+	for (const auto& local : localStates)
+	{
+		ResourceHandle resource{ local.first };
+		for (uint32_t i{ 0 }; i < local.second.states.size(); i++)
+		{
+			if (local.second.splitPending[i])
+			{
+				throw(runtime_error{ "Split barrier left open at the end of a command list." });
+			}
+
+			registry.setState(resource, i, local.second.states[i]);
+		}
+	}
+}
+
+const ResourceStateTracker::Stats& ResourceStateTracker::getStats() const
+{
+	return stats;
+}
+
+void ResourceStateTracker::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+ResourceStateTracker::LocalState& ResourceStateTracker::getLocalState(ResourceHandle resource)
+{
+	auto local = localStates.find(resource.id);
+	if (local != localStates.end())
+	{
+		return local->second;
+	}
+
+	LocalState& state{ localStates[resource.id] };
+	uint32_t subresourceCount{ registry.getSubresourceCount(resource) };
+	for (uint32_t i{ 0 }; i < subresourceCount; i++)
+	{
+		state.states.push_back(registry.getState(resource, i));
+	}
+
+	state.splitStates.assign(subresourceCount, ResourceState::Common);
+	state.splitPending.assign(subresourceCount, false);
+	return state;
+}
+
+void ResourceStateTracker::transitionSubresource(ResourceHandle resource, LocalState& local, uint32_t subresource, ResourceState state)
+{
+	ResourceState& current{ local.states.at(subresource) };
+	++stats.transitions;
+
+	bool splitEnded{ local.splitPending[subresource] != 0 };
+	if (splitEnded)
+	{
+		// The end half completes the split; a different target state needs another barrier after it.
+		queueBarrier({ resource, getBarrierSubresource(local, subresource), current, local.splitStates[subresource], BarrierFlags::EndOnly });
+		current = local.splitStates[subresource];
+		local.splitPending[subresource] = false;
+	}
+
+	if (current == state)
+	{
+		if (!splitEnded)
+		{
+			++stats.redundantTransitions;
+		}
+
+		return;
+	}
+
+	queueBarrier({ resource, getBarrierSubresource(local, subresource), current, state, BarrierFlags::None });
+	current = state;
+}
+
+uint32_t ResourceStateTracker::getBarrierSubresource(const LocalState& local, uint32_t subresource)
+{
+	return local.states.size() == 1 ? allSubresources : subresource;
+}
+
+void ResourceStateTracker::queueBarrier(const ResourceBarrier& barrier)
+{
+	// A -> B queued and not recorded yet followed by B -> C becomes A -> C, or nothing when C is A.
+	if (barrier.flags == BarrierFlags::None)
+	{
+		for (size_t i{ queuedBarriers.size() }; i-- > 0;)
+		{
+			ResourceBarrier& queued{ queuedBarriers[i] };
+			if (queued.resource != barrier.resource)
+			{
+				continue;
+			}
+
+			if (queued.flags == BarrierFlags::None && queued.subresource == barrier.subresource && queued.stateAfter == barrier.stateBefore)
+			{
+				if (queued.stateBefore == barrier.stateAfter)
+				{
+					queuedBarriers.erase(queuedBarriers.begin() + i);
+				}
+				else
+				{
+					queued.stateAfter = barrier.stateAfter;
+				}
+
+				return;
+			}
+
+			break;
+		}
+	}
+
+	queuedBarriers.push_back(barrier);
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "RenderDevice.h"
+
+// States of resources between command lists, i.e. what a resource is in when the next submitted list starts.
+// Only registered resources are tracked; buffers that rely on implicit promotion from the common state are left
+// out. Every subresource has its own state once one of them is transitioned alone.
+class ResourceStateRegistry
+{
+public:
+	void registerResource(ResourceHandle resource, ResourceState state, uint32_t subresourceCount = 1);
+	void unregisterResource(ResourceHandle resource);
+
+	bool isRegistered(ResourceHandle resource) const;
+	uint32_t getSubresourceCount(ResourceHandle resource) const;
+	ResourceState getState(ResourceHandle resource, uint32_t subresource) const;
+	void setState(ResourceHandle resource, uint32_t subresource, ResourceState state);
+
+private:
+	struct Entry
+	{
+		uint32_t subresourceCount;
+		ResourceState state;
+		// Empty while all subresources are in state.
+		std::vector<ResourceState> subresourceStates;
+	};
+
+	const Entry& getEntry(ResourceHandle resource) const;
+
+private:
+	std::unordered_map<uint32_t, Entry> entries;
+};
+
+// Derives barriers from the states resources are used in, for one command list. The first use of a resource in
+// the list starts from the registry's state, so lists sharing a registry have to be committed in the order they
+// are submitted. Transitions are queued and flushBarriers() records them with one resourceBarrier call, so a
+// pass states what it needs and pays for one call; a transition that is undone before the flush disappears.
+//
+// beginTransition() records the begin half of a split barrier right away, giving the GPU the work between it and
+// the end half to overlap the transition with; the end half is queued by the next transition of the resource.
+class ResourceStateTracker
+{
+public:
+	struct Stats
+	{
+		uint64_t transitions;
+		uint64_t redundantTransitions;
+		uint64_t barriersIssued;
+		uint64_t barrierCalls;
+		uint64_t splitBarriers;
+	};
+
+	explicit ResourceStateTracker(ResourceStateRegistry& registry);
+
+	// Forgets the states of the previous list; call when the command list is reset.
+	void reset();
+
+	void transition(ResourceHandle resource, ResourceState state, uint32_t subresource = allSubresources);
+	void beginTransition(RenderCommandList& commandList, ResourceHandle resource, ResourceState state, uint32_t subresource = allSubresources);
+	void flushBarriers(RenderCommandList& commandList);
+
+	// Writes the states at the end of the list to the registry. Call after close(), before executing the list.
+	void commit();
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct LocalState
+	{
+		// Indexed by subresource.
+		std::vector<ResourceState> states;
+		// Target state of a split barrier whose end half is not recorded yet, per subresource.
+		std::vector<ResourceState> splitStates;
+		std::vector<uint8_t> splitPending;
+	};
+
+	LocalState& getLocalState(ResourceHandle resource);
+	void transitionSubresource(ResourceHandle resource, LocalState& local, uint32_t subresource, ResourceState state);
+	void queueBarrier(const ResourceBarrier& barrier);
+	static uint32_t getBarrierSubresource(const LocalState& local, uint32_t subresource);
+
+private:
+	ResourceStateRegistry& registry;
+	std::unordered_map<uint32_t, LocalState> localStates;
+	std::vector<ResourceBarrier> queuedBarriers;
+	Stats stats;
+};
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+
+namespace teapot_tutorial
+{
+	const float cameraFov{ 45.0f };
+	const float cameraNear{ 1.0f };
+	const float cameraFar{ 100.0f };
+
+	inline DirectX::XMMATRIX XM_CALLCONV computeViewProjMatrix(float width, float height)
+	{
+		using namespace DirectX;
+
+		float ratio{ width / height };
+		XMMATRIX projMatrixDX{ XMMatrixPerspectiveFovLH(XMConvertToRadians(cameraFov), ratio, cameraNear, cameraFar) };
+
+		XMVECTOR camPositionDX(XMVectorSet(0.0f, 0.0f, -10.0f, 0.0f));
+		XMVECTOR camLookAtDX(XMVectorSet(0.0f, 0.0f, 0.0f, 0.0f));
+		XMVECTOR camUpDX(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX viewMatrixDX{ XMMatrixLookAtLH(camPositionDX, camLookAtDX, camUpDX) };
+
+		return viewMatrixDX * projMatrixDX;
+	}
+
+	// The teapot turns half a revolution either way as the mouse moves from the window center to its edges.
+	inline DirectX::XMMATRIX XM_CALLCONV computeModelMatrix(float mouseX, float mouseY, float width, float height)
+	{
+		using namespace DirectX;
+
+		float pitch{ -XMConvertToRadians((mouseX - (width / 2.0f)) / (width / 2.0f) * 180.0f) };
+		float roll{ XMConvertToRadians((mouseY - (height / 2.0f)) / (height / 2.0f) * 180.0f) };
+
+		XMMATRIX modelMatrixRotationDX{ XMMatrixRotationRollPitchYaw(roll, pitch, 0.0f) };
+		XMMATRIX modelMatrixTranslationDX{ XMMatrixTranslation(0.0f, -1.0f, 0.0f) };
+		return modelMatrixRotationDX * modelMatrixTranslationDX;
+	}
+
+	// A placement applied scale first, then the rotation quaternion, then the translation.
+	struct Transform
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT4 rotation;
+		DirectX::XMFLOAT3 scale;
+	};
+
+	inline DirectX::XMMATRIX XM_CALLCONV computeTransformMatrix(const Transform& transform)
+	{
+		using namespace DirectX;
+
+		XMMATRIX matrix{ XMMatrixScaling(transform.scale.x, transform.scale.y, transform.scale.z) * XMMatrixRotationQuaternion(XMLoadFloat4(&transform.rotation)) };
+		matrix.r[3] = XMVectorSet(transform.position.x, transform.position.y, transform.position.z, 1.0f);
+		return matrix;
+	}
+
+	// The sphere (localCenter, localRadius) placed by transform, as center and radius. The radius grows with the
+	// largest scale of the transform.
+	inline DirectX::XMFLOAT4 XM_CALLCONV transformBoundingSphere(DirectX::FXMMATRIX transform, const DirectX::XMFLOAT3& localCenter, float localRadius)
+	{
+		using namespace DirectX;
+
+		float scaleX{ XMVectorGetX(XMVector3Length(transform.r[0])) };
+		float scaleY{ XMVectorGetX(XMVector3Length(transform.r[1])) };
+		float scaleZ{ XMVectorGetX(XMVector3Length(transform.r[2])) };
+		float scale{ scaleX > scaleY ? scaleX : scaleY };
+		scale = scale > scaleZ ? scale : scaleZ;
+
+		XMFLOAT4 sphere;
+		XMStoreFloat4(&sphere, XMVector3Transform(XMLoadFloat3(&localCenter), transform));
+		sphere.w = localRadius * scale;
+		return sphere;
+	}
+
+	// count teapots on a cubic grid centered on the origin, shrunk so the whole grid fits the view, with colors
+	// running along the grid's axes.
+	inline void makeInstanceGrid(uint32_t count, std::vector<Transform>& transforms, std::vector<DirectX::XMFLOAT4>& colors)
+	{
+		using namespace DirectX;
+
+		uint32_t side{ 1 };
+		while (side * side * side < count)
+		{
+			++side;
+		}
+
+		const float extent{ 8.0f };
+		float spacing{ extent / side };
+		float scale{ spacing * 0.15f };
+		float origin{ -0.5f * spacing * (side - 1) };
+
+		transforms.resize(count);
+		colors.resize(count);
+		for (uint32_t i{ 0 }; i < count; i++)
+		{
+			uint32_t x{ i % side };
+			uint32_t y{ (i / side) % side };
+			uint32_t z{ i / (side * side) };
+
+			transforms[i] = Transform{ { origin + x * spacing, origin + y * spacing, origin + z * spacing }, { 0.0f, 0.0f, 0.0f, 1.0f }, { scale, scale, scale } };
+			colors[i] = XMFLOAT4{ 0.25f + 0.75f * x / side, 0.25f + 0.75f * y / side, 0.25f + 0.75f * z / side, 1.0f };
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+
+// Everything the render thread needs from one update tick. It is copied whole through a TripleBuffer, so it
+// only holds values, no pointers into state the update thread goes on changing.
+struct SceneSnapshot
+{
+	DirectX::XMFLOAT4X4 model;
+	DirectX::XMFLOAT4X4 viewProj;
+	int tessFactor;
+	// Number of the update tick that produced it.
+	uint64_t tick;
+};
\ No newline at end of file
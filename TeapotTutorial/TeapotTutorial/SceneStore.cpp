@@ -0,0 +1,275 @@
+#include "SceneStore.h"
+#include <stdexcept>
+
+using namespace std;
+using namespace DirectX;
+
+void SceneStore::setLocalBounds(const XMFLOAT3& center, float radius)
+{
+	localCenter = center;
+	localRadius = radius;
+	for (uint32_t i{ 0 }; i < getSize(); i++)
+	{
+		markDirty(i);
+	}
+}
+
+SceneStore::Handle SceneStore::create(const teapot_tutorial::Transform& transform, const XMFLOAT4& color, uint32_t flags)
+{
+	uint32_t slot;
+	if (!freeSlots.empty())
+	{
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+	}
+	else
+	{
+		// Generations start at 1, so a zeroed handle is never valid.
+		slot = static_cast<uint32_t>(slots.size());
+		slots.push_back({ absent, 1 });
+	}
+
+	uint32_t index{ getSize() };
+	slots[slot].index = index;
+	indexSlots.push_back(slot);
+	for (Stream<float>& stream : transforms)
+	{
+		stream.push_back(0.0f);
+	}
+	worlds.emplace_back();
+	bounds.emplace_back();
+	colors.push_back(color);
+	this->flags.push_back(flags);
+	dirty.push_back(0);
+
+	writeTransform(index, transform);
+	++colorsVersion;
+	return { slot, slots[slot].generation };
+}
+
+void SceneStore::destroy(Handle handle)
+{
+	uint32_t index{ getCheckedIndex(handle) };
+
+	// The last object takes the place, so the streams stay packed.
+	uint32_t last{ getSize() - 1 };
+	if (index != last)
+	{
+		for (Stream<float>& stream : transforms)
+		{
+			stream[index] = stream[last];
+		}
+		worlds[index] = worlds[last];
+		bounds[index] = bounds[last];
+		colors[index] = colors[last];
+		flags[index] = flags[last];
+		dirty[index] = dirty[last];
+		indexSlots[index] = indexSlots[last];
+		slots[indexSlots[index]].index = index;
+	}
+
+	for (Stream<float>& stream : transforms)
+	{
+		stream.pop_back();
+	}
+	worlds.pop_back();
+	bounds.pop_back();
+	colors.pop_back();
+	flags.pop_back();
+	dirty.pop_back();
+	indexSlots.pop_back();
+
+	Slot& slot{ slots[handle.slot] };
+	slot.index = absent;
+	++slot.generation;
+	freeSlots.push_back(handle.slot);
+
+	++worldsVersion;
+	++colorsVersion;
+}
+
+void SceneStore::clear()
+{
+	// Freed last to first, so the objects created next get the slots in order.
+	freeSlots.clear();
+	for (uint32_t slot{ static_cast<uint32_t>(slots.size()) }; slot-- > 0;)
+	{
+		if (slots[slot].index != absent)
+		{
+			slots[slot].index = absent;
+			++slots[slot].generation;
+		}
+		freeSlots.push_back(slot);
+	}
+
+	for (Stream<float>& stream : transforms)
+	{
+		stream.clear();
+	}
+	worlds.clear();
+	bounds.clear();
+	colors.clear();
+	flags.clear();
+	dirty.clear();
+	indexSlots.clear();
+	dirtySlots.clear();
+
+	++worldsVersion;
+	++colorsVersion;
+}
+
+void SceneStore::reserve(uint32_t capacity)
+{
+	for (Stream<float>& stream : transforms)
+	{
+		stream.reserve(capacity);
+	}
+	worlds.reserve(capacity);
+	bounds.reserve(capacity);
+	colors.reserve(capacity);
+	flags.reserve(capacity);
+	dirty.reserve(capacity);
+	indexSlots.reserve(capacity);
+	slots.reserve(capacity);
+}
+
+bool SceneStore::isValid(Handle handle) const
+{
+	return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation && slots[handle.slot].index != absent;
+}
+
+void SceneStore::setTransform(Handle handle, const teapot_tutorial::Transform& transform)
+{
+	writeTransform(getCheckedIndex(handle), transform);
+}
+
+void SceneStore::setColor(Handle handle, const XMFLOAT4& color)
+{
+	colors[getCheckedIndex(handle)] = color;
+	++colorsVersion;
+}
+
+void SceneStore::setFlags(Handle handle, uint32_t flags)
+{
+	this->flags[getCheckedIndex(handle)] = flags;
+}
+
+uint32_t SceneStore::getIndex(Handle handle) const
+{
+	return getCheckedIndex(handle);
+}
+
+void SceneStore::updateWorlds(vector<uint32_t>& updated)
+{
+	if (dirtySlots.empty())
+	{
+		return;
+	}
+
+	size_t firstUpdated{ updated.size() };
+	for (uint32_t slot : dirtySlots)
+	{
+		uint32_t index{ slots[slot].index };
+		if (index != absent && dirty[index] != 0)
+		{
+			dirty[index] = 0;
+			updated.push_back(index);
+		}
+	}
+
+	// Built in a batch, then put in place.
+	uint32_t count{ static_cast<uint32_t>(updated.size() - firstUpdated) };
+	const uint32_t* indices{ updated.data() + firstUpdated };
+	updatedWorlds.resize(count);
+	teapot_tutorial::computeTransformMatrices(getTransformStreams(), indices, 0, count, XMMatrixIdentity(), updatedWorlds.data());
+	for (uint32_t i{ 0 }; i < count; i++)
+	{
+		uint32_t index{ indices[i] };
+		worlds[index] = updatedWorlds[i];
+		bounds[index] = teapot_tutorial::transformBoundingSphere(XMLoadFloat4x4(&updatedWorlds[i]), localCenter, localRadius);
+	}
+
+	dirtySlots.clear();
+	++worldsVersion;
+}
+
+uint32_t SceneStore::getSize() const
+{
+	return static_cast<uint32_t>(indexSlots.size());
+}
+
+teapot_tutorial::TransformStreams SceneStore::getTransformStreams() const
+{
+	teapot_tutorial::TransformStreams streams;
+	for (uint32_t stream{ 0 }; stream < teapot_tutorial::transformStreamCount; stream++)
+	{
+		streams.components[stream] = transforms[stream].data();
+	}
+
+	return streams;
+}
+
+const XMFLOAT4X4* SceneStore::getWorlds() const
+{
+	return worlds.data();
+}
+
+const XMFLOAT4* SceneStore::getBounds() const
+{
+	return bounds.data();
+}
+
+const XMFLOAT4* SceneStore::getColors() const
+{
+	return colors.data();
+}
+
+const uint32_t* SceneStore::getFlags() const
+{
+	return flags.data();
+}
+
+uint64_t SceneStore::getWorldsVersion() const
+{
+	return worldsVersion;
+}
+
+uint64_t SceneStore::getColorsVersion() const
+{
+	return colorsVersion;
+}
+
+uint32_t SceneStore::getCheckedIndex(Handle handle) const
+{
+	if (!isValid(handle))
+	{
+		throw(runtime_error{ "Invalid scene object handle." });
+	}
+
+	return slots[handle.slot].index;
+}
+
+void SceneStore::writeTransform(uint32_t index, const teapot_tutorial::Transform& transform)
+{
+	const float components[teapot_tutorial::transformStreamCount]
+	{
+		transform.position.x, transform.position.y, transform.position.z,
+		transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w,
+		transform.scale.x, transform.scale.y, transform.scale.z
+	};
+	for (uint32_t stream{ 0 }; stream < teapot_tutorial::transformStreamCount; stream++)
+	{
+		transforms[stream][index] = components[stream];
+	}
+
+	markDirty(index);
+}
+
+void SceneStore::markDirty(uint32_t index)
+{
+	if (dirty[index] == 0)
+	{
+		dirty[index] = 1;
+		dirtySlots.push_back(indexSlots[index]);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <cstdint>
+#include "AlignedAllocator.h"
+#include "SceneMath.h"
+#include "TransformKernel.h"
+
+// Scene objects as structure of arrays: every attribute is its own dense stream, aligned to a cache line, with
+// the live objects packed at its front. Kernels that only need transforms or bounds read only those, four
+// objects a vector (see computeTransformMatrices()), and the colors stream is laid out as the GPU reads it, so
+// uploading it is a single copy of its front.
+//
+// Objects are named by generational handles: a handle indexes a slot table that holds the object's place in
+// the streams and the slot's generation, which changes when the object is destroyed, so stale handles are
+// detected instead of reaching the object that took the slot. Destroying an object moves the last object into
+// its place in the streams; handles stay valid across that, stream indices do not.
+//
+// Setting a transform only writes the translation, rotation and scale streams and marks the object dirty;
+// updateWorlds() recomputes the world matrices and bounds of the dirty objects in one batch, however often
+// each was moved. Each of the world and color streams has a version that changes with its contents, so a
+// consumer keeping a copy per frame slot knows which streams to copy again.
+class SceneStore
+{
+public:
+	struct Handle
+	{
+		uint32_t slot;
+		uint32_t generation;
+	};
+
+	static const size_t streamAlignment{ 64 };
+
+	template<typename T>
+	using Stream = std::vector<T, AlignedAllocator<T, streamAlignment>>;
+
+	// The model space bounding sphere every object's bounds are placed from. Marks every object dirty.
+	void setLocalBounds(const DirectX::XMFLOAT3& center, float radius);
+
+	Handle create(const teapot_tutorial::Transform& transform, const DirectX::XMFLOAT4& color, uint32_t flags);
+	void destroy(Handle handle);
+	void clear();
+	void reserve(uint32_t capacity);
+	bool isValid(Handle handle) const;
+
+	void setTransform(Handle handle, const teapot_tutorial::Transform& transform);
+	void setColor(Handle handle, const DirectX::XMFLOAT4& color);
+	// Application defined bits, carried along with the object.
+	void setFlags(Handle handle, uint32_t flags);
+	// The object's current place in the streams.
+	uint32_t getIndex(Handle handle) const;
+
+	// Recomputes the world matrices and bounds of the objects whose transforms changed and appends their stream
+	// indices to updated.
+	void updateWorlds(std::vector<uint32_t>& updated);
+
+	uint32_t getSize() const;
+	// The translation, rotation and scale streams, in the order of teapot_tutorial::TransformStreams.
+	teapot_tutorial::TransformStreams getTransformStreams() const;
+	const DirectX::XMFLOAT4X4* getWorlds() const;
+	// Bounding spheres as center and radius.
+	const DirectX::XMFLOAT4* getBounds() const;
+	const DirectX::XMFLOAT4* getColors() const;
+	const uint32_t* getFlags() const;
+	uint64_t getWorldsVersion() const;
+	uint64_t getColorsVersion() const;
+
+private:
+	struct Slot
+	{
+		// The object's stream index, or absent while the slot is free.
+		uint32_t index;
+		uint32_t generation;
+	};
+
+	static const uint32_t absent{ 0xFFFFFFFF };
+
+	uint32_t getCheckedIndex(Handle handle) const;
+	void writeTransform(uint32_t index, const teapot_tutorial::Transform& transform);
+	void markDirty(uint32_t index);
+
+private:
+	DirectX::XMFLOAT3 localCenter{ 0.0f, 0.0f, 0.0f };
+	float localRadius{ 0.0f };
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+
+	// By stream index.
+	Stream<float> transforms[teapot_tutorial::transformStreamCount];
+	Stream<DirectX::XMFLOAT4X4> worlds;
+	Stream<DirectX::XMFLOAT4> bounds;
+	Stream<DirectX::XMFLOAT4> colors;
+	Stream<uint32_t> flags;
+	Stream<uint8_t> dirty;
+	std::vector<uint32_t> indexSlots;
+	// The slots of the objects marked dirty since the last updateWorlds(); the dirty stream filters out the ones
+	// destroyed or listed twice since.
+	std::vector<uint32_t> dirtySlots;
+	Stream<DirectX::XMFLOAT4X4> updatedWorlds;
+
+	uint64_t worldsVersion{ 1 };
+	uint64_t colorsVersion{ 1 };
+};
\ No newline at end of file
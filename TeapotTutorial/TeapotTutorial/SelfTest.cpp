@@ -0,0 +1,386 @@
+#include "SelfTest.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <cstdint>
+#include "TlsfAllocator.h"
+#include "DescriptorAllocator.h"
+#include "NullRenderDevice.h"
+#include "ShaderStore.h"
+#include "SceneStore.h"
+
+using namespace std;
+
+namespace
+{
+	template<typename F>
+	bool throwsRuntimeError(F f)
+	{
+		try
+		{
+			f();
+		}
+		catch (runtime_error&)
+		{
+			return true;
+		}
+
+		return false;
+	}
+
+	void writeFile(const string& fileName, const string& contents)
+	{
+		ofstream file{ fileName, ios::binary | ios::trunc };
+		file.write(contents.data(), static_cast<streamsize>(contents.size()));
+		if (!file)
+		{
+			throw(runtime_error{ "Error writing self test file " + fileName + "." });
+		}
+	}
+
+	bool hasContents(const ShaderStore::Blob& blob, const string& contents)
+	{
+		return blob && blob->size() == contents.size() && equal(blob->begin(), blob->end(), contents.begin(), [](uint8_t a, char b) { return a == static_cast<uint8_t>(b); });
+	}
+
+	// Fences complete only when the checks let the GPU catch up or the CPU waits for them, so reuse that has to
+	// wait for the GPU can be told from reuse that must not.
+	class LaggingFenceDevice : public NullRenderDevice
+	{
+	public:
+		LaggingFenceDevice() : NullRenderDevice{ 2, 64, 64 }
+		{
+		}
+
+		uint64_t getCompletedValue(FenceHandle fence) override
+		{
+			uint64_t signaled{ NullRenderDevice::getCompletedValue(fence) };
+			return signaled < gpuProgress ? signaled : gpuProgress;
+		}
+
+		void waitForFence(FenceHandle fence, uint64_t value) override
+		{
+			NullRenderDevice::waitForFence(fence, value);
+			gpuProgress = value > gpuProgress ? value : gpuProgress;
+			++waits;
+		}
+
+		void completeUpTo(uint64_t value)
+		{
+			gpuProgress = value;
+		}
+
+		uint64_t getGpuProgress() const
+		{
+			return gpuProgress;
+		}
+
+		uint32_t getWaits() const
+		{
+			return waits;
+		}
+
+	private:
+		uint64_t gpuProgress{ 0 };
+		uint32_t waits{ 0 };
+	};
+}
+
+SelfTest::SelfTest(string scratchDirectory) : scratchDirectory{ move(scratchDirectory) }
+{
+}
+
+vector<SelfTest::CheckResult> SelfTest::run()
+{
+	results.clear();
+	runGroup("tlsf", [this]() { checkTlsfAllocator(); });
+	runGroup("descriptors", [this]() { checkDescriptorAllocator(); });
+	runGroup("shaders", [this]() { checkShaderStore(); });
+	runGroup("scene", [this]() { checkSceneStore(); });
+	return results;
+}
+
+void SelfTest::writeReport(const vector<CheckResult>& results, const string& fileName) const
+{
+	ofstream file{ fileName };
+	if (!file)
+	{
+		throw(runtime_error{ "Error writing self test report." });
+	}
+
+	file << "check,result,error\n";
+	for (const CheckResult& r : results)
+	{
+		file << r.name << "," << (r.passed ? "pass" : "FAIL") << "," << r.error << "\n";
+	}
+}
+
+bool SelfTest::allPassed(const vector<CheckResult>& results)
+{
+	return all_of(results.begin(), results.end(), [](const CheckResult& r) { return r.passed; });
+}
+
+void SelfTest::runGroup(const string& name, const function<void()>& checks)
+{
+	try
+	{
+		checks();
+	}
+	catch (exception& e)
+	{
+		results.push_back({ name, false, e.what() });
+	}
+}
+
+void SelfTest::check(const string& name, bool passed)
+{
+	results.push_back({ name, passed, "" });
+}
+
+void SelfTest::checkTlsfAllocator()
+{
+	const uint64_t size{ 4096 };
+
+	// Structured buffer ranges are aligned to their stride, which is rarely a power of two.
+	{
+		TlsfAllocator allocator{ size };
+		vector<pair<uint64_t, uint64_t>> ranges;
+		bool aligned{ true };
+		for (uint64_t rangeSize : { 100, 37, 200, 64, 1000, 5 })
+		{
+			uint64_t offset{ allocator.allocate(rangeSize, 48) };
+			aligned = aligned && offset != TlsfAllocator::invalidOffset && offset % 48 == 0;
+			ranges.push_back({ offset, offset + rangeSize });
+		}
+
+		sort(ranges.begin(), ranges.end());
+		bool disjoint{ ranges.back().second <= size };
+		for (size_t i{ 1 }; i < ranges.size(); i++)
+		{
+			disjoint = disjoint && ranges[i - 1].second <= ranges[i].first;
+		}
+
+		check("tlsf: offsets aligned to 48", aligned);
+		check("tlsf: aligned ranges disjoint and inside the range", disjoint);
+	}
+
+	// The padding in front of an aligned range is split off as a free block and merged back on free.
+	{
+		TlsfAllocator allocator{ size };
+		uint64_t first{ allocator.allocate(10, 1) };
+		uint64_t second{ allocator.allocate(20, 48) };
+		TlsfAllocator::Stats stats{ allocator.getStats() };
+		check("tlsf: split leaves the padding free", first == 0 && second == 48 && stats.freeBlocks == 2 && stats.allocatedBytes == 30);
+
+		uint64_t padding{ allocator.allocate(38, 1) };
+		check("tlsf: padding is allocated again", padding == 10);
+
+		allocator.free(second);
+		allocator.free(first);
+		allocator.free(padding);
+		stats = allocator.getStats();
+		check("tlsf: freeing everything merges into one block", allocator.isEmpty() && stats.freeBlocks == 1 && stats.largestFreeBlock == size && allocator.getFragmentation() == 0.0);
+	}
+
+	// A freed block merges with free neighbours on both sides, never with allocated ones.
+	{
+		TlsfAllocator allocator{ size };
+		uint64_t a{ allocator.allocate(100, 1) };
+		uint64_t b{ allocator.allocate(100, 1) };
+		uint64_t c{ allocator.allocate(100, 1) };
+		uint64_t d{ allocator.allocate(100, 1) };
+		allocator.free(a);
+		allocator.free(c);
+		check("tlsf: separated free blocks stay apart", allocator.getStats().freeBlocks == 3);
+
+		allocator.free(b);
+		TlsfAllocator::Stats stats{ allocator.getStats() };
+		check("tlsf: freed block merges with both neighbours", stats.freeBlocks == 2 && stats.freeBytes == size - 100);
+
+		allocator.free(d);
+		check("tlsf: last free merges the rest", allocator.getStats().freeBlocks == 1);
+	}
+
+	// Filling the range with stride aligned ranges, freeing them and filling again fits as many the second time.
+	{
+		TlsfAllocator allocator{ size };
+		vector<uint64_t> offsets;
+		for (uint64_t offset{ allocator.allocate(72, 24) }; offset != TlsfAllocator::invalidOffset; offset = allocator.allocate(72, 24))
+		{
+			offsets.push_back(offset);
+		}
+
+		size_t firstFill{ offsets.size() };
+		for (uint64_t offset : offsets)
+		{
+			allocator.free(offset);
+		}
+
+		offsets.clear();
+		for (uint64_t offset{ allocator.allocate(72, 24) }; offset != TlsfAllocator::invalidOffset; offset = allocator.allocate(72, 24))
+		{
+			offsets.push_back(offset);
+		}
+
+		check("tlsf: range fills with aligned ranges", firstFill >= size / 72 - 1);
+		check("tlsf: refill after free fits as many", offsets.size() == firstFill);
+		check("tlsf: oversized request fails", allocator.allocate(size + 1, 1) == TlsfAllocator::invalidOffset);
+	}
+
+	{
+		TlsfAllocator allocator{ size };
+		uint64_t offset{ allocator.allocate(64, 16) };
+		check("tlsf: freeing an unknown offset throws", throwsRuntimeError([&]() { allocator.free(offset + 16); }));
+	}
+}
+
+void SelfTest::checkDescriptorAllocator()
+{
+	// A freed persistent range may still be read by frames in flight, so it is reused only once its frame is done.
+	{
+		LaggingFenceDevice device;
+		DescriptorAllocator descriptors{ device, 8, 8 };
+		DescriptorAllocator::Range range{ descriptors.allocatePersistent(8) };
+		descriptors.freePersistent(range);
+		check("descriptors: freed range not reused within its frame", throwsRuntimeError([&]() { descriptors.allocatePersistent(1); }));
+
+		descriptors.endFrame(QueueType::Direct);
+		check("descriptors: freed range not reused before the GPU passed its frame", throwsRuntimeError([&]() { descriptors.allocatePersistent(1); }));
+
+		device.completeUpTo(1);
+		DescriptorAllocator::Range reused{ descriptors.allocatePersistent(8) };
+		check("descriptors: freed range reused after the GPU passed its frame", reused.gpu.index == range.gpu.index && reused.count == 8 && device.getWaits() == 0);
+	}
+
+	// Per frame tables come from a ring whose regions are reused once the GPU has finished their frame; when the
+	// ring is full, only the oldest frame is waited for.
+	{
+		LaggingFenceDevice device;
+		DescriptorAllocator descriptors{ device, 4, 8 };
+		DescriptorAllocator::Range range{ descriptors.allocatePersistent(4) };
+		DescriptorHandle sources[4];
+		for (uint32_t i{ 0 }; i < 4; i++)
+		{
+			sources[i] = { range.staging.heap, range.staging.index + i };
+		}
+
+		DescriptorHandle first{ descriptors.allocateTable(4, sources) };
+		descriptors.flush();
+		check("descriptors: consecutive sources copied as one range", descriptors.getStats().copyRanges == 1 && descriptors.getStats().descriptorsCopied == 4);
+		descriptors.endFrame(QueueType::Direct);
+
+		DescriptorHandle second{ descriptors.allocateTable(4, sources) };
+		descriptors.flush();
+		descriptors.endFrame(QueueType::Direct);
+		check("descriptors: tables of frames in flight are disjoint", second.index == first.index + 4);
+
+		DescriptorHandle third{ descriptors.allocateTable(4, sources) };
+		descriptors.flush();
+		descriptors.endFrame(QueueType::Direct);
+		check("descriptors: full ring waits for the oldest frame only", third.index == first.index && descriptors.getStats().stalls == 1 && device.getWaits() == 1 && device.getGpuProgress() == 1);
+
+		device.completeUpTo(2);
+		DescriptorHandle fourth{ descriptors.allocateTable(4, sources) };
+		check("descriptors: completed frame reused without waiting while a later one is in flight", fourth.index == second.index && descriptors.getStats().stalls == 1 && device.getWaits() == 1);
+		check("descriptors: table larger than the ring throws", throwsRuntimeError([&]() { descriptors.allocateTable(9, sources); }));
+	}
+}
+
+void SelfTest::checkShaderStore()
+{
+	const string fileA{ scratchDirectory + "/selftest_shader_a.cso" };
+	const string fileB{ scratchDirectory + "/selftest_shader_b.cso" };
+	const string original{ "shader bytecode v1" };
+	const string edited{ "shader bytecode v2, longer" };
+
+	// The files are removed however the checks end.
+	struct ScratchFiles
+	{
+		~ScratchFiles()
+		{
+			for (const string& fileName : fileNames)
+			{
+				remove(fileName.c_str());
+			}
+		}
+
+		vector<string> fileNames;
+	} scratchFiles{ { fileA, fileB } };
+
+	writeFile(fileA, original);
+	writeFile(fileB, original);
+
+	ShaderStore store;
+	ShaderStore::Hash hashA{ store.load(fileA) };
+	ShaderStore::Hash hashB{ store.load(fileB) };
+	check("shaders: same contents under two names share one blob", hashA == hashB && store.getBlob(fileA) == store.getBlob(fileB) && store.getStats().blobsShared == 1);
+	check("shaders: loaded blob holds the file contents", hasContents(store.getBlob(fileA), original));
+
+	// The edit changes the size, so it is seen however coarse the file system's write times are.
+	writeFile(fileA, edited);
+	uint32_t firstPoll{ store.poll() };
+	uint32_t secondPoll{ store.poll() };
+	check("shaders: a change is staged once it is seen twice", firstPoll == 0 && secondPoll == 1);
+	check("shaders: staged contents are not current before applyChanges", store.getHash(fileA) == hashA && hasContents(store.getBlob(fileA), original));
+	check("shaders: polling again stages nothing new", store.poll() == 0);
+
+	vector<string> changed{ store.applyChanges() };
+	check("shaders: applyChanges returns the changed file", changed.size() == 1 && changed[0] == fileA);
+	check("shaders: applied contents are current", store.getHash(fileA) != hashA && hasContents(store.getBlob(fileA), edited));
+	check("shaders: other names keep their blob", store.getHash(fileB) == hashB && hasContents(store.getBlob(hashA), original));
+	check("shaders: nothing left to apply", store.applyChanges().empty());
+
+	// Once no file refers to the old contents, their blob is dropped; a holder keeps its copy alive.
+	ShaderStore::Blob oldBlob{ store.getBlob(hashA) };
+	writeFile(fileB, edited);
+	store.poll();
+	store.poll();
+	store.applyChanges();
+	check("shaders: reload to stored contents shares the blob", store.getBlob(fileA) == store.getBlob(fileB));
+	check("shaders: unused blob is dropped", throwsRuntimeError([&]() { store.getBlob(hashA); }) && hasContents(oldBlob, original));
+
+	check("shaders: loading a missing file throws", throwsRuntimeError([&]() { store.load(scratchDirectory + "/selftest_missing.cso"); }));
+	check("shaders: unknown name throws", throwsRuntimeError([&]() { store.getHash("selftest_never_loaded.cso"); }));
+}
+
+void SelfTest::checkSceneStore()
+{
+	auto at = [](float x) { return teapot_tutorial::Transform{ { x, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f } }; };
+	const teapot_tutorial::Transform moved{ at(5.0f) };
+
+	SceneStore store;
+	SceneStore::Handle a{ store.create(at(1.0f), { 1.0f, 0.0f, 0.0f, 1.0f }, 1) };
+	SceneStore::Handle b{ store.create(at(2.0f), { 0.0f, 1.0f, 0.0f, 1.0f }, 2) };
+	SceneStore::Handle c{ store.create(at(3.0f), { 0.0f, 0.0f, 1.0f, 1.0f }, 3) };
+	vector<uint32_t> updated;
+	store.updateWorlds(updated);
+	check("scene: new objects are updated once", updated.size() == 3 && store.getWorlds()[store.getIndex(c)].m[3][0] == 3.0f);
+
+	// The last object takes the destroyed one's place; its handle follows it, the destroyed handle goes stale.
+	store.destroy(a);
+	check("scene: destroyed handle is stale", !store.isValid(a) && store.isValid(b) && store.isValid(c));
+	check("scene: stale handle is rejected", throwsRuntimeError([&]() { store.setTransform(a, moved); }) && throwsRuntimeError([&]() { store.getIndex(a); }) && throwsRuntimeError([&]() { store.destroy(a); }));
+	check("scene: streams stay packed", store.getSize() == 2 && store.getIndex(c) == 0 && store.getColors()[store.getIndex(c)].z == 1.0f && store.getFlags()[store.getIndex(c)] == 3);
+
+	// The slot is reused with a new generation, so the stale handle does not reach the new object.
+	SceneStore::Handle d{ store.create(at(4.0f), { 1.0f, 1.0f, 0.0f, 1.0f }, 4) };
+	check("scene: reused slot gets a new generation", d.slot == a.slot && d.generation != a.generation && !store.isValid(a) && store.isValid(d));
+	check("scene: stale handle cannot write the slot's new object", throwsRuntimeError([&]() { store.setColor(a, { 0.0f, 0.0f, 0.0f, 0.0f }); }) && store.getColors()[store.getIndex(d)].x == 1.0f);
+
+	// Moves are batched: an object moved twice is updated once, and one destroyed after moving not at all.
+	updated.clear();
+	store.updateWorlds(updated);
+	updated.clear();
+	store.setTransform(b, moved);
+	store.setTransform(b, moved);
+	store.setTransform(d, moved);
+	store.destroy(d);
+	store.updateWorlds(updated);
+	check("scene: moved objects are updated once, destroyed ones not at all", updated.size() == 1 && updated[0] == store.getIndex(b) && store.getWorlds()[store.getIndex(b)].m[3][0] == 5.0f);
+
+	store.clear();
+	check("scene: clear makes every handle stale", !store.isValid(b) && !store.isValid(c) && !store.isValid(d) && store.getSize() == 0);
+	check("scene: zeroed and out of range handles are invalid", !store.isValid(SceneStore::Handle{ 0, 0 }) && !store.isValid(SceneStore::Handle{ 1000, 1 }));
+}
\ No newline at end of file
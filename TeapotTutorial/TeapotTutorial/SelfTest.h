@@ -0,0 +1,40 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <functional>
+
+// Behavior checks of the allocators and stores the renderer is built on, run without a window or a GPU. Each
+// check is one named expectation, so a failure in the report says what broke rather than only where. A group
+// of checks that throws unexpectedly fails as a whole with the exception's message.
+class SelfTest
+{
+public:
+	struct CheckResult
+	{
+		std::string name;
+		bool passed;
+		std::string error;
+	};
+
+	// Checks that need files write them to scratchDirectory and remove them when done.
+	explicit SelfTest(std::string scratchDirectory);
+
+	std::vector<CheckResult> run();
+	void writeReport(const std::vector<CheckResult>& results, const std::string& fileName) const;
+
+	static bool allPassed(const std::vector<CheckResult>& results);
+
+private:
+	void runGroup(const std::string& name, const std::function<void()>& checks);
+	void check(const std::string& name, bool passed);
+
+	void checkTlsfAllocator();
+	void checkDescriptorAllocator();
+	void checkShaderStore();
+	void checkSceneStore();
+
+private:
+	std::string scratchDirectory;
+	std::vector<CheckResult> results;
+};
\ No newline at end of file
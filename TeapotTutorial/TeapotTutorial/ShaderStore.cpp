@@ -0,0 +1,245 @@
+#include "ShaderStore.h"
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include "Fnv1aHasher.h"
+
+using namespace std;
+
+ShaderStore::ShaderStore()
+{
+	resetStats();
+}
+
+ShaderStore::~ShaderStore()
+{
+	stopWatching();
+}
+
+ShaderStore::Hash ShaderStore::load(const string& fileName)
+{
+	// The stamp is taken first: a write after it is seen as a change by the next polls.
+	MappedFile::Stamp stamp;
+	if (!MappedFile::getStamp(fileName, stamp))
+	{
+		throw(runtime_error{ "Error reading shader " + fileName + "." });
+	}
+
+	Hash hash;
+	Blob blob{ readFile(fileName, hash) };
+
+	lock_guard<mutex> lock{ filesMutex };
+	blobs[hash] = blob;
+	File& file{ files[fileName] };
+	file.current = hash;
+	file.hasStaged = false;
+	file.stamp = stamp;
+	file.pending = false;
+	return hash;
+}
+
+ShaderStore::Hash ShaderStore::getHash(const string& fileName) const
+{
+	lock_guard<mutex> lock{ filesMutex };
+	auto file = files.find(fileName);
+	if (file == files.end())
+	{
+		throw(runtime_error{ "Shader " + fileName + " was never loaded." });
+	}
+
+	return file->second.current;
+}
+
+ShaderStore::Blob ShaderStore::getBlob(Hash hash) const
+{
+	lock_guard<mutex> lock{ filesMutex };
+	auto blob = blobs.find(hash);
+	if (blob == blobs.end())
+	{
+		throw(runtime_error{ "No shader with this hash is stored." });
+	}
+
+	return blob->second;
+}
+
+ShaderStore::Blob ShaderStore::getBlob(const string& fileName) const
+{
+	return getBlob(getHash(fileName));
+}
+
+uint32_t ShaderStore::poll()
+{
+	lock_guard<mutex> pollLock{ pollMutex };
+
+	vector<string> fileNames;
+	{
+		lock_guard<mutex> lock{ filesMutex };
+		for (const auto& file : files)
+		{
+			fileNames.push_back(file.first);
+		}
+	}
+
+	uint32_t numStaged{ 0 };
+	for (const string& fileName : fileNames)
+	{
+		// Files that are missing for a moment, as when an editor replaces them, are looked at again next time.
+		MappedFile::Stamp stamp;
+		if (!MappedFile::getStamp(fileName, stamp))
+		{
+			continue;
+		}
+
+		{
+			lock_guard<mutex> lock{ filesMutex };
+			File& file{ files[fileName] };
+			if (stamp == file.stamp)
+			{
+				file.pending = false;
+				continue;
+			}
+
+			if (!file.pending || stamp != file.pendingStamp)
+			{
+				file.pending = true;
+				file.pendingStamp = stamp;
+				continue;
+			}
+		}
+
+		Hash hash;
+		Blob blob;
+		try
+		{
+			blob = readFile(fileName, hash);
+		}
+		catch (const runtime_error&)
+		{
+			continue;
+		}
+
+		lock_guard<mutex> lock{ filesMutex };
+		File& file{ files[fileName] };
+		file.stamp = stamp;
+		file.pending = false;
+		if (hash == (file.hasStaged ? file.staged : file.current))
+		{
+			++stats.unchangedRewrites;
+			continue;
+		}
+
+		// An applyChanges() since the read may have dropped the blob. A file changed back to its current
+		// contents before they were applied has nothing staged anymore.
+		blobs[hash] = blob;
+		file.staged = hash;
+		file.hasStaged = hash != file.current;
+		++stats.reloads;
+		if (file.hasStaged)
+		{
+			++numStaged;
+		}
+	}
+
+	return numStaged;
+}
+
+void ShaderStore::startWatching(uint32_t intervalMilliseconds)
+{
+	if (watcher.joinable())
+	{
+		throw(runtime_error{ "The shader store is already watching its files." });
+	}
+
+	stopping = false;
+	watcher = thread{ &ShaderStore::runWatcher, this, intervalMilliseconds };
+}
+
+void ShaderStore::stopWatching()
+{
+	if (!watcher.joinable())
+	{
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock{ watcherMutex };
+		stopping = true;
+	}
+
+	watcherWake.notify_one();
+	watcher.join();
+}
+
+vector<string> ShaderStore::applyChanges()
+{
+	vector<string> changed;
+
+	lock_guard<mutex> lock{ filesMutex };
+	for (auto& file : files)
+	{
+		if (file.second.hasStaged)
+		{
+			file.second.current = file.second.staged;
+			file.second.hasStaged = false;
+			changed.push_back(file.first);
+		}
+	}
+
+	if (changed.empty())
+	{
+		return changed;
+	}
+
+	// Reloads add a blob per version; only the current ones are kept. Callers holding an old blob keep it alive.
+	unordered_map<Hash, Blob> currentBlobs;
+	for (const auto& file : files)
+	{
+		currentBlobs[file.second.current] = blobs[file.second.current];
+	}
+
+	blobs = move(currentBlobs);
+	return changed;
+}
+
+ShaderStore::Stats ShaderStore::getStats() const
+{
+	lock_guard<mutex> lock{ filesMutex };
+	return stats;
+}
+
+void ShaderStore::resetStats()
+{
+	lock_guard<mutex> lock{ filesMutex };
+	memset(&stats, 0, sizeof(stats));
+}
+
+ShaderStore::Blob ShaderStore::readFile(const string& fileName, Hash& hash)
+{
+	MappedFile mappedFile{ fileName };
+	hash = Fnv1aHasher::hashBytes(mappedFile.getData(), mappedFile.getSize());
+
+	lock_guard<mutex> lock{ filesMutex };
+	++stats.filesMapped;
+	stats.bytesMapped += mappedFile.getSize();
+
+	Blob& blob{ blobs[hash] };
+	if (blob)
+	{
+		++stats.blobsShared;
+		return blob;
+	}
+
+	blob = make_shared<const ShaderBytecode>(mappedFile.getData(), mappedFile.getData() + mappedFile.getSize());
+	return blob;
+}
+
+void ShaderStore::runWatcher(uint32_t intervalMilliseconds)
+{
+	unique_lock<mutex> lock{ watcherMutex };
+	while (!watcherWake.wait_for(lock, chrono::milliseconds{ intervalMilliseconds }, [this]() { return stopping; }))
+	{
+		lock.unlock();
+		poll();
+		lock.lock();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include "RenderTypes.h"
+#include "MappedFile.h"
+
+// Compiled shaders addressed by the hash of their contents. Files are read through a file mapping and hashed;
+// a file whose contents are already stored, under the same or another name, shares the stored blob. Every
+// loaded file stays watched: poll(), called by the watcher thread or directly, notices files whose write time
+// or size changed, reloads them and stages the new contents. The staged contents only become current in
+// applyChanges(), which the render thread calls between frames, so a frame never sees a half updated shader
+// set; the names it returns are the shaders whose pipeline states must be recreated.
+class ShaderStore
+{
+public:
+	typedef uint64_t Hash;
+	typedef std::shared_ptr<const ShaderBytecode> Blob;
+
+	struct Stats
+	{
+		uint64_t filesMapped;
+		uint64_t bytesMapped;
+		// Loads and reloads whose contents were already stored.
+		uint64_t blobsShared;
+		// Changed files whose contents were staged, and files that were rewritten with the same contents.
+		uint64_t reloads;
+		uint64_t unchangedRewrites;
+	};
+
+	ShaderStore();
+	// Stops the watcher thread.
+	~ShaderStore();
+
+	ShaderStore(const ShaderStore&) = delete;
+	ShaderStore& operator=(const ShaderStore&) = delete;
+
+	// Maps and hashes the file and makes its contents current for fileName, which is watched from then on.
+	// Throws runtime_error if the file cannot be read.
+	Hash load(const std::string& fileName);
+	// The current contents of a loaded file; throws runtime_error for names that were never loaded.
+	Hash getHash(const std::string& fileName) const;
+	Blob getBlob(Hash hash) const;
+	Blob getBlob(const std::string& fileName) const;
+
+	// Checks every loaded file once. A change is picked up when a file shows the same new write time and size
+	// in two polls in a row, so a file that is still being written is not read. Any thread; returns the number
+	// of files whose new contents were staged.
+	uint32_t poll();
+	// Runs poll() on a thread of its own every intervalMilliseconds until stopWatching().
+	void startWatching(uint32_t intervalMilliseconds);
+	void stopWatching();
+
+	// Makes the staged contents current and returns the names that changed. Blobs no file refers to anymore
+	// are dropped.
+	std::vector<std::string> applyChanges();
+
+	Stats getStats() const;
+	void resetStats();
+
+private:
+	struct File
+	{
+		Hash current;
+		Hash staged;
+		bool hasStaged;
+		MappedFile::Stamp stamp;
+		MappedFile::Stamp pendingStamp;
+		bool pending;
+	};
+
+	// Maps and hashes the file without holding the lock and adds its blob unless one with the same hash is
+	// stored.
+	Blob readFile(const std::string& fileName, Hash& hash);
+	void runWatcher(uint32_t intervalMilliseconds);
+
+private:
+	mutable std::mutex filesMutex;
+	std::unordered_map<std::string, File> files;
+	std::unordered_map<Hash, Blob> blobs;
+	Stats stats;
+
+	// Serializes poll() calls from the watcher and other threads.
+	std::mutex pollMutex;
+
+	std::thread watcher;
+	std::mutex watcherMutex;
+	std::condition_variable watcherWake;
+	bool stopping{ false };
+};
\ No newline at end of file
@@ -0,0 +1,420 @@
+#include "SpatialHashGrid.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	// A few hundred spheres each with the cell sizes the renderer uses.
+	const uint32_t cellsPerGrain{ 8 };
+	const uint64_t cellKeyMask{ (1u << 21) - 1 };
+
+	struct QueryPlanes
+	{
+		// Each plane's components splatted, for the sphere tests.
+		XMVECTOR splats[6][4];
+		// Structure of arrays for the cell tests, four planes a vector; the last two planes are repeated.
+		XMVECTOR x[2];
+		XMVECTOR y[2];
+		XMVECTOR z[2];
+		XMVECTOR w[2];
+		// The distance of a box corner along the plane normal per unit of half extent.
+		XMVECTOR extent[2];
+	};
+
+	// Planes of a row vector view projection with D3D's [0, w] depth range, normals pointing inwards.
+	void XM_CALLCONV buildQueryPlanes(FXMMATRIX viewProj, QueryPlanes& planes)
+	{
+		XMMATRIX columns{ XMMatrixTranspose(viewProj) };
+		XMVECTOR frustum[6]
+		{
+			XMVectorAdd(columns.r[3], columns.r[0]),
+			XMVectorSubtract(columns.r[3], columns.r[0]),
+			XMVectorAdd(columns.r[3], columns.r[1]),
+			XMVectorSubtract(columns.r[3], columns.r[1]),
+			columns.r[2],
+			XMVectorSubtract(columns.r[3], columns.r[2])
+		};
+
+		XMFLOAT4 components[8];
+		for (uint32_t i{ 0 }; i < 6; i++)
+		{
+			frustum[i] = XMPlaneNormalize(frustum[i]);
+			XMStoreFloat4(&components[i], frustum[i]);
+			planes.splats[i][0] = XMVectorSplatX(frustum[i]);
+			planes.splats[i][1] = XMVectorSplatY(frustum[i]);
+			planes.splats[i][2] = XMVectorSplatZ(frustum[i]);
+			planes.splats[i][3] = XMVectorSplatW(frustum[i]);
+		}
+		components[6] = components[4];
+		components[7] = components[5];
+
+		for (uint32_t i{ 0 }; i < 2; i++)
+		{
+			const XMFLOAT4* p{ components + i * 4 };
+			planes.x[i] = XMVectorSet(p[0].x, p[1].x, p[2].x, p[3].x);
+			planes.y[i] = XMVectorSet(p[0].y, p[1].y, p[2].y, p[3].y);
+			planes.z[i] = XMVectorSet(p[0].z, p[1].z, p[2].z, p[3].z);
+			planes.w[i] = XMVectorSet(p[0].w, p[1].w, p[2].w, p[3].w);
+			planes.extent[i] = XMVectorAdd(XMVectorAbs(planes.x[i]), XMVectorAdd(XMVectorAbs(planes.y[i]), XMVectorAbs(planes.z[i])));
+		}
+	}
+
+	// Appends the ids of the four spheres that are not entirely behind a plane; lanes past count are ignored.
+	void XM_CALLCONV testSpheres(const QueryPlanes& planes, FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, GXMVECTOR radius, const uint32_t* ids, uint32_t count, vector<uint32_t>& visible)
+	{
+		XMVECTOR negativeRadius{ XMVectorNegate(radius) };
+		XMVECTOR inside{ XMVectorTrueInt() };
+		for (uint32_t i{ 0 }; i < 6; i++)
+		{
+			const XMVECTOR* plane{ planes.splats[i] };
+			XMVECTOR distance{ XMVectorMultiplyAdd(x, plane[0], XMVectorMultiplyAdd(y, plane[1], XMVectorMultiplyAdd(z, plane[2], plane[3]))) };
+			inside = XMVectorAndInt(inside, XMVectorGreater(distance, negativeRadius));
+		}
+
+		uint32_t lanes[4];
+		XMStoreInt4(lanes, inside);
+		for (uint32_t lane{ 0 }; lane < count; lane++)
+		{
+			if (lanes[lane] != 0)
+			{
+				visible.push_back(ids[lane]);
+			}
+		}
+	}
+}
+
+SpatialHashGrid::SpatialHashGrid(float cellSize) : cellSize{ cellSize }, invCellSize{ 1.0f / cellSize }
+{
+	if (!(cellSize > 0.0f))
+	{
+		throw(runtime_error{ "Invalid grid cell size." });
+	}
+
+	resetStats();
+}
+
+void SpatialHashGrid::insert(uint32_t id, const XMFLOAT4& sphere)
+{
+	if (contains(id))
+	{
+		throw(runtime_error{ "Sphere already in the grid." });
+	}
+
+	if (id >= locations.size())
+	{
+		locations.resize(static_cast<size_t>(id) + 1, { absent, absent });
+	}
+
+	int32_t coords[3];
+	getCellCoords(sphere, coords);
+	addToCell(findOrAddCell(coords), id, sphere);
+	++size;
+	++stats.inserts;
+}
+
+void SpatialHashGrid::move(uint32_t id, const XMFLOAT4& sphere)
+{
+	if (!contains(id))
+	{
+		throw(runtime_error{ "Sphere not in the grid." });
+	}
+
+	int32_t coords[3];
+	getCellCoords(sphere, coords);
+
+	const Location& location{ locations[id] };
+	Cell& cell{ cells[location.cell] };
+	if (coords[0] == cell.coords[0] && coords[1] == cell.coords[1] && coords[2] == cell.coords[2])
+	{
+		cell.centersX[location.slot] = sphere.x;
+		cell.centersY[location.slot] = sphere.y;
+		cell.centersZ[location.slot] = sphere.z;
+		cell.radii[location.slot] = sphere.w;
+		cell.maxRadius = cell.maxRadius > sphere.w ? cell.maxRadius : sphere.w;
+	}
+	else
+	{
+		removeFromCell(id);
+		addToCell(findOrAddCell(coords), id, sphere);
+		++stats.cellChanges;
+	}
+
+	++stats.moves;
+}
+
+void SpatialHashGrid::remove(uint32_t id)
+{
+	if (!contains(id))
+	{
+		throw(runtime_error{ "Sphere not in the grid." });
+	}
+
+	removeFromCell(id);
+	--size;
+	++stats.removes;
+}
+
+void SpatialHashGrid::update(const vector<Update>& updates)
+{
+	for (const Update& update : updates)
+	{
+		if (contains(update.id))
+		{
+			move(update.id, update.sphere);
+		}
+		else
+		{
+			insert(update.id, update.sphere);
+		}
+	}
+}
+
+void SpatialHashGrid::clear()
+{
+	for (uint32_t cell : occupiedCells)
+	{
+		Cell& c{ cells[cell] };
+		c.ids.clear();
+		c.centersX.clear();
+		c.centersY.clear();
+		c.centersZ.clear();
+		c.radii.clear();
+		freeCells.push_back(cell);
+	}
+
+	cellIndices.clear();
+	occupiedCells.clear();
+	locations.clear();
+	size = 0;
+}
+
+bool SpatialHashGrid::contains(uint32_t id) const
+{
+	return id < locations.size() && locations[id].cell != absent;
+}
+
+uint32_t SpatialHashGrid::getSize() const
+{
+	return size;
+}
+
+uint32_t SpatialHashGrid::getOccupiedCellCount() const
+{
+	return static_cast<uint32_t>(occupiedCells.size());
+}
+
+void SpatialHashGrid::query(FXMMATRIX viewProj, JobSystem& jobs, vector<uint32_t>& visible)
+{
+	auto begin{ chrono::steady_clock::now() };
+
+	QueryPlanes planes;
+	buildQueryPlanes(viewProj, planes);
+
+	uint32_t numCells{ static_cast<uint32_t>(occupiedCells.size()) };
+	uint32_t numGrains{ (numCells + cellsPerGrain - 1) / cellsPerGrain };
+	if (grainVisible.size() < numGrains)
+	{
+		grainVisible.resize(numGrains);
+	}
+
+	grainCounts.assign(static_cast<size_t>(numGrains) * 2, 0);
+	jobs.parallelFor(numGrains, 1, [&](uint32_t firstGrain, uint32_t endGrain)
+	{
+		for (uint32_t grain{ firstGrain }; grain < endGrain; grain++)
+		{
+			vector<uint32_t>& grainList{ grainVisible[grain] };
+			grainList.clear();
+			uint64_t cellsInside{ 0 };
+			uint64_t spheresTested{ 0 };
+
+			uint32_t firstCell{ grain * cellsPerGrain };
+			uint32_t endCell{ firstCell + cellsPerGrain < numCells ? firstCell + cellsPerGrain : numCells };
+			for (uint32_t i{ firstCell }; i < endCell; i++)
+			{
+				const Cell& cell{ cells[occupiedCells[i]] };
+
+				// The loose cell box against four planes at a time: outside if a plane has it entirely behind,
+				// inside if every plane has it entirely in front.
+				float halfExtent{ 0.5f * cellSize + cell.maxRadius };
+				XMVECTOR centerX{ XMVectorReplicate((static_cast<float>(cell.coords[0]) + 0.5f) * cellSize) };
+				XMVECTOR centerY{ XMVectorReplicate((static_cast<float>(cell.coords[1]) + 0.5f) * cellSize) };
+				XMVECTOR centerZ{ XMVectorReplicate((static_cast<float>(cell.coords[2]) + 0.5f) * cellSize) };
+				XMVECTOR outside{ XMVectorFalseInt() };
+				XMVECTOR crossing{ XMVectorFalseInt() };
+				for (uint32_t k{ 0 }; k < 2; k++)
+				{
+					XMVECTOR distance{ XMVectorMultiplyAdd(centerX, planes.x[k], XMVectorMultiplyAdd(centerY, planes.y[k], XMVectorMultiplyAdd(centerZ, planes.z[k], planes.w[k]))) };
+					XMVECTOR extent{ XMVectorScale(planes.extent[k], halfExtent) };
+					outside = XMVectorOrInt(outside, XMVectorLess(distance, XMVectorNegate(extent)));
+					crossing = XMVectorOrInt(crossing, XMVectorLess(distance, extent));
+				}
+
+				if (!XMVector4EqualInt(outside, XMVectorFalseInt()))
+				{
+					continue;
+				}
+
+				if (XMVector4EqualInt(crossing, XMVectorFalseInt()))
+				{
+					grainList.insert(grainList.end(), cell.ids.begin(), cell.ids.end());
+					++cellsInside;
+					continue;
+				}
+
+				uint32_t count{ static_cast<uint32_t>(cell.ids.size()) };
+				uint32_t first{ 0 };
+				for (; first + 4 <= count; first += 4)
+				{
+					XMVECTOR x{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&cell.centersX[first])) };
+					XMVECTOR y{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&cell.centersY[first])) };
+					XMVECTOR z{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&cell.centersZ[first])) };
+					XMVECTOR r{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(&cell.radii[first])) };
+					testSpheres(planes, x, y, z, r, &cell.ids[first], 4, grainList);
+				}
+
+				if (first < count)
+				{
+					// The tail is copied out rather than read past the end of the streams.
+					float tail[4][4]{};
+					for (uint32_t lane{ 0 }; first + lane < count; lane++)
+					{
+						tail[0][lane] = cell.centersX[first + lane];
+						tail[1][lane] = cell.centersY[first + lane];
+						tail[2][lane] = cell.centersZ[first + lane];
+						tail[3][lane] = cell.radii[first + lane];
+					}
+
+					XMVECTOR x{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[0])) };
+					XMVECTOR y{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[1])) };
+					XMVECTOR z{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[2])) };
+					XMVECTOR r{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(tail[3])) };
+					testSpheres(planes, x, y, z, r, &cell.ids[first], count - first, grainList);
+				}
+
+				spheresTested += count;
+			}
+
+			grainCounts[grain * 2] = cellsInside;
+			grainCounts[grain * 2 + 1] = spheresTested;
+		}
+	});
+
+	size_t firstVisible{ visible.size() };
+	for (uint32_t grain{ 0 }; grain < numGrains; grain++)
+	{
+		visible.insert(visible.end(), grainVisible[grain].begin(), grainVisible[grain].end());
+		stats.cellsInside += grainCounts[grain * 2];
+		stats.spheresTested += grainCounts[grain * 2 + 1];
+	}
+
+	++stats.queries;
+	stats.cellsTested += numCells;
+	stats.spheresVisible += visible.size() - firstVisible;
+	stats.queryMilliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+}
+
+const SpatialHashGrid::Stats& SpatialHashGrid::getStats() const
+{
+	return stats;
+}
+
+void SpatialHashGrid::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void SpatialHashGrid::getCellCoords(const XMFLOAT4& sphere, int32_t coords[3]) const
+{
+	coords[0] = static_cast<int32_t>(floorf(sphere.x * invCellSize));
+	coords[1] = static_cast<int32_t>(floorf(sphere.y * invCellSize));
+	coords[2] = static_cast<int32_t>(floorf(sphere.z * invCellSize));
+}
+
+uint64_t SpatialHashGrid::getCellKey(const int32_t coords[3])
+{
+	return (static_cast<uint64_t>(coords[0]) & cellKeyMask) | ((static_cast<uint64_t>(coords[1]) & cellKeyMask) << 21) | ((static_cast<uint64_t>(coords[2]) & cellKeyMask) << 42);
+}
+
+uint32_t SpatialHashGrid::findOrAddCell(const int32_t coords[3])
+{
+	uint64_t key{ getCellKey(coords) };
+	auto found{ cellIndices.find(key) };
+	if (found != cellIndices.end())
+	{
+		return found->second;
+	}
+
+	uint32_t cell;
+	if (!freeCells.empty())
+	{
+		cell = freeCells.back();
+		freeCells.pop_back();
+	}
+	else
+	{
+		cell = static_cast<uint32_t>(cells.size());
+		cells.emplace_back();
+	}
+
+	Cell& c{ cells[cell] };
+	memcpy(c.coords, coords, sizeof(c.coords));
+	c.occupiedSlot = static_cast<uint32_t>(occupiedCells.size());
+	c.maxRadius = 0.0f;
+	occupiedCells.push_back(cell);
+	cellIndices.emplace(key, cell);
+	return cell;
+}
+
+void SpatialHashGrid::addToCell(uint32_t cell, uint32_t id, const XMFLOAT4& sphere)
+{
+	Cell& c{ cells[cell] };
+	locations[id] = { cell, static_cast<uint32_t>(c.ids.size()) };
+	c.ids.push_back(id);
+	c.centersX.push_back(sphere.x);
+	c.centersY.push_back(sphere.y);
+	c.centersZ.push_back(sphere.z);
+	c.radii.push_back(sphere.w);
+	c.maxRadius = c.maxRadius > sphere.w ? c.maxRadius : sphere.w;
+}
+
+void SpatialHashGrid::removeFromCell(uint32_t id)
+{
+	Location location{ locations[id] };
+	Cell& c{ cells[location.cell] };
+
+	// The cell's last sphere takes the slot.
+	uint32_t last{ static_cast<uint32_t>(c.ids.size()) - 1 };
+	if (location.slot != last)
+	{
+		uint32_t movedId{ c.ids[last] };
+		c.ids[location.slot] = movedId;
+		c.centersX[location.slot] = c.centersX[last];
+		c.centersY[location.slot] = c.centersY[last];
+		c.centersZ[location.slot] = c.centersZ[last];
+		c.radii[location.slot] = c.radii[last];
+		locations[movedId].slot = location.slot;
+	}
+
+	c.ids.pop_back();
+	c.centersX.pop_back();
+	c.centersY.pop_back();
+	c.centersZ.pop_back();
+	c.radii.pop_back();
+	locations[id] = { absent, absent };
+
+	if (c.ids.empty())
+	{
+		cellIndices.erase(getCellKey(c.coords));
+
+		uint32_t lastOccupied{ occupiedCells.back() };
+		occupiedCells[c.occupiedSlot] = lastOccupied;
+		cells[lastOccupied].occupiedSlot = c.occupiedSlot;
+		occupiedCells.pop_back();
+		freeCells.push_back(location.cell);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include "JobSystem.h"
+
+// A spatial index of bounding spheres that move every frame: a uniform grid whose occupied cells live in a hash
+// map, so the scene needs no bounds up front and empty space costs nothing. A sphere is kept in the cell of its
+// center and each cell's bounds are loosened by the largest radius in it, so a sphere never spans cells. Every
+// sphere knows its cell and its slot there: moving within a cell rewrites its bounds, moving to another cell
+// and removing are a swap with the cell's last sphere, all O(1) apart from the occasional hash map insert.
+//
+// Frustum queries test the occupied cells in parallel grains on the job system. Cells outside the frustum are
+// skipped, cells inside it are taken whole and only the spheres of cells crossing it are tested, four at a
+// time against the six planes with DirectXMath vectors. Each grain writes its own list, and the lists are
+// concatenated in grain order, so the result does not depend on the thread count.
+class SpatialHashGrid
+{
+public:
+	// A sphere as center and radius.
+	struct Update
+	{
+		uint32_t id;
+		DirectX::XMFLOAT4 sphere;
+	};
+
+	struct Stats
+	{
+		uint64_t inserts;
+		uint64_t moves;
+		// The moves that left their cell.
+		uint64_t cellChanges;
+		uint64_t removes;
+		uint64_t queries;
+		uint64_t cellsTested;
+		// Cells entirely inside the frustum, taken without testing their spheres.
+		uint64_t cellsInside;
+		uint64_t spheresTested;
+		uint64_t spheresVisible;
+		double queryMilliseconds;
+	};
+
+	// Spheres a lot larger than cellSize still work, but loosen their cells for every query. Centers have to
+	// stay within 2^20 cells of the origin, which is what the hash keys hold.
+	explicit SpatialHashGrid(float cellSize);
+
+	// Ids index a table, so they should be dense, like instance indices.
+	void insert(uint32_t id, const DirectX::XMFLOAT4& sphere);
+	void move(uint32_t id, const DirectX::XMFLOAT4& sphere);
+	void remove(uint32_t id);
+	// Inserts the ids that are not in the grid and moves the others, e.g. for a batch of changes made on an
+	// update thread.
+	void update(const std::vector<Update>& updates);
+	void clear();
+
+	bool contains(uint32_t id) const;
+	uint32_t getSize() const;
+	uint32_t getOccupiedCellCount() const;
+
+	// Appends the ids of the spheres that are at least partly inside the frustum of viewProj (row vectors, D3D
+	// depth range).
+	void query(DirectX::FXMMATRIX viewProj, JobSystem& jobs, std::vector<uint32_t>& visible);
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct Cell
+	{
+		int32_t coords[3];
+		// Position in occupiedCells.
+		uint32_t occupiedSlot;
+		// Grows only, until the cell empties: a shrinking maximum would need a scan on every removal.
+		float maxRadius;
+		std::vector<uint32_t> ids;
+		std::vector<float> centersX;
+		std::vector<float> centersY;
+		std::vector<float> centersZ;
+		std::vector<float> radii;
+	};
+
+	struct Location
+	{
+		uint32_t cell;
+		uint32_t slot;
+	};
+
+	static const uint32_t absent{ 0xFFFFFFFF };
+
+	static uint64_t getCellKey(const int32_t coords[3]);
+	void getCellCoords(const DirectX::XMFLOAT4& sphere, int32_t coords[3]) const;
+	uint32_t findOrAddCell(const int32_t coords[3]);
+	void addToCell(uint32_t cell, uint32_t id, const DirectX::XMFLOAT4& sphere);
+	void removeFromCell(uint32_t id);
+
+private:
+	float cellSize;
+	float invCellSize;
+	std::unordered_map<uint64_t, uint32_t> cellIndices;
+	std::vector<Cell> cells;
+	// Emptied cells, reused with their capacity.
+	std::vector<uint32_t> freeCells;
+	std::vector<uint32_t> occupiedCells;
+	// By id.
+	std::vector<Location> locations;
+	uint32_t size{ 0 };
+
+	std::vector<std::vector<uint32_t>> grainVisible;
+	// Cells inside and spheres tested per grain.
+	std::vector<uint64_t> grainCounts;
+	Stats stats;
+};
\ No newline at end of file
@@ -0,0 +1,420 @@
+#include "StateCachingCommandList.h"
+#include <cstring>
+
+using namespace std;
+
+namespace
+{
+	bool operator==(const Viewport& a, const Viewport& b)
+	{
+		return a.topLeftX == b.topLeftX && a.topLeftY == b.topLeftY && a.width == b.width && a.height == b.height && a.minDepth == b.minDepth && a.maxDepth == b.maxDepth;
+	}
+
+	bool operator==(const ScissorRect& a, const ScissorRect& b)
+	{
+		return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+	}
+
+	bool operator==(const VertexBufferView& a, const VertexBufferView& b)
+	{
+		return a.bufferLocation == b.bufferLocation && a.sizeInBytes == b.sizeInBytes && a.strideInBytes == b.strideInBytes;
+	}
+
+	bool operator==(const IndexBufferView& a, const IndexBufferView& b)
+	{
+		return a.bufferLocation == b.bufferLocation && a.sizeInBytes == b.sizeInBytes && a.format == b.format;
+	}
+
+	bool operator==(const DescriptorHandle& a, const DescriptorHandle& b)
+	{
+		return a.heap == b.heap && a.index == b.index;
+	}
+}
+
+uint64_t StateCachingCommandList::Stats::getIssuedTotal() const
+{
+	uint64_t total{ 0 };
+	for (uint64_t count : issued)
+	{
+		total += count;
+	}
+
+	return total;
+}
+
+uint64_t StateCachingCommandList::Stats::getElidedTotal() const
+{
+	uint64_t total{ 0 };
+	for (uint64_t count : elided)
+	{
+		total += count;
+	}
+
+	return total;
+}
+
+void StateCachingCommandList::Stats::add(const Stats& other)
+{
+	for (size_t i{ 0 }; i < static_cast<size_t>(RenderCommandType::Count); i++)
+	{
+		issued[i] += other.issued[i];
+		elided[i] += other.elided[i];
+	}
+
+	barriersIssued += other.barriersIssued;
+	barriersElided += other.barriersElided;
+}
+
+StateCachingCommandList::StateCachingCommandList(unique_ptr<RenderCommandList> target) : target{ move(target) }
+{
+	resetStats();
+	invalidate();
+}
+
+void StateCachingCommandList::reset(uint32_t frameIndex)
+{
+	pendingBarriers.clear();
+	pendingBarrierCalls = 0;
+	invalidate();
+
+	issue(RenderCommandType::Reset, false);
+	target->reset(frameIndex);
+}
+
+void StateCachingCommandList::close()
+{
+	flushBarriers();
+	issue(RenderCommandType::Close, false);
+	target->close();
+}
+
+void StateCachingCommandList::setPipelineState(PipelineStateHandle pipelineState)
+{
+	if (issue(RenderCommandType::SetPipelineState, pipelineStateValid && this->pipelineState == pipelineState))
+	{
+		pipelineStateValid = true;
+		this->pipelineState = pipelineState;
+		target->setPipelineState(pipelineState);
+	}
+}
+
+void StateCachingCommandList::setGraphicsRootSignature(RootSignatureHandle rootSignature)
+{
+	if (issue(RenderCommandType::SetGraphicsRootSignature, rootSignatureValid && this->rootSignature == rootSignature))
+	{
+		rootSignatureValid = true;
+		this->rootSignature = rootSignature;
+		invalidateRootArguments();
+		target->setGraphicsRootSignature(rootSignature);
+	}
+}
+
+void StateCachingCommandList::setViewport(const Viewport& viewport)
+{
+	if (issue(RenderCommandType::SetViewport, viewportValid && this->viewport == viewport))
+	{
+		viewportValid = true;
+		this->viewport = viewport;
+		target->setViewport(viewport);
+	}
+}
+
+void StateCachingCommandList::setScissorRect(const ScissorRect& scissorRect)
+{
+	if (issue(RenderCommandType::SetScissorRect, scissorRectValid && this->scissorRect == scissorRect))
+	{
+		scissorRectValid = true;
+		this->scissorRect = scissorRect;
+		target->setScissorRect(scissorRect);
+	}
+}
+
+void StateCachingCommandList::resourceBarrier(uint32_t numBarriers, const ResourceBarrier* barriers)
+{
+	if (!enabled)
+	{
+		issue(RenderCommandType::ResourceBarrier, false);
+		stats.barriersIssued += numBarriers;
+		target->resourceBarrier(numBarriers, barriers);
+		return;
+	}
+
+	++pendingBarrierCalls;
+
+	for (uint32_t i{ 0 }; i < numBarriers; i++)
+	{
+		const ResourceBarrier& barrier{ barriers[i] };
+
+		// Only the last pending barrier on the same subresource can be folded into; split barriers are kept
+		// as they are since their halves have to stay where the caller put them.
+		bool folded{ false };
+		for (size_t j{ pendingBarriers.size() }; j-- > 0;)
+		{
+			ResourceBarrier& pending{ pendingBarriers[j] };
+			if (pending.resource != barrier.resource)
+			{
+				continue;
+			}
+
+			if (barrier.flags == BarrierFlags::None && pending.flags == BarrierFlags::None && pending.subresource == barrier.subresource && pending.stateAfter == barrier.stateBefore)
+			{
+				folded = true;
+				if (pending.stateBefore == barrier.stateAfter)
+				{
+					pendingBarriers.erase(pendingBarriers.begin() + j);
+					stats.barriersElided += 2;
+				}
+				else
+				{
+					pending.stateAfter = barrier.stateAfter;
+					++stats.barriersElided;
+				}
+			}
+
+			break;
+		}
+
+		if (!folded)
+		{
+			pendingBarriers.push_back(barrier);
+		}
+	}
+}
+
+void StateCachingCommandList::setRenderTarget(const DescriptorHandle& rtv, const DescriptorHandle* dsv)
+{
+	issue(RenderCommandType::SetRenderTarget, false);
+	target->setRenderTarget(rtv, dsv);
+}
+
+void StateCachingCommandList::clearRenderTarget(const DescriptorHandle& rtv, const float (&color)[4])
+{
+	issue(RenderCommandType::ClearRenderTarget, false);
+	target->clearRenderTarget(rtv, color);
+}
+
+void StateCachingCommandList::clearDepth(const DescriptorHandle& dsv, float depth)
+{
+	issue(RenderCommandType::ClearDepth, false);
+	target->clearDepth(dsv, depth);
+}
+
+void StateCachingCommandList::setPrimitiveTopology(PrimitiveTopology topology)
+{
+	if (issue(RenderCommandType::SetPrimitiveTopology, topologyValid && this->topology == topology))
+	{
+		topologyValid = true;
+		this->topology = topology;
+		target->setPrimitiveTopology(topology);
+	}
+}
+
+void StateCachingCommandList::setVertexBuffer(uint32_t slot, const VertexBufferView& view)
+{
+	if (slot >= vertexBuffers.size())
+	{
+		vertexBuffers.resize(slot + 1);
+		vertexBuffersValid.resize(slot + 1, 0);
+	}
+
+	if (issue(RenderCommandType::SetVertexBuffer, vertexBuffersValid[slot] && vertexBuffers[slot] == view))
+	{
+		vertexBuffersValid[slot] = 1;
+		vertexBuffers[slot] = view;
+		target->setVertexBuffer(slot, view);
+	}
+}
+
+void StateCachingCommandList::setIndexBuffer(const IndexBufferView& view)
+{
+	if (issue(RenderCommandType::SetIndexBuffer, indexBufferValid && indexBuffer == view))
+	{
+		indexBufferValid = true;
+		indexBuffer = view;
+		target->setIndexBuffer(view);
+	}
+}
+
+void StateCachingCommandList::setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValues, const void* data, uint32_t destOffset)
+{
+	RootArgument& argument{ getRootArgument(rootParameterIndex) };
+	if (argument.constants.size() < destOffset + num32BitValues)
+	{
+		argument.constants.resize(destOffset + num32BitValues);
+		argument.constantsValid.resize(destOffset + num32BitValues, 0);
+	}
+
+	const uint32_t* values{ static_cast<const uint32_t*>(data) };
+	bool redundant{ rootSignatureValid };
+	for (uint32_t i{ 0 }; i < num32BitValues && redundant; i++)
+	{
+		redundant = argument.constantsValid[destOffset + i] && argument.constants[destOffset + i] == values[i];
+	}
+
+	if (issue(RenderCommandType::SetGraphicsRoot32BitConstants, redundant))
+	{
+		for (uint32_t i{ 0 }; i < num32BitValues; i++)
+		{
+			argument.constants[destOffset + i] = values[i];
+			argument.constantsValid[destOffset + i] = 1;
+		}
+
+		target->setGraphicsRoot32BitConstants(rootParameterIndex, num32BitValues, data, destOffset);
+	}
+}
+
+void StateCachingCommandList::setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation)
+{
+	RootArgument& argument{ getRootArgument(rootParameterIndex) };
+	if (issue(RenderCommandType::SetGraphicsRootConstantBufferView, argument.cbvValid && argument.cbv == bufferLocation))
+	{
+		argument.cbvValid = true;
+		argument.cbv = bufferLocation;
+		target->setGraphicsRootConstantBufferView(rootParameterIndex, bufferLocation);
+	}
+}
+
+void StateCachingCommandList::setDescriptorHeap(DescriptorHeapHandle heap)
+{
+	if (issue(RenderCommandType::SetDescriptorHeap, descriptorHeapValid && descriptorHeap == heap))
+	{
+		descriptorHeapValid = true;
+		descriptorHeap = heap;
+		target->setDescriptorHeap(heap);
+	}
+}
+
+void StateCachingCommandList::setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, const DescriptorHandle& baseDescriptor)
+{
+	RootArgument& argument{ getRootArgument(rootParameterIndex) };
+	if (issue(RenderCommandType::SetGraphicsRootDescriptorTable, argument.tableValid && argument.table == baseDescriptor))
+	{
+		argument.tableValid = true;
+		argument.table = baseDescriptor;
+		target->setGraphicsRootDescriptorTable(rootParameterIndex, baseDescriptor);
+	}
+}
+
+void StateCachingCommandList::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation)
+{
+	issue(RenderCommandType::DrawIndexedInstanced, false);
+	target->drawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+}
+
+void StateCachingCommandList::executeIndirect(CommandSignatureHandle commandSignature, uint32_t maxCommandCount, ResourceHandle argumentBuffer, uint64_t argumentBufferOffset)
+{
+	issue(RenderCommandType::ExecuteIndirect, false);
+	target->executeIndirect(commandSignature, maxCommandCount, argumentBuffer, argumentBufferOffset);
+
+	// Constant arguments leave the root arguments undefined, so the next explicit set must not be elided.
+	invalidateRootArguments();
+}
+
+void StateCachingCommandList::copyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes)
+{
+	issue(RenderCommandType::CopyBufferRegion, false);
+	target->copyBufferRegion(dst, dstOffset, src, srcOffset, numBytes);
+}
+
+RenderCommandList* StateCachingCommandList::getTarget() const
+{
+	return target.get();
+}
+
+void StateCachingCommandList::setEnabled(bool enabled)
+{
+	flushBarriers();
+	invalidate();
+	this->enabled = enabled;
+}
+
+bool StateCachingCommandList::isEnabled() const
+{
+	return enabled;
+}
+
+const StateCachingCommandList::Stats& StateCachingCommandList::getStats() const
+{
+	return stats;
+}
+
+void StateCachingCommandList::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+void StateCachingCommandList::invalidate()
+{
+	pipelineStateValid = false;
+	rootSignatureValid = false;
+	viewportValid = false;
+	scissorRectValid = false;
+	topologyValid = false;
+	vertexBuffersValid.assign(vertexBuffersValid.size(), 0);
+	indexBufferValid = false;
+	descriptorHeapValid = false;
+	invalidateRootArguments();
+}
+
+void StateCachingCommandList::invalidateRootArguments()
+{
+	for (RootArgument& argument : rootArguments)
+	{
+		argument.cbvValid = false;
+		argument.tableValid = false;
+		argument.constantsValid.assign(argument.constantsValid.size(), 0);
+	}
+}
+
+StateCachingCommandList::RootArgument& StateCachingCommandList::getRootArgument(uint32_t rootParameterIndex)
+{
+	while (rootArguments.size() <= rootParameterIndex)
+	{
+		RootArgument argument;
+		argument.cbvValid = false;
+		argument.cbv = 0;
+		argument.tableValid = false;
+		argument.table = {};
+		rootArguments.push_back(argument);
+	}
+
+	return rootArguments[rootParameterIndex];
+}
+
+void StateCachingCommandList::flushBarriers()
+{
+	if (pendingBarrierCalls == 0)
+	{
+		return;
+	}
+
+	// Every resourceBarrier call since the last flush collapses into at most one.
+	if (pendingBarriers.empty())
+	{
+		stats.elided[static_cast<size_t>(RenderCommandType::ResourceBarrier)] += pendingBarrierCalls;
+	}
+	else
+	{
+		stats.elided[static_cast<size_t>(RenderCommandType::ResourceBarrier)] += pendingBarrierCalls - 1;
+		++stats.issued[static_cast<size_t>(RenderCommandType::ResourceBarrier)];
+		stats.barriersIssued += pendingBarriers.size();
+		target->resourceBarrier(static_cast<uint32_t>(pendingBarriers.size()), pendingBarriers.data());
+	}
+
+	pendingBarriers.clear();
+	pendingBarrierCalls = 0;
+}
+
+bool StateCachingCommandList::issue(RenderCommandType type, bool redundant)
+{
+	if (enabled && redundant)
+	{
+		++stats.elided[static_cast<size_t>(type)];
+		return false;
+	}
+
+	// Whatever is issued next may depend on the held back barriers having been recorded.
+	flushBarriers();
+	++stats.issued[static_cast<size_t>(type)];
+	return true;
+}
\ No newline at end of file
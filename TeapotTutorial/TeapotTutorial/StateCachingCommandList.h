@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "RenderDevice.h"
+
+// RenderCommandList decorator that drops state changes the target list already has (pipeline, root
+// signature and root arguments, viewport, scissor, topology, vertex and index buffers, descriptor heap) and
+// merges barriers: consecutive resourceBarrier calls become one, A->B followed by B->C on the same resource
+// becomes A->C and a transition that is undone before anything uses the resource disappears. Barriers are
+// held back until the next non-barrier command. The cache follows D3D12 rules: reset() forgets everything
+// and a different root signature invalidates the root arguments.
+class StateCachingCommandList : public RenderCommandList
+{
+public:
+	struct Stats
+	{
+		uint64_t issued[static_cast<size_t>(RenderCommandType::Count)];
+		uint64_t elided[static_cast<size_t>(RenderCommandType::Count)];
+		uint64_t barriersIssued;
+		uint64_t barriersElided;
+
+		uint64_t getIssuedTotal() const;
+		uint64_t getElidedTotal() const;
+		// Adds the counts of another list, for frames recorded into several lists.
+		void add(const Stats& other);
+	};
+
+	explicit StateCachingCommandList(std::unique_ptr<RenderCommandList> target);
+
+	void reset(uint32_t frameIndex) override;
+	void close() override;
+
+	void setPipelineState(PipelineStateHandle pipelineState) override;
+	void setGraphicsRootSignature(RootSignatureHandle rootSignature) override;
+	void setViewport(const Viewport& viewport) override;
+	void setScissorRect(const ScissorRect& scissorRect) override;
+	void resourceBarrier(uint32_t numBarriers, const ResourceBarrier* barriers) override;
+	void setRenderTarget(const DescriptorHandle& rtv, const DescriptorHandle* dsv) override;
+	void clearRenderTarget(const DescriptorHandle& rtv, const float (&color)[4]) override;
+	void clearDepth(const DescriptorHandle& dsv, float depth) override;
+	void setPrimitiveTopology(PrimitiveTopology topology) override;
+	void setVertexBuffer(uint32_t slot, const VertexBufferView& view) override;
+	void setIndexBuffer(const IndexBufferView& view) override;
+	void setGraphicsRoot32BitConstants(uint32_t rootParameterIndex, uint32_t num32BitValues, const void* data, uint32_t destOffset) override;
+	void setGraphicsRootConstantBufferView(uint32_t rootParameterIndex, uint64_t bufferLocation) override;
+	void setDescriptorHeap(DescriptorHeapHandle heap) override;
+	void setGraphicsRootDescriptorTable(uint32_t rootParameterIndex, const DescriptorHandle& baseDescriptor) override;
+	void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndexLocation, int32_t baseVertexLocation, uint32_t startInstanceLocation) override;
+	void executeIndirect(CommandSignatureHandle commandSignature, uint32_t maxCommandCount, ResourceHandle argumentBuffer, uint64_t argumentBufferOffset) override;
+	void copyBufferRegion(ResourceHandle dst, uint64_t dstOffset, ResourceHandle src, uint64_t srcOffset, uint64_t numBytes) override;
+
+	// The list to hand to RenderDevice::executeCommandLists.
+	RenderCommandList* getTarget() const;
+
+	// With filtering disabled every call is forwarded as is and only counted.
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct RootArgument
+	{
+		bool cbvValid;
+		uint64_t cbv;
+		bool tableValid;
+		DescriptorHandle table;
+		std::vector<uint32_t> constants;
+		std::vector<uint8_t> constantsValid;
+	};
+
+	void invalidate();
+	void invalidateRootArguments();
+	RootArgument& getRootArgument(uint32_t rootParameterIndex);
+	void flushBarriers();
+	bool issue(RenderCommandType type, bool redundant);
+
+private:
+	std::unique_ptr<RenderCommandList> target;
+	bool enabled{ true };
+	Stats stats;
+
+	bool pipelineStateValid;
+	PipelineStateHandle pipelineState;
+	bool rootSignatureValid;
+	RootSignatureHandle rootSignature;
+	bool viewportValid;
+	Viewport viewport;
+	bool scissorRectValid;
+	ScissorRect scissorRect;
+	bool topologyValid;
+	PrimitiveTopology topology;
+	std::vector<uint8_t> vertexBuffersValid;
+	std::vector<VertexBufferView> vertexBuffers;
+	bool indexBufferValid;
+	IndexBufferView indexBuffer;
+	bool descriptorHeapValid;
+	DescriptorHeapHandle descriptorHeap;
+	std::vector<RootArgument> rootArguments;
+
+	std::vector<ResourceBarrier> pendingBarriers;
+	uint32_t pendingBarrierCalls{ 0 };
+};
\ No newline at end of file
@@ -0,0 +1,908 @@
+#include "TeapotRenderer.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <stdexcept>
+#include "TeapotData.h"
+#include "SceneMath.h"
+
+using namespace std;
+using namespace DirectX;
+
+namespace
+{
+	// In ShaderSet order.
+	const char* const shaderFileNames[]{ "VertexShader.cso", "HullShader.cso", "DomainShader.cso", "PixelShader.cso" };
+
+	// The static teapot buffers are a few KB each and share one pool buffer of the first heap.
+	const uint64_t bufferHeapSize{ 1024 * 1024 };
+	const uint64_t uploadStagingSize{ 64 * 1024 };
+	// Mostly the instance matrices: three frames in flight of a hundred thousand visible teapots.
+	const uint64_t constantRingSize{ 32 * 1024 * 1024 };
+	// Transforms and colors views of a few thousand models, and per frame tables for a few frames in flight.
+	const uint32_t persistentDescriptorCount{ 8192 };
+	const uint32_t transientDescriptorCount{ 4096 };
+	const uint64_t residencyMaxBytes{ 64 * 1024 * 1024 };
+	const uint64_t streamBytesPerFrame{ 1024 * 1024 };
+	// Teapots from a fifth of a 1080p screen high get the full tessellation factor, each bucket below down to
+	// a factor of a sixteenth the ones half as big. A teapot has to be an eighth past a boundary to cross it.
+	const uint32_t lodBuckets{ 5 };
+	const float lodFullDetailPixels{ 200.0f };
+	const float lodHysteresis{ 0.125f };
+	// A few hundred of the instance grid's teapots per cell.
+	const float instanceGridCellSize{ 1.0f };
+	// A multiple of four, so only the last grain has a partial vector.
+	const uint32_t instanceMatricesPerGrain{ 4096 };
+
+	// Matches ConstantBufferPerObj in DomainShader.hlsl.
+	struct ObjectConstants
+	{
+		uint32_t firstInstanceMatrix;
+	};
+}
+
+TeapotRenderer::TeapotRenderer(RenderDevice& device, const ShaderSet& shaders, uint32_t width, uint32_t height, const string& pipelineCacheFile) : device{ device }, shaders{ shaders }, bufferCount{ device.getBufferCount() }, framePacer{ device, bufferCount > 1 ? bufferCount - 1 : 1 }, bufferAllocator{ device, bufferHeapSize }, uploadManager{ device, uploadStagingSize }, constantRing{ device, constantRingSize }, descriptors{ device, persistentDescriptorCount, transientDescriptorCount }, residency{ device, bufferAllocator, uploadManager, residencyMaxBytes, streamBytesPerFrame }, pipelines{ device, pipelineCacheFile }, instances{ device, descriptors, jobs, bufferCount, constantRing.getBuffer(), static_cast<uint32_t>(constantRingSize / sizeof(XMFLOAT4X4)) }, lodSelector{ jobs, lodBuckets, lodFullDetailPixels, lodHysteresis }, instanceGrid{ instanceGridCellSize }, stateTracker{ resourceStates }, occlusionCuller{ static_cast<int>(width / 4), static_cast<int>(height / 4) }, drawBuilder{ patchesPerChunk, teapot_tutorial::numPatchControlPoints }
+{
+	createBuffers();
+	createTransformsAndColorsViews();
+	createRootSignature();
+	createCommandSignature();
+	requestPipelineStates();
+	createViewport(width, height);
+	createScissorRect(width, height);
+	createOcclusionData();
+	createPatchChunks();
+	setInstances({}, {});
+
+	commandList = make_unique<StateCachingCommandList>(device.createCommandList(QueueType::Direct));
+
+	// The static buffers are promoted from the common state implicitly, so only the back buffers are tracked.
+	for (uint32_t i{ 0 }; i < bufferCount; i++)
+	{
+		resourceStates.registerResource(device.getBackBuffer(i), ResourceState::Present);
+	}
+
+	// The copies and the pipeline compiles run meanwhile; only the first frame's state is waited for, the other
+	// one goes on compiling.
+	currPipelineState = pipelines.waitFor(currPipelineStateKey);
+	uploadManager.waitIdle();
+}
+
+TeapotRenderer::~TeapotRenderer()
+{
+	device.waitIdle();
+	// A cache that cannot be written only costs the next run its compiles.
+	pipelines.saveCache();
+}
+
+void TeapotRenderer::beginFrame()
+{
+	framePacer.beginFrame();
+}
+
+void TeapotRenderer::render(float mouseX, float mouseY, float width, float height)
+{
+	SceneSnapshot snapshot;
+	XMStoreFloat4x4(&snapshot.model, teapot_tutorial::computeModelMatrix(mouseX, mouseY, width, height));
+	XMStoreFloat4x4(&snapshot.viewProj, teapot_tutorial::computeViewProjMatrix(width, height));
+	snapshot.tessFactor = tessFactor;
+	snapshot.tick = 0;
+	render(snapshot);
+}
+
+void TeapotRenderer::render(const SceneSnapshot& snapshot)
+{
+	tessFactor = snapshot.tessFactor;
+	currPipelineState = pipelines.getPipelineState(currPipelineStateKey, currPipelineState);
+	framePacer.beginFrame();
+	uint32_t frameIndex{ device.getCurrentBackBufferIndex() };
+
+	commandList->reset(frameIndex);
+	stateTracker.reset();
+
+	ResourceHandle currBuffer{ device.getBackBuffer(frameIndex) };
+
+	stateTracker.transition(currBuffer, ResourceState::RenderTarget);
+	stateTracker.flushBarriers(*commandList);
+
+	setFrameTargets(*commandList, frameIndex);
+
+	static const float clearColor[]{ 0.1f, 0.1f, 0.1f, 1.0f };
+	commandList->clearRenderTarget(device.getBackBufferRtv(frameIndex), clearColor);
+	commandList->clearDepth(device.getDepthStencilView(), 1.0f);
+
+	XMMATRIX mvpMatrixDX{ XMLoadFloat4x4(&snapshot.model) * XMLoadFloat4x4(&snapshot.viewProj) };
+	cullPatches(mvpMatrixDX);
+	requestPatchChunks(mvpMatrixDX);
+	uint32_t firstInstanceMatrix{ updateInstances(frameIndex, mvpMatrixDX) };
+
+	UploadRing::Allocation constants{ constantRing.allocate(sizeof(ObjectConstants), UploadRing::constantBufferAlignment) };
+	static_cast<ObjectConstants*>(constants.cpuAddress)->firstInstanceMatrix = firstInstanceMatrix;
+	uint64_t constBufferLocation{ constants.gpuAddress };
+
+	// The indirect path records one ExecuteIndirect per group of commands, the direct path a draw per command.
+	uint64_t argumentOffset;
+	uint32_t numCommands{ buildPatchDraws(argumentOffset) };
+	uint32_t numItems{ indirectDraws ? static_cast<uint32_t>(drawBuilder.getGroups().size()) : numCommands };
+	auto recordItems = [&](RenderCommandList& list, uint32_t begin, uint32_t end)
+	{
+		if (indirectDraws)
+		{
+			recordIndirectGroups(list, begin, end, constBufferLocation, argumentOffset);
+		}
+		else
+		{
+			recordPatchDraws(list, begin, end, constBufferLocation);
+		}
+	};
+
+	submittedCommandLists.clear();
+	submittedCommandLists.push_back(commandList->getTarget());
+
+	// With parallel recording the draws go into the workers' lists between this frame's first list (barrier and
+	// clears) and a last one for the barrier to present; all of them are submitted together.
+	StateCachingCommandList* lastCommandList{ commandList.get() };
+	if (drawRecorder)
+	{
+		commandList->close();
+		drawRecorder->record(frameIndex, numItems, [&](StateCachingCommandList& workerList, uint32_t begin, uint32_t end)
+		{
+			setFrameTargets(workerList, frameIndex);
+			recordItems(workerList, begin, end);
+		});
+
+		drawRecorder->appendCommandLists(submittedCommandLists);
+		presentCommandList->reset(frameIndex);
+		submittedCommandLists.push_back(presentCommandList->getTarget());
+		lastCommandList = presentCommandList.get();
+	}
+	else
+	{
+		recordItems(*commandList, 0, numItems);
+	}
+
+	stateTracker.transition(currBuffer, ResourceState::Present);
+	stateTracker.flushBarriers(*lastCommandList);
+
+	lastCommandList->close();
+	stateTracker.commit();
+
+	descriptors.flush();
+	device.executeCommandLists(QueueType::Direct, static_cast<uint32_t>(submittedCommandLists.size()), submittedCommandLists.data());
+	constantRing.endFrame(QueueType::Direct);
+	descriptors.endFrame(QueueType::Direct);
+	residency.endFrame(QueueType::Direct);
+
+	device.present();
+	framePacer.endFrame(QueueType::Direct);
+}
+
+// Render target, viewport and scissor belong to the list, so every list drawing into the frame sets them.
+void TeapotRenderer::setFrameTargets(RenderCommandList& list, uint32_t frameIndex)
+{
+	DescriptorHandle descHandleRtv{ device.getBackBufferRtv(frameIndex) };
+	DescriptorHandle descHandleDepthStencil{ device.getDepthStencilView() };
+
+	list.setViewport(viewport);
+	list.setScissorRect(scissorRect);
+	list.setRenderTarget(descHandleRtv, &descHandleDepthStencil);
+}
+
+// SV_PrimitiveID restarts at zero for every draw, so each command passes its first patch index to the domain
+// shader. The indirect path writes the commands into the upload ring, where the GPU reads them as arguments.
+uint32_t TeapotRenderer::buildPatchDraws(uint64_t& argumentOffset)
+{
+	for (size_t i{ 0 }; i < residentPatchChunks.size(); i++)
+	{
+		patchChunkResident[i] = residentPatchChunks[i] != nullptr ? 1 : 0;
+	}
+
+	// Sized for the worst case of one command per visible patch and instance range; the unused tail costs
+	// memory or ring space only.
+	size_t maxCommands{ (visiblePatches.empty() ? 1 : visiblePatches.size()) * (instanceRanges.empty() ? 1 : instanceRanges.size()) };
+	argumentOffset = 0;
+	if (!indirectDraws)
+	{
+		patchDraws.resize(maxCommands);
+		return drawBuilder.build(visiblePatches, patchChunkResident, instanceRanges, patchDraws.data());
+	}
+
+	UploadRing::Allocation arguments{ constantRing.allocate(maxCommands * sizeof(PatchDrawCommand), sizeof(uint32_t)) };
+	argumentOffset = arguments.offset;
+	return drawBuilder.build(visiblePatches, patchChunkResident, instanceRanges, static_cast<PatchDrawCommand*>(arguments.cpuAddress));
+}
+
+// Only reads renderer state, so ranges of commands can be recorded on several threads.
+void TeapotRenderer::recordPatchDraws(RenderCommandList& list, uint32_t begin, uint32_t end, uint64_t constBufferLocation)
+{
+	for (uint32_t i{ begin }; i < end; i++)
+	{
+		const PatchDrawCommand& command{ patchDraws[i] };
+		const DrawIndexedArguments& draw{ command.draw };
+
+		bindPatchState(list, constBufferLocation, command.firstPatch / patchesPerChunk);
+		list.setGraphicsRoot32BitConstants(1, 2, command.tessFactors, 0);
+		list.setGraphicsRoot32BitConstants(3, 2, &command.firstPatch, 0);
+		list.drawIndexedInstanced(draw.indexCountPerInstance, draw.instanceCount, draw.startIndexLocation, draw.baseVertexLocation, draw.startInstanceLocation);
+	}
+}
+
+// The commands set their own root constants; each group binds the index buffer of its chunk first.
+void TeapotRenderer::recordIndirectGroups(RenderCommandList& list, uint32_t begin, uint32_t end, uint64_t constBufferLocation, uint64_t argumentOffset)
+{
+	const vector<IndirectDrawBuilder::Group>& groups{ drawBuilder.getGroups() };
+	for (uint32_t i{ begin }; i < end; i++)
+	{
+		const IndirectDrawBuilder::Group& group{ groups[i] };
+		bindPatchState(list, constBufferLocation, group.chunk);
+		list.executeIndirect(patchCommandSignature, group.numCommands, constantRing.getBuffer(), argumentOffset + static_cast<uint64_t>(group.firstCommand) * sizeof(PatchDrawCommand));
+	}
+}
+
+// Every draw binds all the state it depends on, like any draw in a larger scene would; the state caching
+// command list drops what is already bound.
+void TeapotRenderer::bindPatchState(RenderCommandList& list, uint64_t constBufferLocation, uint32_t chunk)
+{
+	const GpuMemoryAllocator::Allocation* indices{ residentPatchChunks[chunk] };
+
+	list.setPipelineState(currPipelineState);
+	list.setGraphicsRootSignature(rootSignature);
+	list.setPrimitiveTopology(PrimitiveTopology::PatchList16);
+	list.setVertexBuffer(0, controlPointsBufferView);
+	list.setIndexBuffer({ indices->gpuAddress, static_cast<uint32_t>(indices->size), Format::R32Uint });
+
+	list.setDescriptorHeap(descriptors.getHeap());
+	list.setGraphicsRootDescriptorTable(2, transformsAndColorsSrvs.gpu);
+	list.setGraphicsRootDescriptorTable(4, currInstanceTable);
+	list.setGraphicsRootConstantBufferView(0, constBufferLocation);
+}
+
+void TeapotRenderer::decreaseTessFactor()
+{
+	--tessFactor;
+	if (tessFactor < 1) tessFactor = 1;
+}
+
+void TeapotRenderer::increaseTessFactor()
+{
+	++tessFactor;
+	if (tessFactor > 64) tessFactor = 64;
+}
+
+void TeapotRenderer::setWireframe(bool wireframe)
+{
+	currPipelineStateKey = wireframe ? pipelineStateWireframe : pipelineStateSolid;
+}
+
+void TeapotRenderer::setShaders(const ShaderSet& shaders)
+{
+	bool wireframe{ currPipelineStateKey == pipelineStateWireframe };
+	this->shaders = shaders;
+	requestPipelineStates();
+	setWireframe(wireframe);
+}
+
+void TeapotRenderer::toggleOcclusionCulling()
+{
+	// The slots get the identity order back when instance culling stops.
+	occlusionCullingEnabled = !occlusionCullingEnabled;
+	++instanceOrderVersion;
+}
+
+void TeapotRenderer::setInstances(const vector<teapot_tutorial::Transform>& transforms, const vector<XMFLOAT4>& colors)
+{
+	if (transforms.size() != colors.size())
+	{
+		throw(runtime_error{ "Every instance needs a transform and a color." });
+	}
+
+	instanced = !transforms.empty();
+	instanceStore.clear();
+	instanceHandles.clear();
+	if (instanced)
+	{
+		instanceStore.reserve(static_cast<uint32_t>(transforms.size()));
+		for (size_t i{ 0 }; i < transforms.size(); i++)
+		{
+			instanceHandles.push_back(instanceStore.create(transforms[i], colors[i], 0));
+		}
+	}
+	else
+	{
+		const teapot_tutorial::Transform identity{ { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f } };
+		instanceHandles.push_back(instanceStore.create(identity, XMFLOAT4{ 1.0f, 1.0f, 1.0f, 1.0f }, 0));
+	}
+
+	// A buffer that grows comes back empty; the store's new versions have every slot written again either way.
+	uint32_t count{ instanceStore.getSize() };
+	instances.reserve(count);
+	instanceSlotVersions.resize(bufferCount, { 0, 0 });
+	for (uint32_t i{ static_cast<uint32_t>(identityInstanceOrder.size()) }; i < count; i++)
+	{
+		identityInstanceOrder.push_back(i);
+	}
+	++instanceOrderVersion;
+
+	updatedInstances.clear();
+	instanceStore.updateWorlds(updatedInstances);
+	instanceGrid.clear();
+	updateInstanceGrid();
+	lodSelector.setInstances(instanceStore.getBounds(), count);
+}
+
+void TeapotRenderer::moveInstances(const vector<uint32_t>& indices, const vector<teapot_tutorial::Transform>& transforms)
+{
+	if (!instanced || indices.size() != transforms.size())
+	{
+		throw(runtime_error{ "Every moved instance needs a transform." });
+	}
+
+	for (size_t i{ 0 }; i < indices.size(); i++)
+	{
+		if (indices[i] >= instanceHandles.size())
+		{
+			throw(runtime_error{ "Moved instance out of range." });
+		}
+
+		instanceStore.setTransform(instanceHandles[indices[i]], transforms[i]);
+	}
+}
+
+uint32_t TeapotRenderer::getInstanceCount() const
+{
+	return instanceStore.getSize();
+}
+
+void TeapotRenderer::setLevelsOfDetail(bool enabled)
+{
+	// The slots get the identity order back when the selection stops.
+	levelsOfDetail = enabled;
+	++instanceOrderVersion;
+}
+
+bool TeapotRenderer::isLevelsOfDetailEnabled() const
+{
+	return levelsOfDetail;
+}
+
+void TeapotRenderer::setStateFiltering(bool enabled)
+{
+	commandList->setEnabled(enabled);
+	if (drawRecorder)
+	{
+		presentCommandList->setEnabled(enabled);
+		drawRecorder->setStateFiltering(enabled);
+	}
+}
+
+bool TeapotRenderer::isStateFilteringEnabled() const
+{
+	return commandList->isEnabled();
+}
+
+void TeapotRenderer::setIndirectDraws(bool enabled)
+{
+	indirectDraws = enabled;
+}
+
+bool TeapotRenderer::isIndirectDrawsEnabled() const
+{
+	return indirectDraws;
+}
+
+void TeapotRenderer::setRecordingLists(uint32_t numLists)
+{
+	// The current lists may still be executing.
+	device.waitIdle();
+	drawRecorder.reset();
+	if (numLists == 0)
+	{
+		return;
+	}
+
+	if (!presentCommandList)
+	{
+		presentCommandList = make_unique<StateCachingCommandList>(device.createCommandList(QueueType::Direct));
+	}
+
+	drawRecorder = make_unique<ParallelCommandRecorder>(device, jobs, numLists);
+	setStateFiltering(isStateFilteringEnabled());
+}
+
+void TeapotRenderer::setFramePacing(FramePacer::Mode mode, uint32_t maxFramesInFlight)
+{
+	framePacer.setMaxFramesInFlight(maxFramesInFlight);
+	framePacer.setMode(mode);
+}
+
+FramePacer::Mode TeapotRenderer::getFramePacingMode() const
+{
+	return framePacer.getMode();
+}
+
+uint32_t TeapotRenderer::getMaxFramesInFlight() const
+{
+	return framePacer.getMaxFramesInFlight();
+}
+
+uint32_t TeapotRenderer::getRecordingLists() const
+{
+	return drawRecorder ? drawRecorder->getListCount() : 0;
+}
+
+StateCachingCommandList::Stats TeapotRenderer::getCommandStats() const
+{
+	StateCachingCommandList::Stats stats(commandList->getStats());
+	if (presentCommandList)
+	{
+		stats.add(presentCommandList->getStats());
+	}
+
+	if (drawRecorder)
+	{
+		drawRecorder->addCommandStats(stats);
+	}
+
+	return stats;
+}
+
+void TeapotRenderer::resetCommandStats()
+{
+	commandList->resetStats();
+	if (presentCommandList)
+	{
+		presentCommandList->resetStats();
+	}
+
+	if (drawRecorder)
+	{
+		drawRecorder->resetCommandStats();
+	}
+}
+
+PipelineStateManager::Stats TeapotRenderer::getPipelineStats() const
+{
+	return pipelines.getStats();
+}
+
+const IndirectDrawBuilder::Stats& TeapotRenderer::getDrawBuilderStats() const
+{
+	return drawBuilder.getStats();
+}
+
+const InstanceBuffers::Stats& TeapotRenderer::getInstanceStats() const
+{
+	return instances.getStats();
+}
+
+void TeapotRenderer::resetInstanceStats()
+{
+	instances.resetStats();
+}
+
+const LodSelector::Stats& TeapotRenderer::getLodStats() const
+{
+	return lodSelector.getStats();
+}
+
+void TeapotRenderer::resetLodStats()
+{
+	lodSelector.resetStats();
+}
+
+const SpatialHashGrid::Stats& TeapotRenderer::getInstanceGridStats() const
+{
+	return instanceGrid.getStats();
+}
+
+void TeapotRenderer::resetInstanceGridStats()
+{
+	instanceGrid.resetStats();
+}
+
+const OcclusionCuller::Stats& TeapotRenderer::getInstanceOcclusionStats() const
+{
+	return instanceOcclusionStats;
+}
+
+void TeapotRenderer::resetInstanceOcclusionStats()
+{
+	instanceOcclusionStats = {};
+}
+
+int TeapotRenderer::getTessFactor() const
+{
+	return tessFactor;
+}
+
+const vector<uint32_t>& TeapotRenderer::getVisiblePatches() const
+{
+	return visiblePatches;
+}
+
+TeapotRenderer::ShaderSet TeapotRenderer::loadShaderSet(ShaderStore& store, const string& directory)
+{
+	string prefix{ directory.empty() ? string{} : directory + "/" };
+	for (const char* fileName : shaderFileNames)
+	{
+		store.load(prefix + fileName);
+	}
+
+	return getShaderSet(store, directory);
+}
+
+TeapotRenderer::ShaderSet TeapotRenderer::getShaderSet(const ShaderStore& store, const string& directory)
+{
+	string prefix{ directory.empty() ? string{} : directory + "/" };
+
+	ShaderSet shaderSet;
+	shaderSet.vertexShader = *store.getBlob(prefix + shaderFileNames[0]);
+	shaderSet.hullShader = *store.getBlob(prefix + shaderFileNames[1]);
+	shaderSet.domainShader = *store.getBlob(prefix + shaderFileNames[2]);
+	shaderSet.pixelShader = *store.getBlob(prefix + shaderFileNames[3]);
+	return shaderSet;
+}
+
+void TeapotRenderer::createBuffers()
+{
+	using PointType = decltype(TeapotData::points)::value_type;
+	using TransformType = decltype(TeapotData::patchesTransforms)::value_type;
+	using ColorType = decltype(TeapotData::patchesColors)::value_type;
+
+	uint64_t pointsSize{ TeapotData::points.size() * sizeof(PointType) };
+	uint64_t transformsSize{ TeapotData::patchesTransforms.size() * sizeof(TransformType) };
+	uint64_t colorsSize{ TeapotData::patchesColors.size() * sizeof(ColorType) };
+
+	// Filled on the copy queue, so they start in the common state and are promoted on first use. Each range is
+	// aligned to its element size, so the structured buffer views can start at offset / stride.
+	controlPointsBuffer = bufferAllocator.allocateBuffer({ pointsSize, HeapType::Default, ResourceState::Common, "control points" }, sizeof(PointType));
+	transformsBuffer = bufferAllocator.allocateBuffer({ transformsSize, HeapType::Default, ResourceState::Common, "transforms" }, sizeof(TransformType));
+	colorsBuffer = bufferAllocator.allocateBuffer({ colorsSize, HeapType::Default, ResourceState::Common, "colors" }, sizeof(ColorType));
+
+	// All three uploads go into one batch.
+	uploadManager.upload(controlPointsBuffer.buffer, controlPointsBuffer.offset, TeapotData::points.data(), pointsSize);
+	uploadManager.upload(transformsBuffer.buffer, transformsBuffer.offset, TeapotData::patchesTransforms.data(), transformsSize);
+	uploadManager.upload(colorsBuffer.buffer, colorsBuffer.offset, TeapotData::patchesColors.data(), colorsSize);
+	uploadManager.flush();
+
+	controlPointsBufferView.bufferLocation = controlPointsBuffer.gpuAddress;
+	controlPointsBufferView.strideInBytes = static_cast<uint32_t>(sizeof(PointType));
+	controlPointsBufferView.sizeInBytes = static_cast<uint32_t>(pointsSize);
+}
+
+void TeapotRenderer::createTransformsAndColorsViews()
+{
+	using TransformType = decltype(TeapotData::patchesTransforms)::value_type;
+	using ColorType = decltype(TeapotData::patchesColors)::value_type;
+
+	transformsAndColorsSrvs = descriptors.allocatePersistent(2);
+
+	uint32_t firstTransform{ static_cast<uint32_t>(transformsBuffer.offset / sizeof(TransformType)) };
+	uint32_t firstColor{ static_cast<uint32_t>(colorsBuffer.offset / sizeof(ColorType)) };
+	descriptors.createShaderResourceView(transformsAndColorsSrvs, 0, transformsBuffer.buffer, { firstTransform, static_cast<uint32_t>(TeapotData::patchesTransforms.size()), static_cast<uint32_t>(sizeof(TransformType)) });
+	descriptors.createShaderResourceView(transformsAndColorsSrvs, 1, colorsBuffer.buffer, { firstColor, static_cast<uint32_t>(TeapotData::patchesColors.size()), static_cast<uint32_t>(sizeof(ColorType)) });
+	descriptors.flush();
+}
+
+void TeapotRenderer::createRootSignature()
+{
+	RootParameterDesc dsObjCb{ RootParameterType::Cbv, ShaderVisibility::Domain, 0, 0, 1 };
+	RootParameterDesc hsTessFactorsCb{ RootParameterType::Constants, ShaderVisibility::Hull, 0, 0, 2 };
+	RootParameterDesc dsTransformAndColorSrv{ RootParameterType::SrvTable, ShaderVisibility::Domain, 0, 0, 2 };
+	RootParameterDesc dsPatchOffsetCb{ RootParameterType::Constants, ShaderVisibility::Domain, 1, 0, 2 };
+	RootParameterDesc dsInstanceSrv{ RootParameterType::SrvTable, ShaderVisibility::Domain, 2, 0, 3 };
+
+	RootSignatureDesc rootSignatureDesc;
+	rootSignatureDesc.parameters = { dsObjCb, hsTessFactorsCb, dsTransformAndColorSrv, dsPatchOffsetCb, dsInstanceSrv };
+	rootSignatureDesc.flags =
+		RootSignatureFlagAllowInputLayout |
+		RootSignatureFlagDenyVertexShaderRootAccess |
+		RootSignatureFlagDenyGeometryShaderRootAccess |
+		RootSignatureFlagDenyPixelShaderRootAccess;
+
+	rootSignature = pipelines.createRootSignature(rootSignatureDesc);
+}
+
+// Matches PatchDrawCommand: the tessellation factors, the first patch and instance indices, then the draw.
+void TeapotRenderer::createCommandSignature()
+{
+	CommandSignatureDesc commandSignatureDesc;
+	commandSignatureDesc.byteStride = sizeof(PatchDrawCommand);
+	commandSignatureDesc.arguments =
+	{
+		{ IndirectArgumentType::Constant, 1, 0, 2 },
+		{ IndirectArgumentType::Constant, 3, 0, 2 },
+		{ IndirectArgumentType::DrawIndexed, 0, 0, 0 }
+	};
+	commandSignatureDesc.rootSignature = rootSignature;
+
+	patchCommandSignature = device.createCommandSignature(commandSignatureDesc);
+}
+
+// The fill modes are permutations of one desc; the manager keys each by its full contents.
+void TeapotRenderer::requestPipelineStates()
+{
+	PipelineStateDesc pipelineStateDesc;
+	pipelineStateDesc.rootSignature = rootSignature;
+	pipelineStateDesc.inputLayout = { { "POSITION", 0, Format::R32G32B32Float, 0, 0 } };
+	pipelineStateDesc.vertexShader = shaders.vertexShader;
+	pipelineStateDesc.hullShader = shaders.hullShader;
+	pipelineStateDesc.domainShader = shaders.domainShader;
+	pipelineStateDesc.pixelShader = shaders.pixelShader;
+	pipelineStateDesc.cullMode = CullMode::None;
+	pipelineStateDesc.depthEnable = true;
+	pipelineStateDesc.topologyType = PrimitiveTopologyType::Patch;
+	pipelineStateDesc.renderTargetFormat = Format::R8G8B8A8Unorm;
+	pipelineStateDesc.depthStencilFormat = Format::D32Float;
+
+	pipelineStateDesc.fillMode = FillMode::Wireframe;
+	pipelineStateWireframe = pipelines.request(pipelineStateDesc);
+	pipelineStateDesc.fillMode = FillMode::Solid;
+	pipelineStateSolid = pipelines.request(pipelineStateDesc);
+	currPipelineStateKey = pipelineStateWireframe;
+}
+
+void TeapotRenderer::createViewport(uint32_t width, uint32_t height)
+{
+	viewport.topLeftX = 0.0f;
+	viewport.topLeftY = 0.0f;
+	viewport.width = static_cast<float>(width);
+	viewport.height = static_cast<float>(height);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+}
+
+void TeapotRenderer::createScissorRect(uint32_t width, uint32_t height)
+{
+	scissorRect.left = 0;
+	scissorRect.top = 0;
+	scissorRect.right = static_cast<int32_t>(width);
+	scissorRect.bottom = static_cast<int32_t>(height);
+}
+
+void TeapotRenderer::createOcclusionData()
+{
+	patchBounds = OcclusionCuller::buildPatchBounds(TeapotData::points, TeapotData::patches, TeapotData::patchesTransforms);
+	occluderMesh = OcclusionCuller::buildOccluderMesh(TeapotData::points, TeapotData::patches, TeapotData::patchesTransforms, occluderTessFactor, occluderMinAreaFraction);
+	visiblePatches.reserve(patchBounds.size());
+
+	Aabb teapotBounds{ patchBounds.front() };
+	for (const Aabb& bounds : patchBounds)
+	{
+		teapotBounds.merge(bounds);
+	}
+
+	XMVECTOR minCorner{ XMLoadFloat3(&teapotBounds.minCorner) };
+	XMVECTOR maxCorner{ XMLoadFloat3(&teapotBounds.maxCorner) };
+	XMFLOAT3 teapotCenter;
+	XMStoreFloat3(&teapotCenter, XMVectorScale(XMVectorAdd(minCorner, maxCorner), 0.5f));
+	instanceStore.setLocalBounds(teapotCenter, 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(maxCorner, minCorner))));
+}
+
+void TeapotRenderer::createPatchChunks()
+{
+	uint32_t numPatches{ static_cast<uint32_t>(TeapotData::patches.size() / teapot_tutorial::numPatchControlPoints) };
+	for (uint32_t first{ 0 }; first < numPatches; first += patchesPerChunk)
+	{
+		uint32_t count{ numPatches - first < patchesPerChunk ? numPatches - first : patchesPerChunk };
+		const uint32_t* indices{ TeapotData::patches.data() + first * teapot_tutorial::numPatchControlPoints };
+		patchChunks.push_back(residency.addChunk(indices, count * teapot_tutorial::numPatchControlPoints * sizeof(uint32_t), sizeof(uint32_t), "patches " + to_string(first)));
+	}
+
+	patchChunkPriorities.resize(patchChunks.size());
+	residentPatchChunks.resize(patchChunks.size());
+	patchChunkResident.resize(patchChunks.size());
+
+	// Everything fits the budget at start up, so the first frame does not wait for its chunks.
+	for (uint32_t chunk : patchChunks)
+	{
+		residency.request(chunk, 0.0f);
+	}
+	residency.update();
+}
+
+// The instances moved since the last frame get their bounds in one batch, which then go to the grid and the
+// level of detail selection. The frame slot was waited for in beginFrame(), so the GPU is done reading it; it
+// gets the colors again when their version changed. The instance order lists the instances drawn: all of
+// them, or the ones the grid finds in the frustum, then sorted by level of detail. Only the order of all
+// instances as they are stays the same from frame to frame.
+//
+// Every drawn instance's matrix, premultiplied by the model, view and projection matrices, is then written to
+// the upload ring in the order's order, by the batched kernel in parallel grains; the domain shader applies
+// it instead of an instance transform and the frame's matrix. Returns the ring element the matrices start at.
+uint32_t TeapotRenderer::updateInstances(uint32_t frameIndex, FXMMATRIX mvp)
+{
+	updatedInstances.clear();
+	instanceStore.updateWorlds(updatedInstances);
+	const XMFLOAT4* bounds{ instanceStore.getBounds() };
+	for (uint32_t index : updatedInstances)
+	{
+		lodSelector.setInstance(index, bounds[index]);
+	}
+	updateInstanceGrid();
+
+	uint32_t count{ instanceStore.getSize() };
+	bool cullInstances{ instanced && occlusionCullingEnabled };
+	bool selectLevels{ instanced && levelsOfDetail };
+	InstanceSlotVersions& versions{ instanceSlotVersions[frameIndex] };
+	if (versions.colors != instanceStore.getColorsVersion())
+	{
+		instances.updateColors(frameIndex, count, instanceStore.getColors());
+		versions.colors = instanceStore.getColorsVersion();
+	}
+
+	if (!cullInstances && !selectLevels && versions.order != instanceOrderVersion)
+	{
+		instances.updateOrder(frameIndex, count, identityInstanceOrder.data());
+		versions.order = instanceOrderVersion;
+	}
+
+	if (cullInstances)
+	{
+		visibleInstances.clear();
+		instanceGrid.query(mvp, jobs, visibleInstances);
+
+		// Like the patches, nothing is occluded in wireframe.
+		if (currPipelineStateKey != pipelineStateWireframe)
+		{
+			cullOccludedInstances(mvp);
+		}
+	}
+
+	// Without culling or levels of detail the instances are drawn as they are, read straight from the streams.
+	const uint32_t* drawOrder{ nullptr };
+	uint32_t drawCount{ count };
+	instanceRanges.clear();
+	if (selectLevels)
+	{
+		float pixelsPerUnit{ 0.5f * viewport.height / tanf(0.5f * XMConvertToRadians(teapot_tutorial::cameraFov)) };
+		if (cullInstances)
+		{
+			lodSelector.select(mvp, pixelsPerUnit, tessFactor, visibleInstances);
+		}
+		else
+		{
+			lodSelector.select(mvp, pixelsPerUnit, tessFactor);
+		}
+
+		const vector<uint32_t>& order{ lodSelector.getInstanceOrder() };
+		instances.updateOrder(frameIndex, static_cast<uint32_t>(order.size()), order.data());
+		instanceRanges = lodSelector.getBuckets();
+		drawOrder = order.data();
+		drawCount = static_cast<uint32_t>(order.size());
+	}
+	else if (cullInstances)
+	{
+		instances.updateOrder(frameIndex, static_cast<uint32_t>(visibleInstances.size()), visibleInstances.data());
+		instanceRanges.push_back({ tessFactor, 0, static_cast<uint32_t>(visibleInstances.size()) });
+		drawOrder = visibleInstances.data();
+		drawCount = static_cast<uint32_t>(visibleInstances.size());
+	}
+	else
+	{
+		instanceRanges.push_back({ tessFactor, 0, count });
+	}
+
+	currInstanceTable = instances.getTable(frameIndex);
+
+	// Aligned to the view's stride, so the matrices start at a whole element of it.
+	UploadRing::Allocation matrices{ constantRing.allocate(static_cast<uint64_t>(drawCount > 0 ? drawCount : 1) * sizeof(XMFLOAT4X4), sizeof(XMFLOAT4X4)) };
+	XMFLOAT4X4* matricesData{ static_cast<XMFLOAT4X4*>(matrices.cpuAddress) };
+	teapot_tutorial::TransformStreams streams{ instanceStore.getTransformStreams() };
+	uint32_t numGrains{ (drawCount + instanceMatricesPerGrain - 1) / instanceMatricesPerGrain };
+	jobs.parallelFor(numGrains, 1, [&](uint32_t firstGrain, uint32_t endGrain)
+	{
+		for (uint32_t grain{ firstGrain }; grain < endGrain; grain++)
+		{
+			uint32_t first{ grain * instanceMatricesPerGrain };
+			uint32_t grainCount{ drawCount - first < instanceMatricesPerGrain ? drawCount - first : instanceMatricesPerGrain };
+			teapot_tutorial::computeTransformMatrices(streams, drawOrder != nullptr ? drawOrder + first : nullptr, first, grainCount, mvp, matricesData + first);
+		}
+	});
+
+	return static_cast<uint32_t>(matrices.offset / sizeof(XMFLOAT4X4));
+}
+
+void TeapotRenderer::updateInstanceGrid()
+{
+	const XMFLOAT4* bounds{ instanceStore.getBounds() };
+	instanceGridUpdates.clear();
+	for (uint32_t index : updatedInstances)
+	{
+		instanceGridUpdates.push_back({ index, bounds[index] });
+	}
+
+	instanceGrid.update(instanceGridUpdates);
+}
+
+// The occluder mesh of a teapot stands in for an instance when placed by its world matrix, as the domain shader
+// places the patches.
+void TeapotRenderer::cullOccludedInstances(FXMMATRIX mvp)
+{
+	const XMFLOAT4* bounds{ instanceStore.getBounds() };
+	const XMFLOAT4X4* worlds{ instanceStore.getWorlds() };
+
+	// Radius over view depth ranks the instances by size on screen; those reaching behind the eye would only
+	// have their near triangles dropped.
+	float texelsPerUnit{ 0.5f * occlusionCuller.getHiZBuffer().getHeight() / tanf(0.5f * XMConvertToRadians(teapot_tutorial::cameraFov)) };
+	instanceOccluders.clear();
+	for (uint32_t index : visibleInstances)
+	{
+		const XMFLOAT4& sphere{ bounds[index] };
+		float depth{ XMVectorGetW(XMVector3Transform(XMVectorSet(sphere.x, sphere.y, sphere.z, 1.0f), mvp)) };
+		if (depth > sphere.w && sphere.w / depth * texelsPerUnit >= minInstanceOccluderTexels)
+		{
+			instanceOccluders.push_back({ sphere.w / depth, index });
+		}
+	}
+
+	size_t numOccluders{ instanceOccluders.size() < maxInstanceOccluders ? instanceOccluders.size() : maxInstanceOccluders };
+	if (numOccluders == 0)
+	{
+		return;
+	}
+
+	partial_sort(instanceOccluders.begin(), instanceOccluders.begin() + numOccluders, instanceOccluders.end(), greater<pair<float, uint32_t>>{});
+
+	occlusionCuller.beginFrame();
+	for (size_t i{ 0 }; i < numOccluders; i++)
+	{
+		occlusionCuller.addOccluder(occluderMesh, XMLoadFloat4x4(&worlds[instanceOccluders[i].second]) * mvp);
+	}
+	occlusionCuller.endOccluders();
+	occlusionCuller.cullSpheres(bounds, mvp, jobs, visibleInstances);
+
+	const OcclusionCuller::Stats& stats{ occlusionCuller.getStats() };
+	instanceOcclusionStats.tested += stats.tested;
+	instanceOcclusionStats.culled += stats.culled;
+	instanceOcclusionStats.occluderTriangles += stats.occluderTriangles;
+}
+
+void TeapotRenderer::cullPatches(FXMMATRIX mvp)
+{
+	visiblePatches.clear();
+
+	// Wireframe shows the patches behind the front ones through the lines, so nothing is occluded.
+	bool wireframe{ currPipelineStateKey == pipelineStateWireframe };
+	if (!occlusionCullingEnabled || wireframe || instanced)
+	{
+		for (size_t i{ 0 }; i < patchBounds.size(); i++)
+		{
+			visiblePatches.push_back(static_cast<uint32_t>(i));
+		}
+
+		return;
+	}
+
+	occlusionCuller.beginFrame();
+	occlusionCuller.addOccluder(occluderMesh, mvp);
+	occlusionCuller.endOccluders();
+	occlusionCuller.cull(patchBounds, mvp, jobs, visiblePatches);
+}
+
+// Chunks with visible patches are requested, nearer ones first: the priority falls with the clip space w, the
+// view depth, of the nearest visible patch of the chunk.
+void TeapotRenderer::requestPatchChunks(FXMMATRIX mvp)
+{
+	fill(patchChunkPriorities.begin(), patchChunkPriorities.end(), -1.0f);
+	for (uint32_t patch : visiblePatches)
+	{
+		const Aabb& bounds{ patchBounds[patch] };
+		XMVECTOR center{ XMVectorScale(XMVectorAdd(XMLoadFloat3(&bounds.minCorner), XMLoadFloat3(&bounds.maxCorner)), 0.5f) };
+		float depth{ XMVectorGetW(XMVector3Transform(center, mvp)) };
+		float priority{ 1.0f / (1.0f + (depth > 0.0f ? depth : 0.0f)) };
+
+		float& chunkPriority{ patchChunkPriorities[patch / patchesPerChunk] };
+		if (priority > chunkPriority)
+		{
+			chunkPriority = priority;
+		}
+	}
+
+	for (size_t i{ 0 }; i < patchChunks.size(); i++)
+	{
+		residentPatchChunks[i] = patchChunkPriorities[i] >= 0.0f ? residency.request(patchChunks[i], patchChunkPriorities[i]) : nullptr;
+	}
+
+	residency.update();
+}
\ No newline at end of file
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include <memory>
+#include <string>
+#include <utility>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "OcclusionCuller.h"
+#include "StateCachingCommandList.h"
+#include "ParallelCommandRecorder.h"
+#include "FramePacer.h"
+#include "PipelineStateManager.h"
+#include "ShaderStore.h"
+#include "SceneSnapshot.h"
+#include "ResourceStateTracker.h"
+#include "GpuMemoryAllocator.h"
+#include "DescriptorAllocator.h"
+#include "UploadManager.h"
+#include "UploadRing.h"
+#include "ResidencyManager.h"
+#include "IndirectDrawBuilder.h"
+#include "InstanceBuffers.h"
+#include "LodSelector.h"
+#include "SpatialHashGrid.h"
+#include "SceneStore.h"
+
+// Everything TeapotTutorial draws, written against RenderDevice only, so the same frame can be submitted to
+// the D3D12 backend, the null device or a recording device.
+class TeapotRenderer
+{
+public:
+	struct ShaderSet
+	{
+		ShaderBytecode vertexShader;
+		ShaderBytecode hullShader;
+		ShaderBytecode domainShader;
+		ShaderBytecode pixelShader;
+	};
+
+	// The compiled pipeline states are kept in pipelineCacheFile across runs; empty keeps no file.
+	TeapotRenderer(RenderDevice& device, const ShaderSet& shaders, uint32_t width, uint32_t height, const std::string& pipelineCacheFile);
+	~TeapotRenderer();
+
+	// Waits for a frame slot. Applications that sample input per frame call it first, so in low latency mode
+	// the input is read after the wait; render() calls it otherwise.
+	void beginFrame();
+	void render(float mouseX, float mouseY, float width, float height);
+	// Renders a scene prepared elsewhere, e.g. by an update thread; its tessellation factor replaces the
+	// renderer's.
+	void render(const SceneSnapshot& snapshot);
+
+	void decreaseTessFactor();
+	void increaseTessFactor();
+	// Until the pipeline state of the new mode is compiled, frames are drawn in the old one.
+	void setWireframe(bool wireframe);
+	// Recompiles the pipeline states with new shaders, e.g. after ShaderStore::applyChanges(); frames are drawn
+	// with the old ones until they are ready.
+	void setShaders(const ShaderSet& shaders);
+	// Culling only takes effect in solid mode; wireframe frames draw every patch.
+	void toggleOcclusionCulling();
+	// Draws the teapot once per instance, placed by its transform before the model matrix and tinted by its
+	// color, with one draw per run of visible patches for all instances together, or for each level of detail
+	// bucket when those are selected. Empty vectors go back to the single teapot. With culling on, instanced
+	// frames only draw the instances a spatial grid finds in the view frustum and, in solid mode, that the
+	// largest of them on screen do not hide; their patches are not culled one by one.
+	void setInstances(const std::vector<teapot_tutorial::Transform>& transforms, const std::vector<DirectX::XMFLOAT4>& colors);
+	// Gives some instances new transforms, e.g. a batch an update thread moved. The next frame recomputes their
+	// bounds and moves them in the spatial grid, at a cost that does not depend on the instance count. The
+	// matrices of the instances drawn are built from the transforms every frame either way.
+	void moveInstances(const std::vector<uint32_t>& indices, const std::vector<teapot_tutorial::Transform>& transforms);
+	uint32_t getInstanceCount() const;
+	// Draws instances with a tessellation factor by their size on screen, from the renderer's factor down,
+	// instead of all with the renderer's factor. The single teapot is always drawn with the renderer's factor.
+	void setLevelsOfDetail(bool enabled);
+	bool isLevelsOfDetailEnabled() const;
+	void setStateFiltering(bool enabled);
+	bool isStateFilteringEnabled() const;
+	// Submits each chunk's patch draws with one ExecuteIndirect over arguments written to the upload ring
+	// instead of a draw call per run of patches.
+	void setIndirectDraws(bool enabled);
+	bool isIndirectDrawsEnabled() const;
+
+	// 0 records the draws on the calling thread into the frame's single list; otherwise they are split across
+	// that many lists recorded as jobs. Waits for the GPU to finish with the old lists.
+	void setRecordingLists(uint32_t numLists);
+	uint32_t getRecordingLists() const;
+
+	// Defaults to throughput pacing with one frame in flight less than there are back buffers.
+	void setFramePacing(FramePacer::Mode mode, uint32_t maxFramesInFlight);
+	FramePacer::Mode getFramePacingMode() const;
+	uint32_t getMaxFramesInFlight() const;
+
+	// Sums the counts of all lists the renderer records into.
+	StateCachingCommandList::Stats getCommandStats() const;
+	void resetCommandStats();
+
+	PipelineStateManager::Stats getPipelineStats() const;
+	const IndirectDrawBuilder::Stats& getDrawBuilderStats() const;
+	// The cost of writing instance data for the GPU, paid in the frames after setInstances().
+	const InstanceBuffers::Stats& getInstanceStats() const;
+	void resetInstanceStats();
+	const LodSelector::Stats& getLodStats() const;
+	void resetLodStats();
+	const SpatialHashGrid::Stats& getInstanceGridStats() const;
+	void resetInstanceGridStats();
+	// The instances the grid found that were tested against the occluding instances, and those hidden.
+	const OcclusionCuller::Stats& getInstanceOcclusionStats() const;
+	void resetInstanceOcclusionStats();
+
+	int getTessFactor() const;
+	const std::vector<uint32_t>& getVisiblePatches() const;
+
+	// Loads the compiled shader objects (VertexShader.cso, ...) of directory into the store.
+	static ShaderSet loadShaderSet(ShaderStore& store, const std::string& directory);
+	// The store's current contents of the shader objects loadShaderSet() loaded.
+	static ShaderSet getShaderSet(const ShaderStore& store, const std::string& directory);
+
+private:
+	void createBuffers();
+	void createTransformsAndColorsViews();
+	void createRootSignature();
+	void createCommandSignature();
+	void requestPipelineStates();
+	void createViewport(uint32_t width, uint32_t height);
+	void createScissorRect(uint32_t width, uint32_t height);
+	void createOcclusionData();
+	void createPatchChunks();
+	uint32_t updateInstances(uint32_t frameIndex, DirectX::FXMMATRIX mvp);
+	// Moves the instances updateWorlds() last returned in the grid.
+	void updateInstanceGrid();
+	// Drops the visible instances hidden behind the ones covering the most of the screen.
+	void cullOccludedInstances(DirectX::FXMMATRIX mvp);
+	void cullPatches(DirectX::FXMMATRIX mvp);
+	void requestPatchChunks(DirectX::FXMMATRIX mvp);
+	void setFrameTargets(RenderCommandList& list, uint32_t frameIndex);
+	uint32_t buildPatchDraws(uint64_t& argumentOffset);
+	void recordPatchDraws(RenderCommandList& list, uint32_t begin, uint32_t end, uint64_t constBufferLocation);
+	void recordIndirectGroups(RenderCommandList& list, uint32_t begin, uint32_t end, uint64_t constBufferLocation, uint64_t argumentOffset);
+	void bindPatchState(RenderCommandList& list, uint64_t constBufferLocation, uint32_t chunk);
+
+private:
+	RenderDevice& device;
+	ShaderSet shaders;
+	uint32_t bufferCount;
+	FramePacer framePacer;
+	GpuMemoryAllocator bufferAllocator;
+	UploadManager uploadManager;
+	UploadRing constantRing;
+	DescriptorAllocator descriptors;
+	ResidencyManager residency;
+
+	GpuMemoryAllocator::Allocation controlPointsBuffer;
+	VertexBufferView controlPointsBufferView;
+	GpuMemoryAllocator::Allocation transformsBuffer;
+	GpuMemoryAllocator::Allocation colorsBuffer;
+	DescriptorAllocator::Range transformsAndColorsSrvs;
+	RootSignatureHandle rootSignature;
+	CommandSignatureHandle patchCommandSignature;
+	PipelineStateManager::Key pipelineStateWireframe;
+	PipelineStateManager::Key pipelineStateSolid;
+	PipelineStateManager::Key currPipelineStateKey;
+	// The state the frame draws with, resolved once per frame before recording.
+	PipelineStateHandle currPipelineState;
+	Viewport viewport;
+	ScissorRect scissorRect;
+	std::unique_ptr<StateCachingCommandList> commandList;
+	JobSystem jobs;
+	PipelineStateManager pipelines;
+	InstanceBuffers instances;
+	LodSelector lodSelector;
+	SpatialHashGrid instanceGrid;
+	std::unique_ptr<StateCachingCommandList> presentCommandList;
+	std::unique_ptr<ParallelCommandRecorder> drawRecorder;
+	std::vector<RenderCommandList*> submittedCommandLists;
+	ResourceStateRegistry resourceStates;
+	ResourceStateTracker stateTracker;
+
+	int tessFactor{ 8 };
+
+	const int occluderTessFactor{ 4 };
+	const float occluderMinAreaFraction{ 0.25f };
+	// Each occluding instance rasterizes the whole occluder mesh, so only the few largest on screen do, and none
+	// that is only a few depth buffer texels across: those hide nothing as large as a bounding sphere.
+	const uint32_t maxInstanceOccluders{ 16 };
+	const float minInstanceOccluderTexels{ 4.0f };
+
+	std::vector<Aabb> patchBounds;
+	OccluderMesh occluderMesh;
+	OcclusionCuller occlusionCuller;
+	std::vector<uint32_t> visiblePatches;
+
+	// The patch index data is streamed in chunks of patchesPerChunk patches; the rest is small and shared by
+	// all patches, so it stays resident.
+	const uint32_t patchesPerChunk{ 16 };
+	std::vector<uint32_t> patchChunks;
+	std::vector<float> patchChunkPriorities;
+	std::vector<const GpuMemoryAllocator::Allocation*> residentPatchChunks;
+	std::vector<uint8_t> patchChunkResident;
+	IndirectDrawBuilder drawBuilder;
+	// The direct path's commands; the indirect path builds straight into the upload ring.
+	std::vector<PatchDrawCommand> patchDraws;
+	bool indirectDraws{ false };
+
+	// The versions of the instance data a frame slot holds.
+	struct InstanceSlotVersions
+	{
+		uint64_t colors;
+		uint64_t order;
+	};
+
+	// One identity instance unless instanced, placed by the whole teapot's bounding sphere. Instance indices are
+	// stream indices: instances are only ever replaced all together, so they never move in the streams. Each
+	// frame slot gets the colors or order again when their version changed.
+	SceneStore instanceStore;
+	std::vector<SceneStore::Handle> instanceHandles;
+	bool instanced{ false };
+	uint64_t instanceOrderVersion{ 1 };
+	std::vector<InstanceSlotVersions> instanceSlotVersions;
+	DescriptorHandle currInstanceTable;
+	std::vector<uint32_t> updatedInstances;
+	std::vector<SpatialHashGrid::Update> instanceGridUpdates;
+	// The order the instances are looked up in: all as they are, or every frame the visible ones, sorted by
+	// level of detail.
+	std::vector<uint32_t> identityInstanceOrder;
+	std::vector<uint32_t> visibleInstances;
+	// Visible instances by the size of their bounding sphere on screen.
+	std::vector<std::pair<float, uint32_t>> instanceOccluders;
+	OcclusionCuller::Stats instanceOcclusionStats{};
+	std::vector<InstanceRange> instanceRanges;
+	bool levelsOfDetail{ false };
+	bool occlusionCullingEnabled{ true };
+};
\ No newline at end of file
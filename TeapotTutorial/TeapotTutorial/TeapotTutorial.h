@@ -1,47 +1,99 @@
 #pragma once
 
-#include <DirectXMath.h>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <functional>
+#include <exception>
 #include "Graphics.h"
+#include "TeapotRenderer.h"
+#include "RecordingRenderDevice.h"
+#include "SceneSnapshot.h"
+#include "TripleBuffer.h"
+#include "BatchRing.h"
+#include "InputEventQueue.h"
+#include "ShaderStore.h"
 
+// Runs the teapot on two threads. The thread that created the window pumps its messages and runs the update
+// at a fixed tick: it drains the input events the window queued since the last tick, builds the matrices and
+// publishes them as a SceneSnapshot. A render thread draws the newest snapshot every frame, so a slow frame
+// never holds up input and the update rate does not depend on the frame rate. The instances the update moves
+// go to the render thread in batches through a lock-free ring, as every batch has to arrive; key presses that
+// change renderer settings are rare and queued for it under a lock.
 class TeapotTutorial : public Graphics
 {
 public:
 	TeapotTutorial(UINT bufferCount, std::string name, LONG width, LONG height);
+	~TeapotTutorial();
 
-	void render();
+	// Runs the update ticks that are due, or waits for the next tick or window message. Rethrows an error of
+	// the render thread.
+	void update();
 
 private:
-	void createTransformsAndColorsDescHeap();
-	void createConstantBuffer();
-	void createShaders();
-	void createRootSignature();
-	void createPipelineStateWireframe();
-	void createPipelineStateSolid();
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> createPipelineState(D3D12_FILL_MODE fillMode, D3D12_CULL_MODE cullMode);
-	void createViewport();
-	void createScissorRect();
+	void publishSnapshot();
+	void animateInstances();
+	void onInputEvent(const InputEvent& event);
+	void onKeyDown(uint32_t key, bool repeat);
+	void runRenderThread();
+	void queueRenderAction(std::function<void()> action);
+	void runRenderActions();
+	void applyInstanceMoves();
 
 private:
-	const int numParts{ 28 };
-
-	Microsoft::WRL::ComPtr<ID3D12Resource> controlPointsBuffer;
-	D3D12_VERTEX_BUFFER_VIEW controlPointsBufferView;
-	Microsoft::WRL::ComPtr<ID3D12Resource> controlPointsIndexBuffer;
-	D3D12_INDEX_BUFFER_VIEW controlPointsIndexBufferView;
-	Microsoft::WRL::ComPtr<ID3D12Resource> transformsBuffer;
-	Microsoft::WRL::ComPtr<ID3D12Resource> colorsBuffer;
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> transformsAndColorsDescHeap;
-	Microsoft::WRL::ComPtr<ID3D12Resource> constBuffer;
-	Microsoft::WRL::ComPtr<ID3DBlob> vertexShaderBlob;
-	Microsoft::WRL::ComPtr<ID3DBlob> hullShaderBlob;
-	Microsoft::WRL::ComPtr<ID3DBlob> domainShaderBlob;
-	Microsoft::WRL::ComPtr<ID3DBlob> pixelShaderBlob;
-	Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineStateWireframe;
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineStateSolid;
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> currPipelineState;
-	D3D12_VIEWPORT viewport;
-	D3D12_RECT scissorRect;
-
-	int tessFactor{ 8 };
+	// Instances one update tick moved. Moves only apply to the instances they were made for: a batch of an
+	// earlier set is dropped, one of a later set waits for its setInstances() to be run.
+	struct InstanceMoveBatch
+	{
+		uint64_t instanceSet;
+		std::vector<uint32_t> indices;
+		std::vector<teapot_tutorial::Transform> transforms;
+	};
+
+	const int framesPerCapture{ 60 };
+	// Command lists the draws are split across when parallel recording is switched on.
+	const uint32_t recordingLists{ 4 };
+	const std::chrono::microseconds tickDuration{ 1000000 / 120 };
+	const uint32_t shaderWatchMilliseconds{ 250 };
+	// Teapots drawn when instancing is switched on, and how many of them each update tick moves.
+	const uint32_t instancedTeapots{ 100000 };
+	const uint32_t teapotsMovedPerTick{ 4096 };
+
+	// The renderer always goes through the recording device so captures contain every object it created;
+	// commands are only recorded while a capture is running.
+	std::unique_ptr<RecordingRenderDevice> captureDevice;
+	// Rebuilding a .cso while the teapot runs swaps its pipeline states in.
+	ShaderStore shaderStore;
+	std::unique_ptr<TeapotRenderer> renderer;
+	int framesToCapture{ 0 };
+
+	// Update thread state.
+	InputEventQueue inputQueue{ 1024 };
+	POINT mousePosition;
+	POINT windowSize;
+	int tessFactor;
+	bool instancing{ false };
+	// Where the instances rest; they bob up and down around it in batches.
+	std::vector<teapot_tutorial::Transform> instanceRestTransforms;
+	// Counts the instance sets handed to the renderer.
+	uint64_t instanceSet{ 0 };
+	uint32_t nextMovedInstance{ 0 };
+	uint64_t tick{ 0 };
+	std::chrono::steady_clock::time_point nextTick;
+
+	TripleBuffer<SceneSnapshot> snapshots;
+	// Frames up to eight ticks long take every batch; longer ones hold the wave up rather than lose moves.
+	BatchRing<InstanceMoveBatch, 8> instanceMoves;
+	// Render thread: the instance set the renderer has.
+	uint64_t renderedInstanceSet{ 0 };
+	std::mutex renderActionMutex;
+	std::vector<std::function<void()>> renderActions;
+	std::vector<std::function<void()>> runningRenderActions;
+	std::thread renderThread;
+	std::atomic<bool> stopping{ false };
+	std::atomic<bool> renderFailed{ false };
+	std::exception_ptr renderError;
 };
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include "TlsfAllocator.h"
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+	uint32_t findLastSet(uint64_t value)
+	{
+		uint32_t bit{ 0 };
+		for (uint32_t shift{ 32 }; shift > 0; shift /= 2)
+		{
+			if (value >> shift)
+			{
+				value >>= shift;
+				bit += shift;
+			}
+		}
+
+		return bit;
+	}
+
+	uint32_t findFirstSet(uint64_t value)
+	{
+		return findLastSet(value & (~value + 1));
+	}
+
+	uint64_t alignUp(uint64_t offset, uint64_t alignment)
+	{
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+}
+
+TlsfAllocator::TlsfAllocator(uint64_t size) : size{ size }
+{
+	if (size == 0)
+	{
+		throw(runtime_error{ "TLSF allocator needs a non zero size." });
+	}
+
+	for (uint32_t i{ 0 }; i < firstLevelCount; i++)
+	{
+		secondLevelBitmaps[i] = 0;
+		for (uint32_t j{ 0 }; j < secondLevelCount; j++)
+		{
+			freeLists[i][j] = noBlock;
+		}
+	}
+
+	uint32_t block{ newBlock() };
+	blocks[block] = { 0, size, noBlock, noBlock, noBlock, noBlock, true };
+	insertFreeBlock(block);
+}
+
+uint64_t TlsfAllocator::allocate(uint64_t size, uint64_t alignment)
+{
+	if (size == 0 || alignment == 0)
+	{
+		throw(runtime_error{ "Invalid TLSF allocation." });
+	}
+
+	if (size > this->size)
+	{
+		return invalidOffset;
+	}
+
+	// The block found for the plain size usually is aligned already; only when it is not is the search
+	// repeated with room for the worst case padding.
+	uint32_t block{ findFreeBlock(size) };
+	if (block == noBlock || alignUp(blocks[block].offset, alignment) + size > blocks[block].offset + blocks[block].size)
+	{
+		if (alignment - 1 > this->size - size)
+		{
+			return invalidOffset;
+		}
+
+		block = findFreeBlock(size + alignment - 1);
+		if (block == noBlock)
+		{
+			return invalidOffset;
+		}
+	}
+
+	removeFreeBlock(block);
+
+	uint64_t offset{ alignUp(blocks[block].offset, alignment) };
+	if (offset > blocks[block].offset)
+	{
+		uint32_t aligned{ splitBlock(block, offset - blocks[block].offset) };
+		insertFreeBlock(block);
+		block = aligned;
+	}
+
+	if (blocks[block].size > size)
+	{
+		insertFreeBlock(splitBlock(block, size));
+	}
+
+	blocks[block].free = false;
+	allocatedBlocks[offset] = block;
+	allocatedBytes += size;
+	return offset;
+}
+
+void TlsfAllocator::free(uint64_t offset)
+{
+	auto allocated = allocatedBlocks.find(offset);
+	if (allocated == allocatedBlocks.end())
+	{
+		throw(runtime_error{ "Freeing an offset that was not allocated." });
+	}
+
+	uint32_t block{ allocated->second };
+	allocatedBlocks.erase(allocated);
+	allocatedBytes -= blocks[block].size;
+	blocks[block].free = true;
+
+	uint32_t prev{ blocks[block].prevPhysical };
+	if (prev != noBlock && blocks[prev].free)
+	{
+		removeFreeBlock(prev);
+		blocks[prev].size += blocks[block].size;
+		blocks[prev].nextPhysical = blocks[block].nextPhysical;
+		if (blocks[block].nextPhysical != noBlock)
+		{
+			blocks[blocks[block].nextPhysical].prevPhysical = prev;
+		}
+
+		unusedBlocks.push_back(block);
+		block = prev;
+	}
+
+	uint32_t next{ blocks[block].nextPhysical };
+	if (next != noBlock && blocks[next].free)
+	{
+		removeFreeBlock(next);
+		blocks[block].size += blocks[next].size;
+		blocks[block].nextPhysical = blocks[next].nextPhysical;
+		if (blocks[next].nextPhysical != noBlock)
+		{
+			blocks[blocks[next].nextPhysical].prevPhysical = block;
+		}
+
+		unusedBlocks.push_back(next);
+	}
+
+	insertFreeBlock(block);
+}
+
+bool TlsfAllocator::isEmpty() const
+{
+	return allocatedBlocks.empty();
+}
+
+TlsfAllocator::Stats TlsfAllocator::getStats() const
+{
+	Stats stats;
+	stats.size = size;
+	stats.allocatedBytes = allocatedBytes;
+	stats.freeBytes = size - allocatedBytes;
+	stats.largestFreeBlock = 0;
+	stats.allocations = static_cast<uint32_t>(allocatedBlocks.size());
+	stats.freeBlocks = static_cast<uint32_t>(blocks.size() - unusedBlocks.size() - allocatedBlocks.size());
+
+	// The largest free block is in the highest non empty bin; only that list needs to be walked.
+	if (firstLevelBitmap != 0)
+	{
+		uint32_t firstLevel{ findLastSet(firstLevelBitmap) };
+		uint32_t secondLevel{ findLastSet(secondLevelBitmaps[firstLevel]) };
+		for (uint32_t block{ freeLists[firstLevel][secondLevel] }; block != noBlock; block = blocks[block].nextFree)
+		{
+			if (blocks[block].size > stats.largestFreeBlock)
+			{
+				stats.largestFreeBlock = blocks[block].size;
+			}
+		}
+	}
+
+	return stats;
+}
+
+double TlsfAllocator::getFragmentation() const
+{
+	Stats stats{ getStats() };
+	if (stats.freeBytes == 0)
+	{
+		return 0.0;
+	}
+
+	return 1.0 - static_cast<double>(stats.largestFreeBlock) / static_cast<double>(stats.freeBytes);
+}
+
+void TlsfAllocator::mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const
+{
+	if (size < secondLevelCount)
+	{
+		firstLevel = 0;
+		secondLevel = static_cast<uint32_t>(size);
+		return;
+	}
+
+	uint32_t bit{ findLastSet(size) };
+	firstLevel = bit - secondLevelLog2 + 1;
+	secondLevel = static_cast<uint32_t>(size >> (bit - secondLevelLog2)) ^ secondLevelCount;
+}
+
+uint32_t TlsfAllocator::findFreeBlock(uint64_t size) const
+{
+	// Rounding up to the next bin boundary makes any block of the bin found large enough.
+	if (size >= secondLevelCount)
+	{
+		size += (static_cast<uint64_t>(1) << (findLastSet(size) - secondLevelLog2)) - 1;
+	}
+
+	uint32_t firstLevel;
+	uint32_t secondLevel;
+	mapping(size, firstLevel, secondLevel);
+
+	uint32_t secondLevelMap{ secondLevelBitmaps[firstLevel] & (~0u << secondLevel) };
+	if (secondLevelMap == 0)
+	{
+		uint64_t firstLevelMap{ firstLevel + 1 < firstLevelCount ? firstLevelBitmap & (~static_cast<uint64_t>(0) << (firstLevel + 1)) : 0 };
+		if (firstLevelMap == 0)
+		{
+			return noBlock;
+		}
+
+		firstLevel = findFirstSet(firstLevelMap);
+		secondLevelMap = secondLevelBitmaps[firstLevel];
+	}
+
+	return freeLists[firstLevel][findFirstSet(secondLevelMap)];
+}
+
+void TlsfAllocator::insertFreeBlock(uint32_t block)
+{
+	uint32_t firstLevel;
+	uint32_t secondLevel;
+	mapping(blocks[block].size, firstLevel, secondLevel);
+
+	uint32_t& head{ freeLists[firstLevel][secondLevel] };
+	blocks[block].free = true;
+	blocks[block].prevFree = noBlock;
+	blocks[block].nextFree = head;
+	if (head != noBlock)
+	{
+		blocks[head].prevFree = block;
+	}
+
+	head = block;
+	secondLevelBitmaps[firstLevel] |= 1u << secondLevel;
+	firstLevelBitmap |= static_cast<uint64_t>(1) << firstLevel;
+}
+
+void TlsfAllocator::removeFreeBlock(uint32_t block)
+{
+	uint32_t firstLevel;
+	uint32_t secondLevel;
+	mapping(blocks[block].size, firstLevel, secondLevel);
+
+	Block& b{ blocks[block] };
+	if (b.prevFree != noBlock)
+	{
+		blocks[b.prevFree].nextFree = b.nextFree;
+	}
+	else
+	{
+		freeLists[firstLevel][secondLevel] = b.nextFree;
+	}
+
+	if (b.nextFree != noBlock)
+	{
+		blocks[b.nextFree].prevFree = b.prevFree;
+	}
+
+	if (freeLists[firstLevel][secondLevel] == noBlock)
+	{
+		secondLevelBitmaps[firstLevel] &= ~(1u << secondLevel);
+		if (secondLevelBitmaps[firstLevel] == 0)
+		{
+			firstLevelBitmap &= ~(static_cast<uint64_t>(1) << firstLevel);
+		}
+	}
+
+	b.free = false;
+}
+
+uint32_t TlsfAllocator::splitBlock(uint32_t block, uint64_t size)
+{
+	uint32_t rest{ newBlock() };
+	blocks[rest].offset = blocks[block].offset + size;
+	blocks[rest].size = blocks[block].size - size;
+	blocks[rest].prevPhysical = block;
+	blocks[rest].nextPhysical = blocks[block].nextPhysical;
+	blocks[rest].free = false;
+	if (blocks[block].nextPhysical != noBlock)
+	{
+		blocks[blocks[block].nextPhysical].prevPhysical = rest;
+	}
+
+	blocks[block].size = size;
+	blocks[block].nextPhysical = rest;
+	return rest;
+}
+
+uint32_t TlsfAllocator::newBlock()
+{
+	if (!unusedBlocks.empty())
+	{
+		uint32_t block{ unusedBlocks.back() };
+		unusedBlocks.pop_back();
+		return block;
+	}
+
+	blocks.emplace_back();
+	return static_cast<uint32_t>(blocks.size() - 1);
+}
\ No newline at end of file
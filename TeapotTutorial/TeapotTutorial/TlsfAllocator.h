@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Two level segregated fit allocator over an abstract range of offsets. Free blocks are binned by the power of
+// two of their size (first level) and 16 linear steps inside it (second level); two bitmaps find a block that
+// is large enough in constant time and neighbouring free blocks are merged on free. Block bookkeeping lives on
+// the CPU side only, so the range can be a GPU heap, a buffer or nothing at all.
+class TlsfAllocator
+{
+public:
+	static const uint64_t invalidOffset{ UINT64_MAX };
+
+	struct Stats
+	{
+		uint64_t size;
+		uint64_t allocatedBytes;
+		uint64_t freeBytes;
+		uint64_t largestFreeBlock;
+		uint32_t allocations;
+		uint32_t freeBlocks;
+	};
+
+	explicit TlsfAllocator(uint64_t size);
+
+	// Alignment does not need to be a power of two, so structured buffer ranges can be aligned to their
+	// stride. Returns invalidOffset when no free block fits.
+	uint64_t allocate(uint64_t size, uint64_t alignment);
+	void free(uint64_t offset);
+
+	bool isEmpty() const;
+	Stats getStats() const;
+	// 0 when all free space is one block, approaching 1 as it is split into many small ones.
+	double getFragmentation() const;
+
+private:
+	static const uint32_t secondLevelLog2{ 4 };
+	static const uint32_t secondLevelCount{ 1 << secondLevelLog2 };
+	static const uint32_t firstLevelCount{ 64 };
+	static const uint32_t noBlock{ UINT32_MAX };
+
+	struct Block
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint32_t prevPhysical;
+		uint32_t nextPhysical;
+		uint32_t prevFree;
+		uint32_t nextFree;
+		bool free;
+	};
+
+	void mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel) const;
+	uint32_t findFreeBlock(uint64_t size) const;
+	void insertFreeBlock(uint32_t block);
+	void removeFreeBlock(uint32_t block);
+	uint32_t splitBlock(uint32_t block, uint64_t size);
+	uint32_t newBlock();
+
+private:
+	uint64_t size;
+	std::vector<Block> blocks;
+	std::vector<uint32_t> unusedBlocks;
+	uint64_t firstLevelBitmap{ 0 };
+	uint32_t secondLevelBitmaps[firstLevelCount];
+	uint32_t freeLists[firstLevelCount][secondLevelCount];
+	std::unordered_map<uint64_t, uint32_t> allocatedBlocks;
+	uint64_t allocatedBytes{ 0 };
+};
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "TransformKernel.h"
+#include "SceneMath.h"
+
+using namespace std;
+using namespace DirectX;
+
+namespace teapot_tutorial
+{
+	void XM_CALLCONV computeTransformMatrices(const TransformStreams& streams, const uint32_t* indices, uint32_t first, uint32_t count, FXMMATRIX post, XMFLOAT4X4* matrices)
+	{
+		XMFLOAT4X4 postElements;
+		XMStoreFloat4x4(&postElements, post);
+		XMVECTOR p[4][4];
+		for (uint32_t r{ 0 }; r < 4; r++)
+		{
+			for (uint32_t c{ 0 }; c < 4; c++)
+			{
+				p[r][c] = XMVectorReplicate(postElements.m[r][c]);
+			}
+		}
+
+		XMVECTOR one{ XMVectorSplatOne() };
+		for (uint32_t i{ 0 }; i < count; i += 4)
+		{
+			// Lanes past the end repeat the last object and are not stored.
+			uint32_t lanes{ count - i < 4 ? count - i : 4 };
+			XMVECTOR components[transformStreamCount];
+			if (indices != nullptr || lanes < 4)
+			{
+				uint32_t ids[4];
+				for (uint32_t lane{ 0 }; lane < 4; lane++)
+				{
+					uint32_t k{ i + (lane < lanes ? lane : lanes - 1) };
+					ids[lane] = indices != nullptr ? indices[k] : first + k;
+				}
+
+				for (uint32_t s{ 0 }; s < transformStreamCount; s++)
+				{
+					const float* stream{ streams.components[s] };
+					components[s] = XMVectorSet(stream[ids[0]], stream[ids[1]], stream[ids[2]], stream[ids[3]]);
+				}
+			}
+			else
+			{
+				for (uint32_t s{ 0 }; s < transformStreamCount; s++)
+				{
+					components[s] = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(streams.components[s] + first + i));
+				}
+			}
+
+			// The rows of XMMatrixRotationQuaternion(), each scaled by its axis' scale.
+			XMVECTOR x{ components[3] };
+			XMVECTOR y{ components[4] };
+			XMVECTOR z{ components[5] };
+			XMVECTOR w{ components[6] };
+			XMVECTOR x2{ XMVectorAdd(x, x) };
+			XMVECTOR y2{ XMVectorAdd(y, y) };
+			XMVECTOR z2{ XMVectorAdd(z, z) };
+			XMVECTOR xx{ XMVectorMultiply(x, x2) };
+			XMVECTOR yy{ XMVectorMultiply(y, y2) };
+			XMVECTOR zz{ XMVectorMultiply(z, z2) };
+			XMVECTOR xy{ XMVectorMultiply(x, y2) };
+			XMVECTOR xz{ XMVectorMultiply(x, z2) };
+			XMVECTOR yz{ XMVectorMultiply(y, z2) };
+			XMVECTOR wx{ XMVectorMultiply(w, x2) };
+			XMVECTOR wy{ XMVectorMultiply(w, y2) };
+			XMVECTOR wz{ XMVectorMultiply(w, z2) };
+
+			XMVECTOR world[4][3];
+			world[0][0] = XMVectorMultiply(components[7], XMVectorSubtract(XMVectorSubtract(one, yy), zz));
+			world[0][1] = XMVectorMultiply(components[7], XMVectorAdd(xy, wz));
+			world[0][2] = XMVectorMultiply(components[7], XMVectorSubtract(xz, wy));
+			world[1][0] = XMVectorMultiply(components[8], XMVectorSubtract(xy, wz));
+			world[1][1] = XMVectorMultiply(components[8], XMVectorSubtract(XMVectorSubtract(one, xx), zz));
+			world[1][2] = XMVectorMultiply(components[8], XMVectorAdd(yz, wx));
+			world[2][0] = XMVectorMultiply(components[9], XMVectorAdd(xz, wy));
+			world[2][1] = XMVectorMultiply(components[9], XMVectorSubtract(yz, wx));
+			world[2][2] = XMVectorMultiply(components[9], XMVectorSubtract(XMVectorSubtract(one, xx), yy));
+			world[3][0] = components[0];
+			world[3][1] = components[1];
+			world[3][2] = components[2];
+
+			// Times post; the world matrices' last column is (0, 0, 0, 1). Each product row, one element per
+			// vector, is transposed into that row of the four matrices.
+			XMMATRIX rows[4];
+			for (uint32_t r{ 0 }; r < 4; r++)
+			{
+				XMMATRIX elements;
+				for (uint32_t c{ 0 }; c < 4; c++)
+				{
+					XMVECTOR element{ r == 3 ? p[3][c] : XMVectorZero() };
+					element = XMVectorMultiplyAdd(world[r][2], p[2][c], element);
+					element = XMVectorMultiplyAdd(world[r][1], p[1][c], element);
+					elements.r[c] = XMVectorMultiplyAdd(world[r][0], p[0][c], element);
+				}
+
+				rows[r] = XMMatrixTranspose(elements);
+			}
+
+			for (uint32_t lane{ 0 }; lane < lanes; lane++)
+			{
+				XMFLOAT4X4& matrix{ matrices[i + lane] };
+				for (uint32_t r{ 0 }; r < 4; r++)
+				{
+					XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(matrix.m[r]), rows[r].r[lane]);
+				}
+			}
+		}
+	}
+
+	void XM_CALLCONV computeTransformMatricesOneByOne(const TransformStreams& streams, const uint32_t* indices, uint32_t first, uint32_t count, FXMMATRIX post, XMFLOAT4X4* matrices)
+	{
+		for (uint32_t i{ 0 }; i < count; i++)
+		{
+			uint32_t id{ indices != nullptr ? indices[i] : first + i };
+			const float* const* c{ streams.components };
+			Transform transform{ { c[0][id], c[1][id], c[2][id] }, { c[3][id], c[4][id], c[5][id], c[6][id] }, { c[7][id], c[8][id], c[9][id] } };
+			XMStoreFloat4x4(&matrices[i], computeTransformMatrix(transform) * post);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+
+namespace teapot_tutorial
+{
+	// Position x, y, z, rotation quaternion x, y, z, w and scale x, y, z, as SceneStore keeps them.
+	const uint32_t transformStreamCount{ 10 };
+
+	struct TransformStreams
+	{
+		const float* components[transformStreamCount];
+	};
+
+	// matrices[i] is the matrix of Transform (scale, then rotation, then translation) of object indices[i], or
+	// of object first + i without indices, times post: with post the identity the world matrices, with a view
+	// projection the matrices that take model space straight to clip space.
+	//
+	// Works on four objects at a time with DirectXMath vectors, one object per lane: the twelve elements of the
+	// four world matrices are built from the streams as vectors, multiplied by post's splatted elements and
+	// transposed back into four matrices per row. That is a quarter of the instructions of building them one by
+	// one, which is what DirectXMath compiles to with the instruction set the project targets (SSE, AVX or
+	// AVX2); the no intrinsics build runs the same code on floats. The matrices are written front to back and
+	// never read, so they can go straight to write combined upload memory.
+	void XM_CALLCONV computeTransformMatrices(const TransformStreams& streams, const uint32_t* indices, uint32_t first, uint32_t count, DirectX::FXMMATRIX post, DirectX::XMFLOAT4X4* matrices);
+
+	// The same one object at a time with computeTransformMatrix(), as the reference the batched kernel is
+	// checked and timed against.
+	void XM_CALLCONV computeTransformMatricesOneByOne(const TransformStreams& streams, const uint32_t* indices, uint32_t first, uint32_t count, DirectX::FXMMATRIX post, DirectX::XMFLOAT4X4* matrices);
+}
\ No newline at end of file
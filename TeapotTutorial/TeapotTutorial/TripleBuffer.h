@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands the latest value from one producer thread to one consumer thread without locks or waiting. Of the
+// three slots the producer owns one, the consumer owns one and the third is the hand over slot; publish() and
+// update() each swap their slot with it in a single atomic exchange. The consumer always sees a complete value,
+// the newest one published before its update(); values published in between are skipped.
+template<typename T>
+class TripleBuffer
+{
+public:
+	// The slot to fill before publish(). It keeps its contents from two publishes ago.
+	T& getWriteBuffer()
+	{
+		return buffers[writeIndex];
+	}
+
+	void publish()
+	{
+		uint8_t previous{ handOver.exchange(static_cast<uint8_t>(writeIndex | freshBit), std::memory_order_acq_rel) };
+		writeIndex = previous & indexMask;
+	}
+
+	// Takes the newest published value if there is one; returns false when nothing was published since.
+	bool update()
+	{
+		if ((handOver.load(std::memory_order_relaxed) & freshBit) == 0)
+		{
+			return false;
+		}
+
+		uint8_t previous{ handOver.exchange(readIndex, std::memory_order_acq_rel) };
+		readIndex = previous & indexMask;
+		return true;
+	}
+
+	const T& getReadBuffer() const
+	{
+		return buffers[readIndex];
+	}
+
+private:
+	static const uint8_t indexMask{ 3 };
+	static const uint8_t freshBit{ 4 };
+
+	T buffers[3];
+	uint8_t writeIndex{ 0 };
+	uint8_t readIndex{ 1 };
+	std::atomic<uint8_t> handOver{ 2 };
+};
\ No newline at end of file
@@ -0,0 +1,198 @@
+#include "UploadManager.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+namespace
+{
+	const uint64_t stagingAlignment{ 16 };
+}
+
+UploadFuture::UploadFuture() : manager{ nullptr }, fenceValue{ 0 }
+{
+}
+
+UploadFuture::UploadFuture(UploadManager& manager, uint64_t fenceValue) : manager{ &manager }, fenceValue{ fenceValue }
+{
+}
+
+bool UploadFuture::isValid() const
+{
+	return manager != nullptr;
+}
+
+bool UploadFuture::isReady() const
+{
+	return manager == nullptr || manager->isComplete(fenceValue);
+}
+
+void UploadFuture::wait() const
+{
+	if (manager != nullptr)
+	{
+		manager->wait(fenceValue);
+	}
+}
+
+uint64_t UploadFuture::getFenceValue() const
+{
+	return fenceValue;
+}
+
+UploadManager::UploadManager(RenderDevice& device, uint64_t stagingSize) : device{ device }, stagingRing{ stagingSize }
+{
+	stagingBuffer = device.createBuffer({ stagingSize, HeapType::Upload, ResourceState::GenericRead, "upload staging" }, nullptr);
+	stagingData = static_cast<uint8_t*>(device.mapBuffer(stagingBuffer));
+	fence = device.createFence(0);
+	resetStats();
+}
+
+UploadManager::~UploadManager()
+{
+	waitIdle();
+	device.unmapBuffer(stagingBuffer);
+}
+
+UploadFuture UploadManager::upload(ResourceHandle dst, uint64_t dstOffset, const void* data, uint64_t size)
+{
+	if (size == 0)
+	{
+		return UploadFuture{};
+	}
+
+	// Large uploads go through the ring in pieces, so they stream behind the copies already in flight instead
+	// of needing the whole ring at once.
+	const uint8_t* bytes{ static_cast<const uint8_t*>(data) };
+	uint64_t maxChunkSize{ stagingRing.getSize() / 2 };
+	for (uint64_t done{ 0 }; done < size;)
+	{
+		uint64_t chunkSize{ size - done < maxChunkSize ? size - done : maxChunkSize };
+		uint64_t offset{ allocateStaging(chunkSize) };
+		memcpy(stagingData + offset, bytes + done, static_cast<size_t>(chunkSize));
+
+		getOpenCommandList().copyBufferRegion(dst, dstOffset + done, stagingBuffer, offset, chunkSize);
+		++stats.copiesRecorded;
+		done += chunkSize;
+	}
+
+	++stats.uploads;
+	stats.bytesUploaded += size;
+	return UploadFuture{ *this, nextFenceValue };
+}
+
+void UploadManager::flush()
+{
+	if (openBatch < 0)
+	{
+		return;
+	}
+
+	Batch& batch{ batches[openBatch] };
+	batch.commandList->close();
+
+	RenderCommandList* commandList{ batch.commandList.get() };
+	device.executeCommandLists(QueueType::Copy, 1, &commandList);
+	device.signal(QueueType::Copy, fence, nextFenceValue);
+
+	batch.fenceValue = nextFenceValue;
+	stagingRing.retire(nextFenceValue);
+	submittedFenceValue = nextFenceValue++;
+	openBatch = -1;
+	++stats.batchesSubmitted;
+}
+
+bool UploadManager::isComplete(uint64_t fenceValue)
+{
+	return fenceValue <= getCompletedValue();
+}
+
+void UploadManager::wait(uint64_t fenceValue)
+{
+	if (fenceValue > submittedFenceValue)
+	{
+		flush();
+	}
+
+	if (fenceValue > submittedFenceValue)
+	{
+		throw(runtime_error{ "Waiting for an upload that was never made." });
+	}
+
+	device.waitForFence(fence, fenceValue);
+	stagingRing.release(getCompletedValue());
+}
+
+void UploadManager::waitIdle()
+{
+	flush();
+	if (submittedFenceValue > 0)
+	{
+		wait(submittedFenceValue);
+	}
+}
+
+const UploadManager::Stats& UploadManager::getStats() const
+{
+	return stats;
+}
+
+void UploadManager::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
+
+RenderCommandList& UploadManager::getOpenCommandList()
+{
+	if (openBatch < 0)
+	{
+		uint64_t completedValue{ getCompletedValue() };
+		for (size_t i{ 0 }; i < batches.size() && openBatch < 0; i++)
+		{
+			if (batches[i].fenceValue <= completedValue)
+			{
+				openBatch = static_cast<int>(i);
+			}
+		}
+
+		if (openBatch < 0)
+		{
+			batches.push_back({ device.createCommandList(QueueType::Copy), 0 });
+			openBatch = static_cast<int>(batches.size() - 1);
+		}
+
+		batches[openBatch].commandList->reset(0);
+	}
+
+	return *batches[openBatch].commandList;
+}
+
+uint64_t UploadManager::allocateStaging(uint64_t size)
+{
+	while (true)
+	{
+		stagingRing.release(getCompletedValue());
+
+		uint64_t offset{ stagingRing.allocate(size, stagingAlignment) };
+		if (offset != LinearRingAllocator::invalidOffset)
+		{
+			return offset;
+		}
+
+		// The ring is full of copies that have not executed yet: submit what is pending and wait for the
+		// oldest batch to make room.
+		flush();
+		if (!stagingRing.hasRetiredRanges())
+		{
+			throw(runtime_error{ "Upload does not fit into the staging ring." });
+		}
+
+		++stats.stagingStalls;
+		device.waitForFence(fence, stagingRing.getOldestFenceValue());
+	}
+}
+
+uint64_t UploadManager::getCompletedValue()
+{
+	return device.getCompletedValue(fence);
+}
\ No newline at end of file
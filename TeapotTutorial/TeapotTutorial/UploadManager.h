@@ -0,0 +1,82 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "RenderDevice.h"
+#include "LinearRingAllocator.h"
+
+class UploadManager;
+
+// Completion handle of an upload: the value of the upload fence that signals once its copies have executed.
+class UploadFuture
+{
+public:
+	UploadFuture();
+	UploadFuture(UploadManager& manager, uint64_t fenceValue);
+
+	bool isValid() const;
+	bool isReady() const;
+	// Submits the batch holding the upload if it is still open, then blocks until it has completed.
+	void wait() const;
+	uint64_t getFenceValue() const;
+
+private:
+	UploadManager* manager;
+	uint64_t fenceValue;
+};
+
+// Fills default heap buffers through the copy queue. Source data is staged in one persistently mapped upload
+// buffer managed as a ring, copies are batched into a single copy command list, and every submitted batch
+// signals the next value of one timeline fence. upload() only waits when the staging ring is full, so any
+// number of uploads can be kicked off before waiting once for the last future. Destination buffers should be in
+// the common state; they are promoted to copy dest on the copy queue and decay back when the batch completes.
+class UploadManager
+{
+public:
+	struct Stats
+	{
+		uint64_t uploads;
+		uint64_t bytesUploaded;
+		uint64_t copiesRecorded;
+		uint64_t batchesSubmitted;
+		uint64_t stagingStalls;
+	};
+
+	UploadManager(RenderDevice& device, uint64_t stagingSize);
+	~UploadManager();
+
+	UploadFuture upload(ResourceHandle dst, uint64_t dstOffset, const void* data, uint64_t size);
+
+	// Submits the open batch, if any.
+	void flush();
+	bool isComplete(uint64_t fenceValue);
+	void wait(uint64_t fenceValue);
+	void waitIdle();
+
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	struct Batch
+	{
+		std::unique_ptr<RenderCommandList> commandList;
+		uint64_t fenceValue;
+	};
+
+	RenderCommandList& getOpenCommandList();
+	uint64_t allocateStaging(uint64_t size);
+	uint64_t getCompletedValue();
+
+private:
+	RenderDevice& device;
+	ResourceHandle stagingBuffer;
+	uint8_t* stagingData;
+	LinearRingAllocator stagingRing;
+	FenceHandle fence;
+	uint64_t nextFenceValue{ 1 };
+	uint64_t submittedFenceValue{ 0 };
+	std::vector<Batch> batches;
+	int openBatch{ -1 };
+	Stats stats;
+};
\ No newline at end of file
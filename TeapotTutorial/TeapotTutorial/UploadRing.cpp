@@ -0,0 +1,71 @@
+#include "UploadRing.h"
+#include <cstring>
+#include <stdexcept>
+
+using namespace std;
+
+UploadRing::UploadRing(RenderDevice& device, uint64_t size) : device{ device }, ring{ size }
+{
+	buffer = device.createBuffer({ size, HeapType::Upload, ResourceState::GenericRead, "upload ring" }, nullptr);
+	cpuBase = static_cast<uint8_t*>(device.mapBuffer(buffer));
+	gpuBase = device.getGpuVirtualAddress(buffer);
+	fence = device.createFence(0);
+	resetStats();
+}
+
+UploadRing::~UploadRing()
+{
+	if (fenceValue > 0)
+	{
+		device.waitForFence(fence, fenceValue);
+	}
+
+	device.unmapBuffer(buffer);
+}
+
+UploadRing::Allocation UploadRing::allocate(uint64_t size, uint64_t alignment)
+{
+	while (true)
+	{
+		ring.release(device.getCompletedValue(fence));
+
+		uint64_t offset{ ring.allocate(size, alignment) };
+		if (offset != LinearRingAllocator::invalidOffset)
+		{
+			++stats.allocations;
+			stats.bytesAllocated += size;
+			return{ cpuBase + offset, gpuBase + offset, offset };
+		}
+
+		// Blocks of the frame being built cannot be reused until the frame is submitted.
+		if (!ring.hasRetiredRanges())
+		{
+			throw(runtime_error{ "Upload ring is too small for one frame." });
+		}
+
+		++stats.stalls;
+		device.waitForFence(fence, ring.getOldestFenceValue());
+	}
+}
+
+void UploadRing::endFrame(QueueType queue)
+{
+	device.signal(queue, fence, ++fenceValue);
+	ring.retire(fenceValue);
+	++stats.frames;
+}
+
+ResourceHandle UploadRing::getBuffer() const
+{
+	return buffer;
+}
+
+const UploadRing::Stats& UploadRing::getStats() const
+{
+	return stats;
+}
+
+void UploadRing::resetStats()
+{
+	memset(&stats, 0, sizeof(stats));
+}
\ No newline at end of file
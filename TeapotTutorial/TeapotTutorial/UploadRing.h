@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include "RenderDevice.h"
+#include "LinearRingAllocator.h"
+
+// Persistently mapped upload heap buffer for data written by the CPU every frame (constants, per draw and per
+// instance data). Any number of aligned blocks can be allocated per frame; endFrame() signals the ring's own
+// fence after the frame's submission and the blocks of that frame are reused once the GPU has passed it. When
+// the GPU is more than a ring behind, allocate() waits for the oldest frame.
+class UploadRing
+{
+public:
+	struct Allocation
+	{
+		void* cpuAddress;
+		uint64_t gpuAddress;
+		// Into getBuffer(), for calls that take a buffer and offset instead of an address.
+		uint64_t offset;
+	};
+
+	struct Stats
+	{
+		uint64_t allocations;
+		uint64_t bytesAllocated;
+		uint64_t frames;
+		uint64_t stalls;
+	};
+
+	// Constant buffer views have to start on 256 byte boundaries.
+	static const uint64_t constantBufferAlignment{ 256 };
+
+	UploadRing(RenderDevice& device, uint64_t size);
+	~UploadRing();
+
+	Allocation allocate(uint64_t size, uint64_t alignment);
+	// Call after the lists that read this frame's blocks were executed on queue.
+	void endFrame(QueueType queue);
+
+	ResourceHandle getBuffer() const;
+	const Stats& getStats() const;
+	void resetStats();
+
+private:
+	RenderDevice& device;
+	ResourceHandle buffer;
+	uint8_t* cpuBase;
+	uint64_t gpuBase;
+	LinearRingAllocator ring;
+	FenceHandle fence;
+	uint64_t fenceValue{ 0 };
+	Stats stats;
+};
\ No newline at end of file
@@ -1,17 +1,20 @@
 struct VertexData
 {
 	float3 pos : POSITION;
+	uint instance : SV_InstanceID;
 };
 
 struct VertexToHull
 {
 	float3 pos : POSITION;
+	uint instance : INSTANCE;
 };
 
 VertexToHull main(VertexData input)
 {
 	VertexToHull output;
 	output.pos = input.pos;
+	output.instance = input.instance;
 
 	return output;
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Window.h"
+#include <windowsx.h>
 #include <stdexcept>
 
 using namespace std;
@@ -61,9 +62,9 @@ POINT Window::getSize()
 	return{ rect.right - rect.left, rect.bottom - rect.top };
 }
 
-void Window::addKeyPressCallback(shared_ptr<function<void(WPARAM)>> onKeyPress)
+void Window::setInputQueue(InputEventQueue* inputQueue)
 {
-	this->onKeyPress = onKeyPress;
+	this->inputQueue = inputQueue;
 }
 
 LRESULT CALLBACK Window::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
@@ -82,12 +83,30 @@ LRESULT CALLBACK Window::WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM
 		PostQuitMessage(0);
 		break;
 	case WM_KEYDOWN:
-		if (window->onKeyPress != nullptr)
+	case WM_KEYUP:
+		if (window->inputQueue != nullptr)
 		{
-			(*window->onKeyPress)(wParam);
+			// Bit 30 of lParam is the previous key state, set on the key downs Windows repeats while a key is held.
+			bool repeat{ message == WM_KEYDOWN && (lParam & (1 << 30)) != 0 };
+			window->inputQueue->push(message == WM_KEYDOWN ? InputEventType::KeyDown : InputEventType::KeyUp, static_cast<uint32_t>(wParam), repeat, 0, 0);
 		}
-		
+
+		break;
+	case WM_MOUSEMOVE:
+		if (window->inputQueue != nullptr)
+		{
+			window->inputQueue->push(InputEventType::MouseMove, 0, false, GET_X_LPARAM(lParam), GET_Y_LPARAM(lParam));
+		}
+
 		break;
+	case WM_SIZE:
+		// Sent while the window is being created, before the queue can be set.
+		if (window != nullptr && window->inputQueue != nullptr)
+		{
+			window->inputQueue->push(InputEventType::Resize, 0, false, LOWORD(lParam), HIWORD(lParam));
+		}
+
+		return DefWindowProc(hWnd, message, wParam, lParam);
 	default:
 		return DefWindowProc(hWnd, message, wParam, lParam);
 	}
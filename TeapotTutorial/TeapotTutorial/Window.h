@@ -1,8 +1,7 @@
 #pragma once
 
 #include <Windows.h>
-#include <functional>
-#include <memory>
+#include "InputEventQueue.h"
 
 class Window
 {
@@ -11,12 +10,13 @@ public:
 	HWND getHandle();
 	POINT getMousePosition();
 	POINT getSize();
-	void addKeyPressCallback(std::shared_ptr<std::function<void(WPARAM)>> onKeyPress);
+	// Key, mouse move and resize messages are pushed to inputQueue from the message thread.
+	void setInputQueue(InputEventQueue* inputQueue);
 
 private:
 	static LRESULT CALLBACK WndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
 
 private:
 	HWND hWnd;
-	std::shared_ptr<std::function<void(WPARAM)>> onKeyPress;
+	InputEventQueue* inputQueue{ nullptr };
 };
\ No newline at end of file